@@ -0,0 +1,130 @@
+#define SCG_IMPLEMENTATION
+#include "../scg.h"
+
+#define ATLAS_GRID_SIZE 4
+#define ATLAS_NUM_SPRITES (ATLAS_GRID_SIZE * ATLAS_GRID_SIZE)
+#define ATLAS_SPRITE_SIZE 30
+#define ATLAS_PADDING 2
+// The page is exactly as large as the grid of sprites with padding between
+// them, so the last sprite of each row and column ends at the page edge.
+#define ATLAS_PAGE_SIZE                                                        \
+    (ATLAS_GRID_SIZE * ATLAS_SPRITE_SIZE +                                     \
+     (ATLAS_GRID_SIZE - 1) * ATLAS_PADDING)
+#define ATLAS_ORBIT_RADIUS 150.0f
+
+// Sprites are drawn by hand rather than loaded, each a ring of a different
+// colour around a square, on a transparent background.
+static scg_image_t *new_sprite(int index) {
+    scg_image_t *sprite = scg_image_new(ATLAS_SPRITE_SIZE, ATLAS_SPRITE_SIZE);
+    if (sprite == NULL) {
+        return NULL;
+    }
+
+    int half = ATLAS_SPRITE_SIZE / 2;
+    scg_pixel_t color = scg_pixel_new_rgb((uint8_t)(60 + index * 12),
+                                          (uint8_t)(255 - index * 14),
+                                          (uint8_t)(120 + (index % 4) * 40));
+
+    scg_image_clear(sprite, scg_pixel_new_uint32(0));
+    scg_image_fill_circle(sprite, half, half, half - 1, color);
+    scg_image_fill_circle(sprite, half, half, half - 5,
+                          scg_pixel_new_uint32(0));
+    scg_image_fill_rect(sprite, half - 2 - index / 4, half - 2 - index / 4,
+                        4 + index / 2, 4 + index / 2, color);
+    scg_image_set_blend_mode(sprite, SCG_BLEND_MODE_MASK);
+
+    return sprite;
+}
+
+static scg_atlas_t *init(scg_image_t **sprites) {
+    scg_atlas_t *atlas =
+        scg_atlas_new(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, ATLAS_PADDING);
+    if (atlas == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < ATLAS_NUM_SPRITES; i++) {
+        scg_image_t *sprite = new_sprite(i);
+        if (sprite == NULL) {
+            scg_atlas_free(atlas);
+            return NULL;
+        }
+
+        sprites[i] = scg_atlas_add_image(atlas, sprite);
+        scg_image_free(sprite);
+        if (sprites[i] == NULL) {
+            scg_atlas_free(atlas);
+            return NULL;
+        }
+    }
+
+    return atlas;
+}
+
+static void draw(scg_image_t *draw_target, scg_atlas_t *atlas,
+                 scg_image_t **sprites, float32_t elapsed_time) {
+    int w = draw_target->width;
+    int h = draw_target->height;
+
+    scg_image_clear(draw_target, SCG_COLOR_95_GREEN);
+    // Only opaque pixels are drawn, leaving out the background of sprites.
+    scg_image_set_blend_mode(draw_target, SCG_BLEND_MODE_MASK);
+
+    // The page on the left, with the rect of every sprite outlined.
+    int page_x = 24;
+    int page_y = (h - ATLAS_PAGE_SIZE) / 2;
+    scg_image_fill_rect(draw_target, page_x, page_y, ATLAS_PAGE_SIZE,
+                        ATLAS_PAGE_SIZE, SCG_COLOR_BLACK);
+    scg_image_draw_image(draw_target, atlas->page, page_x, page_y);
+    scg_image_draw_string(draw_target, "Atlas page", page_x, page_y - 16,
+                          false, SCG_COLOR_WHITE);
+
+    for (int i = 0; i < ATLAS_NUM_SPRITES; i++) {
+        int offset = (int)(sprites[i]->pixels - atlas->page->pixels);
+        int x = offset % atlas->page->width;
+        int y = offset / atlas->page->width;
+
+        scg_image_draw_rect(draw_target, page_x + x, page_y + y,
+                            sprites[i]->width, sprites[i]->height,
+                            SCG_COLOR_YELLOW);
+    }
+
+    // The same sprites, drawn straight from the page, orbiting on the right.
+    int center_x = w - (int)ATLAS_ORBIT_RADIUS - 60;
+    int center_y = h / 2;
+    for (int i = 0; i < ATLAS_NUM_SPRITES; i++) {
+        float32_t angle =
+            elapsed_time + (float32_t)i * 2.0f * SCG_PI / ATLAS_NUM_SPRITES;
+        int x = center_x + (int)(ATLAS_ORBIT_RADIUS * cosf(angle)) -
+                ATLAS_SPRITE_SIZE / 2;
+        int y = center_y + (int)(ATLAS_ORBIT_RADIUS * sinf(angle)) -
+                ATLAS_SPRITE_SIZE / 2;
+
+        scg_image_draw_image(draw_target, sprites[i], x, y);
+    }
+}
+
+int main(int arcg, char *argv[]) {
+    scg_config_t config = scg_config_new_default();
+    config.video.title = "SCG Example: Atlas";
+
+    scg_app_t app;
+    scg_app_init(&app, config);
+
+    scg_image_t *sprites[ATLAS_NUM_SPRITES];
+    scg_atlas_t *atlas = init(sprites);
+    if (atlas == NULL) {
+        return -1;
+    }
+
+    while (scg_app_process_events(&app)) {
+        draw(app.draw_target, atlas, sprites, app.elapsed_time);
+
+        scg_app_present(&app);
+    }
+
+    scg_atlas_free(atlas);
+    scg_app_free(&app);
+
+    return 0;
+}
@@ -4,13 +4,50 @@
 #define SCG_IMPLEMENTATION
 #include "../scg.h"
 
-static void draw(scg_image_t *draw_target, float32_t music_progress) {
+#define AUDIO_BAND_WIDTH 12
+#define AUDIO_BAND_HEIGHT 60
+#define AUDIO_PULSE_RADIUS 12
+
+static void draw_analysis(scg_image_t *draw_target,
+                          scg_audio_analysis_t *analysis, float32_t pulse) {
     int w = draw_target->width;
     int h = draw_target->height;
-    scg_pixel_t clear_color = SCG_COLOR_WHITE;
-    scg_pixel_t progress_bar_color = SCG_COLOR_BLACK;
+    int x = (w - SCG_AUDIO_NUM_BANDS * AUDIO_BAND_WIDTH) / 2;
+    int y = h / 2 - 40;
+
+    for (int i = 0; i < SCG_AUDIO_NUM_BANDS; i++) {
+        float32_t level = scg_min_float32(analysis->bands[i], 1.0f);
+        int band_height = (int)(level * AUDIO_BAND_HEIGHT);
+
+        scg_image_fill_rect(draw_target, x + i * AUDIO_BAND_WIDTH,
+                            y - band_height, AUDIO_BAND_WIDTH - 2, band_height,
+                            SCG_COLOR_95_GREEN);
+    }
+
+    // The circle jumps on every onset and shrinks back between them.
+    int radius = (int)((1.0f + pulse) * AUDIO_PULSE_RADIUS);
+    scg_image_fill_circle(draw_target, w / 2, h / 2 + 100, radius,
+                          SCG_COLOR_RED);
+}
 
-    scg_image_clear(draw_target, clear_color);
+static void draw_loading(scg_image_t *draw_target, float32_t progress) {
+    int w = draw_target->width;
+    int h = draw_target->height;
+
+    scg_image_draw_string(draw_target, "Loading: arcade-music-loop.wav", w / 2,
+                          h / 2 - 20, true, SCG_COLOR_BLACK);
+    scg_image_draw_rect(draw_target, 10, h / 2 + 20, w - 20, 10,
+                        SCG_COLOR_BLACK);
+    scg_image_fill_rect(draw_target, 10, h / 2 + 20,
+                        (int)((float32_t)(w - 20) * progress), 10,
+                        SCG_COLOR_BLACK);
+}
+
+static void draw(scg_image_t *draw_target, float32_t music_progress,
+                 bool muffled) {
+    int w = draw_target->width;
+    int h = draw_target->height;
+    scg_pixel_t progress_bar_color = SCG_COLOR_BLACK;
 
     scg_image_draw_string(draw_target, "Playing: arcade-music-loop.wav", w / 2,
                           h / 2 - 20, true, progress_bar_color);
@@ -23,30 +60,87 @@ static void draw(scg_image_t *draw_target, float32_t music_progress) {
                         progress_bar_color);
     scg_image_fill_rect(draw_target, 10, h / 2 + 20, progress_bar_width, 10,
                         progress_bar_color);
+
+    scg_image_draw_string(draw_target,
+                          muffled ? "Space: remove filter" : "Space: muffle",
+                          w / 2, h / 2 + 50, true, progress_bar_color);
 }
 
 int main(int arcg, char *argv[]) {
     scg_config_t config = scg_config_new_default();
     config.video.title = "SCG Example: Audio";
     config.audio.enabled = true;
+    config.audio.analysis = true;
 
     scg_app_t app;
     scg_app_init(&app, config);
 
-    scg_sound_t *music =
-        scg_sound_new_from_wav(app.audio, "assets/arcade-music-loop.wav", true);
-    if (music == NULL) {
+    // The music is decoded and resampled on a worker thread while the
+    // window keeps drawing.
+    scg_asset_loader_t *loader = scg_asset_loader_new(app.audio, 0);
+    if (loader == NULL) {
+        return -1;
+    }
+    scg_asset_t *music_asset =
+        scg_asset_load_async(loader, "assets/arcade-music-loop.wav");
+    if (music_asset == NULL) {
+        return -1;
+    }
+    scg_sound_t *music = NULL;
+
+    scg_effect_t *muffle = scg_effect_new_filter(
+        app.audio, SCG_FILTER_LOWPASS, 600.0f, 0.7f, 0.0f);
+    if (muffle == NULL) {
         return -1;
     }
-    scg_sound_play(music);
+    bool muffled = false;
+    float32_t pulse = 0.0f;
 
     while (scg_app_process_events(&app)) {
+        if (music == NULL) {
+            if (scg_asset_get_state(music_asset) == SCG_ASSET_STATE_FAILED) {
+                break;
+            }
+
+            music = scg_asset_get_sound(music_asset);
+            if (music == NULL) {
+                scg_image_clear(app.draw_target, SCG_COLOR_WHITE);
+                draw_loading(app.draw_target,
+                             scg_asset_loader_get_progress(loader));
+                scg_app_present(&app);
+                continue;
+            }
+
+            music->loop = true;
+            scg_sound_play(music);
+        }
+
+        if (scg_keyboard_is_key_triggered(app.keyboard, SCG_KEY_SPACE)) {
+            muffled = !muffled;
+
+            if (muffled) {
+                scg_audio_add_effect(app.audio, muffle);
+            } else {
+                scg_audio_remove_effect(app.audio, muffle);
+            }
+        }
+
+        scg_audio_analysis_t analysis;
+        scg_audio_get_analysis(app.audio, &analysis);
+        pulse = analysis.is_onset
+                    ? 1.0f
+                    : scg_max_float32(pulse - app.delta_time * 4.0f, 0.0f);
+
+        scg_image_clear(app.draw_target, SCG_COLOR_WHITE);
+
         float32_t play_position = scg_sound_get_position(music);
-        draw(app.draw_target, play_position);
+        draw(app.draw_target, play_position, muffled);
+        draw_analysis(app.draw_target, &analysis, pulse);
 
         scg_app_present(&app);
     }
 
+    scg_asset_loader_free(loader);
     scg_app_free(&app);
 
     return 0;
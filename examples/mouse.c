@@ -8,7 +8,10 @@ int main(int arcg, char *argv[]) {
     scg_app_t app;
     scg_app_init(&app, config);
 
-    scg_image_t *cursor = scg_image_new_from_bmp("assets/mouse_cursor.bmp");
+    // The cursor is either fully opaque or fully transparent, so it can be
+    // drawn from a run-length encoded copy.
+    scg_rle_image_t *cursor =
+        scg_rle_image_new_from_bmp("assets/mouse_cursor.bmp");
     if (cursor == NULL) {
         return -1;
     }
@@ -53,12 +56,12 @@ int main(int arcg, char *argv[]) {
                                   half_h + SCG_FONT_SIZE * 2, true, text_color);
         }
 
-        scg_image_set_blend_mode(draw_target, SCG_BLEND_MODE_ALPHA);
-        scg_image_draw_image(draw_target, cursor, mouse->x, mouse->y);
+        scg_image_draw_rle_image(draw_target, cursor, mouse->x, mouse->y);
 
         scg_app_present(&app);
     }
 
+    scg_rle_image_free(cursor);
     scg_app_free(&app);
 
     return 0;
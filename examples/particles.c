@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#define SCG_IMPLEMENTATION
+#include "../scg.h"
+
+#define PARTICLES_NUM_PARTICLES 4000
+#define PARTICLES_GRAVITY 120.0f
+
+typedef struct particle_t {
+    float32_t x;
+    float32_t y;
+    float32_t vx;
+    float32_t vy;
+    float32_t angle;
+    float32_t spin;
+    int layer;
+} particle_t;
+
+static void init_particle(particle_t *particle, int w, int h) {
+    particle->x = (float32_t)(w / 2);
+    particle->y = (float32_t)h;
+    particle->vx = (float32_t)(rand() % 200 - 100);
+    particle->vy = -(float32_t)(rand() % 200 + 150);
+    particle->angle = 0.0f;
+    particle->spin = (float32_t)(rand() % 100 - 50) / 10.0f;
+    particle->layer = rand() % 3;
+}
+
+static void update(particle_t *particles, int num_particles, scg_app_t *app) {
+    int w = app->draw_target->width;
+    int h = app->draw_target->height;
+    float32_t delta_time = app->delta_time;
+
+    for (int i = 0; i < num_particles; i++) {
+        particle_t *particle = &particles[i];
+
+        particle->vy += PARTICLES_GRAVITY * delta_time;
+        particle->x += particle->vx * delta_time;
+        particle->y += particle->vy * delta_time;
+        particle->angle += particle->spin * delta_time;
+
+        if (particle->y > h + 32) {
+            init_particle(particle, w, h);
+        }
+    }
+}
+
+static void draw(scg_image_t *draw_target, scg_sprite_batch_t *batch,
+                 particle_t *particles, int num_particles, scg_image_t *ball) {
+    scg_image_clear(draw_target, SCG_COLOR_95_GREEN);
+
+    scg_sprite_batch_clear(batch);
+
+    for (int i = 0; i < num_particles; i++) {
+        particle_t *particle = &particles[i];
+        int x = (int)particle->x - ball->width / 2;
+        int y = (int)particle->y - ball->height / 2;
+
+        // Particles on the front layer spin, the rest are plain blits.
+        if (particle->layer == 2) {
+            scg_sprite_batch_add_transformed(batch, ball, x, y, particle->layer,
+                                             SCG_BLEND_MODE_ALPHA,
+                                             particle->angle, 0.5f, 0.5f);
+        } else {
+            scg_sprite_batch_add(batch, ball, x, y, particle->layer,
+                                 SCG_BLEND_MODE_MASK);
+        }
+    }
+
+    scg_sprite_batch_draw(batch, draw_target);
+}
+
+int main(int arcg, char *argv[]) {
+    scg_config_t config = scg_config_new_default();
+    config.video.title = "SCG Example: Particles";
+
+    scg_app_t app;
+    scg_app_init(&app, config);
+
+    srand(scg_get_performance_counter());
+
+    scg_image_t *ball = scg_image_new_from_bmp("assets/ball.bmp");
+    if (ball == NULL) {
+        return -1;
+    }
+
+    // Saving a new ball.bmp while the example runs swaps it in on the next
+    // frame.
+    scg_asset_watcher_t *watcher = scg_asset_watcher_new(NULL);
+    if (watcher == NULL) {
+        return -1;
+    }
+    scg_asset_watcher_add_image(watcher, ball, "assets/ball.bmp");
+
+    scg_sprite_batch_t *batch =
+        scg_sprite_batch_new(PARTICLES_NUM_PARTICLES, 0);
+    if (batch == NULL) {
+        return -1;
+    }
+
+    int w = app.draw_target->width;
+    int h = app.draw_target->height;
+    particle_t *particles =
+        malloc(PARTICLES_NUM_PARTICLES * sizeof(*particles));
+    for (int i = 0; i < PARTICLES_NUM_PARTICLES; i++) {
+        init_particle(&particles[i], w, h);
+    }
+
+    while (scg_app_process_events(&app)) {
+        scg_asset_watcher_update(watcher);
+
+        update(particles, PARTICLES_NUM_PARTICLES, &app);
+
+        draw(app.draw_target, batch, particles, PARTICLES_NUM_PARTICLES, ball);
+
+        scg_app_present(&app);
+    }
+
+    free(particles);
+    scg_sprite_batch_free(batch);
+    scg_asset_watcher_free(watcher);
+    scg_image_free(ball);
+    scg_app_free(&app);
+
+    return 0;
+}
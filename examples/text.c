@@ -0,0 +1,104 @@
+#define SCG_IMPLEMENTATION
+#include "../scg.h"
+
+#define TEXT_BOX_WIDTH 240
+#define TEXT_ALIGN_SECS 2.0f
+#define TEXT_TITLE_SCALE 3
+#define TEXT_SUBTITLE_SCALE 1.5f
+
+static const char *paragraph =
+    "Text objects are laid out once and cached, so drawing an unchanged "
+    "label every frame only draws its glyphs.\n\nLines wrap at spaces to "
+    "fit the box and can be aligned left, centre or right.";
+
+static const char *align_names[] = {"left", "centre", "right"};
+
+static void draw(scg_image_t *draw_target, scg_text_t *title,
+                 scg_text_t *subtitle, scg_text_t *body, scg_text_t *label,
+                 scg_text_t *counter) {
+    int w = draw_target->width;
+    int h = draw_target->height;
+    int box_x = (w - TEXT_BOX_WIDTH) / 2;
+    int box_y = (h - body->height) / 2;
+
+    scg_image_clear(draw_target, SCG_COLOR_95_GREEN);
+
+    scg_image_draw_text(draw_target, title, (w - title->width) / 2, 10,
+                        SCG_COLOR_WHITE);
+    scg_image_draw_text(draw_target, subtitle, (w - subtitle->width) / 2,
+                        10 + title->height + 4, SCG_COLOR_WHITE);
+
+    scg_image_draw_rect(draw_target, box_x - 5, box_y - 5,
+                        TEXT_BOX_WIDTH + 10, body->height + 10,
+                        SCG_COLOR_WHITE);
+    scg_image_draw_text(draw_target, body, box_x, box_y, SCG_COLOR_WHITE);
+
+    scg_image_draw_text(draw_target, label, (w - label->width) / 2,
+                        box_y - 20, SCG_COLOR_YELLOW);
+    scg_image_draw_text(draw_target, counter, (w - counter->width) / 2,
+                        box_y + body->height + 15, SCG_COLOR_YELLOW);
+}
+
+int main(int arcg, char *argv[]) {
+    scg_config_t config = scg_config_new_default();
+    config.video.title = "SCG Example: Text";
+
+    scg_app_t app;
+    scg_app_init(&app, config);
+
+    // Scaled fonts are made once and text laid out with them draws at the
+    // same speed as unscaled text.
+    scg_font_t *title_font =
+        scg_font_new_scaled(scg_get_font(), TEXT_TITLE_SCALE, false);
+    scg_font_t *subtitle_font =
+        scg_font_new_scaled(scg_get_font(), TEXT_SUBTITLE_SCALE, true);
+    if (title_font == NULL || subtitle_font == NULL) {
+        return -1;
+    }
+
+    scg_set_font(title_font);
+    scg_text_t *title = scg_text_new("Text", 0, SCG_TEXT_ALIGN_LEFT);
+    scg_set_font(subtitle_font);
+    scg_text_t *subtitle =
+        scg_text_new("Scaled and smoothed", 0, SCG_TEXT_ALIGN_LEFT);
+    scg_set_font(NULL);
+
+    scg_text_t *body =
+        scg_text_new(paragraph, TEXT_BOX_WIDTH, SCG_TEXT_ALIGN_LEFT);
+    scg_text_t *label = scg_text_new("", 0, SCG_TEXT_ALIGN_LEFT);
+    scg_text_t *counter = scg_text_new("", 0, SCG_TEXT_ALIGN_LEFT);
+    if (title == NULL || subtitle == NULL || body == NULL || label == NULL ||
+        counter == NULL) {
+        return -1;
+    }
+
+    while (scg_app_process_events(&app)) {
+        int align = (int)(app.elapsed_time / TEXT_ALIGN_SECS) % 3;
+        scg_text_set_layout(body, TEXT_BOX_WIDTH, (scg_text_align_t)align);
+
+        // The label only changes every few seconds, so it is usually
+        // reused from the cache.
+        char str[64];
+        snprintf(str, sizeof(str), "Aligned %s", align_names[align]);
+        scg_text_set(label, str);
+
+        snprintf(str, sizeof(str), "%d glyphs in %d lines", body->num_glyphs,
+                 body->num_lines);
+        scg_text_set(counter, str);
+
+        draw(app.draw_target, title, subtitle, body, label, counter);
+
+        scg_app_present(&app);
+    }
+
+    scg_text_free(counter);
+    scg_text_free(label);
+    scg_text_free(body);
+    scg_text_free(subtitle);
+    scg_text_free(title);
+    scg_font_free(subtitle_font);
+    scg_font_free(title_font);
+    scg_app_free(&app);
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+#define SCG_IMPLEMENTATION
+#include "../scg.h"
+
+#define TILEMAP_TILE_SIZE 16
+#define TILEMAP_MAP_WIDTH 96
+#define TILEMAP_MAP_HEIGHT 64
+#define TILEMAP_SCROLL_RADIUS 200.0f
+#define TILEMAP_SCROLL_SPEED 0.4f
+#define TILEMAP_WAVE_TIME 0.5f
+
+typedef enum tile_type_t {
+    TILE_DEEP_WATER,
+    TILE_WATER,
+    TILE_WATER_WAVE,
+    TILE_SAND,
+    TILE_GRASS,
+    TILE_FOREST,
+    TILE_STONE,
+    TILE_SNOW,
+    TILE_NUM_TYPES
+} tile_type_t;
+
+typedef struct world_t {
+    scg_atlas_t *atlas;
+    scg_tilemap_t *tilemap;
+    float32_t wave_time;
+    bool is_wave;
+} world_t;
+
+// Tiles are drawn by hand rather than loaded, a base colour with a few
+// darker speckles so the scrolling is easy to follow.
+static scg_image_t *new_tile(scg_pixel_t base, scg_pixel_t detail, int seed) {
+    scg_image_t *tile = scg_image_new(TILEMAP_TILE_SIZE, TILEMAP_TILE_SIZE);
+    if (tile == NULL) {
+        return NULL;
+    }
+
+    scg_image_clear(tile, base);
+    for (int i = 0; i < 12; i++) {
+        int x = (seed * 7 + i * 5) % TILEMAP_TILE_SIZE;
+        int y = (seed * 3 + i * 11) % TILEMAP_TILE_SIZE;
+        scg_image_fill_rect(tile, x, y, 2, 2, detail);
+    }
+
+    return tile;
+}
+
+static tile_type_t terrain_at(int x, int y) {
+    float32_t height = sinf((float32_t)x * 0.11f) * cosf((float32_t)y * 0.13f) +
+                       0.5f * sinf((float32_t)(x + y) * 0.07f);
+
+    if (height < -0.6f) {
+        return TILE_DEEP_WATER;
+    } else if (height < -0.2f) {
+        return TILE_WATER;
+    } else if (height < 0.0f) {
+        return TILE_SAND;
+    } else if (height < 0.5f) {
+        return TILE_GRASS;
+    } else if (height < 0.8f) {
+        return TILE_FOREST;
+    } else if (height < 1.1f) {
+        return TILE_STONE;
+    }
+
+    return TILE_SNOW;
+}
+
+static bool init(world_t *world) {
+    const scg_pixel_t colors[TILE_NUM_TYPES][2] = {
+        {scg_pixel_new_rgb(20, 40, 120), scg_pixel_new_rgb(10, 25, 90)},
+        {scg_pixel_new_rgb(40, 90, 200), scg_pixel_new_rgb(30, 70, 170)},
+        {scg_pixel_new_rgb(40, 90, 200), scg_pixel_new_rgb(150, 190, 255)},
+        {scg_pixel_new_rgb(220, 200, 130), scg_pixel_new_rgb(190, 170, 100)},
+        {scg_pixel_new_rgb(70, 160, 60), scg_pixel_new_rgb(50, 130, 40)},
+        {scg_pixel_new_rgb(30, 100, 40), scg_pixel_new_rgb(15, 70, 25)},
+        {scg_pixel_new_rgb(120, 120, 120), scg_pixel_new_rgb(90, 90, 90)},
+        {scg_pixel_new_rgb(240, 240, 250), scg_pixel_new_rgb(200, 200, 220)},
+    };
+
+    // Tile i of the map is the i-th image added to the atlas.
+    world->atlas = scg_atlas_new(TILEMAP_TILE_SIZE * 4, TILEMAP_TILE_SIZE * 2,
+                                 0);
+    if (world->atlas == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < TILE_NUM_TYPES; i++) {
+        scg_image_t *tile = new_tile(colors[i][0], colors[i][1], i);
+        if (tile == NULL) {
+            return false;
+        }
+
+        scg_image_t *added = scg_atlas_add_image(world->atlas, tile);
+        scg_image_free(tile);
+        if (added == NULL) {
+            return false;
+        }
+    }
+
+    world->tilemap =
+        scg_tilemap_new(world->atlas, TILEMAP_MAP_WIDTH, TILEMAP_MAP_HEIGHT,
+                        TILEMAP_TILE_SIZE, TILEMAP_TILE_SIZE, 0);
+    if (world->tilemap == NULL) {
+        return false;
+    }
+
+    for (int y = 0; y < TILEMAP_MAP_HEIGHT; y++) {
+        for (int x = 0; x < TILEMAP_MAP_WIDTH; x++) {
+            scg_tilemap_set_tile(world->tilemap, x, y, terrain_at(x, y));
+        }
+    }
+
+    world->wave_time = 0.0f;
+    world->is_wave = false;
+
+    return true;
+}
+
+// Shallow water swaps between two tiles, which only re-renders the chunks
+// that hold water.
+static void update(world_t *world, float32_t delta_time) {
+    world->wave_time += delta_time;
+    if (world->wave_time < TILEMAP_WAVE_TIME) {
+        return;
+    }
+
+    world->wave_time -= TILEMAP_WAVE_TIME;
+    world->is_wave = !world->is_wave;
+
+    for (int y = 0; y < TILEMAP_MAP_HEIGHT; y++) {
+        for (int x = 0; x < TILEMAP_MAP_WIDTH; x++) {
+            if (terrain_at(x, y) == TILE_WATER && (x + y) % 3 == 0) {
+                scg_tilemap_set_tile(world->tilemap, x, y,
+                                     world->is_wave ? TILE_WATER_WAVE
+                                                    : TILE_WATER);
+            }
+        }
+    }
+}
+
+static void draw(scg_image_t *draw_target, world_t *world,
+                 float32_t elapsed_time) {
+    int map_w = TILEMAP_MAP_WIDTH * TILEMAP_TILE_SIZE;
+    int map_h = TILEMAP_MAP_HEIGHT * TILEMAP_TILE_SIZE;
+    float32_t angle = elapsed_time * TILEMAP_SCROLL_SPEED;
+    float32_t scroll_x = (float32_t)(map_w - draw_target->width) / 2.0f +
+                         TILEMAP_SCROLL_RADIUS * cosf(angle);
+    float32_t scroll_y = (float32_t)(map_h - draw_target->height) / 2.0f +
+                         TILEMAP_SCROLL_RADIUS * 0.5f * sinf(angle);
+
+    scg_image_set_blend_mode(draw_target, SCG_BLEND_MODE_NONE);
+    scg_tilemap_draw(world->tilemap, draw_target, scroll_x, scroll_y);
+}
+
+int main(int arcg, char *argv[]) {
+    scg_config_t config = scg_config_new_default();
+    config.video.title = "SCG Example: Tile Map";
+
+    scg_app_t app;
+    scg_app_init(&app, config);
+
+    world_t world;
+    if (!init(&world)) {
+        return -1;
+    }
+
+    while (scg_app_process_events(&app)) {
+        update(&world, app.delta_time);
+
+        draw(app.draw_target, &world, app.elapsed_time);
+
+        scg_app_present(&app);
+    }
+
+    scg_tilemap_free(world.tilemap);
+    scg_atlas_free(world.atlas);
+    scg_app_free(&app);
+
+    return 0;
+}
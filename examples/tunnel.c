@@ -17,13 +17,22 @@ typedef struct tunnel_t {
     scg_image_t *src_image;
 } tunnel_t;
 
-static void init(scg_app_t *app, tunnel_t *tunnel, scg_image_t *src_image) {
+static bool init(scg_app_t *app, tunnel_t *tunnel, scg_image_t *src_image) {
     int w = app->draw_target->width;
     int h = app->draw_target->height;
 
-    uint32_t *distance_buffer = malloc(w * h * sizeof(*distance_buffer));
-    uint32_t *angle_buffer = malloc(w * h * sizeof(*angle_buffer));
-    float32_t *shade_buffer = malloc(w * h * sizeof(*shade_buffer));
+    // The tables last as long as the app, so they are kept in its arena
+    // rather than allocated one by one.
+    uint32_t *distance_buffer =
+        scg_arena_alloc(app->arena, w * h * sizeof(*distance_buffer), 0);
+    uint32_t *angle_buffer =
+        scg_arena_alloc(app->arena, w * h * sizeof(*angle_buffer), 0);
+    float32_t *shade_buffer =
+        scg_arena_alloc(app->arena, w * h * sizeof(*shade_buffer), 0);
+    if (distance_buffer == NULL || angle_buffer == NULL ||
+        shade_buffer == NULL) {
+        return false;
+    }
 
     int image_w = src_image->width;
     int image_h = src_image->height;
@@ -47,6 +56,8 @@ static void init(scg_app_t *app, tunnel_t *tunnel, scg_image_t *src_image) {
     tunnel->angle_buffer = angle_buffer;
     tunnel->shade_buffer = shade_buffer;
     tunnel->src_image = src_image;
+
+    return true;
 }
 
 static void draw(scg_image_t *draw_target, tunnel_t *tunnel,
@@ -91,7 +102,9 @@ int main(int arcg, char *argv[]) {
     }
 
     tunnel_t tunnel;
-    init(&app, &tunnel, image);
+    if (!init(&app, &tunnel, image)) {
+        return -1;
+    }
 
     while (scg_app_process_events(&app)) {
         draw(app.draw_target, &tunnel, app.elapsed_time);
@@ -99,10 +112,6 @@ int main(int arcg, char *argv[]) {
         scg_app_present(&app);
     }
 
-    free(tunnel.shade_buffer);
-    free(tunnel.angle_buffer);
-    free(tunnel.distance_buffer);
-
     scg_image_free(image);
     scg_app_free(&app);
 
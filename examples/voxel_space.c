@@ -23,13 +23,16 @@ typedef struct terrain_t {
     scg_image_t *height_map;
 } terrain_t;
 
-static bool init(terrain_t *terrain, camera_t *camera) {
-    scg_image_t *color_map = scg_image_new_from_bmp("assets/color_map.bmp");
+// The maps last as long as the app, so their pixels are kept in its arena.
+static bool init(terrain_t *terrain, camera_t *camera, scg_arena_t *arena) {
+    scg_image_t *color_map =
+        scg_image_new_from_file_in_arena(arena, "assets/color_map.bmp");
     if (color_map == NULL) {
         return false;
     }
 
-    scg_image_t *height_map = scg_image_new_from_bmp("assets/height_map.bmp");
+    scg_image_t *height_map =
+        scg_image_new_from_file_in_arena(arena, "assets/height_map.bmp");
     if (height_map == NULL) {
         return false;
     }
@@ -107,7 +110,8 @@ static inline void draw_vertical_line(scg_image_t *draw_target, int x0, int y0,
     }
 }
 
-static void draw(scg_image_t *draw_target, terrain_t terrain, camera_t camera) {
+static void draw(scg_image_t *draw_target, terrain_t terrain, camera_t camera,
+                 scg_arena_t *frame_arena) {
     scg_image_clear(draw_target, SCG_COLOR_WHITE);
 
     int w = draw_target->width;
@@ -118,7 +122,11 @@ static void draw(scg_image_t *draw_target, terrain_t terrain, camera_t camera) {
     float32_t s = sinf(camera.angle);
     float32_t c = cosf(camera.angle);
 
-    float32_t ybuffer[w];
+    // The frame arena is reset once the frame is presented.
+    float32_t *ybuffer = scg_arena_alloc(frame_arena, w * sizeof(*ybuffer), 0);
+    if (ybuffer == NULL) {
+        return;
+    }
     for (int x = 0; x < w; x++) {
         ybuffer[x] = h;
     }
@@ -178,7 +186,7 @@ int main(int arcg, char *argv[]) {
 
     terrain_t terrain;
     camera_t camera;
-    bool success = init(&terrain, &camera);
+    bool success = init(&terrain, &camera, app.arena);
     if (!success) {
         return -1;
     }
@@ -219,7 +227,7 @@ int main(int arcg, char *argv[]) {
             camera.height = map_height;
         }
 
-        draw(app.draw_target, terrain, camera);
+        draw(app.draw_target, terrain, camera, app.frame_arena);
 
         scg_app_present(&app);
     }
@@ -66,6 +66,8 @@ extern float32_t scg_max_float32(float32_t val, float32_t max);
 extern int scg_round_float32(float32_t val);
 extern float32_t scg_clamp_float32(float32_t val, float32_t min, float32_t max);
 
+// In headless apps with a fixed time step this is a virtual clock that moves
+// on by the time step every frame, so runs can be repeated exactly.
 extern uint64_t scg_get_performance_counter(void);
 extern uint64_t scg_get_performance_frequency(void);
 extern float64_t scg_get_elapsed_time_secs(uint64_t end, uint64_t start);
@@ -89,6 +91,30 @@ extern int scg_sprintf(char *buf, const char *fmt, ...);
 // the formatted string. The buf argument must be free'd by the caller.
 extern int scg_asprintf(char **buf, const char *fmt, ...);
 
+// Arenas hand out memory from one fixed block by moving an offset along it,
+// and give it all back at once when reset, so allocating from them never
+// calls malloc. Allocations that do not fit fail and are counted rather
+// than growing the block. high_water_mark is the most that has been in use
+// at once since the arena was created, which shows how large it needs to
+// be. Arenas are not thread safe.
+typedef struct scg_arena_t {
+    uint8_t *memory;
+    size_t capacity;
+    size_t offset;
+    size_t high_water_mark;
+    int num_failed;
+} scg_arena_t;
+
+#define SCG_ARENA_DEFAULT_ALIGNMENT 16
+
+extern scg_arena_t *scg_arena_new(size_t capacity);
+// Alignment must be a power of two, or 0 for SCG_ARENA_DEFAULT_ALIGNMENT.
+// The memory is not cleared.
+extern void *scg_arena_alloc(scg_arena_t *arena, size_t size,
+                             size_t alignment);
+extern void scg_arena_reset(scg_arena_t *arena);
+extern void scg_arena_free(scg_arena_t *arena);
+
 typedef union scg_pixel_t {
     uint32_t packed;
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
@@ -137,14 +163,76 @@ typedef enum scg_blend_mode_t {
     SCG_BLEND_MODE_ALPHA
 } scg_blend_mode_t;
 
+// Rows of an image are pitch bytes apart, which may be more than
+// width * 4 when the image is a sub-image of a larger one.
 typedef struct scg_image_t {
     int width;
     int height;
     int pitch;
     uint32_t *pixels;
     scg_blend_mode_t blend_mode;
+    bool owns_pixels;
 } scg_image_t;
 
+// Fonts are made of fixed size bitmap glyphs. Each glyph row is
+// bytes_per_row bytes where bit j of byte b is the pixel at x + b * 8 + j,
+// and row_bounds holds the first and last (exclusive) rows of each glyph
+// with any pixel set. Smooth fonts also hold 8 bit coverage for every pixel
+// of every glyph, which is blended with the text colour when drawing.
+//
+// Code points are mapped to glyphs either through ranges sorted by code
+// point, which are binary searched, or through a two level page table
+// indexed by the high and low bits of the code point, which loaded fonts
+// build so that lookups stay constant time for large character sets. Tables
+// for constant fonts can be generated with tools/font_tables.c.
+typedef struct scg_font_range_t {
+    uint32_t first_code;
+    uint32_t last_code;
+    int first_glyph;
+} scg_font_range_t;
+
+typedef struct scg_font_t {
+    int glyph_width;
+    int glyph_height;
+    int bytes_per_row;
+    int num_glyphs;
+    const uint8_t *bitmaps;
+    const uint8_t *row_bounds;
+    const uint8_t *coverage;
+    int num_ranges;
+    const scg_font_range_t *ranges;
+    int32_t **pages;
+    int fallback_glyph;
+    bool owns_data;
+} scg_font_t;
+
+// The built-in font covering ASCII and hiragana.
+extern const scg_font_t scg_font8x8;
+
+// Loads a PSF1 or PSF2 console font, using its unicode table if it has one.
+extern scg_font_t *scg_font_new_from_psf(const char *filepath);
+// Loads a BDF font. Glyphs are placed in the font bounding box.
+extern scg_font_t *scg_font_new_from_bdf(const char *filepath);
+// Loads a file of glyphs stored back to back in the scg_font_t bitmap
+// layout, mapping them to consecutive code points from first_code.
+extern scg_font_t *scg_font_new_from_raw(const char *filepath, int glyph_width,
+                                         int glyph_height, uint32_t first_code);
+// Creates a font with the glyphs of another font scaled once up front, so
+// scaled text draws as fast as any other text. Without smoothing the scale
+// is rounded to a whole number and each pixel is expanded to a block. With
+// smoothing any scale can be used and each glyph is box filtered into
+// coverage, which is blended with the text colour.
+extern scg_font_t *scg_font_new_scaled(const scg_font_t *font,
+                                       float32_t scale, bool smooth);
+extern void scg_font_free(scg_font_t *font);
+
+// Replaces the font used by the char and string draw functions. Pass NULL to
+// restore the built-in font. The font is only read when drawing, so text can
+// be drawn from several threads as long as the font is not replaced
+// meanwhile.
+extern void scg_set_font(const scg_font_t *font);
+extern const scg_font_t *scg_get_font(void);
+
 typedef struct scg_frame_metrics_t {
     int target_fps;
     float64_t frame_time_secs;
@@ -154,6 +242,26 @@ typedef struct scg_frame_metrics_t {
 
 extern scg_image_t *scg_image_new(int width, int height);
 extern scg_image_t *scg_image_new_from_bmp(const char *filepath);
+extern scg_image_t *scg_image_new_from_png(const char *filepath);
+extern scg_image_t *scg_image_new_from_qoi(const char *filepath);
+extern scg_image_t *scg_image_new_from_tga(const char *filepath);
+// Loads a BMP, PNG, QOI or TGA image, detecting the format from the file
+// contents rather than the extension.
+extern scg_image_t *scg_image_new_from_file(const char *filepath);
+extern scg_image_t *scg_image_new_from_memory(const uint8_t *data,
+                                              size_t size);
+// Create images whose pixels are allocated from an arena, so many images can
+// be freed at once with it. Freeing the image does not free the pixels, so
+// it must not outlive the arena or be used after the arena is reset.
+extern scg_image_t *scg_image_new_in_arena(scg_arena_t *arena, int width,
+                                           int height);
+extern scg_image_t *scg_image_new_from_file_in_arena(scg_arena_t *arena,
+                                                     const char *filepath);
+// Creates an image that shares the pixels of a region of another image.
+// Freeing it does not free the shared pixels, so it must not outlive
+// the image it was created from.
+extern scg_image_t *scg_image_new_sub_image(scg_image_t *image, int x, int y,
+                                            int width, int height);
 extern void scg_image_set_blend_mode(scg_image_t *image,
                                      scg_blend_mode_t blend_mode);
 extern scg_pixel_t scg_image_get_pixel(scg_image_t *image, int x, int y);
@@ -188,24 +296,495 @@ extern void scg_image_draw_wchar(scg_image_t *image, wchar_t char_code, int x,
 extern void scg_image_draw_wstring(scg_image_t *image, const wchar_t *str,
                                    int x, int y, bool anchor_to_center,
                                    scg_pixel_t color);
+// Draws a UTF-8 string. Invalid sequences are drawn as U+FFFD.
+extern void scg_image_draw_utf8_string(scg_image_t *image, const char *str,
+                                       int x, int y, bool anchor_to_center,
+                                       scg_pixel_t color);
 extern void scg_image_draw_frame_metrics(scg_image_t *image,
                                          scg_frame_metrics_t frame_metrics);
+// Images are written straight from their rows, so sub-images save only their
+// own pixels.
 extern bool scg_image_save_to_bmp(scg_image_t *image, const char *filepath);
+extern bool scg_image_save_to_qoi(scg_image_t *image, const char *filepath);
+extern bool scg_image_save_to_png(scg_image_t *image, const char *filepath);
 extern void scg_image_free(scg_image_t *image);
 
-#define SCG__MAX_SOUNDS 16
+typedef enum scg_image_format_t {
+    SCG_IMAGE_FORMAT_BMP,
+    SCG_IMAGE_FORMAT_QOI,
+    SCG_IMAGE_FORMAT_PNG
+} scg_image_format_t;
+
+typedef struct scg_image_save_t {
+    scg_image_t *snapshot;
+    char *filepath;
+    scg_image_format_t format;
+    bool is_saved;
+    SDL_atomic_t is_done;
+    SDL_Thread *sdl_thread;
+
+    struct scg_image_save_t *next;
+} scg_image_save_t;
+
+// Copies the pixels of an image and encodes and writes the copy on a
+// background thread, so the image can be drawn to again straight away.
+extern scg_image_save_t *scg_image_save_async(scg_image_t *image,
+                                              const char *filepath,
+                                              scg_image_format_t format);
+extern bool scg_image_save_is_done(scg_image_save_t *save);
+// Waits for the file to be written and frees the save. Returns whether it
+// was written.
+extern bool scg_image_save_wait(scg_image_save_t *save);
+
+typedef enum scg_text_align_t {
+    SCG_TEXT_ALIGN_LEFT,
+    SCG_TEXT_ALIGN_CENTER,
+    SCG_TEXT_ALIGN_RIGHT
+} scg_text_align_t;
+
+typedef struct scg_text_glyph_t {
+    int x;
+    int y;
+    int glyph;
+} scg_text_glyph_t;
+
+// A text object holds a UTF-8 string laid out into a run of positioned
+// glyphs. Lines are broken at newlines and, when max_width is above zero,
+// wrapped at spaces to fit it. Each line is aligned within max_width, or
+// within the widest line when not wrapping. Setting the same string again
+// with the same font keeps the cached run, so unchanged labels are never
+// laid out twice. Glyph positions are relative to the top left of the text.
+typedef struct scg_text_t {
+    const scg_font_t *font;
+    char *str;
+    int max_width;
+    scg_text_align_t align;
+    int width;
+    int height;
+    int num_lines;
+    int num_glyphs;
+    int capacity;
+    scg_text_glyph_t *glyphs;
+} scg_text_t;
+
+extern scg_text_t *scg_text_new(const char *str, int max_width,
+                                scg_text_align_t align);
+// Lays out a new string with the current font, unless both are unchanged.
+extern bool scg_text_set(scg_text_t *text, const char *str);
+extern bool scg_text_set_layout(scg_text_t *text, int max_width,
+                                scg_text_align_t align);
+extern void scg_text_free(scg_text_t *text);
+// Measures a UTF-8 string as scg_text_new would lay it out, without keeping
+// the glyph run.
+extern void scg_measure_text(const char *str, int max_width, int *width,
+                             int *height);
+extern void scg_image_draw_text(scg_image_t *image, scg_text_t *text, int x,
+                                int y, scg_pixel_t color);
+
+// A sprite batch collects many image draws per frame and submits them in
+// one pass. Sprites are sorted by layer, then by source image so draws of
+// the same image stay together in the cache. Off-screen sprites are culled
+// before drawing. Within a layer the draw order between different images is
+// not preserved, use separate layers where overlap order matters.
+//
+// With more than one thread the destination is split into horizontal bands,
+// each drawn by its own worker. The result is identical to a single thread.
+typedef struct scg_sprite_t {
+    scg_image_t *image;
+    int x, y;
+    int layer;
+    int order;
+    scg_blend_mode_t blend_mode;
+    bool transformed;
+    float32_t angle;
+    float32_t sx, sy;
+    int min_x, min_y, max_x, max_y;
+} scg_sprite_t;
+
+struct scg_sprite_batch_t;
+
+typedef struct scg__sprite_band_t {
+    struct scg_sprite_batch_t *batch;
+    int min_y, max_y;
+    bool quit;
+
+    SDL_Thread *sdl_thread;
+    SDL_sem *sdl_start_sem;
+    SDL_sem *sdl_done_sem;
+} scg__sprite_band_t;
+
+typedef struct scg_sprite_batch_t {
+    int num_sprites;
+    int capacity;
+    scg_sprite_t *sprites;
+
+    int num_visible;
+    scg_sprite_t **visible;
+    scg_image_t *dest;
+
+    int num_bands;
+    scg__sprite_band_t *bands;
+} scg_sprite_batch_t;
+
+// Pass num_threads <= 0 to use one thread per CPU core.
+extern scg_sprite_batch_t *scg_sprite_batch_new(int capacity, int num_threads);
+extern void scg_sprite_batch_clear(scg_sprite_batch_t *batch);
+extern bool scg_sprite_batch_add(scg_sprite_batch_t *batch, scg_image_t *image,
+                                 int x, int y, int layer,
+                                 scg_blend_mode_t blend_mode);
+extern bool scg_sprite_batch_add_transformed(scg_sprite_batch_t *batch,
+                                             scg_image_t *image, int x, int y,
+                                             int layer,
+                                             scg_blend_mode_t blend_mode,
+                                             float32_t angle, float32_t sx,
+                                             float32_t sy);
+extern void scg_sprite_batch_draw(scg_sprite_batch_t *batch,
+                                  scg_image_t *dest);
+extern void scg_sprite_batch_free(scg_sprite_batch_t *batch);
+
+// A texture atlas packs many small images into one page using a skyline
+// packer. Each added image returns a sub-image of the page, which can be
+// passed to any draw function. Sub-images are owned by the atlas and are
+// freed with it.
+typedef struct scg__skyline_node_t {
+    int x, y, width;
+} scg__skyline_node_t;
+
+typedef struct scg_atlas_t {
+    scg_image_t *page;
+    int padding;
+
+    int num_nodes;
+    int nodes_capacity;
+    scg__skyline_node_t *nodes;
+
+    int num_images;
+    int images_capacity;
+    scg_image_t **images;
+} scg_atlas_t;
+
+extern scg_atlas_t *scg_atlas_new(int width, int height, int padding);
+extern scg_image_t *scg_atlas_add_image(scg_atlas_t *atlas, scg_image_t *src);
+extern scg_image_t *scg_atlas_add_image_from_bmp(scg_atlas_t *atlas,
+                                                 const char *filepath);
+extern void scg_atlas_free(scg_atlas_t *atlas);
+
+#define SCG_TILEMAP_EMPTY_TILE -1
+
+// A tile map draws a grid of tiles taken from an atlas, where tile i is the
+// i-th image added to the atlas. Atlas images larger than a tile are cropped
+// to its top left corner. Tiles are pre-rendered into chunks that are
+// only re-rendered when one of their tiles changes, so drawing a scrolling
+// map is a row copy per visible chunk. Empty tiles are fully transparent,
+// draw with SCG_BLEND_MODE_MASK to overlay a layer on another.
+typedef struct scg__tilemap_chunk_t {
+    scg_image_t *image;
+    bool dirty;
+} scg__tilemap_chunk_t;
+
+typedef struct scg_tilemap_t {
+    int width, height;
+    int tile_width, tile_height;
+    int *tiles;
+    scg_atlas_t *atlas;
+
+    int chunk_size;
+    int num_chunks_x, num_chunks_y;
+    scg__tilemap_chunk_t *chunks;
+} scg_tilemap_t;
+
+// Width and height are in tiles. Pass chunk_size <= 0 for a default size.
+extern scg_tilemap_t *scg_tilemap_new(scg_atlas_t *atlas, int width, int height,
+                                      int tile_width, int tile_height,
+                                      int chunk_size);
+extern int scg_tilemap_get_tile(scg_tilemap_t *tilemap, int x, int y);
+extern void scg_tilemap_set_tile(scg_tilemap_t *tilemap, int x, int y,
+                                 int tile);
+extern void scg_tilemap_invalidate(scg_tilemap_t *tilemap);
+// Draws the map with its top left at (-scroll_x, -scroll_y) using the blend
+// mode of dest. Scrolling is per pixel, not per tile.
+extern void scg_tilemap_draw(scg_tilemap_t *tilemap, scg_image_t *dest,
+                             float32_t scroll_x, float32_t scroll_y);
+extern void scg_tilemap_free(scg_tilemap_t *tilemap);
+
+// A run-length encoded image stores each row as pairs of counts, the number
+// of transparent pixels to skip followed by the number of opaque pixels to
+// copy. Only the opaque pixels are kept, packed one row after another.
+// Drawing one is the same as drawing the source image with
+// SCG_BLEND_MODE_MASK, but each opaque run is a single copy and transparent
+// areas are never read.
+typedef struct scg_rle_image_t {
+    int width;
+    int height;
+    int *row_runs;
+    uint16_t *runs;
+    int *row_pixels;
+    uint32_t *pixels;
+} scg_rle_image_t;
+
+extern scg_rle_image_t *scg_rle_image_new(scg_image_t *image);
+extern scg_rle_image_t *scg_rle_image_new_from_bmp(const char *filepath);
+extern void scg_image_draw_rle_image(scg_image_t *dest, scg_rle_image_t *src,
+                                     int x, int y);
+extern void scg_rle_image_free(scg_rle_image_t *image);
+
+#define SCG__AUDIO_MAX_COMMANDS 256
+#define SCG__AUDIO_MAX_EFFECTS 16
+#define SCG__REVERB_NUM_COMBS 4
+#define SCG__REVERB_NUM_ALLPASSES 2
+
+// A streamed sound reads its samples from disk on a background thread into
+// a ring buffer, which the audio thread mixes from. Ring positions count
+// the bytes written and read since the stream last restarted. The audio
+// thread restarts a stream by bumping restart_request and waits for the
+// stream thread to refill the ring and set restart_done to match.
+typedef struct scg__sound_stream_t {
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    SDL_atomic_t quit;
+
+    SDL_RWops *file;
+    const uint8_t *mapping;
+    size_t mapping_size;
+    uint32_t data_offset;
+    uint32_t data_position;
+    bool loop;
 
+    uint8_t *ring;
+    uint32_t ring_size;
+    SDL_atomic_t read_position;
+    SDL_atomic_t write_position;
+    SDL_atomic_t is_finished;
+    SDL_atomic_t restart_request;
+    SDL_atomic_t restart_done;
+} scg__sound_stream_t;
+
+// A sound holds loaded samples and can be played by any number of voices at
+// once, except for streamed sounds which play on one voice at a time.
+// Sounds must be created and freed on the thread controlling audio.
 typedef struct scg_sound_t {
-    int device_id;
+    struct scg_audio_t *audio;
     SDL_AudioSpec sdl_spec;
     uint32_t length;
     uint8_t *buffer;
-    uint32_t play_offset;
-    uint8_t *end_position;
-    bool is_playing;
+    bool owns_buffer;
+    scg__sound_stream_t *stream;
     bool loop;
+    int priority;
+
+    uint32_t last_voice;
+    struct scg_sound_t *next;
 } scg_sound_t;
 
+// Identifies one playback of a sound. Ids stay unique when their voice is
+// reused, so an id of a voice that has finished is safely ignored. Zero is
+// never a valid id.
+typedef uint32_t scg_voice_id_t;
+
+// Voice state kept by the thread controlling audio, used to hand out voices
+// and pick one to steal when they are all in use.
+typedef struct scg__voice_slot_t {
+    scg_voice_id_t id;
+    scg_sound_t *sound;
+    int priority;
+    uint64_t play_order;
+    bool allocated;
+} scg__voice_slot_t;
+
+// Voice state owned by the audio thread. The id and play offset are
+// published after each mix so other threads can follow playback. The start
+// frame is the low 32 bits of the audio clock when the voice started.
+typedef struct scg__voice_t {
+    scg_voice_id_t id;
+    scg_sound_t *sound;
+    uint32_t mix_offset;
+    float32_t volume;
+    float32_t pan;
+    float32_t pitch;
+    uint32_t mix_fraction;
+    bool loop;
+    int active_index;
+
+    SDL_atomic_t playing_id;
+    SDL_atomic_t play_offset;
+    SDL_atomic_t start_frame;
+    // Published with play_offset after each callback, for working back from
+    // where mixing stopped to the frame being heard.
+    uint64_t play_step;
+    bool play_loop;
+} scg__voice_t;
+
+typedef enum scg_filter_type_t {
+    SCG_FILTER_LOWPASS,
+    SCG_FILTER_HIGHPASS,
+    SCG_FILTER_BANDPASS,
+    SCG_FILTER_NOTCH,
+    SCG_FILTER_PEAK,
+    SCG_FILTER_LOW_SHELF,
+    SCG_FILTER_HIGH_SHELF
+} scg_filter_type_t;
+
+typedef enum scg_effect_type_t {
+    SCG_EFFECT_FILTER,
+    SCG_EFFECT_DELAY,
+    SCG_EFFECT_REVERB,
+    SCG_EFFECT_COMPRESSOR
+} scg_effect_type_t;
+
+// Transposed direct form II biquad, with the state of both channels.
+typedef struct scg__biquad_t {
+    float32_t b0, b1, b2, a1, a2;
+    float32_t z1[2];
+    float32_t z2[2];
+} scg__biquad_t;
+
+typedef struct scg__delay_t {
+    float32_t *buffer;
+    int length;
+    int position;
+    float32_t feedback;
+} scg__delay_t;
+
+typedef struct scg__delay_line_t {
+    float32_t *buffer;
+    int length;
+    int position;
+    float32_t filter_state;
+} scg__delay_line_t;
+
+// Parallel damped combs feeding allpasses in series for each channel, with
+// the right channel's lines slightly longer to widen the image.
+typedef struct scg__reverb_t {
+    float32_t *buffer;
+    scg__delay_line_t combs[2][SCG__REVERB_NUM_COMBS];
+    scg__delay_line_t allpasses[2][SCG__REVERB_NUM_ALLPASSES];
+    float32_t feedback;
+    float32_t damping;
+} scg__reverb_t;
+
+typedef struct scg__compressor_t {
+    float32_t threshold_db;
+    float32_t slope;
+    float32_t attack;
+    float32_t release;
+    float32_t makeup;
+    float32_t envelope;
+} scg__compressor_t;
+
+// An effect on the master bus. All of its state is allocated when it is
+// created and it is only touched by the audio thread once added, so
+// effects can be added and removed while audio plays. Delays and reverbs
+// are mixed with the dry signal by their wet level; filters and
+// compressors replace it.
+typedef struct scg_effect_t {
+    scg_effect_type_t type;
+    struct scg_audio_t *audio;
+    float32_t wet;
+    bool is_added;
+    union {
+        scg__biquad_t biquad;
+        scg__delay_t delay;
+        scg__reverb_t reverb;
+        scg__compressor_t compressor;
+    } state;
+
+    struct scg_effect_t *next;
+} scg_effect_t;
+
+typedef enum scg__audio_command_type_t {
+    SCG__AUDIO_COMMAND_PLAY,
+    SCG__AUDIO_COMMAND_STOP,
+    SCG__AUDIO_COMMAND_STOP_SOUND,
+    SCG__AUDIO_COMMAND_SET_VOLUME,
+    SCG__AUDIO_COMMAND_SET_PAN,
+    SCG__AUDIO_COMMAND_SET_PITCH,
+    SCG__AUDIO_COMMAND_SET_MASTER_VOLUME,
+    SCG__AUDIO_COMMAND_ADD_EFFECT,
+    SCG__AUDIO_COMMAND_REMOVE_EFFECT
+} scg__audio_command_type_t;
+
+typedef struct scg__audio_command_t {
+    scg__audio_command_type_t type;
+    scg_voice_id_t voice;
+    scg_sound_t *sound;
+    scg_effect_t *effect;
+    float32_t value;
+    bool loop;
+} scg__audio_command_t;
+
+// How voices played at another pitch are resampled while mixing.
+typedef enum scg_audio_interpolation_t {
+    SCG_AUDIO_INTERPOLATION_LINEAR,
+    SCG_AUDIO_INTERPOLATION_CUBIC
+} scg_audio_interpolation_t;
+
+#define SCG_AUDIO_FFT_SIZE 1024
+#define SCG_AUDIO_SPECTRUM_SIZE (SCG_AUDIO_FFT_SIZE / 2)
+#define SCG_AUDIO_NUM_BANDS 16
+#define SCG__AUDIO_FLUX_HISTORY 43
+
+// Analysis of the last window of the mixed output. The spectrum holds the
+// amplitude of each frequency bin, where a full scale sine reads about 1,
+// and the bands sum it over log spaced ranges from 40 Hz to 16 kHz. Flux is
+// how much the spectrum rose since the window before, and num_onsets counts
+// sudden rises, such as beats. Time is where the window ends on the clock
+// of mixed audio.
+typedef struct scg_audio_analysis_t {
+    float64_t time;
+    float32_t level;
+    float32_t spectrum[SCG_AUDIO_SPECTRUM_SIZE];
+    float32_t bands[SCG_AUDIO_NUM_BANDS];
+    float32_t flux;
+    uint32_t num_onsets;
+    bool is_onset;
+} scg_audio_analysis_t;
+
+// Analysis state owned by the audio thread, allocated once. Every half
+// window of output it runs a real FFT, done as a complex FFT of half the
+// size, and publishes the result under a sequence that is odd while it is
+// being written.
+typedef struct scg__audio_analyser_t {
+    float32_t window[SCG_AUDIO_FFT_SIZE];
+    float32_t input[SCG_AUDIO_FFT_SIZE];
+    int input_position;
+    int hop_position;
+    float32_t hop_power;
+    uint64_t num_frames;
+    int frequency;
+
+    float32_t real[SCG_AUDIO_FFT_SIZE / 2];
+    float32_t imag[SCG_AUDIO_FFT_SIZE / 2];
+    float32_t twiddle_real[SCG_AUDIO_FFT_SIZE / 2];
+    float32_t twiddle_imag[SCG_AUDIO_FFT_SIZE / 2];
+    uint16_t bit_reverse[SCG_AUDIO_FFT_SIZE / 2];
+    int band_bins[SCG_AUDIO_NUM_BANDS + 1];
+
+    float32_t previous_spectrum[SCG_AUDIO_SPECTRUM_SIZE];
+    float32_t flux_history[SCG__AUDIO_FLUX_HISTORY];
+    int flux_position;
+    int min_onset_hops;
+    int hops_since_onset;
+
+    scg_audio_analysis_t analysis;
+    SDL_atomic_t sequence;
+    scg_audio_analysis_t published;
+} scg__audio_analyser_t;
+
+// Sounds are mixed on the SDL audio thread whenever the device needs more
+// samples, so audio keeps playing however long a frame takes. Every voice is
+// added into a 32 bit mix buffer with its own gain and pan, and the sum is
+// clipped to 16 bits once at the end. Commands are passed through a single
+// producer, single consumer ring, so sounds must only be controlled from one
+// thread, normally the main thread.
+//
+// Voices come from a pool allocated up front. Free voices are kept in a
+// list; when none are free the voice with the lowest priority, then the
+// oldest, is stolen. The audio thread returns finished voices through a
+// second ring and only walks the voices that are playing.
+//
+// The mix can pass through a chain of effects before it is clipped, in
+// which case it is processed as floats in blocks the size of the mix
+// buffer.
 typedef struct scg_audio_t {
     SDL_AudioDeviceID device_id;
     int frequency;
@@ -213,17 +792,311 @@ typedef struct scg_audio_t {
     uint16_t num_samples;
     int bytes_per_sample;
     int latency_sample_count;
-    uint32_t buffer_size;
-    uint8_t *buffer;
-
-    scg_sound_t *sounds[SCG__MAX_SOUNDS]; // TODO: use linked list for sounds?
-    int num_sounds;
+    scg_audio_interpolation_t interpolation;
+
+    // Offline audio has no device. It is mixed on the controlling thread as
+    // the app's clock advances, and optionally written to a WAV file.
+    bool is_offline;
+    SDL_RWops *output;
+    uint32_t output_length;
+    int16_t *render_buffer;
+    float64_t render_frames_due;
+
+    // Published by the audio thread in two short windows, the clock before
+    // each callback mixes and where the voices stopped once it is done,
+    // stamped with voice_frames. The sequence is odd only while a window is
+    // open, so readers can retry until they see a consistent clock and
+    // voice state without waiting for the mix.
+    SDL_atomic_t clock_sequence;
+    uint64_t clock_frames;
+    uint64_t clock_counter;
+    int clock_callback_frames;
+    uint64_t voice_frames;
+
+    scg_sound_t *sounds;
+    scg_effect_t *effect_list;
+    int num_voices;
+
+    scg__audio_command_t commands[SCG__AUDIO_MAX_COMMANDS];
+    SDL_atomic_t command_read;
+    SDL_atomic_t command_write;
+
+    scg_voice_id_t *finished_voices;
+    int finished_voices_capacity;
+    SDL_atomic_t finished_read;
+    SDL_atomic_t finished_write;
+
+    // Only used by the thread controlling audio.
+    scg__voice_slot_t *voice_slots;
+    int *free_voices;
+    int num_free_voices;
+    uint64_t play_count;
+    uint64_t last_audible_frame;
+    uint32_t last_num_onsets;
+
+    // Only used by the audio thread.
+    scg__voice_t *voices;
+    int *active_voices;
+    int num_active_voices;
+    float32_t volume;
+    int32_t *mix_buffer;
+    int mix_buffer_frames;
+    uint64_t mixed_frames;
+    scg_effect_t *effects[SCG__AUDIO_MAX_EFFECTS];
+    int num_effects;
+    float32_t *effect_buffer;
+    scg__audio_analyser_t *analyser;
 } scg_audio_t;
 
+// Loads a WAV file and converts it to the format, rate and channel count of
+// the audio device, so it can be mixed without further conversion.
 extern scg_sound_t *scg_sound_new_from_wav(scg_audio_t *audio,
                                            const char *filepath, bool loop);
-extern void scg_sound_play(scg_sound_t *sound);
+// Loads a WAV file like scg_sound_new_from_wav, keeping the converted
+// samples in an arena. The sound must not outlive the arena.
+extern scg_sound_t *scg_sound_new_from_wav_in_arena(scg_audio_t *audio,
+                                                    scg_arena_t *arena,
+                                                    const char *filepath,
+                                                    bool loop);
+// Opens a WAV file to be streamed from disk, so long tracks start at once
+// and use a fixed amount of memory. With memory_map the file is mapped
+// rather than read, where supported. The file must already be 16 bit PCM
+// at the rate and channel count of the audio device.
+extern scg_sound_t *scg_sound_new_stream_from_wav(scg_audio_t *audio,
+                                                  const char *filepath,
+                                                  bool loop, bool memory_map);
+// Plays a sound on a new voice. Returns 0 when every voice is in use by
+// sounds of higher priority.
+extern scg_voice_id_t scg_sound_play(scg_sound_t *sound);
+extern scg_voice_id_t scg_sound_play_with(scg_sound_t *sound,
+                                          float32_t volume, float32_t pan);
+// Stops every voice playing the sound.
+extern void scg_sound_stop(scg_sound_t *sound);
+// Voices of higher priority steal from those of lower priority when there
+// are no free voices. The default priority is 0.
+extern void scg_sound_set_priority(scg_sound_t *sound, int priority);
+// Returns the position of the voice that last played the sound, from 0 to 1.
 extern float32_t scg_sound_get_position(scg_sound_t *sound);
+extern void scg_sound_free(scg_sound_t *sound);
+
+extern void scg_voice_stop(scg_audio_t *audio, scg_voice_id_t voice);
+// Sets the volume of a voice from 0 to 1.
+extern void scg_voice_set_volume(scg_audio_t *audio, scg_voice_id_t voice,
+                                 float32_t volume);
+// Sets the balance of a voice from -1 (left) to 1 (right).
+extern void scg_voice_set_pan(scg_audio_t *audio, scg_voice_id_t voice,
+                              float32_t pan);
+// Sets the playback rate of a voice, where 2 plays an octave up and 0.5 an
+// octave down. Streamed sounds always play at their own rate.
+extern void scg_voice_set_pitch(scg_audio_t *audio, scg_voice_id_t voice,
+                                float32_t pitch);
+extern bool scg_voice_is_playing(scg_audio_t *audio, scg_voice_id_t voice);
+// Returns the position of the voice from 0 to 1 at the sample being heard,
+// rather than the one last mixed.
+extern float32_t scg_voice_get_position(scg_audio_t *audio,
+                                        scg_voice_id_t voice);
+// Returns the seconds of the voice that have been heard, or 0 if it is not
+// playing.
+extern float64_t scg_voice_get_time(scg_audio_t *audio, scg_voice_id_t voice);
+// Returns the seconds of audio heard since the device started. The clock
+// allows for the samples queued ahead of the device and moves smoothly
+// between callbacks, so visuals can be drawn in time with what is heard.
+extern float64_t scg_audio_get_time(scg_audio_t *audio);
+// Sets the master volume of all voices from 0 to 1.
+extern void scg_audio_set_volume(scg_audio_t *audio, float32_t volume);
+// Filters the master bus. Frequencies are in Hz; gain_db is only used by
+// peak and shelf filters.
+extern scg_effect_t *scg_effect_new_filter(scg_audio_t *audio,
+                                           scg_filter_type_t type,
+                                           float32_t frequency, float32_t q,
+                                           float32_t gain_db);
+// Echoes the master bus after a delay of up to a few seconds. Feedback and
+// wet are from 0 to 1.
+extern scg_effect_t *scg_effect_new_delay(scg_audio_t *audio,
+                                          float32_t delay_secs,
+                                          float32_t feedback, float32_t wet);
+// Adds a room reverb to the master bus. Room size, damping and wet are from
+// 0 to 1.
+extern scg_effect_t *scg_effect_new_reverb(scg_audio_t *audio,
+                                           float32_t room_size,
+                                           float32_t damping, float32_t wet);
+// Compresses the master bus above a threshold, with the left and right
+// channels linked.
+extern scg_effect_t *
+scg_effect_new_compressor(scg_audio_t *audio, float32_t threshold_db,
+                          float32_t ratio, float32_t attack_ms,
+                          float32_t release_ms, float32_t makeup_db);
+// A compressor with an infinite ratio and a fast attack, which holds the
+// master bus under a ceiling.
+extern scg_effect_t *scg_effect_new_limiter(scg_audio_t *audio,
+                                            float32_t ceiling_db,
+                                            float32_t release_ms);
+// Appends an effect to the end of the master bus chain.
+extern void scg_audio_add_effect(scg_audio_t *audio, scg_effect_t *effect);
+extern void scg_audio_remove_effect(scg_audio_t *audio, scg_effect_t *effect);
+extern void scg_effect_free(scg_effect_t *effect);
+// Copies the latest analysis of the mixed output, with is_onset set if there
+// has been an onset since the last call. Returns false unless
+// config.audio.analysis was set.
+extern bool scg_audio_get_analysis(scg_audio_t *audio,
+                                   scg_audio_analysis_t *analysis);
+// Mixes the next frames of offline audio and appends them to the output
+// file, if there is one. The app calls this each frame for the time that
+// has passed, so it is only needed to render audio without an app.
+extern void scg_audio_render(scg_audio_t *audio, int num_frames);
+
+// A pack is a single file of images, sounds and fonts decoded ahead of time
+// by tools/pack.c, with a table of contents sorted by name. It is memory
+// mapped where supported, so opening it takes the same time whatever its
+// size and assets are used straight from the mapping.
+typedef struct scg_pack_t {
+    uint8_t *data;
+    size_t size;
+    bool is_mapped;
+    int num_entries;
+    const uint8_t *entries;
+    scg_font_t **fonts;
+} scg_pack_t;
+
+extern scg_pack_t *scg_pack_new_from_file(const char *filepath);
+// Creates an image whose pixels are in the pack, with no copying or
+// decoding, so it must not outlive the pack. The pixels can be drawn to,
+// but changes are never written back to the file.
+extern scg_image_t *scg_image_new_from_pack(scg_pack_t *pack,
+                                            const char *name);
+// Creates a sound that plays straight from the pack if it was packed at the
+// rate of the audio device, or from a converted copy otherwise. The sound
+// must be freed before the pack.
+extern scg_sound_t *scg_sound_new_from_pack(scg_audio_t *audio,
+                                            scg_pack_t *pack, const char *name,
+                                            bool loop);
+// Returns a font whose glyphs are in the pack. The font belongs to the pack
+// and is freed with it.
+extern const scg_font_t *scg_pack_get_font(scg_pack_t *pack,
+                                           const char *name);
+extern void scg_pack_free(scg_pack_t *pack);
+
+typedef enum scg_asset_state_t {
+    SCG_ASSET_STATE_LOADING,
+    SCG_ASSET_STATE_READY,
+    SCG_ASSET_STATE_FAILED
+} scg_asset_state_t;
+
+struct scg_asset_loader_t;
+
+typedef struct scg_asset_t {
+    struct scg_asset_loader_t *loader;
+    char *filepath;
+    bool is_sound;
+    // Set by the worker once it has decoded the asset.
+    SDL_atomic_t is_decoded;
+    scg_asset_state_t state;
+    bool is_claimed;
+
+    scg_image_t *image;
+    scg_sound_t *sound;
+    uint8_t *sound_buffer;
+    uint32_t sound_length;
+
+    struct scg_asset_t *next_queued;
+    struct scg_asset_t *next;
+} scg_asset_t;
+
+// Loads images and sounds on a pool of worker threads, so startup scales
+// with the number of cores and assets can be streamed in while frames are
+// drawn.
+typedef struct scg_asset_loader_t {
+    scg_audio_t *audio;
+    int num_threads;
+    SDL_Thread **sdl_threads;
+    SDL_mutex *sdl_mutex;
+    SDL_cond *sdl_decoded_cond;
+    SDL_sem *sdl_work_sem;
+    bool quit;
+
+    scg_asset_t *queue_head;
+    scg_asset_t *queue_tail;
+    scg_asset_t *assets;
+    SDL_atomic_t num_queued;
+    SDL_atomic_t num_decoded;
+} scg_asset_loader_t;
+
+// Pass num_threads <= 0 to use one thread per CPU core. Audio is only needed
+// to load sounds and may be NULL.
+extern scg_asset_loader_t *scg_asset_loader_new(scg_audio_t *audio,
+                                                int num_threads);
+// Returns the fraction of the assets queued so far that have been decoded,
+// from 0 to 1.
+extern float32_t scg_asset_loader_get_progress(scg_asset_loader_t *loader);
+// Waits for the workers to finish the assets they are decoding, then frees
+// every asset handle along with the images and sounds that were never
+// taken from them.
+extern void scg_asset_loader_free(scg_asset_loader_t *loader);
+// Queues a WAV sound or a BMP, PNG, QOI or TGA image to be decoded by the
+// workers. Returns a handle that belongs to the loader and is polled from
+// the main thread.
+extern scg_asset_t *scg_asset_load_async(scg_asset_loader_t *loader,
+                                         const char *filepath);
+// Returns the state of an asset without blocking. Sounds are added to the
+// audio device here once decoded, so call it from the main thread.
+extern scg_asset_state_t scg_asset_get_state(scg_asset_t *asset);
+// Blocks until an asset has loaded or failed.
+extern scg_asset_state_t scg_asset_wait(scg_asset_t *asset);
+// Returns the loaded image or sound, which then belongs to the caller, or
+// NULL while it is loading or if it failed.
+extern scg_image_t *scg_asset_get_image(scg_asset_t *asset);
+extern scg_sound_t *scg_asset_get_sound(scg_asset_t *asset);
+
+typedef struct scg__asset_watch_t {
+    char *filepath;
+    const char *filename;
+    int watch_descriptor;
+    scg_image_t *image;
+    scg_sound_t *sound;
+
+    // Decoded by the watcher thread and swapped in by
+    // scg_asset_watcher_update.
+    bool is_reloaded;
+    scg_image_t *reloaded_image;
+    uint8_t *reloaded_buffer;
+    uint32_t reloaded_length;
+} scg__asset_watch_t;
+
+// Watches the files that images and sounds were loaded from and reloads them
+// when they change, so assets can be tuned without restarting. Changed files
+// are decoded on a background thread and swapped into the existing handles
+// by scg_asset_watcher_update. Only Linux is supported, through inotify,
+// elsewhere nothing is ever reloaded.
+typedef struct scg_asset_watcher_t {
+    scg_audio_t *audio;
+    int inotify_fd;
+    SDL_Thread *sdl_thread;
+    SDL_mutex *sdl_mutex;
+    SDL_atomic_t quit;
+
+    int num_watches;
+    int capacity;
+    scg__asset_watch_t **watches;
+} scg_asset_watcher_t;
+
+// Audio is only needed to reload sounds and may be NULL.
+extern scg_asset_watcher_t *scg_asset_watcher_new(scg_audio_t *audio);
+// Reloads an image from a BMP, PNG, QOI or TGA file when it changes. The
+// new pixels are copied over the old ones, so sub-images of the image see
+// them, but a file whose size changed is not reloaded. Anything built from
+// the pixels, such as RLE images and tile map chunks, is not refreshed.
+extern bool scg_asset_watcher_add_image(scg_asset_watcher_t *watcher,
+                                        scg_image_t *image,
+                                        const char *filepath);
+// Reloads a sound from a WAV file when it changes. Voices playing it carry
+// on from the same offset, or stop if the new sound is shorter.
+extern bool scg_asset_watcher_add_sound(scg_asset_watcher_t *watcher,
+                                        scg_sound_t *sound,
+                                        const char *filepath);
+// Swaps the assets reloaded since the last call into their handles. Call it
+// once per frame, before drawing. Returns the number of assets swapped.
+extern int scg_asset_watcher_update(scg_asset_watcher_t *watcher);
+extern void scg_asset_watcher_free(scg_asset_watcher_t *watcher);
 
 typedef enum scg_key_code_t {
     SCG_KEY_UP = SDL_SCANCODE_UP,
@@ -235,7 +1108,9 @@ typedef enum scg_key_code_t {
     SCG_KEY_Z = SDL_SCANCODE_Z,
     SCG_KEY_P = SDL_SCANCODE_P,
     SCG_KEY_SPACE = SDL_SCANCODE_SPACE,
-    SCG_KEY_ESCAPE = SDL_SCANCODE_ESCAPE
+    SCG_KEY_ESCAPE = SDL_SCANCODE_ESCAPE,
+    SCG_KEY_F12 = SDL_SCANCODE_F12,
+    SCG_KEY_NONE = SDL_SCANCODE_UNKNOWN
 } scg_key_code_t;
 
 typedef struct scg_keyboard_t {
@@ -277,16 +1152,43 @@ typedef struct scg_config_t {
         bool vsync;
         bool lock_fps;
         bool show_frame_metrics;
+        scg_image_format_t screenshot_format;
+        // Headless apps render to the draw target without a window, and mix
+        // audio offline. They stop after num_frames frames when it is not
+        // 0, saving the last frame to output_path if it is set, as PNG, QOI
+        // or BMP by its extension. Setting SCG_HEADLESS_FRAMES and
+        // SCG_HEADLESS_OUTPUT in the environment runs any app this way.
+        bool headless;
+        int num_frames;
+        const char *output_path;
+        // Moves the clock on by this many seconds every frame rather than
+        // by the time that has really passed. 0 uses the real time.
+        float32_t fixed_delta_time;
     } video;
 
     struct {
         bool hide_mouse_cursor;
+        // Saves the draw target to the working directory when pressed.
+        // SCG_KEY_NONE turns screenshots off.
+        scg_key_code_t screenshot_key;
     } input;
 
     struct {
         bool enabled;
         int volume;
+        int num_voices;
+        scg_audio_interpolation_t interpolation;
+        bool offline;
+        const char *output_path;
+        bool analysis;
     } audio;
+
+    struct {
+        // Size in bytes of the arena that is reset after every frame.
+        size_t frame_arena_size;
+        // Size in bytes of the arena that lasts until the app is freed.
+        size_t arena_size;
+    } memory;
 } scg_config_t;
 
 extern scg_config_t scg_config_new_default(void);
@@ -318,6 +1220,17 @@ typedef struct scg_app_t {
 
     uint64_t delta_time_counter;
     scg__screen_t *screen;
+
+    int num_screenshots;
+    scg_image_save_t *screenshots;
+
+    int frame_index;
+    uint64_t render_start_counter;
+
+    // Memory for the frame being drawn, reset by scg_app_present.
+    scg_arena_t *frame_arena;
+    // Memory for images, sounds and tables that live as long as the app.
+    scg_arena_t *arena;
 } scg_app_t;
 
 extern void scg_app_init(scg_app_t *app, scg_config_t config);
@@ -387,34 +1300,99 @@ extern void scg_tween_resume(scg_tween_t *tween, float32_t current_time);
 
 #ifdef SCG_IMPLEMENTATION
 
+#include <limits.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCG__SSE2
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SCG__MMAP
+#endif
+
+#if defined(__linux__)
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#define SCG__INOTIFY
+#endif
 
 #define SCG__DEFAULT_REFRESH_RATE 60
+#define SCG__DEFAULT_FRAME_ARENA_SIZE (1024 * 1024)
+#define SCG__DEFAULT_ARENA_SIZE (16 * 1024 * 1024)
 
-#define SCG__FONT_NUM_CHARS 128
-#define SCG__FONT_CHAR_CODE_START 0
-#define SCG__FONT_CHAR_CODE_END 127
 #define SCG__FONT_CHAR_CODE_SPACE 32
 #define SCG__FONT_CHAR_CODE_QUESTION_MARK 63
-#define SCG__FONT_HIRAGANA_NUM_CHARS 96
-#define SCG__FONT_HIRAGANA_CHAR_CODE_START 0x3040
-#define SCG__FONT_HIRAGANA_CHAR_CODE_END 0x309F
+#define SCG__FONT_CHAR_CODE_REPLACEMENT 0xFFFD
+#define SCG__FONT_NUM_PAGES 0x1100
+#define SCG__FONT_PAGE_SIZE 256
 
 #define SCG__IMAGE_PIXEL_FORMAT SDL_PIXELFORMAT_ARGB8888
+#define SCG__IMAGE_MAX_SIZE 16384
+// Pixels allocated from arenas start on a cache line.
+#define SCG__IMAGE_ARENA_ALIGNMENT 64
 
-#define SCG__MAX_VOLUME SDL_MIX_MAXVOLUME
+#define SCG__INFLATE_FAST_BITS 9
+#define SCG__INFLATE_FAST_MASK ((1 << SCG__INFLATE_FAST_BITS) - 1)
+#define SCG__INFLATE_MAX_SYMBOLS 288
 
-static const char scg__base64_table[64];
-static const char *scg__font8x8_data;
-static const char *scg__font8x8_hiragana_data;
+#define SCG__SPRITE_BATCH_MAX_THREADS 16
 
-static char scg__font8x8[SCG__FONT_NUM_CHARS * SCG_FONT_SIZE];
-static char scg__font8x8_hiragana[SCG__FONT_HIRAGANA_NUM_CHARS * SCG_FONT_SIZE];
+#define SCG__TILEMAP_DEFAULT_CHUNK_SIZE 16
 
-static void scg__decode_font_data(char *out, size_t out_length,
-                                  const char *data);
+#define scg__image_row(IMAGE, Y)                                               \
+    ((uint32_t *)((uint8_t *)(IMAGE)->pixels + (Y) * (IMAGE)->pitch))
+
+#define SCG__MAX_VOLUME SDL_MIX_MAXVOLUME
+#define SCG__AUDIO_DEFAULT_NUM_VOICES 64
+#define SCG__AUDIO_MAX_VOICES 0xFFFF
+#define SCG__SOUND_STREAM_BUFFER_MS 500
+#define SCG__SOUND_STREAM_POLL_MS 10
+#define SCG__AUDIO_MIN_PITCH 0.0625f
+#define SCG__AUDIO_MAX_PITCH 16.0f
+#define SCG__RESAMPLER_TAPS 32
+#define SCG__RESAMPLER_PHASE_BITS 8
+#define SCG__RESAMPLER_PHASES (1 << SCG__RESAMPLER_PHASE_BITS)
+
+#define SCG__PACK_MAGIC "SCGPACK"
+#define SCG__PACK_VERSION 1
+#define SCG__PACK_HEADER_SIZE 32
+#define SCG__PACK_ENTRY_SIZE 96
+#define SCG__PACK_NAME_SIZE 56
+#define SCG__PACK_ALIGNMENT 64
+#define SCG__PACK_ENTRY_IMAGE 1
+#define SCG__PACK_ENTRY_SOUND 2
+#define SCG__PACK_ENTRY_FONT 3
+
+#define SCG__ASSET_LOADER_MAX_THREADS 16
+#define SCG__ASSET_WATCHER_POLL_MS 100
+
+// Every possible glyph row byte mapped to the spans of set pixels it
+// contains.
+typedef struct scg__glyph_row_spans_t {
+    uint8_t num_spans;
+    uint8_t starts[SCG_FONT_SIZE / 2];
+    uint8_t lengths[SCG_FONT_SIZE / 2];
+} scg__glyph_row_spans_t;
+
+static const scg__glyph_row_spans_t scg__glyph_row_spans[256];
+
+static const scg_font_t *scg__font = &scg_font8x8;
+
+static bool scg__is_clock_virtual = false;
+static uint64_t scg__virtual_counter = 0;
 
 static scg__screen_t *scg__screen_new(scg_image_t *draw_target,
                                       const char *title, int scale,
@@ -431,8 +1409,17 @@ static scg_mouse_t *scg__mouse_new(void);
 static void scg__mouse_update(scg_mouse_t *mouse, int w, int h, int win_w,
                               int win_h);
 
-static scg_audio_t *scg__audio_new();
-static void scg__audio_update(scg_audio_t *audio);
+static uint8_t *scg__read_file(const char *filepath, size_t *size);
+
+static scg_audio_t *scg__audio_new(const scg_config_t *config);
+static void scg__audio_send_command(scg_audio_t *audio,
+                                    scg__audio_command_t command);
+static void scg__audio_process_commands(scg_audio_t *audio);
+static void scg__audio_stop_voice(scg_audio_t *audio, scg__voice_t *voice);
+static void scg__audio_lock(scg_audio_t *audio);
+static void scg__audio_unlock(scg_audio_t *audio);
+static bool scg__audio_write_wav_header(scg_audio_t *audio);
+static void scg__audio_render_time(scg_audio_t *audio, float64_t seconds);
 static void scg__audio_free(scg_audio_t *audio);
 
 //
@@ -489,6 +1476,10 @@ float32_t scg_clamp_float32(float32_t val, float32_t min, float32_t max) {
 //
 
 Uint64 scg_get_performance_counter(void) {
+    if (scg__is_clock_virtual) {
+        return scg__virtual_counter;
+    }
+
     return SDL_GetPerformanceCounter();
 }
 
@@ -585,6 +1576,90 @@ int scg_asprintf(char **buf, const char *fmt, ...) {
     return size;
 }
 
+//
+// scg_arena_new implementation
+//
+
+scg_arena_t *scg_arena_new(size_t capacity) {
+    scg_arena_t *arena = malloc(sizeof(*arena));
+    if (arena == NULL) {
+        scg_log_error("Failed to allocate memory for arena");
+
+        return NULL;
+    }
+
+    // Pages of the block are only touched once they are handed out, so a
+    // generous capacity costs little until it is used.
+    arena->memory = NULL;
+    if (capacity > 0) {
+        arena->memory = malloc(capacity);
+        if (arena->memory == NULL) {
+            scg_log_errorf("Failed to allocate %zu bytes for arena", capacity);
+
+            free(arena);
+            return NULL;
+        }
+    }
+
+    arena->capacity = capacity;
+    arena->offset = 0;
+    arena->high_water_mark = 0;
+    arena->num_failed = 0;
+
+    return arena;
+}
+
+//
+// scg_arena_alloc implementation
+//
+
+void *scg_arena_alloc(scg_arena_t *arena, size_t size, size_t alignment) {
+    if (alignment == 0) {
+        alignment = SCG_ARENA_DEFAULT_ALIGNMENT;
+    }
+
+    // Align the address rather than the offset, as the block itself is
+    // only aligned as far as malloc guarantees.
+    uintptr_t base = (uintptr_t)arena->memory;
+    uintptr_t start =
+        (base + arena->offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t offset = (size_t)(start - base);
+
+    if (arena->memory == NULL || (alignment & (alignment - 1)) != 0 ||
+        offset > arena->capacity || size > arena->capacity - offset) {
+        scg_log_errorf("Failed to allocate %zu bytes from arena. "
+                       "%zu of %zu bytes in use",
+                       size, arena->offset, arena->capacity);
+        arena->num_failed++;
+
+        return NULL;
+    }
+
+    arena->offset = offset + size;
+    if (arena->offset > arena->high_water_mark) {
+        arena->high_water_mark = arena->offset;
+    }
+
+    return arena->memory + offset;
+}
+
+//
+// scg_arena_reset implementation
+//
+
+void scg_arena_reset(scg_arena_t *arena) {
+    arena->offset = 0;
+}
+
+//
+// scg_arena_free implementation
+//
+
+void scg_arena_free(scg_arena_t *arena) {
+    free(arena->memory);
+    free(arena);
+}
+
 //
 // scg_pixel_lerp_rgb implementation
 //
@@ -625,1658 +1700,10060 @@ scg_image_t *scg_image_new(int width, int height) {
     image->pitch = width * sizeof(*pixels);
     image->pixels = pixels;
     image->blend_mode = SCG_BLEND_MODE_NONE;
+    image->owns_pixels = true;
 
     return image;
 }
 
-//
-// scg_image_new_from_bmp implementation
-//
-
-scg_image_t *scg_image_new_from_bmp(const char *filepath) {
-    SDL_Surface *surface = SDL_LoadBMP(filepath);
-    if (surface == NULL) {
-        scg_log_errorf("Failed to load image file at %s. %s", filepath,
-                       SDL_GetError());
+// Allocates the pixels from the arena when one is given, otherwise with
+// malloc. The struct is allocated first, as arena space can not be given
+// back if it fails.
+static scg_image_t *scg__image_alloc(int width, int height, const char *name,
+                                     scg_arena_t *arena) {
+    if (width <= 0 || height <= 0 || width > SCG__IMAGE_MAX_SIZE ||
+        height > SCG__IMAGE_MAX_SIZE) {
+        scg_log_errorf("Image %s has unsupported size %dx%d", name, width,
+                       height);
 
         return NULL;
     }
 
-    // Convert the surface to RGBA32 pixel format.
-    SDL_PixelFormat *pixel_format = SDL_AllocFormat(SCG__IMAGE_PIXEL_FORMAT);
-    if (pixel_format == NULL) {
-        scg_log_errorf(
-            "Failed to allocate pixel format for image file at %s. %s",
-            filepath, SDL_GetError());
+    scg_image_t *image = malloc(sizeof(*image));
+    if (image == NULL) {
+        scg_log_error("Failed to allocate memory for image");
 
-        SDL_FreeSurface(surface);
         return NULL;
     }
-    SDL_Surface *converted_surface =
-        SDL_ConvertSurface(surface, pixel_format, 0);
-    if (converted_surface == NULL) {
-        scg_log_errorf("Failed to convert surface for image file at %s. %s",
-                       filepath, SDL_GetError());
 
-        SDL_FreeFormat(pixel_format);
-        SDL_FreeSurface(surface);
+    // The decoders write every pixel, so the buffer is not cleared.
+    size_t size = (size_t)width * height * sizeof(*image->pixels);
+    uint32_t *pixels =
+        arena != NULL
+            ? scg_arena_alloc(arena, size, SCG__IMAGE_ARENA_ALIGNMENT)
+            : malloc(size);
+    if (pixels == NULL) {
+        scg_log_errorf("Failed to allocate memory for image %s", name);
+
+        free(image);
         return NULL;
     }
 
-    // We no longer need the original surface.
-    SDL_FreeFormat(pixel_format);
-    SDL_FreeSurface(surface);
-
-    int surface_w = converted_surface->w;
-    int surface_h = converted_surface->h;
-    int surface_pitch = converted_surface->pitch;
-    uint32_t *surface_pixels = (uint32_t *)converted_surface->pixels;
+    image->width = width;
+    image->height = height;
+    image->pitch = width * sizeof(*pixels);
+    image->pixels = pixels;
+    image->blend_mode = SCG_BLEND_MODE_NONE;
+    image->owns_pixels = arena == NULL;
 
-    // Allocate new pixel buffer and copy over the converted surface pixel data.
-    uint32_t *pixels = malloc(surface_pitch * surface_h);
-    if (pixels == NULL) {
-        scg_log_errorf("Failed to allocate memory for image file at %s",
-                       filepath);
+    return image;
+}
 
-        SDL_FreeSurface(converted_surface);
+static scg_image_t *scg__image_new_from_surface(SDL_Surface *surface,
+                                                const char *name,
+                                                scg_arena_t *arena) {
+    scg_image_t *image = scg__image_alloc(surface->w, surface->h, name, arena);
+    if (image == NULL) {
         return NULL;
     }
-    memcpy(pixels, surface_pixels, surface_pitch * surface_h);
 
-    scg_image_t *image = malloc(sizeof(*image));
-    if (image == NULL) {
-        scg_log_error("Failed to allocate memory for image");
+    // Blit straight into the image pixels, which converts the surface in
+    // the same pass instead of going through an intermediate surface.
+    SDL_Surface *target = SDL_CreateRGBSurfaceWithFormatFrom(
+        image->pixels, image->width, image->height, 32, image->pitch,
+        SCG__IMAGE_PIXEL_FORMAT);
+    if (target == NULL) {
+        scg_log_errorf("Failed to create surface for image %s. %s", name,
+                       SDL_GetError());
 
-        free(pixels);
-        SDL_FreeSurface(converted_surface);
+        scg_image_free(image);
         return NULL;
     }
 
-    // Assign all the image properties.
-    image->width = surface_w;
-    image->height = surface_h;
-    image->pitch = surface_pitch;
-    image->pixels = pixels;
-    image->blend_mode = SCG_BLEND_MODE_NONE;
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+    if (SDL_BlitSurface(surface, NULL, target, NULL) != 0) {
+        scg_log_errorf("Failed to convert image %s. %s", name,
+                       SDL_GetError());
+
+        SDL_FreeSurface(target);
+        scg_image_free(image);
+        return NULL;
+    }
 
-    // We no longer need the converted surface.
-    SDL_FreeSurface(converted_surface);
+    SDL_FreeSurface(target);
 
     return image;
 }
 
-//
-// scg_image_set_blend_mode
-//
+static inline uint32_t scg__read_u16_le(const uint8_t *bytes) {
+    return (uint32_t)bytes[1] << 8 | bytes[0];
+}
 
-void scg_image_set_blend_mode(scg_image_t *image, scg_blend_mode_t blend_mode) {
-    image->blend_mode = blend_mode;
+static inline uint32_t scg__read_u16_be(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] << 8 | bytes[1];
 }
 
-//
-// scg_image_get_pixel implementation
-//
+static inline uint32_t scg__read_u32_be(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 |
+           (uint32_t)bytes[2] << 8 | bytes[3];
+}
 
-scg_pixel_t scg_image_get_pixel(scg_image_t *image, int x, int y) {
-    int w = image->width;
-    int h = image->height;
+static inline void scg__write_u16_le(uint8_t *bytes, uint16_t value) {
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
 
-    if (x < 0 || x >= w || y < 0 || y >= h) {
-        return SCG_COLOR_MAGENTA;
-    }
+static inline void scg__write_u32_le(uint8_t *bytes, uint32_t value) {
+    scg__write_u16_le(bytes, (uint16_t)value);
+    scg__write_u16_le(bytes + 2, (uint16_t)(value >> 16));
+}
 
-    int i = scg_pixel_index_from_xy(x, y, w);
-    return scg_pixel_new_uint32(image->pixels[i]);
+static inline void scg__write_u32_be(uint8_t *bytes, uint32_t value) {
+    bytes[0] = (uint8_t)(value >> 24);
+    bytes[1] = (uint8_t)(value >> 16);
+    bytes[2] = (uint8_t)(value >> 8);
+    bytes[3] = (uint8_t)value;
 }
 
-//
-// scg_image_set_pixel implementation
-//
+static inline uint32_t scg__pack_argb(uint32_t r, uint32_t g, uint32_t b,
+                                      uint32_t a) {
+    return a << 24 | r << 16 | g << 8 | b;
+}
 
-void scg_image_set_pixel(scg_image_t *image, int x, int y, scg_pixel_t color) {
-    int w = image->width;
-    int h = image->height;
+#ifdef SCG__SSE2
+static inline uint32_t scg__load_u32(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
 
-    if (x < 0 || x >= w || y < 0 || y >= h) {
-        return;
-    }
+    return value;
+}
 
-    scg_blend_mode_t blend_mode = image->blend_mode;
-    int i = scg_pixel_index_from_xy(x, y, w);
+// Loads 4 pixels of 3 bytes each into the low bytes of 4 lanes. Reads one
+// byte past the last pixel.
+static inline __m128i scg__load_3x4(const uint8_t *bytes) {
+    return _mm_setr_epi32((int)scg__load_u32(bytes),
+                          (int)scg__load_u32(bytes + 3),
+                          (int)scg__load_u32(bytes + 6),
+                          (int)scg__load_u32(bytes + 9));
+}
 
-    if (blend_mode == SCG_BLEND_MODE_NONE) {
-        image->pixels[i] = color.packed;
+// Swaps the first and third byte of each lane, turning RGBA in memory
+// into BGRA, which is ARGB8888 on little endian machines.
+static inline __m128i scg__swap_red_blue(__m128i pixels) {
+    const __m128i ga_mask = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i low_mask = _mm_set1_epi32(0xFF);
+
+    __m128i ga = _mm_and_si128(pixels, ga_mask);
+    __m128i r = _mm_slli_epi32(_mm_and_si128(pixels, low_mask), 16);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 16), low_mask);
+
+    return _mm_or_si128(ga, _mm_or_si128(r, b));
+}
+#endif
+
+static void scg__pixels_from_rgba(const uint8_t *src, uint32_t *dest,
+                                  int count) {
+    int i = 0;
+
+#ifdef SCG__SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        _mm_storeu_si128((__m128i *)(dest + i), scg__swap_red_blue(pixels));
     }
+#endif
 
-    if (blend_mode == SCG_BLEND_MODE_MASK) {
-        if (color.data.a == 255) {
-            image->pixels[i] = color.packed;
-        }
+    for (; i < count; i++) {
+        const uint8_t *p = src + i * 4;
+        dest[i] = scg__pack_argb(p[0], p[1], p[2], p[3]);
     }
+}
+
+static void scg__pixels_from_rgb(const uint8_t *src, uint32_t *dest,
+                                 int count) {
+    int i = 0;
 
-    if (blend_mode == SCG_BLEND_MODE_ALPHA) {
-        scg_pixel_t d = scg_pixel_new_uint32(image->pixels[i]);
-        float32_t a = (float32_t)(color.data.a / 255.0f);
-        float32_t c = 1.0f - a;
-        float32_t r = a * (float32_t)color.data.r + c * (float32_t)d.data.r;
-        float32_t g = a * (float32_t)color.data.g + c * (float32_t)d.data.g;
-        float32_t b = a * (float32_t)color.data.b + c * (float32_t)d.data.b;
+#ifdef SCG__SSE2
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; i + 4 < count; i += 4) {
+        __m128i pixels = scg__swap_red_blue(scg__load_3x4(src + i * 3));
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(pixels, alpha));
+    }
+#endif
 
-        scg_pixel_t blended_color =
-            scg_pixel_new_rgb((uint8_t)r, (uint8_t)g, (uint8_t)b);
-        image->pixels[i] = blended_color.packed;
+    for (; i < count; i++) {
+        const uint8_t *p = src + i * 3;
+        dest[i] = scg__pack_argb(p[0], p[1], p[2], 0xFF);
     }
 }
 
-//
-// scg_image_clear implementation
-//
+static void scg__pixels_from_bgr(const uint8_t *src, uint32_t *dest,
+                                 int count) {
+    int i = 0;
 
-void scg_image_clear(scg_image_t *image, scg_pixel_t color) {
-    int num_pixels = image->width * image->height;
-    uint32_t pixel = color.packed;
+#ifdef SCG__SSE2
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; i + 4 < count; i += 4) {
+        __m128i pixels = scg__load_3x4(src + i * 3);
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(pixels, alpha));
+    }
+#endif
 
-    for (int i = 0; i < num_pixels; i++) {
-        image->pixels[i] = pixel;
+    for (; i < count; i++) {
+        const uint8_t *p = src + i * 3;
+        dest[i] = scg__pack_argb(p[2], p[1], p[0], 0xFF);
     }
 }
 
-//
-// scg_image_draw_image implementation
-//
+static void scg__pixels_from_bgra(const uint8_t *src, uint32_t *dest,
+                                  int count) {
+    int i = 0;
 
-void scg_image_draw_image(scg_image_t *dest, scg_image_t *src, int x, int y) {
-    int src_w = src->width;
-    int src_h = src->height;
+#ifdef SCG__SSE2
+    // BGRA in memory is already ARGB8888.
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i *)(dest + i),
+                         _mm_loadu_si128((const __m128i *)(src + i * 4)));
+    }
+#endif
 
-    for (int i = 0; i < src_h; i++) {
-        for (int j = 0; j < src_w; j++) {
-            scg_pixel_t color = scg_image_get_pixel(src, j, i);
-            scg_image_set_pixel(dest, x + j, y + i, color);
-        }
+    for (; i < count; i++) {
+        const uint8_t *p = src + i * 4;
+        dest[i] = scg__pack_argb(p[2], p[1], p[0], p[3]);
     }
 }
 
-//
-// scg_image_draw_image_rotate implementation
-//
+static void scg__pixels_from_gray_alpha(const uint8_t *src, uint32_t *dest,
+                                        int count) {
+    int i = 0;
+
+#ifdef SCG__SSE2
+    const __m128i low_mask = _mm_set1_epi16(0xFF);
+    for (; i + 8 <= count; i += 8) {
+        // Each 16 bit lane holds a gray and alpha pair. Interleaving a gray
+        // and gray pair with it gives the 4 bytes of a pixel.
+        __m128i ga = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        __m128i gray = _mm_and_si128(ga, low_mask);
+        __m128i gg = _mm_or_si128(gray, _mm_slli_epi16(gray, 8));
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i *)(dest + i + 4),
+                         _mm_unpackhi_epi16(gg, ga));
+    }
+#endif
 
-void scg_image_draw_image_rotate(scg_image_t *dest, scg_image_t *src, int x,
-                                 int y, float32_t angle) {
-    float32_t src_w = src->width;
-    float32_t src_h = src->height;
-    float32_t origin_x = src_w * 0.5f;
-    float32_t origin_y = src_h * 0.5f;
-    float32_t sin_theta = sinf(-angle);
-    float32_t cos_theta = cosf(-angle);
+    for (; i < count; i++) {
+        const uint8_t *p = src + i * 2;
+        dest[i] = scg__pack_argb(p[0], p[0], p[0], p[1]);
+    }
+}
 
-    float32_t a = src_w * cos_theta;
-    float32_t b = src_h * cos_theta;
-    float32_t c = src_w * sin_theta;
-    float32_t d = src_h * sin_theta;
-    float32_t e = -src_w * cos_theta;
-    float32_t f = -src_w * sin_theta;
-    int x0 = (int)(e + d);
-    int y0 = (int)(f - b);
-    int x1 = (int)(a + d);
-    int y1 = (int)(c - b);
-    int x2 = (int)(a - d);
-    int y2 = (int)(c + b);
-    int x3 = (int)(e - d);
-    int y3 = (int)(f + b);
+// The inflate decoder below decodes a zlib stream into a buffer whose final
+// size is known up front, which is all that PNG needs.
+typedef struct scg__huffman_t {
+    // Symbols of codes up to SCG__INFLATE_FAST_BITS long, indexed by the
+    // next bits of the stream, with the code length above the symbol.
+    uint16_t fast[1 << SCG__INFLATE_FAST_BITS];
+    uint16_t first_code[16];
+    uint16_t first_symbol[16];
+    int max_code[17];
+    uint8_t lengths[SCG__INFLATE_MAX_SYMBOLS];
+    uint16_t symbols[SCG__INFLATE_MAX_SYMBOLS];
+} scg__huffman_t;
+
+typedef struct scg__inflate_t {
+    const uint8_t *src;
+    const uint8_t *src_end;
+    uint64_t bits;
+    int num_bits;
+    // Zero bytes read past the end of the stream.
+    int overrun;
+    uint8_t *dest;
+    uint8_t *dest_start;
+    uint8_t *dest_end;
+    scg__huffman_t literals;
+    scg__huffman_t distances;
+} scg__inflate_t;
+
+static const uint16_t scg__inflate_length_base[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+static const uint8_t scg__inflate_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const uint16_t scg__inflate_distance_base[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+
+static const uint8_t scg__inflate_distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static inline int scg__bit_reverse(int value, int num_bits) {
+    value = ((value & 0xAAAA) >> 1) | ((value & 0x5555) << 1);
+    value = ((value & 0xCCCC) >> 2) | ((value & 0x3333) << 2);
+    value = ((value & 0xF0F0) >> 4) | ((value & 0x0F0F) << 4);
+    value = ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
+
+    return value >> (16 - num_bits);
+}
 
-    int minx =
-        scg_min_int(0, scg_min_int(scg_min_int(x0, scg_min_int(x1, x2)), x3));
-    int miny =
-        scg_min_int(0, scg_min_int(scg_min_int(y0, scg_min_int(y1, y2)), y3));
-    int maxx = scg_max_int(x0, scg_max_int(x1, scg_max_int(x2, x3)));
-    int maxy = scg_max_int(y0, scg_max_int(y1, scg_max_int(y2, y3)));
+static bool scg__huffman_build(scg__huffman_t *huffman,
+                               const uint8_t *lengths, int num_symbols) {
+    int counts[16] = {0};
+    int next_code[16];
 
-    // TODO: Try a pixel subsampling approach to improve the visual quality
-    // of the rotation.
-    // Reference:
-    // http://www.leptonica.org/rotation.html#ROTATION-BY-AREA-MAPPING
-    for (int i = miny; i < maxy; i++) {
-        for (int j = minx; j < maxx; j++) {
-            float32_t image_x = (float32_t)j - origin_x;
-            float32_t image_y = (float32_t)i - origin_y;
-            float32_t xt =
-                (image_x * cos_theta - image_y * sin_theta) + origin_x;
-            float32_t yt =
-                (image_x * sin_theta + image_y * cos_theta) + origin_y;
+    for (int i = 0; i < num_symbols; i++) {
+        counts[lengths[i]]++;
+    }
+    counts[0] = 0;
+
+    memset(huffman->fast, 0, sizeof(huffman->fast));
+
+    // Assign canonical codes, rejecting oversubscribed length sets.
+    int code = 0;
+    int symbol = 0;
+    for (int i = 1; i < 16; i++) {
+        next_code[i] = code;
+        huffman->first_code[i] = (uint16_t)code;
+        huffman->first_symbol[i] = (uint16_t)symbol;
+        code += counts[i];
+        if (counts[i] != 0 && code - 1 >= 1 << i) {
+            return false;
+        }
+        huffman->max_code[i] = code << (16 - i);
+        code <<= 1;
+        symbol += counts[i];
+    }
+    huffman->max_code[16] = 0x10000;
 
-            if (xt >= 0 && xt < src_w && yt >= 0 && yt < src_h) {
-                scg_pixel_t color = scg_image_get_pixel(src, (int)xt, (int)yt);
-                scg_image_set_pixel(dest, x + j, y + i, color);
+    for (int i = 0; i < num_symbols; i++) {
+        int length = lengths[i];
+        if (length == 0) {
+            continue;
+        }
+
+        int index = next_code[length] - huffman->first_code[length] +
+                    huffman->first_symbol[length];
+        huffman->lengths[index] = (uint8_t)length;
+        huffman->symbols[index] = (uint16_t)i;
+
+        if (length <= SCG__INFLATE_FAST_BITS) {
+            uint16_t entry = (uint16_t)(length << SCG__INFLATE_FAST_BITS | i);
+            for (int j = scg__bit_reverse(next_code[length], length);
+                 j < 1 << SCG__INFLATE_FAST_BITS; j += 1 << length) {
+                huffman->fast[j] = entry;
             }
         }
+
+        next_code[length]++;
     }
+
+    return true;
 }
 
-//
-// scg_image_draw_image_rotate_scale implementation
-//
+static inline void scg__inflate_refill(scg__inflate_t *inflate) {
+    while (inflate->num_bits <= 56) {
+        uint64_t byte = 0;
+        if (inflate->src < inflate->src_end) {
+            byte = *inflate->src++;
+        } else {
+            inflate->overrun++;
+        }
 
-void scg_image_draw_image_rotate_scale(scg_image_t *dest, scg_image_t *src,
-                                       int x, int y, float32_t angle,
-                                       float32_t sx, float32_t sy) {
-    if (sx <= 0.0f)
-        sx = 1.0f;
-    if (sy <= 0.0f)
-        sy = 1.0f;
+        inflate->bits |= byte << inflate->num_bits;
+        inflate->num_bits += 8;
+    }
+}
 
-    float32_t src_w = src->width;
-    float32_t src_h = src->height;
-    float32_t src_sw = src_w * sx;
-    float32_t src_sh = src_h * sy;
+static inline uint32_t scg__inflate_bits(scg__inflate_t *inflate,
+                                         int num_bits) {
+    if (inflate->num_bits < num_bits) {
+        scg__inflate_refill(inflate);
+    }
 
-    float32_t ratio_x = src_w / src_sw;
-    float32_t ratio_y = src_h / src_sh;
-    float32_t origin_x = src_w * 0.5f;
-    float32_t origin_y = src_h * 0.5f;
+    uint32_t value = (uint32_t)(inflate->bits & ((1u << num_bits) - 1));
+    inflate->bits >>= num_bits;
+    inflate->num_bits -= num_bits;
 
-    float32_t sin_theta = sinf(-angle);
-    float32_t cos_theta = cosf(-angle);
+    return value;
+}
 
-    float32_t a = src_sw * cos_theta;
-    float32_t b = src_sh * cos_theta;
-    float32_t c = src_sw * sin_theta;
-    float32_t d = src_sh * sin_theta;
-    float32_t e = -src_sw * cos_theta;
-    float32_t f = -src_sw * sin_theta;
-    int x0 = (int)(e + d);
-    int y0 = (int)(f - b);
-    int x1 = (int)(a + d);
-    int y1 = (int)(c - b);
-    int x2 = (int)(a - d);
-    int y2 = (int)(c + b);
-    int x3 = (int)(e - d);
-    int y3 = (int)(f + b);
-
-    int minx =
-        scg_min_int(0, scg_min_int(scg_min_int(x0, scg_min_int(x1, x2)), x3));
-    int miny =
-        scg_min_int(0, scg_min_int(scg_min_int(y0, scg_min_int(y1, y2)), y3));
-    int maxx = scg_max_int(x0, scg_max_int(x1, scg_max_int(x2, x3)));
-    int maxy = scg_max_int(y0, scg_max_int(y1, scg_max_int(y2, y3)));
+static inline int scg__inflate_decode(scg__inflate_t *inflate,
+                                      const scg__huffman_t *huffman) {
+    if (inflate->num_bits < 16) {
+        scg__inflate_refill(inflate);
+    }
 
-    for (int i = miny; i < maxy; i++) {
-        for (int j = minx; j < maxx; j++) {
-            float32_t image_x = (float32_t)j * ratio_x - origin_x;
-            float32_t image_y = (float32_t)i * ratio_y - origin_y;
-            float32_t xt =
-                (image_x * cos_theta - image_y * sin_theta) + origin_x;
-            float32_t yt =
-                (image_x * sin_theta + image_y * cos_theta) + origin_y;
+    int entry = huffman->fast[inflate->bits & SCG__INFLATE_FAST_MASK];
+    if (entry != 0) {
+        int length = entry >> SCG__INFLATE_FAST_BITS;
+        inflate->bits >>= length;
+        inflate->num_bits -= length;
 
-            if (xt >= 0 && xt < src_w && yt >= 0 && yt < src_h) {
-                scg_pixel_t color = scg_image_get_pixel(src, (int)xt, (int)yt);
-                scg_image_set_pixel(dest, x + j, y + i, color);
-            }
-        }
+        return entry & SCG__INFLATE_FAST_MASK;
     }
-}
 
-//
-// scg_image_draw_line implementation
-//
+    // Codes longer than the fast table are found by comparing against the
+    // last code of each length.
+    int code = scg__bit_reverse((int)(inflate->bits & 0xFFFF), 16);
+    int length = SCG__INFLATE_FAST_BITS + 1;
+    while (code >= huffman->max_code[length]) {
+        length++;
+    }
+    if (length >= 16) {
+        return -1;
+    }
 
-void scg_image_draw_line(scg_image_t *image, int x0, int y0, int x1, int y1,
-                         scg_pixel_t color) {
-    // Line is vertical
-    if (x0 == x1) {
-        if (y1 < y0) {
-            int tmp = y1;
-            y1 = y0;
-            y0 = tmp;
-        }
+    int index = (code >> (16 - length)) - huffman->first_code[length] +
+                huffman->first_symbol[length];
+    if (index < 0 || index >= SCG__INFLATE_MAX_SYMBOLS ||
+        huffman->lengths[index] != length) {
+        return -1;
+    }
 
-        for (int y = y0; y <= y1; y++) {
-            scg_image_set_pixel(image, x0, y, color);
-        }
+    inflate->bits >>= length;
+    inflate->num_bits -= length;
 
-        return;
-    }
+    return huffman->symbols[index];
+}
 
-    // Line is horizontal
-    if (y0 == y1) {
-        if (x1 < x0) {
-            int tmp = x1;
-            x1 = x0;
-            x0 = tmp;
+static bool scg__inflate_huffman_block(scg__inflate_t *inflate) {
+    for (;;) {
+        int symbol = scg__inflate_decode(inflate, &inflate->literals);
+        if (symbol < 0) {
+            return false;
         }
 
-        for (int x = x0; x <= x1; x++) {
-            scg_image_set_pixel(image, x, y0, color);
+        if (symbol < 256) {
+            if (inflate->dest == inflate->dest_end) {
+                return false;
+            }
+            *inflate->dest++ = (uint8_t)symbol;
+            continue;
         }
 
-        return;
-    }
-
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-
-    int step_x = x0 < x1 ? 1 : -1;
-    int step_y = y0 < y1 ? 1 : -1;
-    int err = (dx > dy ? dx : -dy) / 2;
-    int e2 = 0;
+        if (symbol == 256) {
+            return true;
+        }
 
-    for (;;) {
-        scg_image_set_pixel(image, x0, y0, color);
+        symbol -= 257;
+        if (symbol >= 29) {
+            return false;
+        }
+        int length = scg__inflate_length_base[symbol] +
+                     scg__inflate_bits(inflate,
+                                       scg__inflate_length_extra[symbol]);
 
-        if (x0 == x1 && y0 == y1) {
-            break;
+        symbol = scg__inflate_decode(inflate, &inflate->distances);
+        if (symbol < 0 || symbol >= 30) {
+            return false;
         }
+        int distance = scg__inflate_distance_base[symbol] +
+                       scg__inflate_bits(inflate,
+                                         scg__inflate_distance_extra[symbol]);
 
-        e2 = err;
-        if (e2 > -dx) {
-            err -= dy;
-            x0 += step_x;
+        if (distance > inflate->dest - inflate->dest_start ||
+            length > inflate->dest_end - inflate->dest) {
+            return false;
         }
-        if (e2 < dy) {
-            err += dx;
-            y0 += step_y;
+
+        const uint8_t *from = inflate->dest - distance;
+        if (distance == 1) {
+            memset(inflate->dest, *from, length);
+        } else if (distance >= length) {
+            memcpy(inflate->dest, from, length);
+        } else {
+            for (int i = 0; i < length; i++) {
+                inflate->dest[i] = from[i];
+            }
         }
+        inflate->dest += length;
     }
 }
 
-//
-// scg_image_draw_rect implementation
-//
+static bool scg__inflate_stored_block(scg__inflate_t *inflate) {
+    scg__inflate_bits(inflate, inflate->num_bits & 7);
 
-void scg_image_draw_rect(scg_image_t *image, int x, int y, int w, int h,
-                         scg_pixel_t color) {
-    int minx = x;
-    int miny = y;
-    int maxx = minx + w;
-    int maxy = miny + h;
+    uint32_t length = scg__inflate_bits(inflate, 16);
+    uint32_t inverse_length = scg__inflate_bits(inflate, 16);
+    if ((length ^ 0xFFFF) != inverse_length ||
+        length > (size_t)(inflate->dest_end - inflate->dest)) {
+        return false;
+    }
 
-    scg_image_draw_line(image, minx, miny, maxx, miny, color);
-    scg_image_draw_line(image, maxx, miny, maxx, maxy, color);
-    scg_image_draw_line(image, maxx, maxy, minx, maxy, color);
-    scg_image_draw_line(image, minx, maxy, minx, miny, color);
+    // Drain the whole bytes left in the bit buffer, then copy the rest
+    // straight from the stream.
+    while (length > 0 && inflate->num_bits > 0) {
+        *inflate->dest++ = (uint8_t)scg__inflate_bits(inflate, 8);
+        length--;
+    }
+
+    if (length > (size_t)(inflate->src_end - inflate->src)) {
+        return false;
+    }
+    memcpy(inflate->dest, inflate->src, length);
+    inflate->dest += length;
+    inflate->src += length;
+
+    return true;
 }
 
-//
-// scg_image_fill_rect implementation
-//
+static bool scg__inflate_dynamic_tables(scg__inflate_t *inflate) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                      11, 4,  12, 3, 13, 2, 14, 1, 15};
 
-void scg_image_fill_rect(scg_image_t *image, int x, int y, int w, int h,
-                         scg_pixel_t color) {
-    for (int i = 0; i <= h; i++) {
-        for (int j = 0; j <= w; j++) {
-            scg_image_set_pixel(image, x + j, y + i, color);
-        }
+    int num_literals = (int)scg__inflate_bits(inflate, 5) + 257;
+    int num_distances = (int)scg__inflate_bits(inflate, 5) + 1;
+    int num_code_lengths = (int)scg__inflate_bits(inflate, 4) + 4;
+
+    uint8_t code_lengths[19] = {0};
+    for (int i = 0; i < num_code_lengths; i++) {
+        code_lengths[order[i]] = (uint8_t)scg__inflate_bits(inflate, 3);
     }
-}
 
-//
-// scg_image_draw_circle implementation
-//
+    // The literal table is free until the real one is built, so it holds
+    // the code length code.
+    if (!scg__huffman_build(&inflate->literals, code_lengths, 19)) {
+        return false;
+    }
 
-void scg_image_draw_circle(scg_image_t *image, int x, int y, int r,
-                           scg_pixel_t color) {
-    int f = 1 - r;
-    int ddf_x = 0;
-    int ddf_y = -2 * r;
-    int xi = 0;
-    int yi = r;
+    uint8_t lengths[SCG__INFLATE_MAX_SYMBOLS + 32];
+    int total = num_literals + num_distances;
+    int n = 0;
+    while (n < total) {
+        int symbol = scg__inflate_decode(inflate, &inflate->literals);
+        if (symbol < 0 || symbol > 18) {
+            return false;
+        }
 
-    scg_image_set_pixel(image, x, y + r, color);
-    scg_image_set_pixel(image, x, y - r, color);
-    scg_image_set_pixel(image, x + r, y, color);
-    scg_image_set_pixel(image, x - r, y, color);
+        if (symbol < 16) {
+            lengths[n++] = (uint8_t)symbol;
+            continue;
+        }
 
-    while (xi < yi) {
-        if (f >= 0) {
-            yi--;
-            ddf_y += 2;
-            f += ddf_y;
+        uint8_t fill = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (n == 0) {
+                return false;
+            }
+            fill = lengths[n - 1];
+            repeat = (int)scg__inflate_bits(inflate, 2) + 3;
+        } else if (symbol == 17) {
+            repeat = (int)scg__inflate_bits(inflate, 3) + 3;
+        } else {
+            repeat = (int)scg__inflate_bits(inflate, 7) + 11;
         }
 
-        xi++;
-        ddf_x += 2;
-        f += ddf_x + 1;
+        if (n + repeat > total) {
+            return false;
+        }
+        memset(lengths + n, fill, repeat);
+        n += repeat;
+    }
 
-        scg_image_set_pixel(image, x + xi, y + yi, color);
-        scg_image_set_pixel(image, x - xi, y + yi, color);
-        scg_image_set_pixel(image, x + xi, y - yi, color);
-        scg_image_set_pixel(image, x - xi, y - yi, color);
-        scg_image_set_pixel(image, x + yi, y + xi, color);
-        scg_image_set_pixel(image, x - yi, y + xi, color);
-        scg_image_set_pixel(image, x + yi, y - xi, color);
-        scg_image_set_pixel(image, x - yi, y - xi, color);
+    if (lengths[256] == 0) {
+        return false;
     }
-}
 
-//
-// scg_image_fill_circle implementation
-//
+    return scg__huffman_build(&inflate->literals, lengths, num_literals) &&
+           scg__huffman_build(&inflate->distances, lengths + num_literals,
+                              num_distances);
+}
 
-void scg_image_fill_circle(scg_image_t *image, int x, int y, int r,
-                           scg_pixel_t color) {
-    int f = 1 - r;
-    int ddf_x = 0;
-    int ddf_y = -2 * r;
-    int xi = 0;
-    int yi = r;
+static bool scg__inflate_fixed_tables(scg__inflate_t *inflate) {
+    uint8_t lengths[SCG__INFLATE_MAX_SYMBOLS];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
 
-    scg_image_draw_line(image, x, y - r, x, y + r, color);
-    scg_image_draw_line(image, x - r, y, x + r, y, color);
+    uint8_t distance_lengths[32];
+    memset(distance_lengths, 5, sizeof(distance_lengths));
 
-    while (xi < yi) {
-        if (f >= 0) {
-            yi--;
-            ddf_y += 2;
-            f += ddf_y;
-        }
+    return scg__huffman_build(&inflate->literals, lengths,
+                              SCG__INFLATE_MAX_SYMBOLS) &&
+           scg__huffman_build(&inflate->distances, distance_lengths, 32);
+}
 
-        xi++;
-        ddf_x += 2;
-        f += ddf_x + 1;
+static bool scg__inflate(const uint8_t *src, size_t src_size, uint8_t *dest,
+                         size_t dest_size) {
+    if (src_size < 2 || (src[0] & 0x0F) != 8 || (src[1] & 0x20) != 0 ||
+        (src[0] << 8 | src[1]) % 31 != 0) {
+        return false;
+    }
 
-        scg_image_draw_line(image, x - xi, y + yi, x + xi, y + yi, color);
-        scg_image_draw_line(image, x - xi, y - yi, x + xi, y - yi, color);
-        scg_image_draw_line(image, x - yi, y + xi, x + yi, y + xi, color);
-        scg_image_draw_line(image, x - yi, y - xi, x + yi, y - xi, color);
+    scg__inflate_t *inflate = malloc(sizeof(*inflate));
+    if (inflate == NULL) {
+        return false;
     }
-}
 
-static void scg__draw_char_bitmap(scg_image_t *image, const char *bitmap, int x,
-                                  int y, scg_pixel_t color) {
-    for (int i = 0; i < SCG_FONT_SIZE; i++) {
-        for (int j = 0; j < SCG_FONT_SIZE; j++) {
-            int set = bitmap[i] & 1 << j;
+    inflate->src = src + 2;
+    inflate->src_end = src + src_size;
+    inflate->bits = 0;
+    inflate->num_bits = 0;
+    inflate->overrun = 0;
+    inflate->dest = dest;
+    inflate->dest_start = dest;
+    inflate->dest_end = dest + dest_size;
+
+    bool ok = true;
+    bool is_final = false;
+    while (ok && !is_final) {
+        is_final = scg__inflate_bits(inflate, 1);
+
+        switch (scg__inflate_bits(inflate, 2)) {
+        case 0:
+            ok = scg__inflate_stored_block(inflate);
+            break;
+        case 1:
+            ok = scg__inflate_fixed_tables(inflate) &&
+                 scg__inflate_huffman_block(inflate);
+            break;
+        case 2:
+            ok = scg__inflate_dynamic_tables(inflate) &&
+                 scg__inflate_huffman_block(inflate);
+            break;
+        default:
+            ok = false;
+            break;
+        }
 
-            if (set) {
-                scg_image_set_pixel(image, x + j, y + i, color);
-            }
+        // Bits taken from past the end mean the stream was truncated.
+        if (inflate->overrun * 8 > inflate->num_bits) {
+            ok = false;
         }
     }
+
+    ok = ok && inflate->dest == inflate->dest_end;
+    free(inflate);
+
+    return ok;
 }
 
 //
-// scg_image_draw_char implementation
+// scg_image_new_from_bmp implementation
 //
 
-void scg_image_draw_char(scg_image_t *image, char ch, int x, int y,
-                         scg_pixel_t color) {
-    uint8_t char_code = (uint8_t)ch;
-    if (char_code > SCG__FONT_CHAR_CODE_END) {
-        char_code = SCG__FONT_CHAR_CODE_QUESTION_MARK;
+scg_image_t *scg_image_new_from_bmp(const char *filepath) {
+    SDL_Surface *surface = SDL_LoadBMP(filepath);
+    if (surface == NULL) {
+        scg_log_errorf("Failed to load image file at %s. %s", filepath,
+                       SDL_GetError());
+
+        return NULL;
     }
 
-    char bitmap[SCG_FONT_SIZE];
-    int index = char_code * SCG_FONT_SIZE;
-    memcpy(bitmap, scg__font8x8 + index, SCG_FONT_SIZE);
+    scg_image_t *image = scg__image_new_from_surface(surface, filepath, NULL);
+    SDL_FreeSurface(surface);
 
-    scg__draw_char_bitmap(image, bitmap, x, y, color);
+    return image;
 }
 
-//
-// scg_image_draw_string implementation
-//
-
-void scg_image_draw_string(scg_image_t *image, const char *str, int x, int y,
-                           bool anchor_to_center, scg_pixel_t color) {
-    int current_x = x;
-    int current_y = y;
+typedef struct scg__png_t {
+    int width;
+    int height;
+    int bit_depth;
+    int color_type;
+    int num_channels;
+    bool is_interlaced;
+    // Pixels of palette and gray images up to 8 bits, indexed by sample.
+    uint32_t palette[256];
+    int palette_size;
+    bool has_key;
+    uint32_t key[3];
+} scg__png_t;
+
+#ifdef SCG__SSE2
+static inline __m128i scg__png_load_pixel(const uint8_t *bytes, int bpp) {
+    uint32_t value = 0;
+    memcpy(&value, bytes, bpp);
+
+    return _mm_cvtsi32_si128((int)value);
+}
 
-    if (anchor_to_center) {
-        int width = strlen(str) * SCG_FONT_SIZE;
-        current_x = x - width / 2;
-        current_y -= SCG_FONT_SIZE / 2;
-    }
+static inline void scg__png_store_pixel(uint8_t *bytes, __m128i pixel,
+                                        int bpp) {
+    uint32_t value = (uint32_t)_mm_cvtsi128_si32(pixel);
+    memcpy(bytes, &value, bpp);
+}
 
-    for (int i = 0; str[i] != '\0'; i++) {
-        if (str[i] != SCG__FONT_CHAR_CODE_SPACE) {
-            scg_image_draw_char(image, str[i], current_x, current_y, color);
+// The Sub, Average and Paeth filters depend on the previous pixel, so
+// pixels of 3 and 4 bytes are unfiltered one register at a time.
+static void scg__png_unfilter_sse2(uint8_t *row, const uint8_t *prior,
+                                   size_t length, int bpp, int filter) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero;
+    __m128i c = zero;
+
+    for (size_t i = 0; i < length; i += bpp) {
+        __m128i x = scg__png_load_pixel(row + i, bpp);
+
+        if (filter == 1) {
+            a = _mm_add_epi8(x, a);
+        } else if (filter == 3) {
+            __m128i b = scg__png_load_pixel(prior + i, bpp);
+            // avg_epu8 rounds up, the filter rounds down.
+            __m128i average = _mm_sub_epi8(
+                _mm_avg_epu8(a, b),
+                _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+            a = _mm_add_epi8(x, average);
+        } else {
+            // Paeth works on 16 bit lanes to keep the signed differences.
+            __m128i b = _mm_unpacklo_epi8(
+                scg__png_load_pixel(prior + i, bpp), zero);
+            __m128i a16 = _mm_unpacklo_epi8(a, zero);
+
+            __m128i pa = _mm_sub_epi16(b, c);
+            __m128i pb = _mm_sub_epi16(a16, c);
+            __m128i pc = _mm_add_epi16(pa, pb);
+            pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+            pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+            pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+            __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+            // Ties favour a over b over c.
+            __m128i mask = _mm_cmpeq_epi16(smallest, pb);
+            __m128i nearest =
+                _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, c));
+            mask = _mm_cmpeq_epi16(smallest, pa);
+            nearest = _mm_or_si128(_mm_and_si128(mask, a16),
+                                   _mm_andnot_si128(mask, nearest));
+
+            a = _mm_add_epi8(x, _mm_packus_epi16(nearest, nearest));
+            c = b;
         }
 
-        current_x += SCG_FONT_SIZE;
+        scg__png_store_pixel(row + i, a, bpp);
     }
 }
+#endif
 
-//
-// scg_image_draw_wchar implementation
-//
+static inline uint8_t scg__png_paeth(int a, int b, int c) {
+    int pa = abs(b - c);
+    int pb = abs(a - c);
+    int pc = abs(a + b - 2 * c);
 
-void scg_image_draw_wchar(scg_image_t *image, wchar_t ch, int x, int y,
-                          scg_pixel_t color) {
-    char bitmap[SCG_FONT_SIZE];
-
-    if (ch <= SCG__FONT_CHAR_CODE_END) {
-        int index = ch * SCG_FONT_SIZE;
-        memcpy(bitmap, scg__font8x8 + index, SCG_FONT_SIZE);
-    } else if (ch >= SCG__FONT_HIRAGANA_CHAR_CODE_START &&
-               ch <= SCG__FONT_HIRAGANA_CHAR_CODE_END) {
-        int mapped_code = SCG__FONT_HIRAGANA_NUM_CHARS -
-                          (SCG__FONT_HIRAGANA_CHAR_CODE_END - ch);
-
-        int index = mapped_code * SCG_FONT_SIZE;
-        memcpy(bitmap, scg__font8x8_hiragana + index, SCG_FONT_SIZE);
-    } else {
-        int index = SCG__FONT_CHAR_CODE_QUESTION_MARK * SCG_FONT_SIZE;
-        memcpy(bitmap, scg__font8x8 + index, SCG_FONT_SIZE);
+    if (pa <= pb && pa <= pc) {
+        return (uint8_t)a;
     }
 
-    scg__draw_char_bitmap(image, bitmap, x, y, color);
+    return (uint8_t)(pb <= pc ? b : c);
 }
 
-//
-// scg_image_draw_wstring implementation
-//
-
-void scg_image_draw_wstring(scg_image_t *image, const wchar_t *str, int x,
-                            int y, bool anchor_to_center, scg_pixel_t color) {
-    int current_x = x;
-    int current_y = y;
+static bool scg__png_unfilter(uint8_t *row, const uint8_t *prior,
+                              size_t length, int bpp, int filter) {
+    if (filter > 4) {
+        return false;
+    }
 
-    if (anchor_to_center) {
-        int width = wcslen(str) * SCG_FONT_SIZE;
-        current_x = x - width / 2;
-        current_y -= SCG_FONT_SIZE / 2;
+    if (filter == 0) {
+        return true;
     }
 
-    for (int i = 0; str[i] != '\0'; i++) {
-        if (str[i] != SCG__FONT_CHAR_CODE_SPACE) {
-            scg_image_draw_wchar(image, str[i], current_x, current_y, color);
+    if (filter == 2) {
+        size_t i = 0;
+#ifdef SCG__SSE2
+        for (; i + 16 <= length; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(prior + i));
+            _mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(x, b));
+        }
+#endif
+        for (; i < length; i++) {
+            row[i] = (uint8_t)(row[i] + prior[i]);
         }
 
-        current_x += SCG_FONT_SIZE;
+        return true;
     }
-}
 
-//
-// scg_image_draw_frame_metrics implementation
-//
+#ifdef SCG__SSE2
+    if (bpp == 3 || bpp == 4) {
+        scg__png_unfilter_sse2(row, prior, length, bpp, filter);
 
-void scg_image_draw_frame_metrics(scg_image_t *image,
-                                  scg_frame_metrics_t frame_metrics) {
-    int fps = frame_metrics.fps;
-    float32_t frame_time_ms = frame_metrics.frame_time_millisecs;
-    const char *fmt = "fps:%d ms/f:%.4f";
+        return true;
+    }
+#endif
 
-    ssize_t bsize = snprintf(NULL, 0, fmt, fps, frame_time_ms);
-    char buffer[bsize];
-    snprintf(buffer, bsize + 1, fmt, fps, frame_time_ms);
+    for (size_t i = 0; i < length; i++) {
+        int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+        int b = prior[i];
+        int c = i >= (size_t)bpp ? prior[i - bpp] : 0;
 
-    scg_pixel_t color = SCG_COLOR_GREEN;
-    float32_t target_fps = (float32_t)frame_metrics.target_fps;
-    if (fps < target_fps * 0.95) {
-        color = SCG_COLOR_YELLOW;
-    }
-    if (fps < target_fps * 0.5) {
-        color = SCG_COLOR_RED;
+        if (filter == 1) {
+            row[i] = (uint8_t)(row[i] + a);
+        } else if (filter == 3) {
+            row[i] = (uint8_t)(row[i] + ((a + b) >> 1));
+        } else {
+            row[i] = (uint8_t)(row[i] + scg__png_paeth(a, b, c));
+        }
     }
 
-    // Draw the metrics with no alpha blending.
-    scg_blend_mode_t blend_mode = image->blend_mode;
-    scg_image_set_blend_mode(image, SCG_BLEND_MODE_NONE);
-    scg_image_draw_string(image, buffer, 10, 10, 0, color);
-    scg_image_set_blend_mode(image, blend_mode);
+    return true;
 }
 
-//
-// scg_image_save_to_bmp implementation
-//
+static void scg__png_convert_row(const scg__png_t *png, const uint8_t *src,
+                                 uint32_t *dest, int width) {
+    int depth = png->bit_depth;
 
-bool scg_image_save_to_bmp(scg_image_t *image, const char *filepath) {
-    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(
-        (void *)image->pixels, image->width, image->height, 32, image->pitch,
-        SCG__IMAGE_PIXEL_FORMAT);
-    if (surface == NULL) {
-        scg_log_errorf("Failed to create SDL surface from image. %s",
-                       SDL_GetError());
+    if (png->color_type == 3 || (png->color_type == 0 && depth <= 8)) {
+        if (depth == 8) {
+            for (int i = 0; i < width; i++) {
+                dest[i] = png->palette[src[i]];
+            }
 
-        return false;
-    }
+            return;
+        }
 
-    if (SDL_SaveBMP(surface, filepath) != 0) {
-        scg_log_errorf("Failed to save image to %s. %s", filepath,
-                       SDL_GetError());
+        int per_byte = 8 / depth;
+        int mask = (1 << depth) - 1;
+        for (int i = 0; i < width; i++) {
+            int shift = 8 - depth * (i % per_byte + 1);
+            dest[i] = png->palette[src[i / per_byte] >> shift & mask];
+        }
 
-        SDL_FreeSurface(surface);
-        return false;
+        return;
     }
 
-    SDL_FreeSurface(surface);
+    if (depth == 8) {
+        switch (png->color_type) {
+        case 2:
+            scg__pixels_from_rgb(src, dest, width);
+            if (png->has_key) {
+                uint32_t key = scg__pack_argb(png->key[0], png->key[1],
+                                              png->key[2], 0xFF);
+                for (int i = 0; i < width; i++) {
+                    if (dest[i] == key) {
+                        dest[i] = key & 0x00FFFFFF;
+                    }
+                }
+            }
+            break;
+        case 4:
+            scg__pixels_from_gray_alpha(src, dest, width);
+            break;
+        default:
+            scg__pixels_from_rgba(src, dest, width);
+            break;
+        }
 
-    return true;
-}
+        return;
+    }
 
-//
-// scg_image_free implementation
-//
+    // 16 bit samples keep their high byte, after comparing the full value
+    // against the transparent color.
+    int channels = png->num_channels;
+    for (int i = 0; i < width; i++) {
+        const uint8_t *p = src + i * channels * 2;
+        uint32_t a = 0xFF;
 
-void scg_image_free(scg_image_t *image) {
-    free(image->pixels);
-    free(image);
+        if (png->color_type == 0) {
+            if (png->has_key && scg__read_u16_be(p) == png->key[0]) {
+                a = 0;
+            }
+            dest[i] = scg__pack_argb(p[0], p[0], p[0], a);
+        } else if (png->color_type == 2) {
+            if (png->has_key && scg__read_u16_be(p) == png->key[0] &&
+                scg__read_u16_be(p + 2) == png->key[1] &&
+                scg__read_u16_be(p + 4) == png->key[2]) {
+                a = 0;
+            }
+            dest[i] = scg__pack_argb(p[0], p[2], p[4], a);
+        } else if (png->color_type == 4) {
+            dest[i] = scg__pack_argb(p[0], p[0], p[0], p[2]);
+        } else {
+            dest[i] = scg__pack_argb(p[0], p[2], p[4], p[6]);
+        }
+    }
 }
 
-//
-// scg_keyboard_is_key_down implementation
-//
-
-bool scg_keyboard_is_key_down(scg_keyboard_t *keyboard, scg_key_code_t key) {
-    return keyboard->current_key_states[key] == 1;
+static size_t scg__png_row_size(const scg__png_t *png, int width) {
+    return ((size_t)width * png->num_channels * png->bit_depth + 7) / 8;
 }
 
-//
-// scg_keyboard_is_key_up implementation
-//
+static bool scg__png_read_header(scg__png_t *png, const uint8_t *chunk,
+                                 uint32_t length) {
+    if (length != 13) {
+        return false;
+    }
 
-bool scg_keyboard_is_key_up(scg_keyboard_t *keyboard, scg_key_code_t key) {
-    return keyboard->current_key_states[key] == 0;
-}
+    // Sizes beyond the limit are clamped so that allocating fails cleanly.
+    uint32_t width = scg__read_u32_be(chunk);
+    uint32_t height = scg__read_u32_be(chunk + 4);
+    png->width = (int)(width <= SCG__IMAGE_MAX_SIZE ? width
+                                                   : SCG__IMAGE_MAX_SIZE + 1);
+    png->height = (int)(height <= SCG__IMAGE_MAX_SIZE ? height
+                                                     : SCG__IMAGE_MAX_SIZE + 1);
+    png->bit_depth = chunk[8];
+    png->color_type = chunk[9];
+    png->is_interlaced = chunk[12] == 1;
+
+    // Compression and filter methods have a single defined value.
+    if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1) {
+        return false;
+    }
 
-//
-// scg_keyboard_is_key_triggered implementation
-//
+    int depth = png->bit_depth;
+    switch (png->color_type) {
+    case 0:
+        png->num_channels = 1;
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8 ||
+               depth == 16;
+    case 3:
+        png->num_channels = 1;
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case 2:
+        png->num_channels = 3;
+        break;
+    case 4:
+        png->num_channels = 2;
+        break;
+    case 6:
+        png->num_channels = 4;
+        break;
+    default:
+        return false;
+    }
 
-bool scg_keyboard_is_key_triggered(scg_keyboard_t *keyboard,
-                                   scg_key_code_t key) {
-    return keyboard->last_frame_key_states[key] == 0 &&
-           keyboard->current_key_states[key] == 1;
+    return depth == 8 || depth == 16;
 }
 
-//
-// scg_mouse_is_button_down implementation
-//
+static bool scg__png_read_transparency(scg__png_t *png, const uint8_t *chunk,
+                                       uint32_t length) {
+    if (png->color_type == 3) {
+        if (length > 256) {
+            return false;
+        }
+        for (uint32_t i = 0; i < length; i++) {
+            png->palette[i] = (png->palette[i] & 0x00FFFFFF) |
+                              (uint32_t)chunk[i] << 24;
+        }
 
-bool scg_mouse_is_button_down(scg_mouse_t *mouse, scg_mouse_button_t button) {
-    return mouse->button_state & SDL_BUTTON(button);
-}
+        return true;
+    }
 
-//
-// scg_mouse_is_button_up implementation
-//
+    int num_samples = png->color_type == 0 ? 1 : 3;
+    if ((png->color_type != 0 && png->color_type != 2) ||
+        length != (uint32_t)num_samples * 2) {
+        return false;
+    }
 
-bool scg_mouse_is_button_up(scg_mouse_t *mouse, scg_mouse_button_t button) {
-    return !(mouse->button_state & SDL_BUTTON(button));
+    for (int i = 0; i < num_samples; i++) {
+        png->key[i] = scg__read_u16_be(chunk + i * 2);
+    }
+    png->has_key = true;
+
+    return true;
 }
 
-//
-// scg_sound_new_from_wav implementation
-//
+static scg_image_t *scg__image_decode_png(const uint8_t *data, size_t size,
+                                          const char *name,
+                                          scg_arena_t *arena) {
+    static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    // Origin and spacing of the 7 Adam7 passes.
+    static const int adam7[7][4] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8},
+                                    {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2},
+                                    {0, 1, 1, 2}};
+    static const int progressive[1][4] = {{0, 0, 1, 1}};
 
-scg_sound_t *scg_sound_new_from_wav(scg_audio_t *audio, const char *filepath,
-                                    bool loop) {
-    if (audio->num_sounds == SCG__MAX_SOUNDS) {
-        scg_log_error("Maximum sounds reached");
+    if (size < 8 || memcmp(data, signature, 8) != 0) {
+        scg_log_errorf("Image %s is not a PNG file", name);
 
         return NULL;
     }
 
-    SDL_AudioSpec spec;
-    uint32_t length;
-    uint8_t *buffer;
+    scg__png_t png;
+    memset(&png, 0, sizeof(png));
 
-    if (SDL_LoadWAV(filepath, &spec, &buffer, &length) == NULL) {
-        scg_log_errorf("Failed to load WAV file at %s. %s", filepath,
-                       SDL_GetError());
+    // Find the header, palette and the total size of the image data, which
+    // may be split over many chunks.
+    const uint8_t *first_data = NULL;
+    size_t data_size = 0;
+    int num_data_chunks = 0;
+    bool has_header = false;
+    const char *error = NULL;
+
+    for (size_t offset = 8; error == NULL;) {
+        if (size - offset < 12) {
+            error = "the file is truncated";
+            break;
+        }
+
+        uint32_t length = scg__read_u32_be(data + offset);
+        const uint8_t *type = data + offset + 4;
+        const uint8_t *chunk = data + offset + 8;
+        if (length > size - offset - 12) {
+            error = "the file is truncated";
+            break;
+        }
+        offset += 12 + (size_t)length;
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (!scg__png_read_header(&png, chunk, length)) {
+                error = "the header is invalid";
+            }
+            has_header = true;
+        } else if (!has_header) {
+            error = "the header is missing";
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            if (length % 3 != 0 || length > 256 * 3) {
+                error = "the palette is invalid";
+                break;
+            }
+            png.palette_size = (int)length / 3;
+            for (int i = 0; i < png.palette_size; i++) {
+                const uint8_t *p = chunk + i * 3;
+                png.palette[i] = scg__pack_argb(p[0], p[1], p[2], 0xFF);
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (!scg__png_read_transparency(&png, chunk, length)) {
+                error = "the transparency is invalid";
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            if (first_data == NULL) {
+                first_data = type;
+            }
+            data_size += length;
+            num_data_chunks++;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        } else if (!(type[0] & 0x20)) {
+            error = "it has an unknown critical chunk";
+        }
+    }
+
+    if (error == NULL && first_data == NULL) {
+        error = "the image data is missing";
+    }
+    if (error == NULL && png.color_type == 3 && png.palette_size == 0) {
+        error = "the palette is missing";
+    }
+    if (error != NULL) {
+        scg_log_errorf("Failed to decode PNG image %s, %s", name, error);
 
         return NULL;
     }
 
-    scg_sound_t *sound = malloc(sizeof(*sound));
-    if (sound == NULL) {
-        scg_log_error("Failed to allocate memory for sound");
+    // Gray images up to 8 bits go through the palette as well.
+    if (png.color_type == 0 && png.bit_depth <= 8) {
+        int max_value = (1 << png.bit_depth) - 1;
+        for (int i = 0; i <= max_value; i++) {
+            uint32_t gray = (uint32_t)(i * 255 / max_value);
+            uint32_t alpha =
+                png.has_key && png.key[0] == (uint32_t)i ? 0 : 0xFF;
+            png.palette[i] = scg__pack_argb(gray, gray, gray, alpha);
+        }
+    } else if (png.color_type == 3) {
+        for (int i = png.palette_size; i < 256; i++) {
+            png.palette[i] = 0xFF000000;
+        }
+    }
 
-        SDL_FreeWAV(buffer);
+    scg_image_t *image = scg__image_alloc(png.width, png.height, name, arena);
+    if (image == NULL) {
         return NULL;
     }
 
-    sound->sdl_spec = spec;
-    sound->length = length;
-    sound->buffer = buffer;
-    sound->play_offset = 0;
-    sound->end_position = buffer + length;
-    sound->is_playing = false;
-    sound->loop = loop;
+    const int(*passes)[4] = png.is_interlaced ? adam7 : progressive;
+    int num_passes = png.is_interlaced ? 7 : 1;
+    int bpp = scg_max_int(1, png.num_channels * png.bit_depth / 8);
+
+    size_t raw_size = 0;
+    size_t max_row_size = 0;
+    for (int i = 0; i < num_passes; i++) {
+        int pass_w = (png.width - passes[i][0] + passes[i][2] - 1) /
+                     passes[i][2];
+        int pass_h = (png.height - passes[i][1] + passes[i][3] - 1) /
+                     passes[i][3];
+        if (pass_w > 0 && pass_h > 0) {
+            size_t row_size = scg__png_row_size(&png, pass_w);
+            raw_size += (row_size + 1) * pass_h;
+            max_row_size = row_size > max_row_size ? row_size : max_row_size;
+        }
+    }
 
-    audio->sounds[audio->num_sounds++] = sound;
+    // Image data split over several chunks is joined before inflating.
+    uint8_t *joined = NULL;
+    const uint8_t *compressed = first_data + 4;
+    if (num_data_chunks > 1) {
+        joined = malloc(data_size);
+        if (joined == NULL) {
+            scg_log_errorf("Failed to allocate memory for image %s", name);
 
-    return sound;
-}
+            scg_image_free(image);
+            return NULL;
+        }
 
-//
-// scg_sound_play implementation
-//
+        size_t joined_size = 0;
+        for (const uint8_t *chunk = first_data - 4;
+             joined_size < data_size;) {
+            uint32_t length = scg__read_u32_be(chunk);
+            if (memcmp(chunk + 4, "IDAT", 4) == 0) {
+                memcpy(joined + joined_size, chunk + 8, length);
+                joined_size += length;
+            }
+            chunk += 12 + (size_t)length;
+        }
 
-void scg_sound_play(scg_sound_t *sound) {
-    if (!sound->is_playing) {
-        sound->is_playing = true;
+        compressed = joined;
     }
-}
 
-//
-// scg_sound_get_position implementation
-//
+    uint8_t *raw = malloc(raw_size);
+    uint8_t *zero_row = calloc(max_row_size, 1);
+    uint32_t *pass_row = png.is_interlaced
+                             ? malloc(png.width * sizeof(*pass_row))
+                             : NULL;
+    if (raw == NULL || zero_row == NULL ||
+        (png.is_interlaced && pass_row == NULL)) {
+        scg_log_errorf("Failed to allocate memory for image %s", name);
+
+        free(pass_row);
+        free(zero_row);
+        free(raw);
+        free(joined);
+        scg_image_free(image);
+        return NULL;
+    }
 
-float32_t scg_sound_get_position(scg_sound_t *sound) {
-    if (!sound->is_playing) {
-        return 0.0f;
+    bool ok = scg__inflate(compressed, data_size, raw, raw_size);
+    free(joined);
+    if (!ok) {
+        error = "the image data is corrupt";
     }
 
-    return (float32_t)sound->play_offset / (float32_t)sound->length;
-}
+    // Unfilter each row in place and convert it straight into the image,
+    // scattering the rows of interlaced passes.
+    uint8_t *row = raw;
+    for (int i = 0; ok && i < num_passes; i++) {
+        int x0 = passes[i][0];
+        int y0 = passes[i][1];
+        int dx = passes[i][2];
+        int dy = passes[i][3];
+        int pass_w = (png.width - x0 + dx - 1) / dx;
+        int pass_h = (png.height - y0 + dy - 1) / dy;
+        if (pass_w <= 0 || pass_h <= 0) {
+            continue;
+        }
 
-//
-// scg_config_new_default implementation
-//
+        size_t row_size = scg__png_row_size(&png, pass_w);
+        const uint8_t *prior = zero_row;
 
-scg_config_t scg_config_new_default(void) {
-    return (scg_config_t){
-        .video = {.width = 640,
-                  .height = 480,
-                  .title = "SCG Application",
-                  .scale = 1,
-                  .fullscreen = false,
-                  .vsync = true,
-                  .lock_fps = true,
-                  .show_frame_metrics = true},
-        .input = {.hide_mouse_cursor = true},
-        .audio = {.enabled = false, .volume = SCG__MAX_VOLUME / 2}};
-}
+        for (int y = 0; y < pass_h; y++) {
+            if (!scg__png_unfilter(row + 1, prior, row_size, bpp, row[0])) {
+                error = "a row has an unknown filter";
+                ok = false;
+                break;
+            }
 
-//
-// scg_app_init implementation
-//
+            uint32_t *dest_row = scg__image_row(image, y0 + y * dy);
+            if (!png.is_interlaced) {
+                scg__png_convert_row(&png, row + 1, dest_row, pass_w);
+            } else {
+                scg__png_convert_row(&png, row + 1, pass_row, pass_w);
+                for (int x = 0; x < pass_w; x++) {
+                    dest_row[x0 + x * dx] = pass_row[x];
+                }
+            }
 
-void scg_app_init(scg_app_t *app, scg_config_t config) {
-    // Initialise the SDL library.
-    {
-        uint32_t flags = SDL_INIT_VIDEO;
-        if (config.audio.enabled) {
-            flags |= SDL_INIT_AUDIO;
+            prior = row + 1;
+            row += row_size + 1;
         }
+    }
 
-        if (SDL_Init(flags) != 0) {
-            scg_log_errorf("Failed to initialise SDL. %s", SDL_GetError());
+    free(pass_row);
+    free(zero_row);
+    free(raw);
 
-            exit(EXIT_FAILURE);
-        }
+    if (!ok) {
+        scg_log_errorf("Failed to decode PNG image %s, %s", name, error);
+
+        scg_image_free(image);
+        return NULL;
     }
 
-    scg_image_t *draw_target =
-        scg_image_new(config.video.width, config.video.height);
-    if (draw_target == NULL) {
-        scg_log_error("Failed to create draw target");
+    return image;
+}
 
-        SDL_Quit();
-        exit(EXIT_FAILURE);
+static scg_image_t *scg__image_decode_qoi(const uint8_t *data, size_t size,
+                                          const char *name,
+                                          scg_arena_t *arena) {
+    const size_t header_size = 14;
+    const size_t padding_size = 8;
+
+    if (size < header_size + padding_size || memcmp(data, "qoif", 4) != 0) {
+        scg_log_errorf("Image %s is not a QOI file", name);
+
+        return NULL;
     }
 
-    scg__screen_t *screen =
-        scg__screen_new(draw_target, config.video.title, config.video.scale,
-                        config.video.fullscreen, config.video.vsync,
-                        config.video.lock_fps, config.input.hide_mouse_cursor);
-    if (screen == NULL) {
-        scg_log_error("Failed to create screen");
+    uint32_t width = scg__read_u32_be(data + 4);
+    uint32_t height = scg__read_u32_be(data + 8);
+    scg_image_t *image = scg__image_alloc(
+        (int)(width <= SCG__IMAGE_MAX_SIZE ? width : SCG__IMAGE_MAX_SIZE + 1),
+        (int)(height <= SCG__IMAGE_MAX_SIZE ? height
+                                            : SCG__IMAGE_MAX_SIZE + 1),
+        name, arena);
+    if (image == NULL) {
+        return NULL;
+    }
 
-        scg_image_free(draw_target);
-        SDL_Quit();
-        exit(EXIT_FAILURE);
+    uint32_t seen[64] = {0};
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 0xFF;
+    uint32_t pixel = 0xFF000000;
+    int run = 0;
+
+    const uint8_t *p = data + header_size;
+    const uint8_t *end = data + size - padding_size;
+    uint32_t *dest = image->pixels;
+    size_t num_pixels = (size_t)image->width * image->height;
+    bool is_truncated = false;
+
+    for (size_t i = 0; i < num_pixels; i++) {
+        if (run > 0) {
+            run--;
+            dest[i] = pixel;
+            continue;
+        }
+
+        if (p == end) {
+            is_truncated = true;
+            break;
+        }
+
+        int op = *p++;
+
+        if (op == 0xFE) {
+            if (end - p < 3) {
+                is_truncated = true;
+                break;
+            }
+            r = p[0];
+            g = p[1];
+            b = p[2];
+            p += 3;
+        } else if (op == 0xFF) {
+            if (end - p < 4) {
+                is_truncated = true;
+                break;
+            }
+            r = p[0];
+            g = p[1];
+            b = p[2];
+            a = p[3];
+            p += 4;
+        } else if ((op & 0xC0) == 0x00) {
+            pixel = seen[op];
+            a = (uint8_t)(pixel >> 24);
+            r = (uint8_t)(pixel >> 16);
+            g = (uint8_t)(pixel >> 8);
+            b = (uint8_t)pixel;
+        } else if ((op & 0xC0) == 0x40) {
+            r += ((op >> 4) & 0x03) - 2;
+            g += ((op >> 2) & 0x03) - 2;
+            b += (op & 0x03) - 2;
+        } else if ((op & 0xC0) == 0x80) {
+            if (p == end) {
+                is_truncated = true;
+                break;
+            }
+            int op2 = *p++;
+            int dg = (op & 0x3F) - 32;
+            r += dg - 8 + ((op2 >> 4) & 0x0F);
+            g += dg;
+            b += dg - 8 + (op2 & 0x0F);
+        } else {
+            run = op & 0x3F;
+        }
+
+        pixel = scg__pack_argb(r, g, b, a);
+        seen[(r * 3 + g * 5 + b * 7 + a * 11) % 64] = pixel;
+
+        dest[i] = pixel;
     }
 
-    scg_keyboard_t *keyboard = scg__keyboard_new();
-    if (keyboard == NULL) {
-        scg_log_error("Failed to create keyboard");
+    if (is_truncated) {
+        scg_log_errorf("Failed to decode QOI image %s, the data is truncated",
+                       name);
 
-        scg__screen_free(screen);
-        scg_image_free(draw_target);
-        SDL_Quit();
-        exit(EXIT_FAILURE);
+        scg_image_free(image);
+        return NULL;
     }
 
-    scg_mouse_t *mouse = scg__mouse_new();
-    if (mouse == NULL) {
-        scg_log_error("Failed to create mouse");
+    return image;
+}
 
-        free(keyboard);
-        scg__screen_free(screen);
-        scg_image_free(draw_target);
-        SDL_Quit();
-        exit(EXIT_FAILURE);
+static inline uint32_t scg__tga_read_pixel(const uint8_t *p, int depth,
+                                           bool has_alpha) {
+    switch (depth) {
+    case 8:
+        return scg__pack_argb(p[0], p[0], p[0], 0xFF);
+    case 15:
+    case 16: {
+        uint32_t value = (uint32_t)p[0] | (uint32_t)p[1] << 8;
+        uint32_t r = (value >> 10) & 0x1F;
+        uint32_t g = (value >> 5) & 0x1F;
+        uint32_t b = value & 0x1F;
+
+        return scg__pack_argb(r << 3 | r >> 2, g << 3 | g >> 2, b << 3 | b >> 2,
+                              0xFF);
+    }
+    case 24:
+        return scg__pack_argb(p[2], p[1], p[0], 0xFF);
+    default:
+        return scg__pack_argb(p[2], p[1], p[0], has_alpha ? p[3] : 0xFF);
     }
-    scg__mouse_update(mouse, draw_target->width, draw_target->height,
-                      screen->window_width, screen->window_height);
+}
 
-    scg_audio_t *audio = NULL;
-    if (config.audio.enabled) {
-        audio = scg__audio_new();
-        if (audio == NULL) {
-            scg_log_error("Failed to create sound device");
+static scg_image_t *scg__image_decode_tga(const uint8_t *data, size_t size,
+                                          const char *name,
+                                          scg_arena_t *arena) {
+    const size_t header_size = 18;
 
-            free(keyboard);
-            scg__screen_free(screen);
-            scg_image_free(draw_target);
-            exit(EXIT_FAILURE);
-        }
+    if (size < header_size) {
+        scg_log_errorf("Image %s is not a TGA file", name);
+
+        return NULL;
     }
 
-    scg__decode_font_data(scg__font8x8, SCG__FONT_NUM_CHARS * SCG_FONT_SIZE,
-                          scg__font8x8_data);
-    scg__decode_font_data(scg__font8x8_hiragana,
-                          SCG__FONT_HIRAGANA_NUM_CHARS * SCG_FONT_SIZE,
-                          scg__font8x8_hiragana_data);
+    int id_length = data[0];
+    int color_map_type = data[1];
+    int image_type = data[2];
+    int color_map_first = (int)scg__read_u16_le(data + 3);
+    int color_map_length = (int)scg__read_u16_le(data + 5);
+    int color_map_depth = data[7];
+    int width = (int)scg__read_u16_le(data + 12);
+    int height = (int)scg__read_u16_le(data + 14);
+    int depth = data[16];
+    int descriptor = data[17];
+
+    bool is_mapped = image_type == 1 || image_type == 9;
+    bool is_gray = image_type == 3 || image_type == 11;
+    bool is_rle = image_type >= 9;
+    // 32 bit images without alpha bits in the descriptor often leave the
+    // alpha channel zeroed.
+    bool has_alpha = (descriptor & 0x0F) != 0;
+
+    bool is_valid;
+    if (is_mapped) {
+        is_valid = color_map_type == 1 && depth == 8 &&
+                   (color_map_depth == 15 || color_map_depth == 16 ||
+                    color_map_depth == 24 || color_map_depth == 32);
+    } else if (is_gray) {
+        is_valid = depth == 8;
+    } else if (image_type == 2 || image_type == 10) {
+        is_valid = depth == 15 || depth == 16 || depth == 24 || depth == 32;
+    } else {
+        is_valid = false;
+    }
 
-    // Log some information to stdout.
-    {
-        scg_log_infof("Application '%s' successfuly initialised. "
-                      "Width: %d, Height: %d, Target FPS: %d, VSync: %d",
-                      config.video.title, draw_target->width,
-                      draw_target->height, screen->target_fps, screen->vsync);
-        if (config.audio.enabled) {
-            scg_log_infof("Audio successfuly initialised. "
-                          "Device ID: %d, Channels: %d, Samples/sec: %d, "
-                          "Samples/frame: %d, Bytes/sample: %d",
-                          audio->device_id, audio->num_channels,
-                          audio->frequency, audio->latency_sample_count,
-                          audio->bytes_per_sample);
-        }
+    if (!is_valid || color_map_type > 1) {
+        scg_log_errorf("Image %s is not a supported TGA file", name);
 
-        SDL_RendererInfo info;
-        SDL_GetRendererInfo(screen->sdl_renderer, &info);
-        scg_log_infof("Renderer name: %s", info.name);
+        return NULL;
+    }
 
-        char buffer[1024] = "";
-        for (unsigned int i = 0; i < info.num_texture_formats; i++) {
-            strcat(buffer, SDL_GetPixelFormatName(info.texture_formats[i]));
-            if (i != info.num_texture_formats - 1) {
-                strcat(buffer, ", ");
-            }
-        }
-        scg_log_infof("Supported texture formats: %s", buffer);
+    int entry_size = (color_map_depth + 7) / 8;
+    size_t color_map_size =
+        color_map_type == 1 ? (size_t)color_map_length * entry_size : 0;
+    if (size - header_size < id_length + color_map_size) {
+        scg_log_errorf("Failed to decode TGA image %s, the file is truncated",
+                       name);
+
+        return NULL;
     }
 
-    app->running = true;
-    app->config = config;
-    app->draw_target = draw_target;
-    app->screen = screen;
-    app->keyboard = keyboard;
-    app->mouse = mouse;
-    app->audio = audio;
-    app->delta_time = 0.0f;
-    app->elapsed_time = 0.0f;
-    app->delta_time_counter = scg_get_performance_counter();
-}
+    // Color maps are expanded to pixels up front, other images read their
+    // pixels straight from the file.
+    const uint8_t *color_map = data + header_size + id_length;
+    uint32_t palette[256] = {0};
+    for (int i = 0; is_mapped && i < 256; i++) {
+        int entry = i - color_map_first;
+        palette[i] = entry >= 0 && entry < color_map_length
+                         ? scg__tga_read_pixel(color_map + entry * entry_size,
+                                               color_map_depth, has_alpha)
+                         : 0xFF000000;
+    }
 
-//
-// scg_app_process_events implementation
-//
+    scg_image_t *image = scg__image_alloc(width, height, name, arena);
+    if (image == NULL) {
+        return NULL;
+    }
 
-bool scg_app_process_events(scg_app_t *app) {
-    // Handle events that need to be polled. This may include
-    // text input, mouse events, and game controller events.
-    {
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            switch (event.type) {
-            case SDL_QUIT:
-                app->running = false;
-                return false;
-            case SDL_KEYDOWN:
-                app->keyboard->current_key_states[event.key.keysym.scancode] =
-                    true;
-                break;
-            case SDL_KEYUP:
-                app->keyboard->current_key_states[event.key.keysym.scancode] =
-                    false;
-                break;
-            case SDL_MOUSEBUTTONUP:
-            case SDL_MOUSEBUTTONDOWN:
-            case SDL_MOUSEMOTION:
-                scg__mouse_update(app->mouse, app->draw_target->width,
-                                  app->draw_target->height,
-                                  app->screen->window_width,
-                                  app->screen->window_height);
+    bool is_top_down = (descriptor & 0x20) != 0;
+    bool is_right_to_left = (descriptor & 0x10) != 0;
+    const uint8_t *p = color_map + color_map_size;
+    int pixel_size = (depth + 7) / 8;
+    const uint8_t *end = data + size;
+    bool is_truncated = false;
+
+    int count = 0;
+    bool is_run = false;
+    uint32_t run_pixel = 0;
+
+    for (int y = 0; y < height && !is_truncated; y++) {
+        uint32_t *dest =
+            scg__image_row(image, is_top_down ? y : height - 1 - y);
+
+        if (!is_rle) {
+            if ((size_t)(end - p) < (size_t)width * pixel_size) {
+                is_truncated = true;
                 break;
             }
+
+            if (is_mapped || is_gray) {
+                for (int x = 0; x < width; x++) {
+                    dest[x] = is_mapped ? palette[p[x]]
+                                        : scg__pack_argb(p[x], p[x], p[x],
+                                                         0xFF);
+                }
+            } else if (depth == 24) {
+                scg__pixels_from_bgr(p, dest, width);
+            } else if (depth == 32 && has_alpha) {
+                scg__pixels_from_bgra(p, dest, width);
+            } else {
+                for (int x = 0; x < width; x++) {
+                    dest[x] =
+                        scg__tga_read_pixel(p + x * pixel_size, depth, false);
+                }
+            }
+
+            p += (size_t)width * pixel_size;
+        } else {
+            // Run length packets may cross rows.
+            for (int x = 0; x < width; x++) {
+                if (count == 0) {
+                    if (end - p < 1 + pixel_size) {
+                        is_truncated = true;
+                        break;
+                    }
+
+                    is_run = (*p & 0x80) != 0;
+                    count = (*p++ & 0x7F) + 1;
+                    if (is_run) {
+                        run_pixel = is_mapped ? palette[*p]
+                                              : scg__tga_read_pixel(
+                                                    p, depth, has_alpha);
+                        p += pixel_size;
+                    }
+                }
+
+                if (is_run) {
+                    dest[x] = run_pixel;
+                } else {
+                    if (end - p < pixel_size) {
+                        is_truncated = true;
+                        break;
+                    }
+                    dest[x] = is_mapped ? palette[*p]
+                                        : scg__tga_read_pixel(p, depth,
+                                                              has_alpha);
+                    p += pixel_size;
+                }
+                count--;
+            }
+        }
+
+        if (is_right_to_left) {
+            for (int x = 0; x < width / 2; x++) {
+                uint32_t pixel = dest[x];
+                dest[x] = dest[width - 1 - x];
+                dest[width - 1 - x] = pixel;
+            }
         }
     }
 
-    if (scg_keyboard_is_key_triggered(app->keyboard, SCG_KEY_ESCAPE)) {
-        app->running = false;
+    if (is_truncated) {
+        scg_log_errorf("Failed to decode TGA image %s, the data is truncated",
+                       name);
+
+        scg_image_free(image);
+        return NULL;
+    }
+
+    return image;
+}
+
+static bool scg__image_is_tga(const uint8_t *data, size_t size) {
+    if (size < 18 || data[1] > 1) {
         return false;
     }
 
-    // Calculate the delta time and elapsed time in seconds.
-    // This is useful for apps that want some quick consistent animation
-    // and don't care about fixed updates.
-    {
-        uint64_t now = scg_get_performance_counter();
-        app->delta_time =
-            scg_get_elapsed_time_secs(now, app->delta_time_counter);
-        app->delta_time_counter = now;
+    int image_type = data[2];
+    int depth = data[16];
 
-        app->elapsed_time += app->delta_time;
+    return ((image_type == 1 || image_type == 9) && depth == 8) ||
+           ((image_type == 3 || image_type == 11) && depth == 8) ||
+           ((image_type == 2 || image_type == 10) &&
+            (depth == 15 || depth == 16 || depth == 24 || depth == 32));
+}
+
+static scg_image_t *scg__image_decode(const uint8_t *data, size_t size,
+                                      const char *name, scg_arena_t *arena) {
+    if (size >= 8 && memcmp(data, "\x89PNG", 4) == 0) {
+        return scg__image_decode_png(data, size, name, arena);
     }
 
-    return true;
+    if (size >= 4 && memcmp(data, "qoif", 4) == 0) {
+        return scg__image_decode_qoi(data, size, name, arena);
+    }
+
+    if (size >= 2 && data[0] == 'B' && data[1] == 'M') {
+        SDL_Surface *surface =
+            SDL_LoadBMP_RW(SDL_RWFromConstMem(data, (int)size), 1);
+        if (surface == NULL) {
+            scg_log_errorf("Failed to load image %s. %s", name,
+                           SDL_GetError());
+
+            return NULL;
+        }
+
+        scg_image_t *image = scg__image_new_from_surface(surface, name, arena);
+        SDL_FreeSurface(surface);
+
+        return image;
+    }
+
+    // TGA has no signature, so it is tried last.
+    if (scg__image_is_tga(data, size)) {
+        return scg__image_decode_tga(data, size, name, arena);
+    }
+
+    scg_log_errorf("Image %s has an unknown format", name);
+
+    return NULL;
+}
+
+typedef scg_image_t *(*scg__image_decoder_t)(const uint8_t *data, size_t size,
+                                             const char *name,
+                                             scg_arena_t *arena);
+
+static scg_image_t *scg__image_load(const char *filepath,
+                                    scg__image_decoder_t decode,
+                                    scg_arena_t *arena) {
+    size_t size;
+    uint8_t *data = scg__read_file(filepath, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    scg_image_t *image = decode(data, size, filepath, arena);
+    free(data);
+
+    return image;
 }
 
 //
-// scg_app_present implementation
+// scg_image_new_from_png implementation
 //
 
-void scg_app_present(scg_app_t *app) {
-    if (app->config.video.show_frame_metrics) {
-        scg_image_draw_frame_metrics(app->draw_target,
-                                     app->screen->frame_metrics);
-    }
+scg_image_t *scg_image_new_from_png(const char *filepath) {
+    return scg__image_load(filepath, scg__image_decode_png, NULL);
+}
 
-    scg__keyboard_update_keystates(app->keyboard);
+//
+// scg_image_new_from_qoi implementation
+//
 
-    if (app->audio != NULL) {
-        scg__audio_update(app->audio);
-    }
+scg_image_t *scg_image_new_from_qoi(const char *filepath) {
+    return scg__image_load(filepath, scg__image_decode_qoi, NULL);
+}
 
-    scg__screen_present(app->screen, app->draw_target);
+//
+// scg_image_new_from_tga implementation
+//
+
+scg_image_t *scg_image_new_from_tga(const char *filepath) {
+    return scg__image_load(filepath, scg__image_decode_tga, NULL);
 }
 
 //
-// scg_app_close implementation
+// scg_image_new_from_file implementation
 //
 
-void scg_app_close(scg_app_t *app) {
-    app->running = false;
+scg_image_t *scg_image_new_from_file(const char *filepath) {
+    return scg__image_load(filepath, scg__image_decode, NULL);
 }
 
 //
-// scg_app_free implementation
+// scg_image_new_from_memory implementation
 //
 
-void scg_app_free(scg_app_t *app) {
-    if (app->audio != NULL) {
-        scg__audio_free(app->audio);
+scg_image_t *scg_image_new_from_memory(const uint8_t *data, size_t size) {
+    return scg__image_decode(data, size, "in memory", NULL);
+}
+
+//
+// scg_image_new_in_arena implementation
+//
+
+scg_image_t *scg_image_new_in_arena(scg_arena_t *arena, int width,
+                                    int height) {
+    scg_image_t *image = scg__image_alloc(width, height, "in arena", arena);
+    if (image == NULL) {
+        return NULL;
     }
 
-    free(app->mouse);
-    free(app->keyboard);
-    scg__screen_free(app->screen);
-    scg_image_free(app->draw_target);
+    memset(image->pixels, 0, (size_t)image->pitch * height);
 
-    SDL_Quit();
+    return image;
 }
 
-// References used for tween functions:
-// - http://robertpenner.com/easing/
-// - https://github.com/warrenm/AHEasing
-// - https://github.com/tweenjs/tween.js
+//
+// scg_image_new_from_file_in_arena implementation
+//
+
+scg_image_t *scg_image_new_from_file_in_arena(scg_arena_t *arena,
+                                              const char *filepath) {
+    // The image is decoded straight into the arena. Nothing else allocates
+    // from it meanwhile, so a file that fails to decode gives back the
+    // space its pixels took.
+    size_t offset = arena->offset;
+
+    scg_image_t *image = scg__image_load(filepath, scg__image_decode, arena);
+    if (image == NULL) {
+        arena->offset = offset;
+    }
+
+    return image;
+}
 
 //
-// scg_tween_linear implementation
+// scg_image_new_sub_image implementation
 //
 
-float32_t scg_tween_linear(float32_t t) {
-    return t;
+scg_image_t *scg_image_new_sub_image(scg_image_t *image, int x, int y,
+                                     int width, int height) {
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 ||
+        x + width > image->width || y + height > image->height) {
+        scg_log_errorf("Sub-image %d,%d %dx%d is outside of the image", x, y,
+                       width, height);
+
+        return NULL;
+    }
+
+    scg_image_t *sub_image = malloc(sizeof(*sub_image));
+    if (sub_image == NULL) {
+        scg_log_error("Failed to allocate memory for image");
+
+        return NULL;
+    }
+
+    sub_image->width = width;
+    sub_image->height = height;
+    sub_image->pitch = image->pitch;
+    sub_image->pixels = scg__image_row(image, y) + x;
+    sub_image->blend_mode = SCG_BLEND_MODE_NONE;
+    sub_image->owns_pixels = false;
+
+    return sub_image;
 }
 
 //
-// scg_tween_exponential_ease_in implementation
+// scg_image_set_blend_mode
 //
 
-float32_t scg_tween_exponential_ease_in(float32_t t) {
-    return (t == 0.0f) ? t : powf(2.0f, 10.0f * (t - 1.0f));
+void scg_image_set_blend_mode(scg_image_t *image, scg_blend_mode_t blend_mode) {
+    image->blend_mode = blend_mode;
 }
 
 //
-// scg_tween_exponential_ease_out implementation
+// scg_image_get_pixel implementation
 //
 
-float32_t scg_tween_exponential_ease_out(float32_t t) {
-    return (t == 1.0f) ? t : 1.0f - powf(2.0f, -10.0f * t);
+scg_pixel_t scg_image_get_pixel(scg_image_t *image, int x, int y) {
+    int w = image->width;
+    int h = image->height;
+
+    if (x < 0 || x >= w || y < 0 || y >= h) {
+        return SCG_COLOR_MAGENTA;
+    }
+
+    return scg_pixel_new_uint32(scg__image_row(image, y)[x]);
+}
+
+static inline uint32_t scg__blend_alpha(uint32_t dest, scg_pixel_t color) {
+    scg_pixel_t d = scg_pixel_new_uint32(dest);
+    float32_t a = (float32_t)(color.data.a / 255.0f);
+    float32_t c = 1.0f - a;
+    float32_t r = a * (float32_t)color.data.r + c * (float32_t)d.data.r;
+    float32_t g = a * (float32_t)color.data.g + c * (float32_t)d.data.g;
+    float32_t b = a * (float32_t)color.data.b + c * (float32_t)d.data.b;
+
+    scg_pixel_t blended_color =
+        scg_pixel_new_rgb((uint8_t)r, (uint8_t)g, (uint8_t)b);
+    return blended_color.packed;
+}
+
+static inline void scg__blend_pixel(uint32_t *dest, uint32_t src,
+                                    scg_blend_mode_t blend_mode) {
+    scg_pixel_t color = scg_pixel_new_uint32(src);
+
+    if (blend_mode == SCG_BLEND_MODE_NONE) {
+        *dest = src;
+    } else if (blend_mode == SCG_BLEND_MODE_MASK) {
+        if (color.data.a == 255) {
+            *dest = src;
+        }
+    } else if (blend_mode == SCG_BLEND_MODE_ALPHA) {
+        *dest = scg__blend_alpha(*dest, color);
+    }
+}
+
+// Blends a row of w pixels, dispatching on the blend mode once per row
+// rather than once per pixel.
+static void scg__blend_row(uint32_t *dest, const uint32_t *src, int w,
+                           scg_blend_mode_t blend_mode) {
+    switch (blend_mode) {
+    case SCG_BLEND_MODE_NONE:
+        memcpy(dest, src, w * sizeof(*dest));
+        break;
+    case SCG_BLEND_MODE_MASK:
+        for (int i = 0; i < w; i++) {
+            if ((src[i] >> 24) == 255) {
+                dest[i] = src[i];
+            }
+        }
+        break;
+    case SCG_BLEND_MODE_ALPHA:
+        for (int i = 0; i < w; i++) {
+            dest[i] = scg__blend_alpha(dest[i], scg_pixel_new_uint32(src[i]));
+        }
+        break;
+    }
 }
 
 //
-// scg_tween_exponential_ease_in_out implementation
+// scg_image_set_pixel implementation
+//
+
+void scg_image_set_pixel(scg_image_t *image, int x, int y, scg_pixel_t color) {
+    int w = image->width;
+    int h = image->height;
+
+    if (x < 0 || x >= w || y < 0 || y >= h) {
+        return;
+    }
+
+    scg__blend_pixel(&scg__image_row(image, y)[x], color.packed,
+                     image->blend_mode);
+}
+
 //
+// scg_image_clear implementation
+//
+
+void scg_image_clear(scg_image_t *image, scg_pixel_t color) {
+    int w = image->width;
+    int h = image->height;
+    uint32_t pixel = color.packed;
+
+    for (int i = 0; i < h; i++) {
+        uint32_t *row = scg__image_row(image, i);
+
+        for (int j = 0; j < w; j++) {
+            row[j] = pixel;
+        }
+    }
+}
+
+// Clips src against dest and the rows [clip_min_y, clip_max_y) once, then
+// blends whole rows.
+static void scg__image_blit(scg_image_t *dest, scg_image_t *src, int x, int y,
+                            scg_blend_mode_t blend_mode, int clip_min_y,
+                            int clip_max_y) {
+    int src_x = 0;
+    int src_y = 0;
+    int w = src->width;
+    int h = src->height;
+    int min_y = scg_max_int(0, clip_min_y);
+    int max_y = scg_min_int(dest->height, clip_max_y);
+
+    if (x < 0) {
+        src_x = -x;
+        w += x;
+        x = 0;
+    }
+    if (y < min_y) {
+        src_y = min_y - y;
+        h -= src_y;
+        y = min_y;
+    }
+    if (x + w > dest->width) {
+        w = dest->width - x;
+    }
+    if (y + h > max_y) {
+        h = max_y - y;
+    }
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < h; i++) {
+        uint32_t *dest_row = scg__image_row(dest, y + i) + x;
+        const uint32_t *src_row = scg__image_row(src, src_y + i) + src_x;
+
+        scg__blend_row(dest_row, src_row, w, blend_mode);
+    }
+}
+
+//
+// scg_image_draw_image implementation
+//
+
+void scg_image_draw_image(scg_image_t *dest, scg_image_t *src, int x, int y) {
+    scg__image_blit(dest, src, x, y, dest->blend_mode, 0, dest->height);
+}
+
+// Computes the area relative to (x, y) that a rotated and scaled draw of src
+// may touch. This is conservative, the rotated image covers a subset of it.
+static void scg__transformed_bounds(scg_image_t *src, float32_t angle,
+                                    float32_t sx, float32_t sy, int *out_minx,
+                                    int *out_miny, int *out_maxx,
+                                    int *out_maxy) {
+    float32_t src_sw = (float32_t)src->width * sx;
+    float32_t src_sh = (float32_t)src->height * sy;
+    float32_t sin_theta = sinf(-angle);
+    float32_t cos_theta = cosf(-angle);
+
+    float32_t a = src_sw * cos_theta;
+    float32_t b = src_sh * cos_theta;
+    float32_t c = src_sw * sin_theta;
+    float32_t d = src_sh * sin_theta;
+    float32_t e = -src_sw * cos_theta;
+    float32_t f = -src_sw * sin_theta;
+    int x0 = (int)(e + d);
+    int y0 = (int)(f - b);
+    int x1 = (int)(a + d);
+    int y1 = (int)(c - b);
+    int x2 = (int)(a - d);
+    int y2 = (int)(c + b);
+    int x3 = (int)(e - d);
+    int y3 = (int)(f + b);
+
+    *out_minx =
+        scg_min_int(0, scg_min_int(scg_min_int(x0, scg_min_int(x1, x2)), x3));
+    *out_miny =
+        scg_min_int(0, scg_min_int(scg_min_int(y0, scg_min_int(y1, y2)), y3));
+    *out_maxx = scg_max_int(x0, scg_max_int(x1, scg_max_int(x2, x3)));
+    *out_maxy = scg_max_int(y0, scg_max_int(y1, scg_max_int(y2, y3)));
+}
+
+static void scg__draw_image_transformed(scg_image_t *dest, scg_image_t *src,
+                                        int x, int y, float32_t angle,
+                                        float32_t sx, float32_t sy,
+                                        scg_blend_mode_t blend_mode,
+                                        int clip_min_y, int clip_max_y) {
+    if (sx <= 0.0f)
+        sx = 1.0f;
+    if (sy <= 0.0f)
+        sy = 1.0f;
+
+    float32_t src_w = src->width;
+    float32_t src_h = src->height;
+    float32_t ratio_x = src_w / (src_w * sx);
+    float32_t ratio_y = src_h / (src_h * sy);
+    float32_t origin_x = src_w * 0.5f;
+    float32_t origin_y = src_h * 0.5f;
+
+    float32_t sin_theta = sinf(-angle);
+    float32_t cos_theta = cosf(-angle);
+
+    int minx, miny, maxx, maxy;
+    scg__transformed_bounds(src, angle, sx, sy, &minx, &miny, &maxx, &maxy);
+
+    // Clip the bounds to the destination once, instead of testing every
+    // destination pixel.
+    minx = scg_max_int(minx, -x);
+    maxx = scg_min_int(maxx, dest->width - x);
+    miny = scg_max_int(miny, scg_max_int(0, clip_min_y) - y);
+    maxy = scg_min_int(maxy, scg_min_int(dest->height, clip_max_y) - y);
+
+    // TODO: Try a pixel subsampling approach to improve the visual quality
+    // of the rotation.
+    // Reference:
+    // http://www.leptonica.org/rotation.html#ROTATION-BY-AREA-MAPPING
+    for (int i = miny; i < maxy; i++) {
+        uint32_t *dest_row = scg__image_row(dest, y + i) + x;
+
+        for (int j = minx; j < maxx; j++) {
+            float32_t image_x = (float32_t)j * ratio_x - origin_x;
+            float32_t image_y = (float32_t)i * ratio_y - origin_y;
+            float32_t xt =
+                (image_x * cos_theta - image_y * sin_theta) + origin_x;
+            float32_t yt =
+                (image_x * sin_theta + image_y * cos_theta) + origin_y;
+
+            if (xt >= 0 && xt < src_w && yt >= 0 && yt < src_h) {
+                uint32_t color = scg__image_row(src, (int)yt)[(int)xt];
+                scg__blend_pixel(&dest_row[j], color, blend_mode);
+            }
+        }
+    }
+}
+
+//
+// scg_image_draw_image_rotate implementation
+//
+
+void scg_image_draw_image_rotate(scg_image_t *dest, scg_image_t *src, int x,
+                                 int y, float32_t angle) {
+    scg__draw_image_transformed(dest, src, x, y, angle, 1.0f, 1.0f,
+                                dest->blend_mode, 0, dest->height);
+}
+
+//
+// scg_image_draw_image_rotate_scale implementation
+//
+
+void scg_image_draw_image_rotate_scale(scg_image_t *dest, scg_image_t *src,
+                                       int x, int y, float32_t angle,
+                                       float32_t sx, float32_t sy) {
+    scg__draw_image_transformed(dest, src, x, y, angle, sx, sy,
+                                dest->blend_mode, 0, dest->height);
+}
+
+//
+// scg_image_draw_line implementation
+//
+
+void scg_image_draw_line(scg_image_t *image, int x0, int y0, int x1, int y1,
+                         scg_pixel_t color) {
+    // Line is vertical
+    if (x0 == x1) {
+        if (y1 < y0) {
+            int tmp = y1;
+            y1 = y0;
+            y0 = tmp;
+        }
+
+        for (int y = y0; y <= y1; y++) {
+            scg_image_set_pixel(image, x0, y, color);
+        }
+
+        return;
+    }
+
+    // Line is horizontal
+    if (y0 == y1) {
+        if (x1 < x0) {
+            int tmp = x1;
+            x1 = x0;
+            x0 = tmp;
+        }
+
+        for (int x = x0; x <= x1; x++) {
+            scg_image_set_pixel(image, x, y0, color);
+        }
+
+        return;
+    }
+
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+
+    int step_x = x0 < x1 ? 1 : -1;
+    int step_y = y0 < y1 ? 1 : -1;
+    int err = (dx > dy ? dx : -dy) / 2;
+    int e2 = 0;
+
+    for (;;) {
+        scg_image_set_pixel(image, x0, y0, color);
+
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+
+        e2 = err;
+        if (e2 > -dx) {
+            err -= dy;
+            x0 += step_x;
+        }
+        if (e2 < dy) {
+            err += dx;
+            y0 += step_y;
+        }
+    }
+}
+
+//
+// scg_image_draw_rect implementation
+//
+
+void scg_image_draw_rect(scg_image_t *image, int x, int y, int w, int h,
+                         scg_pixel_t color) {
+    int minx = x;
+    int miny = y;
+    int maxx = minx + w;
+    int maxy = miny + h;
+
+    scg_image_draw_line(image, minx, miny, maxx, miny, color);
+    scg_image_draw_line(image, maxx, miny, maxx, maxy, color);
+    scg_image_draw_line(image, maxx, maxy, minx, maxy, color);
+    scg_image_draw_line(image, minx, maxy, minx, miny, color);
+}
+
+//
+// scg_image_fill_rect implementation
+//
+
+void scg_image_fill_rect(scg_image_t *image, int x, int y, int w, int h,
+                         scg_pixel_t color) {
+    for (int i = 0; i <= h; i++) {
+        for (int j = 0; j <= w; j++) {
+            scg_image_set_pixel(image, x + j, y + i, color);
+        }
+    }
+}
+
+//
+// scg_image_draw_circle implementation
+//
+
+void scg_image_draw_circle(scg_image_t *image, int x, int y, int r,
+                           scg_pixel_t color) {
+    int f = 1 - r;
+    int ddf_x = 0;
+    int ddf_y = -2 * r;
+    int xi = 0;
+    int yi = r;
+
+    scg_image_set_pixel(image, x, y + r, color);
+    scg_image_set_pixel(image, x, y - r, color);
+    scg_image_set_pixel(image, x + r, y, color);
+    scg_image_set_pixel(image, x - r, y, color);
+
+    while (xi < yi) {
+        if (f >= 0) {
+            yi--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+
+        xi++;
+        ddf_x += 2;
+        f += ddf_x + 1;
+
+        scg_image_set_pixel(image, x + xi, y + yi, color);
+        scg_image_set_pixel(image, x - xi, y + yi, color);
+        scg_image_set_pixel(image, x + xi, y - yi, color);
+        scg_image_set_pixel(image, x - xi, y - yi, color);
+        scg_image_set_pixel(image, x + yi, y + xi, color);
+        scg_image_set_pixel(image, x - yi, y + xi, color);
+        scg_image_set_pixel(image, x + yi, y - xi, color);
+        scg_image_set_pixel(image, x - yi, y - xi, color);
+    }
+}
+
+//
+// scg_image_fill_circle implementation
+//
+
+void scg_image_fill_circle(scg_image_t *image, int x, int y, int r,
+                           scg_pixel_t color) {
+    int f = 1 - r;
+    int ddf_x = 0;
+    int ddf_y = -2 * r;
+    int xi = 0;
+    int yi = r;
+
+    scg_image_draw_line(image, x, y - r, x, y + r, color);
+    scg_image_draw_line(image, x - r, y, x + r, y, color);
+
+    while (xi < yi) {
+        if (f >= 0) {
+            yi--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+
+        xi++;
+        ddf_x += 2;
+        f += ddf_x + 1;
+
+        scg_image_draw_line(image, x - xi, y + yi, x + xi, y + yi, color);
+        scg_image_draw_line(image, x - xi, y - yi, x + xi, y - yi, color);
+        scg_image_draw_line(image, x - yi, y + xi, x + yi, y + xi, color);
+        scg_image_draw_line(image, x - yi, y - xi, x + yi, y - xi, color);
+    }
+}
+
+//
+// scg_set_font implementation
+//
+
+void scg_set_font(const scg_font_t *font) {
+    scg__font = font != NULL ? font : &scg_font8x8;
+}
+
+//
+// scg_get_font implementation
+//
+
+const scg_font_t *scg_get_font(void) {
+    return scg__font;
+}
+
+static inline int scg__font_glyph(const scg_font_t *font, uint32_t code) {
+    if (font->pages != NULL) {
+        uint32_t page = code / SCG__FONT_PAGE_SIZE;
+
+        if (page < SCG__FONT_NUM_PAGES && font->pages[page] != NULL) {
+            int32_t glyph = font->pages[page][code % SCG__FONT_PAGE_SIZE];
+            if (glyph >= 0) {
+                return glyph;
+            }
+        }
+
+        return font->fallback_glyph;
+    }
+
+    int low = 0;
+    int high = font->num_ranges - 1;
+
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        const scg_font_range_t *range = &font->ranges[mid];
+
+        if (code < range->first_code) {
+            high = mid - 1;
+        } else if (code > range->last_code) {
+            low = mid + 1;
+        } else {
+            return range->first_glyph + (int)(code - range->first_code);
+        }
+    }
+
+    return font->fallback_glyph;
+}
+
+// Decodes the code point at *str and advances past it. Invalid or truncated
+// sequences decode to U+FFFD one byte at a time.
+static uint32_t scg__utf8_decode(const char **str) {
+    const uint8_t *bytes = (const uint8_t *)*str;
+    uint32_t code;
+    int length;
+
+    if (bytes[0] < 0x80) {
+        code = bytes[0];
+        length = 1;
+    } else if ((bytes[0] & 0xE0) == 0xC0) {
+        code = bytes[0] & 0x1F;
+        length = 2;
+    } else if ((bytes[0] & 0xF0) == 0xE0) {
+        code = bytes[0] & 0x0F;
+        length = 3;
+    } else if ((bytes[0] & 0xF8) == 0xF0) {
+        code = bytes[0] & 0x07;
+        length = 4;
+    } else {
+        *str += 1;
+        return SCG__FONT_CHAR_CODE_REPLACEMENT;
+    }
+
+    for (int i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            *str += 1;
+            return SCG__FONT_CHAR_CODE_REPLACEMENT;
+        }
+        code = code << 6 | (bytes[i] & 0x3F);
+    }
+
+    // Reject overlong encodings, surrogates and values past U+10FFFF.
+    static const uint32_t min_codes[5] = {0, 0, 0x80, 0x800, 0x10000};
+    if (code < min_codes[length] || code > 0x10FFFF ||
+        (code >= 0xD800 && code <= 0xDFFF)) {
+        *str += 1;
+        return SCG__FONT_CHAR_CODE_REPLACEMENT;
+    }
+
+    *str += length;
+
+    return code;
+}
+
+static int scg__utf8_length(const char *str) {
+    int length = 0;
+
+    while (*str != '\0') {
+        scg__utf8_decode(&str);
+        length++;
+    }
+
+    return length;
+}
+
+// Reads a whole file into a NUL terminated buffer so text formats can be
+// parsed in place.
+static uint8_t *scg__read_file(const char *filepath, size_t *size) {
+    SDL_RWops *file = SDL_RWFromFile(filepath, "rb");
+    if (file == NULL) {
+        scg_log_errorf("Failed to open file at %s. %s", filepath,
+                       SDL_GetError());
+        return NULL;
+    }
+
+    Sint64 file_size = SDL_RWsize(file);
+    if (file_size < 0) {
+        scg_log_errorf("Failed to get size of file at %s. %s", filepath,
+                       SDL_GetError());
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    uint8_t *data = malloc((size_t)file_size + 1);
+    if (data == NULL) {
+        scg_log_error("Failed to allocate memory for file");
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    if (SDL_RWread(file, data, 1, (size_t)file_size) != (size_t)file_size) {
+        scg_log_errorf("Failed to read file at %s. %s", filepath,
+                       SDL_GetError());
+        free(data);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    SDL_RWclose(file);
+    data[file_size] = '\0';
+    *size = (size_t)file_size;
+
+    return data;
+}
+
+static inline uint8_t scg__reverse_bits(uint8_t bits) {
+    bits = (uint8_t)((bits & 0xF0) >> 4 | (bits & 0x0F) << 4);
+    bits = (uint8_t)((bits & 0xCC) >> 2 | (bits & 0x33) << 2);
+    bits = (uint8_t)((bits & 0xAA) >> 1 | (bits & 0x55) << 1);
+
+    return bits;
+}
+
+// Allocates a font with zeroed glyphs and an empty page table for the
+// loaders to fill in. The bitmaps and row bounds are returned separately
+// since the font only exposes them as const.
+static scg_font_t *scg__font_new(int glyph_width, int glyph_height,
+                                 int num_glyphs, uint8_t **bitmaps) {
+    if (glyph_width <= 0 || glyph_height <= 0 || glyph_height > 255 ||
+        num_glyphs <= 0) {
+        scg_log_errorf("Invalid font size %dx%d with %d glyphs", glyph_width,
+                       glyph_height, num_glyphs);
+        return NULL;
+    }
+
+    scg_font_t *font = calloc(1, sizeof(*font));
+    if (font == NULL) {
+        scg_log_error("Failed to allocate memory for font");
+        return NULL;
+    }
+
+    font->glyph_width = glyph_width;
+    font->glyph_height = glyph_height;
+    font->bytes_per_row = (glyph_width + 7) / 8;
+    font->num_glyphs = num_glyphs;
+    font->owns_data = true;
+
+    size_t glyph_size = (size_t)glyph_height * font->bytes_per_row;
+    *bitmaps = calloc(num_glyphs, glyph_size);
+    font->bitmaps = *bitmaps;
+    font->row_bounds = malloc((size_t)num_glyphs * 2);
+    font->pages = calloc(SCG__FONT_NUM_PAGES, sizeof(*font->pages));
+
+    if (font->bitmaps == NULL || font->row_bounds == NULL ||
+        font->pages == NULL) {
+        scg_log_error("Failed to allocate memory for font glyphs");
+        scg_font_free(font);
+        return NULL;
+    }
+
+    return font;
+}
+
+// Maps a code point to a glyph, allocating its page on first use. The first
+// mapping of a code point wins.
+static bool scg__font_map_code(scg_font_t *font, uint32_t code, int glyph) {
+    uint32_t page = code / SCG__FONT_PAGE_SIZE;
+    if (page >= SCG__FONT_NUM_PAGES || glyph < 0 ||
+        glyph >= font->num_glyphs) {
+        return true;
+    }
+
+    if (font->pages[page] == NULL) {
+        int32_t *glyphs =
+            malloc(SCG__FONT_PAGE_SIZE * sizeof(*font->pages[page]));
+        if (glyphs == NULL) {
+            scg_log_error("Failed to allocate memory for font page");
+            return false;
+        }
+
+        for (int i = 0; i < SCG__FONT_PAGE_SIZE; i++) {
+            glyphs[i] = -1;
+        }
+        font->pages[page] = glyphs;
+    }
+
+    if (font->pages[page][code % SCG__FONT_PAGE_SIZE] < 0) {
+        font->pages[page][code % SCG__FONT_PAGE_SIZE] = glyph;
+    }
+
+    return true;
+}
+
+// Picks the glyph drawn for code points the font does not have.
+static void scg__font_find_fallback(scg_font_t *font) {
+    font->fallback_glyph = 0;
+    font->fallback_glyph =
+        scg__font_glyph(font, SCG__FONT_CHAR_CODE_REPLACEMENT);
+    if (font->fallback_glyph == 0) {
+        font->fallback_glyph =
+            scg__font_glyph(font, SCG__FONT_CHAR_CODE_QUESTION_MARK);
+    }
+}
+
+// Computes the row bounds of every glyph and picks the fallback glyph once
+// all glyphs and code points are loaded.
+static void scg__font_finish(scg_font_t *font) {
+    uint8_t *row_bounds = (uint8_t *)font->row_bounds;
+    int row_size = font->bytes_per_row;
+    int glyph_size = font->glyph_height * row_size;
+
+    // Smooth fonts take their bounds from coverage, since faint rows have
+    // no pixels set in the bitmaps.
+    if (font->coverage != NULL) {
+        row_size = font->glyph_width;
+        glyph_size = font->glyph_height * row_size;
+    }
+
+    for (int i = 0; i < font->num_glyphs; i++) {
+        const uint8_t *rows = font->coverage != NULL
+                                  ? font->coverage + i * glyph_size
+                                  : font->bitmaps + i * glyph_size;
+        int first_row = font->glyph_height;
+        int last_row = 0;
+
+        for (int j = 0; j < font->glyph_height; j++) {
+            for (int k = 0; k < row_size; k++) {
+                if (rows[j * row_size + k] != 0) {
+                    first_row = scg_min_int(first_row, j);
+                    last_row = j + 1;
+                    break;
+                }
+            }
+        }
+
+        row_bounds[i * 2] = (uint8_t)(last_row > 0 ? first_row : 0);
+        row_bounds[i * 2 + 1] = (uint8_t)last_row;
+    }
+
+    scg__font_find_fallback(font);
+}
+
+static inline uint32_t scg__read_u32_le(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+           (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+//
+// scg_font_new_from_psf implementation
+//
+
+scg_font_t *scg_font_new_from_psf(const char *filepath) {
+    size_t size;
+    uint8_t *data = scg__read_file(filepath, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    int width, height, num_glyphs;
+    size_t header_size, glyph_size;
+    bool has_table, is_psf2;
+
+    if (size >= 4 && data[0] == 0x36 && data[1] == 0x04) {
+        is_psf2 = false;
+        width = 8;
+        height = data[3];
+        num_glyphs = data[2] & 0x01 ? 512 : 256;
+        has_table = (data[2] & 0x06) != 0;
+        header_size = 4;
+        glyph_size = height;
+    } else if (size >= 32 && scg__read_u32_le(data) == 0x864AB572) {
+        uint32_t psf2_num_glyphs = scg__read_u32_le(data + 16);
+        uint32_t psf2_height = scg__read_u32_le(data + 24);
+        uint32_t psf2_width = scg__read_u32_le(data + 28);
+
+        // Bounded so the sizes below cannot overflow an int.
+        if (psf2_width > 0xFFFF || psf2_height > 0xFFFF ||
+            psf2_num_glyphs > INT_MAX) {
+            scg_log_errorf("PSF font at %s is too large", filepath);
+            free(data);
+            return NULL;
+        }
+
+        is_psf2 = true;
+        header_size = scg__read_u32_le(data + 8);
+        has_table = scg__read_u32_le(data + 12) & 0x01;
+        num_glyphs = (int)psf2_num_glyphs;
+        glyph_size = scg__read_u32_le(data + 20);
+        height = (int)psf2_height;
+        width = (int)psf2_width;
+    } else {
+        scg_log_errorf("File at %s is not a PSF font", filepath);
+        free(data);
+        return NULL;
+    }
+
+    if (width <= 0 || height <= 0 || glyph_size == 0 ||
+        glyph_size != (size_t)height * ((width + 7) / 8) ||
+        header_size > size ||
+        (size - header_size) / glyph_size < (size_t)num_glyphs) {
+        scg_log_errorf("PSF font at %s is truncated or malformed", filepath);
+        free(data);
+        return NULL;
+    }
+
+    uint8_t *bitmaps;
+    scg_font_t *font = scg__font_new(width, height, num_glyphs, &bitmaps);
+    if (font == NULL) {
+        free(data);
+        return NULL;
+    }
+
+    // PSF rows are stored with the leftmost pixel in the high bit.
+    const uint8_t *glyphs = data + header_size;
+    for (size_t i = 0; i < glyph_size * num_glyphs; i++) {
+        bitmaps[i] = scg__reverse_bits(glyphs[i]);
+    }
+
+    bool ok = true;
+    if (!has_table) {
+        for (int i = 0; i < num_glyphs && ok; i++) {
+            ok = scg__font_map_code(font, (uint32_t)i, i);
+        }
+    } else if (!is_psf2) {
+        // Each glyph lists its code points as 16 bit values ended by 0xFFFF.
+        // Sequences of combining characters start with 0xFFFE and are skipped.
+        const uint8_t *entry = glyphs + glyph_size * num_glyphs;
+        const uint8_t *end = data + size;
+
+        for (int i = 0; i < num_glyphs && ok && entry + 1 < end; i++) {
+            bool in_sequence = false;
+
+            for (; entry + 1 < end; entry += 2) {
+                uint32_t code = (uint32_t)entry[0] | (uint32_t)entry[1] << 8;
+
+                if (code == 0xFFFF) {
+                    entry += 2;
+                    break;
+                } else if (code == 0xFFFE) {
+                    in_sequence = true;
+                } else if (!in_sequence) {
+                    ok = ok && scg__font_map_code(font, code, i);
+                }
+            }
+        }
+    } else {
+        // As above, but with UTF-8 code points ended by 0xFF and sequences
+        // started by 0xFE.
+        const char *entry = (const char *)glyphs + glyph_size * num_glyphs;
+        const char *end = (const char *)data + size;
+
+        for (int i = 0; i < num_glyphs && ok && entry < end; i++) {
+            bool in_sequence = false;
+
+            while (entry < end) {
+                uint8_t byte = (uint8_t)*entry;
+
+                if (byte == 0xFF) {
+                    entry++;
+                    break;
+                } else if (byte == 0xFE) {
+                    in_sequence = true;
+                    entry++;
+                } else {
+                    uint32_t code = scg__utf8_decode(&entry);
+                    if (!in_sequence) {
+                        ok = ok && scg__font_map_code(font, code, i);
+                    }
+                }
+            }
+        }
+    }
+
+    free(data);
+
+    if (!ok) {
+        scg_font_free(font);
+        return NULL;
+    }
+
+    scg__font_finish(font);
+
+    return font;
+}
+
+// Returns the next line of a text buffer, NUL terminating it in place.
+static char *scg__next_line(char **text) {
+    char *line = *text;
+    if (*line == '\0') {
+        return NULL;
+    }
+
+    char *end = strchr(line, '\n');
+    if (end != NULL) {
+        *end = '\0';
+        *text = end + 1;
+    } else {
+        *text = line + strlen(line);
+    }
+
+    return line;
+}
+
+static inline int scg__hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+//
+// scg_font_new_from_bdf implementation
+//
+
+scg_font_t *scg_font_new_from_bdf(const char *filepath) {
+    size_t size;
+    char *data = (char *)scg__read_file(filepath, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    int width = 0, height = 0, offset_x = 0, offset_y = 0, num_glyphs = 0;
+    char *text = data;
+    char *line;
+
+    while ((line = scg__next_line(&text)) != NULL) {
+        if (strncmp(line, "FONTBOUNDINGBOX ", 16) == 0) {
+            sscanf(line + 16, "%d %d %d %d", &width, &height, &offset_x,
+                   &offset_y);
+        } else if (strncmp(line, "CHARS ", 6) == 0) {
+            sscanf(line + 6, "%d", &num_glyphs);
+            break;
+        }
+    }
+
+    uint8_t *bitmaps;
+    scg_font_t *font = scg__font_new(width, height, num_glyphs, &bitmaps);
+    if (font == NULL) {
+        scg_log_errorf("Failed to load BDF font at %s", filepath);
+        free(data);
+        return NULL;
+    }
+
+    int row_size = font->bytes_per_row;
+    int glyph = 0;
+    long code = -1;
+    int bbx_w = 0, bbx_h = 0, bbx_x = 0, bbx_y = 0;
+    bool ok = true;
+
+    while (ok && glyph < num_glyphs &&
+           (line = scg__next_line(&text)) != NULL) {
+        if (strncmp(line, "ENCODING ", 9) == 0) {
+            code = strtol(line + 9, NULL, 10);
+        } else if (strncmp(line, "BBX ", 4) == 0) {
+            sscanf(line + 4, "%d %d %d %d", &bbx_w, &bbx_h, &bbx_x, &bbx_y);
+        } else if (strncmp(line, "BITMAP", 6) == 0) {
+            // Glyph rows are hex with the leftmost pixel in the high bit and
+            // are positioned by the glyph box relative to the font box.
+            uint8_t *rows = bitmaps + glyph * height * row_size;
+            int top = (height + offset_y) - (bbx_y + bbx_h);
+            int left = bbx_x - offset_x;
+
+            for (int i = 0; i < bbx_h; i++) {
+                char *hex = scg__next_line(&text);
+                if (hex == NULL) {
+                    break;
+                }
+
+                int row = top + i;
+                for (int j = 0; j < bbx_w && row >= 0 && row < height; j++) {
+                    int bits = scg__hex_digit(hex[j / 4]);
+                    if (bits < 0) {
+                        break;
+                    }
+
+                    int column = left + j;
+                    if ((bits & 8 >> j % 4) && column >= 0 && column < width) {
+                        rows[row * row_size + column / 8] |=
+                            (uint8_t)(1 << column % 8);
+                    }
+                }
+            }
+
+            if (code >= 0) {
+                ok = scg__font_map_code(font, (uint32_t)code, glyph);
+            }
+            glyph++;
+            code = -1;
+        }
+    }
+
+    free(data);
+
+    if (!ok) {
+        scg_font_free(font);
+        return NULL;
+    }
+
+    font->num_glyphs = glyph > 0 ? glyph : 1;
+    scg__font_finish(font);
+
+    return font;
+}
+
+//
+// scg_font_new_from_raw implementation
+//
+
+scg_font_t *scg_font_new_from_raw(const char *filepath, int glyph_width,
+                                  int glyph_height, uint32_t first_code) {
+    size_t size;
+    uint8_t *data = scg__read_file(filepath, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    size_t glyph_size = (size_t)glyph_height * ((glyph_width + 7) / 8);
+    int num_glyphs = glyph_size > 0 ? (int)(size / glyph_size) : 0;
+
+    uint8_t *bitmaps;
+    scg_font_t *font =
+        scg__font_new(glyph_width, glyph_height, num_glyphs, &bitmaps);
+    if (font == NULL) {
+        scg_log_errorf("Failed to load raw font at %s", filepath);
+        free(data);
+        return NULL;
+    }
+
+    memcpy(bitmaps, data, glyph_size * num_glyphs);
+    free(data);
+
+    for (int i = 0; i < num_glyphs; i++) {
+        if (!scg__font_map_code(font, first_code + i, i)) {
+            scg_font_free(font);
+            return NULL;
+        }
+    }
+
+    scg__font_finish(font);
+
+    return font;
+}
+
+// Maps every code point of one font to the same glyphs in another font
+// with the same number of glyphs.
+static bool scg__font_copy_codes(scg_font_t *font, const scg_font_t *src) {
+    if (src->pages != NULL) {
+        for (int i = 0; i < SCG__FONT_NUM_PAGES; i++) {
+            if (src->pages[i] == NULL) {
+                continue;
+            }
+
+            for (int j = 0; j < SCG__FONT_PAGE_SIZE; j++) {
+                uint32_t code = (uint32_t)(i * SCG__FONT_PAGE_SIZE + j);
+                if (!scg__font_map_code(font, code, src->pages[i][j])) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Codes past the last page are never mapped, and clamping to it keeps
+    // the loop from wrapping when a range ends at UINT32_MAX.
+    const uint32_t max_code = SCG__FONT_NUM_PAGES * SCG__FONT_PAGE_SIZE - 1;
+
+    for (int i = 0; i < src->num_ranges; i++) {
+        const scg_font_range_t *range = &src->ranges[i];
+        uint32_t last_code =
+            range->last_code < max_code ? range->last_code : max_code;
+
+        for (uint32_t code = range->first_code; code <= last_code; code++) {
+            int glyph = range->first_glyph + (int)(code - range->first_code);
+            if (!scg__font_map_code(font, code, glyph)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static inline bool scg__font_pixel(const scg_font_t *font, int glyph, int x,
+                                   int y) {
+    const uint8_t *row =
+        font->bitmaps + (glyph * font->glyph_height + y) * font->bytes_per_row;
+
+    return (row[x / 8] >> (x % 8)) & 1;
+}
+
+// Expands every set span of each source row by the scale, then repeats the
+// expanded row scale times.
+static void scg__font_expand_glyphs(scg_font_t *font, uint8_t *bitmaps,
+                                    const scg_font_t *src, int scale) {
+    int row_size = font->bytes_per_row;
+
+    for (int i = 0; i < src->num_glyphs; i++) {
+        for (int y = 0; y < src->glyph_height; y++) {
+            const uint8_t *src_row =
+                src->bitmaps +
+                (i * src->glyph_height + y) * src->bytes_per_row;
+            uint8_t *row =
+                bitmaps + (i * font->glyph_height + y * scale) * row_size;
+
+            for (int b = 0; b < src->bytes_per_row; b++) {
+                const scg__glyph_row_spans_t *spans =
+                    &scg__glyph_row_spans[src_row[b]];
+
+                for (int j = 0; j < spans->num_spans; j++) {
+                    int start = (b * 8 + spans->starts[j]) * scale;
+                    int end = start + spans->lengths[j] * scale;
+
+                    for (int x = start; x < end; x++) {
+                        row[x / 8] |= (uint8_t)(1 << x % 8);
+                    }
+                }
+            }
+
+            for (int j = 1; j < scale; j++) {
+                memcpy(row + j * row_size, row, row_size);
+            }
+        }
+    }
+}
+
+// Box filters each glyph to the new size, so every coverage value is the
+// area of its pixel covered by set source pixels. Pixels of at least half
+// coverage are also set in the bitmaps.
+static void scg__font_filter_glyphs(scg_font_t *font, uint8_t *bitmaps,
+                                    uint8_t *coverage, const scg_font_t *src) {
+    float32_t ratio_x = (float32_t)src->glyph_width / font->glyph_width;
+    float32_t ratio_y = (float32_t)src->glyph_height / font->glyph_height;
+    float32_t inv_area = 1.0f / (ratio_x * ratio_y);
+
+    for (int i = 0; i < src->num_glyphs; i++) {
+        for (int y = 0; y < font->glyph_height; y++) {
+            float32_t y0 = y * ratio_y;
+            float32_t y1 = (y + 1) * ratio_y;
+            uint8_t *row = bitmaps + (i * font->glyph_height + y) *
+                                         font->bytes_per_row;
+
+            for (int x = 0; x < font->glyph_width; x++) {
+                float32_t x0 = x * ratio_x;
+                float32_t x1 = (x + 1) * ratio_x;
+                float32_t area = 0.0f;
+
+                for (int sy = (int)y0; sy < src->glyph_height && sy < y1;
+                     sy++) {
+                    float32_t h = scg_min_float32(y1, (float32_t)sy + 1) -
+                                  scg_max_float32(y0, (float32_t)sy);
+
+                    for (int sx = (int)x0; sx < src->glyph_width && sx < x1;
+                         sx++) {
+                        if (scg__font_pixel(src, i, sx, sy)) {
+                            float32_t w =
+                                scg_min_float32(x1, (float32_t)sx + 1) -
+                                scg_max_float32(x0, (float32_t)sx);
+                            area += w * h;
+                        }
+                    }
+                }
+
+                int value = (int)(area * inv_area * 255.0f + 0.5f);
+                value = scg_min_int(value, 255);
+                coverage[(i * font->glyph_height + y) * font->glyph_width +
+                         x] = (uint8_t)value;
+
+                if (value >= 128) {
+                    row[x / 8] |= (uint8_t)(1 << x % 8);
+                }
+            }
+        }
+    }
+}
+
+//
+// scg_font_new_scaled implementation
+//
+
+scg_font_t *scg_font_new_scaled(const scg_font_t *font, float32_t scale,
+                                bool smooth) {
+    if (font->coverage != NULL) {
+        scg_log_error("Smooth fonts can not be scaled again");
+        return NULL;
+    }
+
+    int scale_int = scg_max_int((int)(scale + 0.5f), 1);
+    int width = smooth ? (int)(font->glyph_width * scale + 0.5f)
+                       : font->glyph_width * scale_int;
+    int height = smooth ? (int)(font->glyph_height * scale + 0.5f)
+                        : font->glyph_height * scale_int;
+
+    uint8_t *bitmaps;
+    scg_font_t *scaled =
+        scg__font_new(width, height, font->num_glyphs, &bitmaps);
+    if (scaled == NULL) {
+        return NULL;
+    }
+
+    if (smooth) {
+        uint8_t *coverage = calloc(font->num_glyphs, (size_t)width * height);
+        if (coverage == NULL) {
+            scg_log_error("Failed to allocate memory for glyph coverage");
+            scg_font_free(scaled);
+            return NULL;
+        }
+
+        scaled->coverage = coverage;
+        scg__font_filter_glyphs(scaled, bitmaps, coverage, font);
+    } else {
+        scg__font_expand_glyphs(scaled, bitmaps, font, scale_int);
+    }
+
+    if (!scg__font_copy_codes(scaled, font)) {
+        scg_font_free(scaled);
+        return NULL;
+    }
+
+    scg__font_finish(scaled);
+    scaled->fallback_glyph = font->fallback_glyph;
+
+    return scaled;
+}
+
+//
+// scg_font_free implementation
+//
+
+void scg_font_free(scg_font_t *font) {
+    if (font == NULL || !font->owns_data) {
+        return;
+    }
+
+    if (scg__font == font) {
+        scg__font = &scg_font8x8;
+    }
+
+    if (font->pages != NULL) {
+        for (int i = 0; i < SCG__FONT_NUM_PAGES; i++) {
+            free(font->pages[i]);
+        }
+        free(font->pages);
+    }
+
+    free((void *)font->bitmaps);
+    free((void *)font->row_bounds);
+    free((void *)font->coverage);
+    free(font);
+}
+
+// Writes the set pixels of one glyph row with no clipping. With SSE2 the
+// row byte is expanded to two 4 pixel masks and the colour is selected into
+// the destination, otherwise the precomputed spans are filled.
+static inline void scg__draw_glyph_row(uint32_t *dest, uint8_t bits,
+                                       uint32_t color) {
+#ifdef SCG__SSE2
+    const __m128i select_lo = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i select_hi = _mm_set_epi32(128, 64, 32, 16);
+    __m128i row_bits = _mm_set1_epi32(bits);
+    __m128i colors = _mm_set1_epi32((int)color);
+
+    __m128i mask_lo =
+        _mm_cmpeq_epi32(_mm_and_si128(row_bits, select_lo), select_lo);
+    __m128i mask_hi =
+        _mm_cmpeq_epi32(_mm_and_si128(row_bits, select_hi), select_hi);
+
+    __m128i *dest_lo = (__m128i *)dest;
+    __m128i *dest_hi = (__m128i *)(dest + 4);
+    __m128i pixels_lo = _mm_andnot_si128(mask_lo, _mm_loadu_si128(dest_lo));
+    __m128i pixels_hi = _mm_andnot_si128(mask_hi, _mm_loadu_si128(dest_hi));
+
+    _mm_storeu_si128(dest_lo,
+                     _mm_or_si128(pixels_lo, _mm_and_si128(mask_lo, colors)));
+    _mm_storeu_si128(dest_hi,
+                     _mm_or_si128(pixels_hi, _mm_and_si128(mask_hi, colors)));
+#else
+    const scg__glyph_row_spans_t *spans = &scg__glyph_row_spans[bits];
+
+    for (int i = 0; i < spans->num_spans; i++) {
+        uint32_t *span = dest + spans->starts[i];
+
+        for (int j = 0; j < spans->lengths[i]; j++) {
+            span[j] = color;
+        }
+    }
+#endif
+}
+
+// Draws the coverage of a smooth glyph, blending partly covered pixels with
+// the colour scaled by their coverage whatever the blend mode.
+static void scg__draw_smooth_glyph(scg_image_t *image, const scg_font_t *font,
+                                   int glyph, int x, int y,
+                                   scg_pixel_t color) {
+    int glyph_width = font->glyph_width;
+    const uint8_t *coverage =
+        font->coverage + glyph * font->glyph_height * glyph_width;
+    const uint8_t *row_bounds = font->row_bounds + glyph * 2;
+    int first_row = scg_max_int(row_bounds[0], -y);
+    int last_row = scg_min_int(row_bounds[1], image->height - y);
+    int first_column = scg_max_int(0, -x);
+    int last_column = scg_min_int(glyph_width, image->width - x);
+    int alpha = image->blend_mode == SCG_BLEND_MODE_ALPHA ? color.data.a : 255;
+
+    for (int i = first_row; i < last_row; i++) {
+        const uint8_t *row = coverage + i * glyph_width;
+        uint32_t *dest = scg__image_row(image, y + i) + x;
+
+        for (int j = first_column; j < last_column; j++) {
+            int a = row[j] * alpha / 255;
+
+            if (a == 255) {
+                dest[j] = color.packed;
+            } else if (a > 0) {
+                scg_pixel_t blended = color;
+                blended.data.a = (uint8_t)a;
+                dest[j] = scg__blend_alpha(dest[j], blended);
+            }
+        }
+    }
+}
+
+// Draws a glyph, choosing the blend once for the whole glyph. Glyphs that are
+// fully inside the image take the unclipped row path, which writes whole
+// bytes of 8 pixels.
+static void scg__draw_glyph(scg_image_t *image, const scg_font_t *font,
+                            int glyph, int x, int y, scg_pixel_t color) {
+    scg_blend_mode_t blend_mode = image->blend_mode;
+    int w = image->width;
+
+    // A masked draw only writes fully opaque colours.
+    if (blend_mode == SCG_BLEND_MODE_MASK && color.data.a != 255) {
+        return;
+    }
+
+    if (font->coverage != NULL) {
+        scg__draw_smooth_glyph(image, font, glyph, x, y, color);
+        return;
+    }
+
+    int bytes_per_row = font->bytes_per_row;
+    const uint8_t *rows =
+        font->bitmaps + glyph * font->glyph_height * bytes_per_row;
+    const uint8_t *row_bounds = font->row_bounds + glyph * 2;
+    int first_row = scg_max_int(row_bounds[0], -y);
+    int last_row = scg_min_int(row_bounds[1], image->height - y);
+    bool inside = x >= 0 && x + bytes_per_row * 8 <= w;
+
+    for (int i = first_row; i < last_row; i++) {
+        uint32_t *dest = scg__image_row(image, y + i) + x;
+
+        for (int b = 0; b < bytes_per_row; b++, dest += 8) {
+            uint8_t bits = rows[i * bytes_per_row + b];
+
+            if (bits == 0) {
+                continue;
+            }
+
+            if (inside && blend_mode != SCG_BLEND_MODE_ALPHA) {
+                scg__draw_glyph_row(dest, bits, color.packed);
+                continue;
+            }
+
+            const scg__glyph_row_spans_t *spans = &scg__glyph_row_spans[bits];
+            int dest_x = x + b * 8;
+            for (int j = 0; j < spans->num_spans; j++) {
+                int start = scg_max_int(spans->starts[j], -dest_x);
+                int end = scg_min_int(spans->starts[j] + spans->lengths[j],
+                                      w - dest_x);
+
+                for (int k = start; k < end; k++) {
+                    if (blend_mode == SCG_BLEND_MODE_ALPHA) {
+                        dest[k] = scg__blend_alpha(dest[k], color);
+                    } else {
+                        dest[k] = color.packed;
+                    }
+                }
+            }
+        }
+    }
+}
+
+//
+// scg_image_draw_char implementation
+//
+
+void scg_image_draw_char(scg_image_t *image, char ch, int x, int y,
+                         scg_pixel_t color) {
+    const scg_font_t *font = scg__font;
+
+    scg__draw_glyph(image, font, scg__font_glyph(font, (uint8_t)ch), x, y,
+                    color);
+}
+
+//
+// scg_image_draw_string implementation
+//
+
+void scg_image_draw_string(scg_image_t *image, const char *str, int x, int y,
+                           bool anchor_to_center, scg_pixel_t color) {
+    const scg_font_t *font = scg__font;
+    int glyph_width = font->glyph_width;
+    int current_x = x;
+    int current_y = y;
+
+    if (anchor_to_center) {
+        int width = strlen(str) * glyph_width;
+        current_x = x - width / 2;
+        current_y -= font->glyph_height / 2;
+    }
+
+    // Clip the whole string against the image once.
+    if (current_y >= image->height || current_y + font->glyph_height <= 0) {
+        return;
+    }
+
+    for (int i = 0; str[i] != '\0' && current_x < image->width; i++) {
+        if (str[i] != SCG__FONT_CHAR_CODE_SPACE &&
+            current_x + glyph_width > 0) {
+            scg__draw_glyph(image, font, scg__font_glyph(font, (uint8_t)str[i]),
+                            current_x, current_y, color);
+        }
+
+        current_x += glyph_width;
+    }
+}
+
+//
+// scg_image_draw_wchar implementation
+//
+
+void scg_image_draw_wchar(scg_image_t *image, wchar_t ch, int x, int y,
+                          scg_pixel_t color) {
+    const scg_font_t *font = scg__font;
+
+    scg__draw_glyph(image, font, scg__font_glyph(font, (uint32_t)ch), x, y,
+                    color);
+}
+
+//
+// scg_image_draw_wstring implementation
+//
+
+void scg_image_draw_wstring(scg_image_t *image, const wchar_t *str, int x,
+                            int y, bool anchor_to_center, scg_pixel_t color) {
+    const scg_font_t *font = scg__font;
+    int glyph_width = font->glyph_width;
+    int current_x = x;
+    int current_y = y;
+
+    if (anchor_to_center) {
+        int width = wcslen(str) * glyph_width;
+        current_x = x - width / 2;
+        current_y -= font->glyph_height / 2;
+    }
+
+    if (current_y >= image->height || current_y + font->glyph_height <= 0) {
+        return;
+    }
+
+    for (int i = 0; str[i] != '\0' && current_x < image->width; i++) {
+        if (str[i] != SCG__FONT_CHAR_CODE_SPACE &&
+            current_x + glyph_width > 0) {
+            scg__draw_glyph(image, font,
+                            scg__font_glyph(font, (uint32_t)str[i]),
+                            current_x, current_y, color);
+        }
+
+        current_x += glyph_width;
+    }
+}
+
+//
+// scg_image_draw_utf8_string implementation
+//
+
+void scg_image_draw_utf8_string(scg_image_t *image, const char *str, int x,
+                                int y, bool anchor_to_center,
+                                scg_pixel_t color) {
+    const scg_font_t *font = scg__font;
+    int glyph_width = font->glyph_width;
+    int current_x = x;
+    int current_y = y;
+
+    if (anchor_to_center) {
+        int width = scg__utf8_length(str) * glyph_width;
+        current_x = x - width / 2;
+        current_y -= font->glyph_height / 2;
+    }
+
+    if (current_y >= image->height || current_y + font->glyph_height <= 0) {
+        return;
+    }
+
+    while (*str != '\0' && current_x < image->width) {
+        uint32_t code = scg__utf8_decode(&str);
+
+        if (code != SCG__FONT_CHAR_CODE_SPACE && current_x + glyph_width > 0) {
+            scg__draw_glyph(image, font, scg__font_glyph(font, code),
+                            current_x, current_y, color);
+        }
+
+        current_x += glyph_width;
+    }
+}
+
+// Lays out a string with the given font into glyphs, which may be NULL to
+// only measure it. Returns the number of glyphs, or -1 on failure. Code
+// points are decoded up front since wrapping needs to look back to the last
+// space of a line.
+static int scg__layout_text(const scg_font_t *font, const char *str,
+                            int max_width, scg_text_align_t align,
+                            scg_text_glyph_t *glyphs, int *width,
+                            int *height, int *num_lines) {
+    int length = scg__utf8_length(str);
+    uint32_t *codes = malloc((size_t)(length + 1) * sizeof(*codes));
+    if (codes == NULL) {
+        scg_log_error("Failed to allocate memory for text layout");
+        return -1;
+    }
+
+    for (int i = 0; i < length; i++) {
+        codes[i] = scg__utf8_decode(&str);
+    }
+
+    int glyph_width = font->glyph_width;
+    bool wrap = max_width > 0;
+    int columns = wrap ? scg_max_int(max_width / glyph_width, 1) : 0;
+
+    // Lines are found twice, first to measure the widest line for
+    // alignment and then to place the glyphs.
+    int box_width = max_width;
+    int count = 0;
+    int lines = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        int start = 0;
+        int widest = 0;
+        count = 0;
+        lines = 0;
+
+        for (;;) {
+            int end = start;
+            int last_space = -1;
+            bool newline = false;
+
+            while (end < length) {
+                if (codes[end] == '\n') {
+                    newline = true;
+                    break;
+                }
+                if (wrap && end - start >= columns) {
+                    break;
+                }
+                if (codes[end] == SCG__FONT_CHAR_CODE_SPACE) {
+                    last_space = end;
+                }
+                end++;
+            }
+
+            int next = end + (newline ? 1 : 0);
+            bool overflow = !newline && end < length;
+            if (overflow && codes[end] != SCG__FONT_CHAR_CODE_SPACE &&
+                last_space > start) {
+                end = last_space;
+                next = last_space;
+            }
+            if (overflow) {
+                while (next < length &&
+                       codes[next] == SCG__FONT_CHAR_CODE_SPACE) {
+                    next++;
+                }
+            }
+
+            int line_end = end;
+            while (line_end > start &&
+                   codes[line_end - 1] == SCG__FONT_CHAR_CODE_SPACE) {
+                line_end--;
+            }
+
+            int line_width = (line_end - start) * glyph_width;
+            widest = scg_max_int(widest, line_width);
+
+            if (pass == 1) {
+                int offset_x = 0;
+                if (align == SCG_TEXT_ALIGN_CENTER) {
+                    offset_x = (box_width - line_width) / 2;
+                } else if (align == SCG_TEXT_ALIGN_RIGHT) {
+                    offset_x = box_width - line_width;
+                }
+
+                for (int i = start; i < line_end; i++) {
+                    if (codes[i] == SCG__FONT_CHAR_CODE_SPACE) {
+                        continue;
+                    }
+
+                    if (glyphs != NULL) {
+                        glyphs[count].x = offset_x + (i - start) * glyph_width;
+                        glyphs[count].y = lines * font->glyph_height;
+                        glyphs[count].glyph = scg__font_glyph(font, codes[i]);
+                    }
+                    count++;
+                }
+            }
+
+            lines++;
+            start = next;
+
+            if (!newline && start >= length) {
+                break;
+            }
+        }
+
+        if (pass == 0) {
+            *width = widest;
+            box_width = wrap ? max_width : widest;
+
+            if (glyphs == NULL) {
+                break;
+            }
+        }
+    }
+
+    *height = lines * font->glyph_height;
+    if (num_lines != NULL) {
+        *num_lines = lines;
+    }
+
+    free(codes);
+
+    return count;
+}
+
+// Lays out the string of a text object, growing its glyph run to fit every
+// code point of the string.
+static bool scg__text_layout(scg_text_t *text) {
+    int length = scg__utf8_length(text->str);
+
+    if (length > text->capacity) {
+        scg_text_glyph_t *glyphs =
+            realloc(text->glyphs, (size_t)length * sizeof(*glyphs));
+        if (glyphs == NULL) {
+            scg_log_error("Failed to allocate memory for text glyphs");
+            return false;
+        }
+
+        text->glyphs = glyphs;
+        text->capacity = length;
+    }
+
+    int num_glyphs = scg__layout_text(
+        text->font, text->str, text->max_width, text->align, text->glyphs,
+        &text->width, &text->height, &text->num_lines);
+    if (num_glyphs < 0) {
+        return false;
+    }
+
+    text->num_glyphs = num_glyphs;
+
+    return true;
+}
+
+//
+// scg_text_new implementation
+//
+
+scg_text_t *scg_text_new(const char *str, int max_width,
+                         scg_text_align_t align) {
+    scg_text_t *text = calloc(1, sizeof(*text));
+    if (text == NULL) {
+        scg_log_error("Failed to allocate memory for text");
+        return NULL;
+    }
+
+    text->max_width = max_width;
+    text->align = align;
+
+    if (!scg_text_set(text, str)) {
+        scg_text_free(text);
+        return NULL;
+    }
+
+    return text;
+}
+
+//
+// scg_text_set implementation
+//
+
+bool scg_text_set(scg_text_t *text, const char *str) {
+    if (text->str != NULL && text->font == scg__font &&
+        strcmp(text->str, str) == 0) {
+        return true;
+    }
+
+    size_t size = strlen(str) + 1;
+    char *copy = malloc(size);
+    if (copy == NULL) {
+        scg_log_error("Failed to allocate memory for text string");
+        return false;
+    }
+
+    memcpy(copy, str, size);
+    free(text->str);
+    text->str = copy;
+    text->font = scg__font;
+
+    return scg__text_layout(text);
+}
+
+//
+// scg_text_set_layout implementation
+//
+
+bool scg_text_set_layout(scg_text_t *text, int max_width,
+                         scg_text_align_t align) {
+    if (text->max_width == max_width && text->align == align) {
+        return true;
+    }
+
+    text->max_width = max_width;
+    text->align = align;
+
+    return scg__text_layout(text);
+}
+
+//
+// scg_text_free implementation
+//
+
+void scg_text_free(scg_text_t *text) {
+    if (text == NULL) {
+        return;
+    }
+
+    free(text->str);
+    free(text->glyphs);
+    free(text);
+}
+
+//
+// scg_measure_text implementation
+//
+
+void scg_measure_text(const char *str, int max_width, int *width,
+                      int *height) {
+    *width = 0;
+    *height = 0;
+    scg__layout_text(scg__font, str, max_width, SCG_TEXT_ALIGN_LEFT, NULL,
+                     width, height, NULL);
+}
+
+//
+// scg_image_draw_text implementation
+//
+
+void scg_image_draw_text(scg_image_t *image, scg_text_t *text, int x, int y,
+                         scg_pixel_t color) {
+    const scg_font_t *font = text->font;
+    int glyph_width = font->glyph_width;
+    int glyph_height = font->glyph_height;
+
+    for (int i = 0; i < text->num_glyphs; i++) {
+        const scg_text_glyph_t *glyph = &text->glyphs[i];
+        int glyph_x = x + glyph->x;
+        int glyph_y = y + glyph->y;
+
+        if (glyph_x >= image->width || glyph_x + glyph_width <= 0 ||
+            glyph_y >= image->height || glyph_y + glyph_height <= 0) {
+            continue;
+        }
+
+        scg__draw_glyph(image, font, glyph->glyph, glyph_x, glyph_y, color);
+    }
+}
+
+//
+// scg_image_draw_frame_metrics implementation
+//
+
+void scg_image_draw_frame_metrics(scg_image_t *image,
+                                  scg_frame_metrics_t frame_metrics) {
+    int fps = frame_metrics.fps;
+    float32_t frame_time_ms = frame_metrics.frame_time_millisecs;
+    const char *fmt = "fps:%d ms/f:%.4f";
+
+    // Longer metrics than this are cut short rather than overflowing.
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), fmt, fps, frame_time_ms);
+
+    scg_pixel_t color = SCG_COLOR_GREEN;
+    float32_t target_fps = (float32_t)frame_metrics.target_fps;
+    if (fps < target_fps * 0.95) {
+        color = SCG_COLOR_YELLOW;
+    }
+    if (fps < target_fps * 0.5) {
+        color = SCG_COLOR_RED;
+    }
+
+    // Draw the metrics with no alpha blending.
+    scg_blend_mode_t blend_mode = image->blend_mode;
+    scg_image_set_blend_mode(image, SCG_BLEND_MODE_NONE);
+    scg_image_draw_string(image, buffer, 10, 10, 0, color);
+    scg_image_set_blend_mode(image, blend_mode);
+}
+
+// Writes a 32 bit BMP with an alpha mask, in the layout SDL_SaveBMP uses for
+// ARGB surfaces. Pixel rows are stored bottom up in the same byte order as
+// scg_image_t, so each row is written as it is.
+static bool scg__image_write_bmp(const scg_image_t *image, SDL_RWops *file) {
+    uint8_t header[122] = {0};
+    uint32_t row_size = (uint32_t)image->width * 4;
+
+    header[0] = 'B';
+    header[1] = 'M';
+    scg__write_u32_le(header + 2, sizeof(header) + row_size * image->height);
+    scg__write_u32_le(header + 10, sizeof(header));
+    scg__write_u32_le(header + 14, 108);
+    scg__write_u32_le(header + 18, image->width);
+    scg__write_u32_le(header + 22, image->height);
+    scg__write_u16_le(header + 26, 1);
+    scg__write_u16_le(header + 28, 32);
+    scg__write_u32_le(header + 30, 3);
+    scg__write_u32_le(header + 34, row_size * image->height);
+    scg__write_u32_le(header + 38, 2835);
+    scg__write_u32_le(header + 42, 2835);
+    scg__write_u32_le(header + 54, 0x00FF0000);
+    scg__write_u32_le(header + 58, 0x0000FF00);
+    scg__write_u32_le(header + 62, 0x000000FF);
+    scg__write_u32_le(header + 66, 0xFF000000);
+    memcpy(header + 70, " niW", 4);
+
+    if (SDL_RWwrite(file, header, sizeof(header), 1) != 1) {
+        return false;
+    }
+
+    for (int y = image->height - 1; y >= 0; y--) {
+        if (SDL_RWwrite(file, scg__image_row(image, y), row_size, 1) != 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool scg__image_write_qoi(const scg_image_t *image, SDL_RWops *file) {
+    size_t num_pixels = (size_t)image->width * image->height;
+    uint8_t *data = malloc(14 + num_pixels * 5 + 8);
+    if (data == NULL) {
+        scg_log_error("Failed to allocate memory to encode QOI");
+
+        return false;
+    }
+
+    memcpy(data, "qoif", 4);
+    scg__write_u32_be(data + 4, image->width);
+    scg__write_u32_be(data + 8, image->height);
+    data[12] = 4;
+    data[13] = 0;
+
+    uint32_t index[64] = {0};
+    uint32_t previous = 0xFF000000;
+    size_t size = 14;
+    int run = 0;
+
+    for (int y = 0; y < image->height; y++) {
+        const uint32_t *row = scg__image_row(image, y);
+
+        for (int x = 0; x < image->width; x++) {
+            uint32_t pixel = row[x];
+
+            if (pixel == previous) {
+                if (++run == 62) {
+                    data[size++] = 0xC0 | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                data[size++] = 0xC0 | (run - 1);
+                run = 0;
+            }
+
+            int r = pixel >> 16 & 0xFF;
+            int g = pixel >> 8 & 0xFF;
+            int b = pixel & 0xFF;
+            int a = pixel >> 24;
+            int hash = (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+
+            if (index[hash] == pixel) {
+                data[size++] = (uint8_t)hash;
+                previous = pixel;
+                continue;
+            }
+            index[hash] = pixel;
+
+            if (a != (int)(previous >> 24)) {
+                data[size++] = 0xFF;
+                data[size++] = (uint8_t)r;
+                data[size++] = (uint8_t)g;
+                data[size++] = (uint8_t)b;
+                data[size++] = (uint8_t)a;
+                previous = pixel;
+                continue;
+            }
+
+            // Differences wrap around, as they do when decoding.
+            int pr = previous >> 16 & 0xFF;
+            int pg = previous >> 8 & 0xFF;
+            int pb = previous & 0xFF;
+            int dr = (((r - pr) & 0xFF) ^ 0x80) - 0x80;
+            int dg = (((g - pg) & 0xFF) ^ 0x80) - 0x80;
+            int db = (((b - pb) & 0xFF) ^ 0x80) - 0x80;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 &&
+                db <= 1) {
+                data[size++] = 0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+            } else if (dg >= -32 && dg <= 31 && dr - dg >= -8 &&
+                       dr - dg <= 7 && db - dg >= -8 && db - dg <= 7) {
+                data[size++] = 0x80 | (dg + 32);
+                data[size++] = (uint8_t)((dr - dg + 8) << 4 | (db - dg + 8));
+            } else {
+                data[size++] = 0xFE;
+                data[size++] = (uint8_t)r;
+                data[size++] = (uint8_t)g;
+                data[size++] = (uint8_t)b;
+            }
+
+            previous = pixel;
+        }
+    }
+
+    if (run > 0) {
+        data[size++] = 0xC0 | (run - 1);
+    }
+
+    memset(data + size, 0, 7);
+    data[size + 7] = 1;
+    size += 8;
+
+    bool is_written = SDL_RWwrite(file, data, size, 1) == 1;
+    free(data);
+
+    return is_written;
+}
+
+static uint32_t scg__crc32(const uint32_t *table, uint32_t crc,
+                           const uint8_t *data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ crc >> 8;
+    }
+
+    return ~crc;
+}
+
+static uint32_t scg__adler32(const uint8_t *data, size_t size) {
+    uint32_t a = 1;
+    uint32_t b = 0;
+
+    while (size > 0) {
+        // The largest block that cannot overflow before the modulo.
+        size_t block_size = size < 5552 ? size : 5552;
+        for (size_t i = 0; i < block_size; i++) {
+            a += data[i];
+            b += a;
+        }
+
+        a %= 65521;
+        b %= 65521;
+        data += block_size;
+        size -= block_size;
+    }
+
+    return b << 16 | a;
+}
+
+typedef struct scg__deflate_t {
+    uint8_t *data;
+    size_t size;
+    uint64_t bits;
+    int num_bits;
+
+    // Fixed Huffman codes, bit reversed ready to be written.
+    uint16_t symbol_codes[288];
+    uint8_t symbol_lengths[288];
+    uint8_t distance_codes[30];
+} scg__deflate_t;
+
+static inline void scg__deflate_put(scg__deflate_t *deflate, uint32_t value,
+                                    int num_bits) {
+    deflate->bits |= (uint64_t)value << deflate->num_bits;
+    deflate->num_bits += num_bits;
+
+    while (deflate->num_bits >= 8) {
+        deflate->data[deflate->size++] = (uint8_t)deflate->bits;
+        deflate->bits >>= 8;
+        deflate->num_bits -= 8;
+    }
+}
+
+// Huffman codes are stored from their most significant bit.
+static uint32_t scg__deflate_reverse(uint32_t code, int num_bits) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < num_bits; i++) {
+        reversed = reversed << 1 | (code >> i & 1);
+    }
+
+    return reversed;
+}
+
+static void scg__deflate_init(scg__deflate_t *deflate, uint8_t *data,
+                              size_t size) {
+    deflate->data = data;
+    deflate->size = size;
+    deflate->bits = 0;
+    deflate->num_bits = 0;
+
+    for (int symbol = 0; symbol < 288; symbol++) {
+        uint32_t code;
+        int num_bits;
+
+        if (symbol < 144) {
+            code = 0x30 + symbol;
+            num_bits = 8;
+        } else if (symbol < 256) {
+            code = 0x190 + symbol - 144;
+            num_bits = 9;
+        } else if (symbol < 280) {
+            code = symbol - 256;
+            num_bits = 7;
+        } else {
+            code = 0xC0 + symbol - 280;
+            num_bits = 8;
+        }
+
+        deflate->symbol_codes[symbol] =
+            (uint16_t)scg__deflate_reverse(code, num_bits);
+        deflate->symbol_lengths[symbol] = (uint8_t)num_bits;
+    }
+
+    for (int code = 0; code < 30; code++) {
+        deflate->distance_codes[code] = (uint8_t)scg__deflate_reverse(code, 5);
+    }
+}
+
+static inline void scg__deflate_put_symbol(scg__deflate_t *deflate,
+                                           int symbol) {
+    scg__deflate_put(deflate, deflate->symbol_codes[symbol],
+                     deflate->symbol_lengths[symbol]);
+}
+
+static void scg__deflate_put_match(scg__deflate_t *deflate, int length,
+                                   int distance) {
+    static const uint16_t length_bases[29] = {
+        3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const uint8_t length_extra_bits[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+        2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const uint16_t distance_bases[30] = {
+        1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+        33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+        1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+    int code = 28;
+    while (length_bases[code] > length) {
+        code--;
+    }
+    scg__deflate_put_symbol(deflate, 257 + code);
+    scg__deflate_put(deflate, length - length_bases[code],
+                     length_extra_bits[code]);
+
+    code = 29;
+    while (distance_bases[code] > distance) {
+        code--;
+    }
+    scg__deflate_put(deflate, deflate->distance_codes[code], 5);
+    scg__deflate_put(deflate, distance - distance_bases[code],
+                     code < 4 ? 0 : code / 2 - 1);
+}
+
+static inline uint32_t scg__deflate_hash(const uint8_t *data) {
+    uint32_t value = data[0] | data[1] << 8 | data[2] << 16;
+
+    return (value * 2654435761u) >> (32 - 15);
+}
+
+// Compresses to a single block of fixed Huffman codes, taking the longest
+// match at the last position with the same hash. Filtered image rows are
+// mostly runs of repeated bytes, which this finds without the cost of
+// searching hash chains or building tables. The output is never more than
+// 9 bits per input byte plus the end of the block.
+static bool scg__deflate(const uint8_t *src, size_t src_size,
+                         scg__deflate_t *deflate) {
+    int32_t *positions = malloc((1 << 15) * sizeof(*positions));
+    if (positions == NULL) {
+        return false;
+    }
+    for (int i = 0; i < 1 << 15; i++) {
+        positions[i] = -1;
+    }
+
+    scg__deflate_put(deflate, 1, 1);
+    scg__deflate_put(deflate, 1, 2);
+
+    size_t i = 0;
+    while (i + 3 <= src_size) {
+        uint32_t hash = scg__deflate_hash(src + i);
+        int32_t candidate = positions[hash];
+        positions[hash] = (int32_t)i;
+
+        size_t length = 0;
+        if (candidate >= 0 && i - candidate <= 32768) {
+            size_t max_length = scg_min_int(258, (int)(src_size - i));
+            while (length < max_length &&
+                   src[candidate + length] == src[i + length]) {
+                length++;
+            }
+        }
+
+        if (length < 3) {
+            scg__deflate_put_symbol(deflate, src[i++]);
+            continue;
+        }
+
+        scg__deflate_put_match(deflate, (int)length, (int)(i - candidate));
+
+        size_t end = i + length;
+        for (i++; i < end; i++) {
+            if (i + 3 <= src_size) {
+                positions[scg__deflate_hash(src + i)] = (int32_t)i;
+            }
+        }
+    }
+
+    for (; i < src_size; i++) {
+        scg__deflate_put_symbol(deflate, src[i]);
+    }
+
+    scg__deflate_put_symbol(deflate, 256);
+    scg__deflate_put(deflate, 0, 7);
+    deflate->bits = 0;
+    deflate->num_bits = 0;
+
+    free(positions);
+
+    return true;
+}
+
+// Filters a row against the row above it, which is all zeros for the first
+// row.
+static void scg__png_filter_row(uint8_t *dest, int filter, const uint8_t *row,
+                                const uint8_t *prior, size_t row_size,
+                                int bpp) {
+    size_t i = 0;
+
+    switch (filter) {
+    case 0:
+        memcpy(dest, row, row_size);
+        break;
+    case 1:
+        for (; i < (size_t)bpp; i++) {
+            dest[i] = row[i];
+        }
+        for (; i < row_size; i++) {
+            dest[i] = (uint8_t)(row[i] - row[i - bpp]);
+        }
+        break;
+    case 2:
+        for (; i < row_size; i++) {
+            dest[i] = (uint8_t)(row[i] - prior[i]);
+        }
+        break;
+    case 3:
+        for (; i < (size_t)bpp; i++) {
+            dest[i] = (uint8_t)(row[i] - prior[i] / 2);
+        }
+        for (; i < row_size; i++) {
+            dest[i] = (uint8_t)(row[i] - (row[i - bpp] + prior[i]) / 2);
+        }
+        break;
+    case 4:
+        for (; i < (size_t)bpp; i++) {
+            dest[i] = (uint8_t)(row[i] - prior[i]);
+        }
+        for (; i < row_size; i++) {
+            dest[i] = (uint8_t)(row[i] - scg__png_paeth(row[i - bpp], prior[i],
+                                                        prior[i - bpp]));
+        }
+        break;
+    }
+}
+
+// Writes an 8 bit RGB PNG when every pixel is opaque, otherwise RGBA. Each
+// row is filtered with whichever filter gives the smallest sum of absolute
+// differences, the usual heuristic for picking one.
+static bool scg__image_write_png(const scg_image_t *image, SDL_RWops *file) {
+    bool is_opaque = true;
+    for (int y = 0; y < image->height && is_opaque; y++) {
+        const uint32_t *row = scg__image_row(image, y);
+        for (int x = 0; x < image->width; x++) {
+            if (row[x] < 0xFF000000) {
+                is_opaque = false;
+                break;
+            }
+        }
+    }
+
+    int bpp = is_opaque ? 3 : 4;
+    size_t row_size = (size_t)image->width * bpp;
+    size_t filtered_size = (row_size + 1) * image->height;
+    size_t max_size = 8 + 25 + 8 + 2 + filtered_size * 9 / 8 + 16 + 12;
+
+    uint8_t *rows = calloc(3, row_size);
+    uint8_t *filtered = malloc(filtered_size + row_size * 5);
+    uint8_t *data = malloc(max_size);
+    if (rows == NULL || filtered == NULL || data == NULL) {
+        scg_log_error("Failed to allocate memory to encode PNG");
+
+        free(data);
+        free(filtered);
+        free(rows);
+        return false;
+    }
+
+    uint8_t *candidates = filtered + filtered_size;
+
+    for (int y = 0; y < image->height; y++) {
+        const uint32_t *pixels = scg__image_row(image, y);
+        uint8_t *row = rows + (1 + (y & 1)) * row_size;
+        uint8_t *prior = y > 0 ? rows + (1 + (~y & 1)) * row_size : rows;
+
+        for (int x = 0; x < image->width; x++) {
+            uint8_t *channels = row + x * bpp;
+            channels[0] = (uint8_t)(pixels[x] >> 16);
+            channels[1] = (uint8_t)(pixels[x] >> 8);
+            channels[2] = (uint8_t)pixels[x];
+            if (bpp == 4) {
+                channels[3] = (uint8_t)(pixels[x] >> 24);
+            }
+        }
+
+        int best_filter = 0;
+        uint64_t best_cost = UINT64_MAX;
+        for (int filter = 0; filter < 5; filter++) {
+            uint8_t *candidate = candidates + filter * row_size;
+            scg__png_filter_row(candidate, filter, row, prior, row_size, bpp);
+
+            uint64_t cost = 0;
+            for (size_t i = 0; i < row_size; i++) {
+                cost += candidate[i] < 128 ? candidate[i] : 256 - candidate[i];
+            }
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_filter = filter;
+            }
+        }
+
+        uint8_t *dest = filtered + y * (row_size + 1);
+        dest[0] = (uint8_t)best_filter;
+        memcpy(dest + 1, candidates + best_filter * row_size, row_size);
+    }
+
+    uint32_t crc_table[256];
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = crc & 1 ? 0xEDB88320 ^ crc >> 1 : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+
+    memcpy(data, "\x89PNG\r\n\x1A\n", 8);
+    scg__write_u32_be(data + 8, 13);
+    memcpy(data + 12, "IHDR", 4);
+    scg__write_u32_be(data + 16, image->width);
+    scg__write_u32_be(data + 20, image->height);
+    data[24] = 8;
+    data[25] = is_opaque ? 2 : 6;
+    data[26] = 0;
+    data[27] = 0;
+    data[28] = 0;
+    scg__write_u32_be(data + 29, scg__crc32(crc_table, 0, data + 12, 17));
+
+    memcpy(data + 37, "IDAT", 4);
+    data[41] = 0x78;
+    data[42] = 0x01;
+
+    scg__deflate_t deflate;
+    scg__deflate_init(&deflate, data, 43);
+    bool is_compressed = scg__deflate(filtered, filtered_size, &deflate);
+    if (!is_compressed) {
+        scg_log_error("Failed to allocate memory to encode PNG");
+
+        free(data);
+        free(filtered);
+        free(rows);
+        return false;
+    }
+
+    size_t size = deflate.size;
+    scg__write_u32_be(data + size, scg__adler32(filtered, filtered_size));
+    size += 4;
+    scg__write_u32_be(data + 33, (uint32_t)(size - 41));
+    scg__write_u32_be(data + size,
+                      scg__crc32(crc_table, 0, data + 37, size - 37));
+    size += 4;
+
+    memcpy(data + size, "\0\0\0\0IEND\xAE\x42\x60\x82", 12);
+    size += 12;
+
+    bool is_written = SDL_RWwrite(file, data, size, 1) == 1;
+
+    free(data);
+    free(filtered);
+    free(rows);
+
+    return is_written;
+}
+
+typedef bool (*scg__image_writer_t)(const scg_image_t *image,
+                                    SDL_RWops *file);
+
+static const scg__image_writer_t scg__image_writers[] = {
+    scg__image_write_bmp, scg__image_write_qoi, scg__image_write_png};
+
+static bool scg__image_save(const scg_image_t *image, const char *filepath,
+                            scg_image_format_t format) {
+    SDL_RWops *file = SDL_RWFromFile(filepath, "wb");
+    if (file == NULL) {
+        scg_log_errorf("Failed to open %s to save image. %s", filepath,
+                       SDL_GetError());
+
+        return false;
+    }
+
+    bool is_written = scg__image_writers[format](image, file);
+    if (SDL_RWclose(file) != 0) {
+        is_written = false;
+    }
+
+    if (!is_written) {
+        scg_log_errorf("Failed to save image to %s. %s", filepath,
+                       SDL_GetError());
+    }
+
+    return is_written;
+}
+
+//
+// scg_image_save_to_bmp implementation
+//
+
+bool scg_image_save_to_bmp(scg_image_t *image, const char *filepath) {
+    return scg__image_save(image, filepath, SCG_IMAGE_FORMAT_BMP);
+}
+
+//
+// scg_image_save_to_qoi implementation
+//
+
+bool scg_image_save_to_qoi(scg_image_t *image, const char *filepath) {
+    return scg__image_save(image, filepath, SCG_IMAGE_FORMAT_QOI);
+}
+
+//
+// scg_image_save_to_png implementation
+//
+
+bool scg_image_save_to_png(scg_image_t *image, const char *filepath) {
+    return scg__image_save(image, filepath, SCG_IMAGE_FORMAT_PNG);
+}
+
+static int scg__image_save_worker(void *data) {
+    scg_image_save_t *save = data;
+
+    save->is_saved =
+        scg__image_save(save->snapshot, save->filepath, save->format);
+    SDL_AtomicSet(&save->is_done, 1);
+
+    return 0;
+}
+
+//
+// scg_image_save_async implementation
+//
+
+scg_image_save_t *scg_image_save_async(scg_image_t *image,
+                                       const char *filepath,
+                                       scg_image_format_t format) {
+    size_t filepath_size = strlen(filepath) + 1;
+
+    scg_image_save_t *save = calloc(1, sizeof(*save));
+    char *filepath_copy = malloc(filepath_size);
+    scg_image_t *snapshot =
+        scg__image_alloc(image->width, image->height, filepath, NULL);
+    if (save == NULL || filepath_copy == NULL || snapshot == NULL) {
+        scg_log_errorf("Failed to allocate memory to save %s", filepath);
+
+        if (snapshot != NULL) {
+            scg_image_free(snapshot);
+        }
+        free(filepath_copy);
+        free(save);
+        return NULL;
+    }
+
+    for (int y = 0; y < image->height; y++) {
+        memcpy(scg__image_row(snapshot, y), scg__image_row(image, y),
+               image->width * sizeof(*image->pixels));
+    }
+
+    memcpy(filepath_copy, filepath, filepath_size);
+    save->snapshot = snapshot;
+    save->filepath = filepath_copy;
+    save->format = format;
+    save->sdl_thread =
+        SDL_CreateThread(scg__image_save_worker, "scg_image_save", save);
+
+    // Without a thread the copy is saved on the calling thread instead.
+    if (save->sdl_thread == NULL) {
+        scg_log_warnf("Failed to create thread to save %s. %s", filepath,
+                      SDL_GetError());
+
+        scg__image_save_worker(save);
+    }
+
+    return save;
+}
+
+//
+// scg_image_save_is_done implementation
+//
+
+bool scg_image_save_is_done(scg_image_save_t *save) {
+    return SDL_AtomicGet(&save->is_done) != 0;
+}
+
+//
+// scg_image_save_wait implementation
+//
+
+bool scg_image_save_wait(scg_image_save_t *save) {
+    if (save->sdl_thread != NULL) {
+        SDL_WaitThread(save->sdl_thread, NULL);
+    }
+
+    bool is_saved = save->is_saved;
+
+    scg_image_free(save->snapshot);
+    free(save->filepath);
+    free(save);
+
+    return is_saved;
+}
+
+//
+// scg_image_free implementation
+//
+
+void scg_image_free(scg_image_t *image) {
+    if (image->owns_pixels) {
+        free(image->pixels);
+    }
+    free(image);
+}
+
+static void scg__sprite_batch_draw_band(scg_sprite_batch_t *batch, int min_y,
+                                        int max_y) {
+    scg_image_t *dest = batch->dest;
+
+    for (int i = 0; i < batch->num_visible; i++) {
+        scg_sprite_t *sprite = batch->visible[i];
+
+        if (sprite->max_y <= min_y || sprite->min_y >= max_y) {
+            continue;
+        }
+
+        if (sprite->transformed) {
+            scg__draw_image_transformed(dest, sprite->image, sprite->x,
+                                        sprite->y, sprite->angle, sprite->sx,
+                                        sprite->sy, sprite->blend_mode, min_y,
+                                        max_y);
+        } else {
+            scg__image_blit(dest, sprite->image, sprite->x, sprite->y,
+                            sprite->blend_mode, min_y, max_y);
+        }
+    }
+}
+
+static int scg__sprite_band_worker(void *data) {
+    scg__sprite_band_t *band = data;
+
+    for (;;) {
+        SDL_SemWait(band->sdl_start_sem);
+        if (band->quit) {
+            break;
+        }
+
+        scg__sprite_batch_draw_band(band->batch, band->min_y, band->max_y);
+
+        SDL_SemPost(band->sdl_done_sem);
+    }
+
+    return 0;
+}
+
+static void scg__sprite_batch_free_bands(scg_sprite_batch_t *batch) {
+    // Band 0 is always drawn on the calling thread and has no worker.
+    for (int i = 1; i < batch->num_bands; i++) {
+        scg__sprite_band_t *band = &batch->bands[i];
+
+        if (band->sdl_thread != NULL) {
+            band->quit = true;
+            SDL_SemPost(band->sdl_start_sem);
+            SDL_WaitThread(band->sdl_thread, NULL);
+        }
+        if (band->sdl_start_sem != NULL) {
+            SDL_DestroySemaphore(band->sdl_start_sem);
+        }
+        if (band->sdl_done_sem != NULL) {
+            SDL_DestroySemaphore(band->sdl_done_sem);
+        }
+    }
+
+    free(batch->bands);
+}
+
+//
+// scg_sprite_batch_new implementation
+//
+
+scg_sprite_batch_t *scg_sprite_batch_new(int capacity, int num_threads) {
+    if (capacity <= 0) {
+        capacity = 256;
+    }
+    if (num_threads <= 0) {
+        num_threads = SDL_GetCPUCount();
+    }
+    num_threads = scg_min_int(scg_max_int(num_threads, 1),
+                              SCG__SPRITE_BATCH_MAX_THREADS);
+
+    scg_sprite_batch_t *batch = calloc(1, sizeof(*batch));
+    if (batch == NULL) {
+        scg_log_error("Failed to allocate memory for sprite batch");
+
+        return NULL;
+    }
+
+    batch->sprites = malloc(capacity * sizeof(*batch->sprites));
+    batch->visible = malloc(capacity * sizeof(*batch->visible));
+    batch->bands = calloc(num_threads, sizeof(*batch->bands));
+    if (batch->sprites == NULL || batch->visible == NULL ||
+        batch->bands == NULL) {
+        scg_log_error("Failed to allocate memory for sprites");
+
+        free(batch->bands);
+        free(batch->visible);
+        free(batch->sprites);
+        free(batch);
+        return NULL;
+    }
+
+    batch->capacity = capacity;
+    batch->num_bands = num_threads;
+
+    for (int i = 0; i < num_threads; i++) {
+        scg__sprite_band_t *band = &batch->bands[i];
+        band->batch = batch;
+
+        if (i == 0) {
+            continue;
+        }
+
+        band->sdl_start_sem = SDL_CreateSemaphore(0);
+        band->sdl_done_sem = SDL_CreateSemaphore(0);
+        if (band->sdl_start_sem != NULL && band->sdl_done_sem != NULL) {
+            band->sdl_thread = SDL_CreateThread(scg__sprite_band_worker,
+                                                "scg_sprite_band", band);
+        }
+
+        if (band->sdl_thread == NULL) {
+            scg_log_errorf("Failed to create sprite batch thread. %s",
+                           SDL_GetError());
+
+            batch->num_bands = i + 1;
+            scg__sprite_batch_free_bands(batch);
+            free(batch->visible);
+            free(batch->sprites);
+            free(batch);
+            return NULL;
+        }
+    }
+
+    return batch;
+}
+
+//
+// scg_sprite_batch_clear implementation
+//
+
+void scg_sprite_batch_clear(scg_sprite_batch_t *batch) {
+    batch->num_sprites = 0;
+}
+
+static scg_sprite_t *scg__sprite_batch_push(scg_sprite_batch_t *batch) {
+    if (batch->num_sprites == batch->capacity) {
+        int capacity = batch->capacity * 2;
+
+        scg_sprite_t *sprites =
+            realloc(batch->sprites, capacity * sizeof(*sprites));
+        if (sprites == NULL) {
+            scg_log_error("Failed to grow sprite batch");
+
+            return NULL;
+        }
+        batch->sprites = sprites;
+
+        scg_sprite_t **visible =
+            realloc(batch->visible, capacity * sizeof(*visible));
+        if (visible == NULL) {
+            scg_log_error("Failed to grow sprite batch");
+
+            return NULL;
+        }
+        batch->visible = visible;
+
+        batch->capacity = capacity;
+    }
+
+    scg_sprite_t *sprite = &batch->sprites[batch->num_sprites];
+    sprite->order = batch->num_sprites++;
+
+    return sprite;
+}
+
+//
+// scg_sprite_batch_add implementation
+//
+
+bool scg_sprite_batch_add(scg_sprite_batch_t *batch, scg_image_t *image, int x,
+                          int y, int layer, scg_blend_mode_t blend_mode) {
+    scg_sprite_t *sprite = scg__sprite_batch_push(batch);
+    if (sprite == NULL) {
+        return false;
+    }
+
+    sprite->image = image;
+    sprite->x = x;
+    sprite->y = y;
+    sprite->layer = layer;
+    sprite->blend_mode = blend_mode;
+    sprite->transformed = false;
+    sprite->angle = 0.0f;
+    sprite->sx = 1.0f;
+    sprite->sy = 1.0f;
+    sprite->min_x = x;
+    sprite->min_y = y;
+    sprite->max_x = x + image->width;
+    sprite->max_y = y + image->height;
+
+    return true;
+}
+
+//
+// scg_sprite_batch_add_transformed implementation
+//
+
+bool scg_sprite_batch_add_transformed(scg_sprite_batch_t *batch,
+                                      scg_image_t *image, int x, int y,
+                                      int layer, scg_blend_mode_t blend_mode,
+                                      float32_t angle, float32_t sx,
+                                      float32_t sy) {
+    scg_sprite_t *sprite = scg__sprite_batch_push(batch);
+    if (sprite == NULL) {
+        return false;
+    }
+
+    if (sx <= 0.0f)
+        sx = 1.0f;
+    if (sy <= 0.0f)
+        sy = 1.0f;
+
+    int minx, miny, maxx, maxy;
+    scg__transformed_bounds(image, angle, sx, sy, &minx, &miny, &maxx, &maxy);
+
+    sprite->image = image;
+    sprite->x = x;
+    sprite->y = y;
+    sprite->layer = layer;
+    sprite->blend_mode = blend_mode;
+    sprite->transformed = true;
+    sprite->angle = angle;
+    sprite->sx = sx;
+    sprite->sy = sy;
+    sprite->min_x = x + minx;
+    sprite->min_y = y + miny;
+    sprite->max_x = x + maxx;
+    sprite->max_y = y + maxy;
+
+    return true;
+}
+
+static int scg__sprite_compare(const void *a, const void *b) {
+    const scg_sprite_t *sa = a;
+    const scg_sprite_t *sb = b;
+
+    if (sa->layer != sb->layer) {
+        return sa->layer < sb->layer ? -1 : 1;
+    }
+
+    // Order by pixel address rather than image, so sub-images of the same
+    // atlas page end up next to each other.
+    uintptr_t pa = (uintptr_t)sa->image->pixels;
+    uintptr_t pb = (uintptr_t)sb->image->pixels;
+    if (pa != pb) {
+        return pa < pb ? -1 : 1;
+    }
+
+    return sa->order - sb->order;
+}
+
+//
+// scg_sprite_batch_draw implementation
+//
+
+void scg_sprite_batch_draw(scg_sprite_batch_t *batch, scg_image_t *dest) {
+    int w = dest->width;
+    int h = dest->height;
+
+    qsort(batch->sprites, batch->num_sprites, sizeof(*batch->sprites),
+          scg__sprite_compare);
+
+    batch->num_visible = 0;
+    for (int i = 0; i < batch->num_sprites; i++) {
+        scg_sprite_t *sprite = &batch->sprites[i];
+
+        if (sprite->max_x <= 0 || sprite->min_x >= w || sprite->max_y <= 0 ||
+            sprite->min_y >= h) {
+            continue;
+        }
+
+        batch->visible[batch->num_visible++] = sprite;
+    }
+
+    if (batch->num_visible == 0) {
+        return;
+    }
+
+    batch->dest = dest;
+
+    int num_bands = batch->num_bands;
+    int band_h = (h + num_bands - 1) / num_bands;
+
+    for (int i = 1; i < num_bands; i++) {
+        scg__sprite_band_t *band = &batch->bands[i];
+        band->min_y = i * band_h;
+        band->max_y = scg_min_int(h, band->min_y + band_h);
+
+        SDL_SemPost(band->sdl_start_sem);
+    }
+
+    scg__sprite_batch_draw_band(batch, 0, scg_min_int(h, band_h));
+
+    for (int i = 1; i < num_bands; i++) {
+        SDL_SemWait(batch->bands[i].sdl_done_sem);
+    }
+
+    batch->dest = NULL;
+}
+
+//
+// scg_sprite_batch_free implementation
+//
+
+void scg_sprite_batch_free(scg_sprite_batch_t *batch) {
+    scg__sprite_batch_free_bands(batch);
+
+    free(batch->visible);
+    free(batch->sprites);
+    free(batch);
+}
+
+//
+// scg_atlas_new implementation
+//
+
+scg_atlas_t *scg_atlas_new(int width, int height, int padding) {
+    scg_atlas_t *atlas = calloc(1, sizeof(*atlas));
+    if (atlas == NULL) {
+        scg_log_error("Failed to allocate memory for atlas");
+
+        return NULL;
+    }
+
+    atlas->page = scg_image_new(width, height);
+    if (atlas->page == NULL) {
+        scg_log_error("Failed to create atlas page");
+
+        free(atlas);
+        return NULL;
+    }
+
+    atlas->nodes_capacity = 16;
+    atlas->nodes = malloc(atlas->nodes_capacity * sizeof(*atlas->nodes));
+    if (atlas->nodes == NULL) {
+        scg_log_error("Failed to allocate memory for atlas skyline");
+
+        scg_image_free(atlas->page);
+        free(atlas);
+        return NULL;
+    }
+
+    // The skyline starts as a single segment along the bottom of the page.
+    atlas->nodes[0] = (scg__skyline_node_t){0, 0, width};
+    atlas->num_nodes = 1;
+    atlas->padding = scg_max_int(padding, 0);
+
+    return atlas;
+}
+
+// Returns the y at which a rect of w x h fits when its left edge is placed at
+// the start of the node at index, or -1 if it does not fit there. Padding is
+// only needed between images, so a rect may end right at the page edge.
+static int scg__atlas_fit(scg_atlas_t *atlas, int index, int w, int h) {
+    scg__skyline_node_t *nodes = atlas->nodes;
+    int x = nodes[index].x;
+    int y = nodes[index].y;
+
+    if (x + w > atlas->page->width) {
+        return -1;
+    }
+
+    int width_left = scg_min_int(w + atlas->padding, atlas->page->width - x);
+
+    for (int i = index; width_left > 0; i++) {
+        if (i == atlas->num_nodes) {
+            return -1;
+        }
+
+        y = scg_max_int(y, nodes[i].y);
+        if (y + h > atlas->page->height) {
+            return -1;
+        }
+
+        width_left -= nodes[i].width;
+    }
+
+    return y;
+}
+
+static bool scg__atlas_add_skyline_level(scg_atlas_t *atlas, int index, int x,
+                                         int y, int w) {
+    if (atlas->num_nodes == atlas->nodes_capacity) {
+        int capacity = atlas->nodes_capacity * 2;
+        scg__skyline_node_t *nodes =
+            realloc(atlas->nodes, capacity * sizeof(*nodes));
+        if (nodes == NULL) {
+            scg_log_error("Failed to grow atlas skyline");
+
+            return false;
+        }
+
+        atlas->nodes = nodes;
+        atlas->nodes_capacity = capacity;
+    }
+
+    scg__skyline_node_t *nodes = atlas->nodes;
+    memmove(&nodes[index + 1], &nodes[index],
+            (atlas->num_nodes - index) * sizeof(*nodes));
+    nodes[index] = (scg__skyline_node_t){x, y, w};
+    atlas->num_nodes++;
+
+    // Shrink or remove the nodes now covered by the new one.
+    for (int i = index + 1; i < atlas->num_nodes; i++) {
+        scg__skyline_node_t *prev = &nodes[i - 1];
+        int overlap = prev->x + prev->width - nodes[i].x;
+        if (overlap <= 0) {
+            break;
+        }
+
+        nodes[i].x += overlap;
+        nodes[i].width -= overlap;
+        if (nodes[i].width > 0) {
+            break;
+        }
+
+        memmove(&nodes[i], &nodes[i + 1],
+                (atlas->num_nodes - i - 1) * sizeof(*nodes));
+        atlas->num_nodes--;
+        i--;
+    }
+
+    // Merge neighbouring nodes at the same height.
+    for (int i = 0; i < atlas->num_nodes - 1; i++) {
+        if (nodes[i].y == nodes[i + 1].y) {
+            nodes[i].width += nodes[i + 1].width;
+            memmove(&nodes[i + 1], &nodes[i + 2],
+                    (atlas->num_nodes - i - 2) * sizeof(*nodes));
+            atlas->num_nodes--;
+            i--;
+        }
+    }
+
+    return true;
+}
+
+//
+// scg_atlas_add_image implementation
+//
+
+scg_image_t *scg_atlas_add_image(scg_atlas_t *atlas, scg_image_t *src) {
+    int w = src->width;
+    int h = src->height;
+
+    // Bottom-left heuristic, choose the lowest position and then the
+    // narrowest segment so the skyline stays as flat as possible.
+    int best_index = -1;
+    int best_y = 0;
+    int best_width = 0;
+    for (int i = 0; i < atlas->num_nodes; i++) {
+        int y = scg__atlas_fit(atlas, i, w, h);
+        if (y < 0) {
+            continue;
+        }
+
+        if (best_index < 0 || y < best_y ||
+            (y == best_y && atlas->nodes[i].width < best_width)) {
+            best_index = i;
+            best_y = y;
+            best_width = atlas->nodes[i].width;
+        }
+    }
+
+    if (best_index < 0) {
+        scg_log_errorf("Atlas page is full, cannot fit a %dx%d image",
+                       src->width, src->height);
+
+        return NULL;
+    }
+
+    if (atlas->num_images == atlas->images_capacity) {
+        int capacity = scg_max_int(16, atlas->images_capacity * 2);
+        scg_image_t **images =
+            realloc(atlas->images, capacity * sizeof(*images));
+        if (images == NULL) {
+            scg_log_error("Failed to grow atlas images");
+
+            return NULL;
+        }
+
+        atlas->images = images;
+        atlas->images_capacity = capacity;
+    }
+
+    int x = atlas->nodes[best_index].x;
+    scg_image_t *sub_image = scg_image_new_sub_image(
+        atlas->page, x, best_y, src->width, src->height);
+    if (sub_image == NULL) {
+        return NULL;
+    }
+
+    // Reserve the padding after the image, unless it ends at the page edge.
+    int level_w = scg_min_int(w + atlas->padding, atlas->page->width - x);
+    int level_y =
+        scg_min_int(best_y + h + atlas->padding, atlas->page->height);
+    if (!scg__atlas_add_skyline_level(atlas, best_index, x, level_y,
+                                      level_w)) {
+        scg_image_free(sub_image);
+        return NULL;
+    }
+
+    scg__image_blit(sub_image, src, 0, 0, SCG_BLEND_MODE_NONE, 0,
+                    src->height);
+    sub_image->blend_mode = src->blend_mode;
+
+    atlas->images[atlas->num_images++] = sub_image;
+
+    return sub_image;
+}
+
+//
+// scg_atlas_add_image_from_bmp implementation
+//
+
+scg_image_t *scg_atlas_add_image_from_bmp(scg_atlas_t *atlas,
+                                          const char *filepath) {
+    scg_image_t *src = scg_image_new_from_bmp(filepath);
+    if (src == NULL) {
+        return NULL;
+    }
+
+    scg_image_t *sub_image = scg_atlas_add_image(atlas, src);
+    scg_image_free(src);
+
+    return sub_image;
+}
+
+//
+// scg_atlas_free implementation
+//
+
+void scg_atlas_free(scg_atlas_t *atlas) {
+    for (int i = 0; i < atlas->num_images; i++) {
+        scg_image_free(atlas->images[i]);
+    }
+
+    free(atlas->images);
+    free(atlas->nodes);
+    scg_image_free(atlas->page);
+    free(atlas);
+}
+
+//
+// scg_tilemap_new implementation
+//
+
+scg_tilemap_t *scg_tilemap_new(scg_atlas_t *atlas, int width, int height,
+                               int tile_width, int tile_height,
+                               int chunk_size) {
+    if (width <= 0 || height <= 0 || tile_width <= 0 || tile_height <= 0) {
+        scg_log_errorf("Invalid tile map size %dx%d with %dx%d tiles", width,
+                       height, tile_width, tile_height);
+
+        return NULL;
+    }
+
+    // Tiles are indexed with ints, so the count must fit in one as well as
+    // in the allocation.
+    if (width > INT_MAX / height ||
+        (size_t)width > SIZE_MAX / sizeof(int) / (size_t)height) {
+        scg_log_errorf("Tile map of %dx%d tiles is too large", width, height);
+
+        return NULL;
+    }
+    size_t num_tiles = (size_t)width * (size_t)height;
+
+    if (chunk_size <= 0) {
+        chunk_size = SCG__TILEMAP_DEFAULT_CHUNK_SIZE;
+    }
+
+    int num_chunks_x = (width - 1) / chunk_size + 1;
+    int num_chunks_y = (height - 1) / chunk_size + 1;
+
+    int *tiles = malloc(num_tiles * sizeof(*tiles));
+    if (tiles == NULL) {
+        scg_log_error("Failed to allocate memory for tiles");
+
+        return NULL;
+    }
+    for (size_t i = 0; i < num_tiles; i++) {
+        tiles[i] = SCG_TILEMAP_EMPTY_TILE;
+    }
+
+    scg__tilemap_chunk_t *chunks =
+        calloc(num_chunks_x * num_chunks_y, sizeof(*chunks));
+    if (chunks == NULL) {
+        scg_log_error("Failed to allocate memory for tile map chunks");
+
+        free(tiles);
+        return NULL;
+    }
+    for (int i = 0; i < num_chunks_x * num_chunks_y; i++) {
+        chunks[i].dirty = true;
+    }
+
+    scg_tilemap_t *tilemap = malloc(sizeof(*tilemap));
+    if (tilemap == NULL) {
+        scg_log_error("Failed to allocate memory for tile map");
+
+        free(chunks);
+        free(tiles);
+        return NULL;
+    }
+
+    tilemap->width = width;
+    tilemap->height = height;
+    tilemap->tile_width = tile_width;
+    tilemap->tile_height = tile_height;
+    tilemap->tiles = tiles;
+    tilemap->atlas = atlas;
+    tilemap->chunk_size = chunk_size;
+    tilemap->num_chunks_x = num_chunks_x;
+    tilemap->num_chunks_y = num_chunks_y;
+    tilemap->chunks = chunks;
+
+    return tilemap;
+}
+
+//
+// scg_tilemap_get_tile implementation
+//
+
+int scg_tilemap_get_tile(scg_tilemap_t *tilemap, int x, int y) {
+    if (x < 0 || x >= tilemap->width || y < 0 || y >= tilemap->height) {
+        return SCG_TILEMAP_EMPTY_TILE;
+    }
+
+    return tilemap->tiles[scg_pixel_index_from_xy(x, y, tilemap->width)];
+}
+
+//
+// scg_tilemap_set_tile implementation
+//
+
+void scg_tilemap_set_tile(scg_tilemap_t *tilemap, int x, int y, int tile) {
+    if (x < 0 || x >= tilemap->width || y < 0 || y >= tilemap->height) {
+        return;
+    }
+
+    int i = scg_pixel_index_from_xy(x, y, tilemap->width);
+    if (tilemap->tiles[i] == tile) {
+        return;
+    }
+    tilemap->tiles[i] = tile;
+
+    int chunk_x = x / tilemap->chunk_size;
+    int chunk_y = y / tilemap->chunk_size;
+    tilemap->chunks[chunk_y * tilemap->num_chunks_x + chunk_x].dirty = true;
+}
+
+//
+// scg_tilemap_invalidate implementation
+//
+
+void scg_tilemap_invalidate(scg_tilemap_t *tilemap) {
+    for (int i = 0; i < tilemap->num_chunks_x * tilemap->num_chunks_y; i++) {
+        tilemap->chunks[i].dirty = true;
+    }
+}
+
+static bool scg__tilemap_render_chunk(scg_tilemap_t *tilemap, int chunk_x,
+                                      int chunk_y) {
+    scg__tilemap_chunk_t *chunk =
+        &tilemap->chunks[chunk_y * tilemap->num_chunks_x + chunk_x];
+    int chunk_size = tilemap->chunk_size;
+    int tile_w = tilemap->tile_width;
+    int tile_h = tilemap->tile_height;
+
+    // Chunk images are only allocated once they are first visible.
+    if (chunk->image == NULL) {
+        chunk->image = scg_image_new(chunk_size * tile_w, chunk_size * tile_h);
+        if (chunk->image == NULL) {
+            scg_log_error("Failed to create tile map chunk");
+
+            return false;
+        }
+    }
+
+    scg_image_t *image = chunk->image;
+    scg_image_clear(image, scg_pixel_new_uint32(0));
+
+    int first_x = chunk_x * chunk_size;
+    int first_y = chunk_y * chunk_size;
+    int last_x = scg_min_int(first_x + chunk_size, tilemap->width);
+    int last_y = scg_min_int(first_y + chunk_size, tilemap->height);
+    scg_atlas_t *atlas = tilemap->atlas;
+
+    for (int y = first_y; y < last_y; y++) {
+        for (int x = first_x; x < last_x; x++) {
+            int tile = tilemap->tiles[scg_pixel_index_from_xy(x, y,
+                                                              tilemap->width)];
+            if (tile < 0 || tile >= atlas->num_images) {
+                continue;
+            }
+
+            // Crop atlas images larger than a tile to its cell, so they do
+            // not spill into the neighbouring tiles of the chunk.
+            scg_image_t cell = *atlas->images[tile];
+            cell.width = scg_min_int(cell.width, tile_w);
+            cell.height = scg_min_int(cell.height, tile_h);
+
+            scg__image_blit(image, &cell, (x - first_x) * tile_w,
+                            (y - first_y) * tile_h, SCG_BLEND_MODE_NONE, 0,
+                            image->height);
+        }
+    }
+
+    chunk->dirty = false;
+
+    return true;
+}
+
+//
+// scg_tilemap_draw implementation
+//
+
+void scg_tilemap_draw(scg_tilemap_t *tilemap, scg_image_t *dest,
+                      float32_t scroll_x, float32_t scroll_y) {
+    int offset_x = (int)floorf(scroll_x);
+    int offset_y = (int)floorf(scroll_y);
+    int chunk_w = tilemap->chunk_size * tilemap->tile_width;
+    int chunk_h = tilemap->chunk_size * tilemap->tile_height;
+
+    // Only visit the chunks that overlap the destination.
+    int first_chunk_x = scg_max_int(0, offset_x / chunk_w);
+    int first_chunk_y = scg_max_int(0, offset_y / chunk_h);
+    int last_chunk_x = scg_min_int(tilemap->num_chunks_x - 1,
+                                   (offset_x + dest->width - 1) / chunk_w);
+    int last_chunk_y = scg_min_int(tilemap->num_chunks_y - 1,
+                                   (offset_y + dest->height - 1) / chunk_h);
+
+    for (int cy = first_chunk_y; cy <= last_chunk_y; cy++) {
+        for (int cx = first_chunk_x; cx <= last_chunk_x; cx++) {
+            scg__tilemap_chunk_t *chunk =
+                &tilemap->chunks[cy * tilemap->num_chunks_x + cx];
+
+            if (chunk->dirty && !scg__tilemap_render_chunk(tilemap, cx, cy)) {
+                continue;
+            }
+
+            scg__image_blit(dest, chunk->image, cx * chunk_w - offset_x,
+                            cy * chunk_h - offset_y, dest->blend_mode, 0,
+                            dest->height);
+        }
+    }
+}
+
+//
+// scg_tilemap_free implementation
+//
+
+void scg_tilemap_free(scg_tilemap_t *tilemap) {
+    for (int i = 0; i < tilemap->num_chunks_x * tilemap->num_chunks_y; i++) {
+        if (tilemap->chunks[i].image != NULL) {
+            scg_image_free(tilemap->chunks[i].image);
+        }
+    }
+
+    free(tilemap->chunks);
+    free(tilemap->tiles);
+    free(tilemap);
+}
+
+//
+// scg_rle_image_new implementation
+//
+
+scg_rle_image_t *scg_rle_image_new(scg_image_t *image) {
+    int w = image->width;
+    int h = image->height;
+
+    if (w > UINT16_MAX) {
+        scg_log_errorf("Image is too wide to run-length encode. width=%d", w);
+
+        return NULL;
+    }
+
+    // Count the runs and opaque pixels first so everything can be allocated
+    // up front.
+    int num_runs = 0;
+    int num_pixels = 0;
+    for (int i = 0; i < h; i++) {
+        const uint32_t *row = scg__image_row(image, i);
+        int j = 0;
+
+        while (j < w) {
+            while (j < w && (row[j] >> 24) != 255) {
+                j++;
+            }
+            if (j == w) {
+                break;
+            }
+            while (j < w && (row[j] >> 24) == 255) {
+                j++;
+                num_pixels++;
+            }
+            num_runs += 2;
+        }
+    }
+
+    scg_rle_image_t *rle = malloc(sizeof(*rle));
+    int *row_runs = malloc((h + 1) * sizeof(*row_runs));
+    int *row_pixels = malloc(h * sizeof(*row_pixels));
+    uint16_t *runs = malloc(scg_max_int(num_runs, 1) * sizeof(*runs));
+    uint32_t *pixels = malloc(scg_max_int(num_pixels, 1) * sizeof(*pixels));
+    if (rle == NULL || row_runs == NULL || row_pixels == NULL ||
+        runs == NULL || pixels == NULL) {
+        scg_log_error("Failed to allocate memory for run-length encoded image");
+
+        free(pixels);
+        free(runs);
+        free(row_pixels);
+        free(row_runs);
+        free(rle);
+        return NULL;
+    }
+
+    int run_index = 0;
+    int pixel_index = 0;
+    for (int i = 0; i < h; i++) {
+        const uint32_t *row = scg__image_row(image, i);
+        int j = 0;
+
+        row_runs[i] = run_index;
+        row_pixels[i] = pixel_index;
+
+        while (j < w) {
+            int start = j;
+            while (j < w && (row[j] >> 24) != 255) {
+                j++;
+            }
+            if (j == w) {
+                break;
+            }
+            int skip = j - start;
+
+            start = j;
+            while (j < w && (row[j] >> 24) == 255) {
+                pixels[pixel_index++] = row[j++];
+            }
+
+            runs[run_index++] = (uint16_t)skip;
+            runs[run_index++] = (uint16_t)(j - start);
+        }
+    }
+    row_runs[h] = run_index;
+
+    rle->width = w;
+    rle->height = h;
+    rle->row_runs = row_runs;
+    rle->runs = runs;
+    rle->row_pixels = row_pixels;
+    rle->pixels = pixels;
+
+    return rle;
+}
+
+//
+// scg_rle_image_new_from_bmp implementation
+//
+
+scg_rle_image_t *scg_rle_image_new_from_bmp(const char *filepath) {
+    scg_image_t *image = scg_image_new_from_bmp(filepath);
+    if (image == NULL) {
+        return NULL;
+    }
+
+    scg_rle_image_t *rle = scg_rle_image_new(image);
+    scg_image_free(image);
+
+    return rle;
+}
+
+//
+// scg_image_draw_rle_image implementation
+//
+
+void scg_image_draw_rle_image(scg_image_t *dest, scg_rle_image_t *src, int x,
+                              int y) {
+    int first_row = scg_max_int(0, -y);
+    int last_row = scg_min_int(src->height, dest->height - y);
+    int dest_w = dest->width;
+
+    if (x >= dest_w || x + src->width <= 0) {
+        return;
+    }
+
+    // Rows that are fully inside horizontally skip the per-run clipping.
+    bool clip = x < 0 || x + src->width > dest_w;
+
+    for (int i = first_row; i < last_row; i++) {
+        uint32_t *dest_row = scg__image_row(dest, y + i);
+        const uint16_t *runs = src->runs + src->row_runs[i];
+        const uint16_t *runs_end = src->runs + src->row_runs[i + 1];
+        const uint32_t *pixels = src->pixels + src->row_pixels[i];
+        int current_x = x;
+
+        for (; runs < runs_end; runs += 2) {
+            current_x += runs[0];
+            int length = runs[1];
+
+            if (!clip) {
+                memcpy(dest_row + current_x, pixels, length * sizeof(*pixels));
+            } else {
+                int start = scg_max_int(current_x, 0);
+                int end = scg_min_int(current_x + length, dest_w);
+
+                if (start < end) {
+                    memcpy(dest_row + start, pixels + (start - current_x),
+                           (end - start) * sizeof(*pixels));
+                }
+            }
+
+            pixels += length;
+            current_x += length;
+        }
+    }
+}
+
+//
+// scg_rle_image_free implementation
+//
+
+void scg_rle_image_free(scg_rle_image_t *image) {
+    free(image->pixels);
+    free(image->runs);
+    free(image->row_pixels);
+    free(image->row_runs);
+    free(image);
+}
+
+//
+// scg_keyboard_is_key_down implementation
+//
+
+bool scg_keyboard_is_key_down(scg_keyboard_t *keyboard, scg_key_code_t key) {
+    return keyboard->current_key_states[key] == 1;
+}
+
+//
+// scg_keyboard_is_key_up implementation
+//
+
+bool scg_keyboard_is_key_up(scg_keyboard_t *keyboard, scg_key_code_t key) {
+    return keyboard->current_key_states[key] == 0;
+}
+
+//
+// scg_keyboard_is_key_triggered implementation
+//
+
+bool scg_keyboard_is_key_triggered(scg_keyboard_t *keyboard,
+                                   scg_key_code_t key) {
+    return keyboard->last_frame_key_states[key] == 0 &&
+           keyboard->current_key_states[key] == 1;
+}
+
+//
+// scg_mouse_is_button_down implementation
+//
+
+bool scg_mouse_is_button_down(scg_mouse_t *mouse, scg_mouse_button_t button) {
+    return mouse->button_state & SDL_BUTTON(button);
+}
+
+//
+// scg_mouse_is_button_up implementation
+//
+
+bool scg_mouse_is_button_up(scg_mouse_t *mouse, scg_mouse_button_t button) {
+    return !(mouse->button_state & SDL_BUTTON(button));
+}
+
+// Reads one sample of any SDL audio format as a float from -1 to 1.
+static float32_t scg__audio_read_sample(SDL_AudioFormat format,
+                                        const uint8_t *data) {
+    int num_bytes = SDL_AUDIO_BITSIZE(format) / 8;
+    bool is_big_endian = SDL_AUDIO_ISBIGENDIAN(format) != 0;
+    uint32_t bits = 0;
+
+    for (int i = 0; i < num_bytes; i++) {
+        bits |= (uint32_t)data[is_big_endian ? num_bytes - 1 - i : i]
+                << (i * 8);
+    }
+
+    if (SDL_AUDIO_ISFLOAT(format)) {
+        float32_t value;
+        memcpy(&value, &bits, sizeof(value));
+
+        return value;
+    }
+
+    // Unsigned samples are centred by flipping the top bit, then every
+    // format is scaled up to 32 bits so the sign is in place.
+    if (!SDL_AUDIO_ISSIGNED(format)) {
+        bits ^= 1u << (num_bytes * 8 - 1);
+    }
+    bits <<= 32 - num_bytes * 8;
+
+    return (float32_t)(int32_t)bits / 2147483648.0f;
+}
+
+// Builds a windowed sinc filter for each fractional position between two
+// source frames. There is one extra phase, so the filter can be interpolated
+// between phases, and every phase is normalized to unity gain.
+static float32_t *scg__resampler_new_filters(float32_t cutoff) {
+    const int half_taps = SCG__RESAMPLER_TAPS / 2;
+    float32_t *filters =
+        malloc((SCG__RESAMPLER_PHASES + 1) * SCG__RESAMPLER_TAPS *
+               sizeof(*filters));
+    if (filters == NULL) {
+        return NULL;
+    }
+
+    for (int phase = 0; phase <= SCG__RESAMPLER_PHASES; phase++) {
+        float32_t *filter = filters + phase * SCG__RESAMPLER_TAPS;
+        float32_t fraction = (float32_t)phase / SCG__RESAMPLER_PHASES;
+        float32_t sum = 0.0f;
+
+        for (int i = 0; i < SCG__RESAMPLER_TAPS; i++) {
+            float32_t t = fraction - (float32_t)(i - half_taps + 1);
+            float32_t x = SCG_PI * cutoff * t;
+            float32_t sinc = x == 0.0f ? 1.0f : sinf(x) / x;
+
+            // Blackman window over the width of the filter.
+            float32_t w = SCG_PI * t / half_taps;
+            float32_t window = 0.42f + 0.5f * cosf(w) + 0.08f * cosf(2.0f * w);
+
+            filter[i] = sinc * window;
+            sum += filter[i];
+        }
+
+        for (int i = 0; i < SCG__RESAMPLER_TAPS; i++) {
+            filter[i] /= sum;
+        }
+    }
+
+    return filters;
+}
+
+static float32_t scg__resampler_dot(const float32_t *samples,
+                                    const float32_t *filter) {
+#ifdef SCG__SSE2
+    __m128 sum = _mm_setzero_ps();
+
+    for (int i = 0; i < SCG__RESAMPLER_TAPS; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + i),
+                                         _mm_loadu_ps(filter + i)));
+    }
+
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+    return _mm_cvtss_f32(sum);
+#else
+    float32_t sum = 0.0f;
+
+    for (int i = 0; i < SCG__RESAMPLER_TAPS; i++) {
+        sum += samples[i] * filter[i];
+    }
+
+    return sum;
+#endif
+}
+
+// Resamples one channel. The source has SCG__RESAMPLER_TAPS / 2 frames of
+// silence on each side, so the filter never reads out of bounds. Positions
+// are stepped in 32.32 fixed point; the top bits of the fraction pick the
+// phase and the rest interpolate to the next one.
+static void scg__resample(const float32_t *src, float32_t *dest,
+                          int num_dest_frames, uint64_t step,
+                          const float32_t *filters) {
+    const int phase_shift = 32 - SCG__RESAMPLER_PHASE_BITS;
+    uint64_t position = 0;
+
+    for (int i = 0; i < num_dest_frames; i++, position += step) {
+        const float32_t *samples = src + (position >> 32) + 1;
+        uint32_t fraction = (uint32_t)position;
+        const float32_t *filter =
+            filters + (fraction >> phase_shift) * SCG__RESAMPLER_TAPS;
+        float32_t t = (float32_t)(fraction & ((1u << phase_shift) - 1)) /
+                      (float32_t)(1u << phase_shift);
+
+        float32_t a = scg__resampler_dot(samples, filter);
+        float32_t b = scg__resampler_dot(samples, filter + SCG__RESAMPLER_TAPS);
+        dest[i] = a + (b - a) * t;
+    }
+}
+
+// Converts a loaded WAV to 16 bit stereo at the given rate, which is the
+// rate of the audio device. Samples are split into padded float channels,
+// resampled if the rates differ and written back interleaved. Returns a
+// buffer to release with free, or NULL on failure.
+static uint8_t *scg__audio_convert_wav(int frequency, SDL_AudioSpec spec,
+                                       const uint8_t *buffer, uint32_t length,
+                                       uint32_t *converted_length) {
+    const int padding = SCG__RESAMPLER_TAPS / 2;
+    int sample_size = SDL_AUDIO_BITSIZE(spec.format) / 8;
+    int frame_size = sample_size * spec.channels;
+    int num_frames = frame_size > 0 ? (int)(length / frame_size) : 0;
+    int num_dest_frames = num_frames;
+
+    if (spec.freq <= 0 || sample_size == 0 || spec.channels == 0) {
+        scg_log_error("Unsupported WAV format");
+        return NULL;
+    }
+
+    if (spec.freq != frequency) {
+        num_dest_frames =
+            (int)((uint64_t)num_frames * frequency / spec.freq);
+    }
+
+    float32_t *channels[2];
+    float32_t *resampled[2] = {NULL, NULL};
+    int16_t *dest = malloc((size_t)num_dest_frames * 2 * sizeof(*dest) + 1);
+    channels[0] = calloc(num_frames + padding * 2, sizeof(float32_t));
+    channels[1] = calloc(num_frames + padding * 2, sizeof(float32_t));
+
+    if (dest == NULL || channels[0] == NULL || channels[1] == NULL) {
+        scg_log_error("Failed to allocate memory to convert sound");
+        free(dest);
+        free(channels[0]);
+        free(channels[1]);
+        return NULL;
+    }
+
+    // Mono is played on both sides and only the front left and right of
+    // surround sounds are kept.
+    for (int i = 0; i < num_frames; i++) {
+        const uint8_t *frame = buffer + i * frame_size;
+        channels[0][padding + i] = scg__audio_read_sample(spec.format, frame);
+        channels[1][padding + i] =
+            spec.channels > 1
+                ? scg__audio_read_sample(spec.format, frame + sample_size)
+                : channels[0][padding + i];
+    }
+
+    const float32_t *output[2] = {channels[0] + padding,
+                                  channels[1] + padding};
+
+    if (spec.freq != frequency) {
+        // Lowering the rate also lowers the cutoff, so nothing above the
+        // new Nyquist frequency folds back into the sound.
+        float32_t ratio = (float32_t)frequency / spec.freq;
+        float32_t *filters =
+            scg__resampler_new_filters(0.95f * scg_min_float32(ratio, 1.0f));
+        resampled[0] = malloc(num_dest_frames * sizeof(float32_t) + 1);
+        resampled[1] = malloc(num_dest_frames * sizeof(float32_t) + 1);
+
+        if (filters == NULL || resampled[0] == NULL || resampled[1] == NULL) {
+            scg_log_error("Failed to allocate memory to resample sound");
+            free(filters);
+            free(resampled[0]);
+            free(resampled[1]);
+            free(channels[0]);
+            free(channels[1]);
+            free(dest);
+            return NULL;
+        }
+
+        uint64_t step = ((uint64_t)spec.freq << 32) / frequency;
+        for (int c = 0; c < 2; c++) {
+            scg__resample(channels[c], resampled[c], num_dest_frames, step,
+                          filters);
+            output[c] = resampled[c];
+        }
+
+        free(filters);
+    }
+
+    for (int i = 0; i < num_dest_frames; i++) {
+        for (int c = 0; c < 2; c++) {
+            float32_t sample = output[c][i] * 32768.0f;
+            dest[i * 2 + c] =
+                (int16_t)lrintf(scg_clamp_float32(sample, -32768.0f, 32767.0f));
+        }
+    }
+
+    free(resampled[0]);
+    free(resampled[1]);
+    free(channels[0]);
+    free(channels[1]);
+
+    *converted_length = (uint32_t)(num_dest_frames * 2 * sizeof(*dest));
+
+    return (uint8_t *)dest;
+}
+
+// Creates a sound from samples already in the format of the audio device.
+static scg_sound_t *scg__sound_new(scg_audio_t *audio, uint8_t *buffer,
+                                   uint32_t length, bool owns_buffer,
+                                   bool loop) {
+    scg_sound_t *sound = calloc(1, sizeof(*sound));
+    if (sound == NULL) {
+        scg_log_error("Failed to allocate memory for sound");
+
+        return NULL;
+    }
+
+    sound->audio = audio;
+    sound->sdl_spec.freq = audio->frequency;
+    sound->sdl_spec.format = AUDIO_S16LSB;
+    sound->sdl_spec.channels = audio->num_channels;
+    sound->length = length;
+    sound->buffer = buffer;
+    sound->owns_buffer = owns_buffer;
+    sound->stream = NULL;
+    sound->loop = loop;
+    sound->priority = 0;
+    sound->last_voice = 0;
+    sound->next = audio->sounds;
+    audio->sounds = sound;
+
+    return sound;
+}
+
+//
+// scg_sound_new_from_wav implementation
+//
+
+scg_sound_t *scg_sound_new_from_wav(scg_audio_t *audio, const char *filepath,
+                                    bool loop) {
+    SDL_AudioSpec spec;
+    uint32_t length;
+    uint8_t *buffer;
+
+    if (SDL_LoadWAV(filepath, &spec, &buffer, &length) == NULL) {
+        scg_log_errorf("Failed to load WAV file at %s. %s", filepath,
+                       SDL_GetError());
+
+        return NULL;
+    }
+
+    uint32_t converted_length;
+    uint8_t *converted =
+        scg__audio_convert_wav(audio->frequency, spec, buffer, length,
+                               &converted_length);
+    SDL_FreeWAV(buffer);
+    if (converted == NULL) {
+        scg_log_errorf("Failed to convert WAV file at %s", filepath);
+
+        return NULL;
+    }
+
+    scg_sound_t *sound =
+        scg__sound_new(audio, converted, converted_length, true, loop);
+    if (sound == NULL) {
+        free(converted);
+    }
+
+    return sound;
+}
+
+//
+// scg_sound_new_from_wav_in_arena implementation
+//
+
+scg_sound_t *scg_sound_new_from_wav_in_arena(scg_audio_t *audio,
+                                             scg_arena_t *arena,
+                                             const char *filepath,
+                                             bool loop) {
+    scg_sound_t *sound = scg_sound_new_from_wav(audio, filepath, loop);
+    if (sound == NULL) {
+        return NULL;
+    }
+
+    uint8_t *buffer = scg_arena_alloc(arena, sound->length, 0);
+    if (buffer == NULL) {
+        scg_log_errorf("Failed to allocate memory for sound %s", filepath);
+
+        scg_sound_free(sound);
+        return NULL;
+    }
+
+    // The sound has not been played yet, so the mixer cannot be reading the
+    // buffer while it is swapped.
+    memcpy(buffer, sound->buffer, sound->length);
+    free(sound->buffer);
+    sound->buffer = buffer;
+    sound->owns_buffer = false;
+
+    return sound;
+}
+
+typedef struct scg__wav_format_t {
+    int format;
+    int num_channels;
+    int frequency;
+    int bits_per_sample;
+    uint32_t data_offset;
+    uint32_t data_length;
+} scg__wav_format_t;
+
+#define SCG__WAV_FORMAT_PCM 1
+#define SCG__WAV_FORMAT_FLOAT 3
+#define SCG__WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// Reads the format and finds the sample data of a WAV file, leaving the file
+// at the start of the data.
+static bool scg__read_wav_format(SDL_RWops *file, scg__wav_format_t *format) {
+    uint8_t header[12];
+    if (SDL_RWread(file, header, 1, sizeof(header)) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool has_format = false;
+    Sint64 file_size = SDL_RWsize(file);
+
+    for (;;) {
+        uint8_t chunk[8];
+        if (SDL_RWread(file, chunk, 1, sizeof(chunk)) != sizeof(chunk)) {
+            return false;
+        }
+
+        uint32_t chunk_size = scg__read_u32_le(chunk + 4);
+        Sint64 chunk_start = SDL_RWtell(file);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+            uint8_t fmt[40] = {0};
+            size_t fmt_size = scg_min_int(chunk_size, sizeof(fmt));
+            if (SDL_RWread(file, fmt, 1, fmt_size) != fmt_size) {
+                return false;
+            }
+
+            format->format = fmt[0] | fmt[1] << 8;
+            format->num_channels = fmt[2] | fmt[3] << 8;
+            format->frequency = (int)scg__read_u32_le(fmt + 4);
+            format->bits_per_sample = fmt[14] | fmt[15] << 8;
+
+            // Extensible formats keep the real format in their sub format.
+            if (format->format == SCG__WAV_FORMAT_EXTENSIBLE &&
+                fmt_size >= 26) {
+                format->format = fmt[24] | fmt[25] << 8;
+            }
+            has_format = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!has_format) {
+                return false;
+            }
+
+            format->data_offset = (uint32_t)chunk_start;
+            format->data_length = chunk_size;
+            if (file_size >= 0 && chunk_start + chunk_size > file_size) {
+                format->data_length = (uint32_t)(file_size - chunk_start);
+            }
+
+            return true;
+        }
+
+        // Chunks are padded to an even size.
+        if (SDL_RWseek(file, chunk_start + chunk_size + (chunk_size & 1),
+                       RW_SEEK_SET) < 0) {
+            return false;
+        }
+    }
+}
+
+static size_t scg__sound_stream_read(scg__sound_stream_t *stream,
+                                     uint8_t *dest, size_t size) {
+    if (stream->mapping != NULL) {
+        memcpy(dest,
+               stream->mapping + stream->data_offset + stream->data_position,
+               size);
+        return size;
+    }
+
+    return SDL_RWread(stream->file, dest, 1, size);
+}
+
+static void scg__sound_stream_rewind(scg__sound_stream_t *stream) {
+    stream->data_position = 0;
+    if (stream->file != NULL) {
+        SDL_RWseek(stream->file, stream->data_offset, RW_SEEK_SET);
+    }
+}
+
+// Fills the free part of the ring from the file. Runs on the stream thread,
+// which owns the write position, except when priming a new stream.
+static void scg__sound_stream_fill(scg__sound_stream_t *stream,
+                                   uint32_t length) {
+    int restart_request = SDL_AtomicGet(&stream->restart_request);
+
+    // The audio thread stops reading until the restart is done, so both
+    // positions can be reset here.
+    if (restart_request != SDL_AtomicGet(&stream->restart_done)) {
+        scg__sound_stream_rewind(stream);
+        SDL_AtomicSet(&stream->read_position, 0);
+        SDL_AtomicSet(&stream->write_position, 0);
+        SDL_AtomicSet(&stream->is_finished, 0);
+    }
+
+    uint32_t write = (uint32_t)SDL_AtomicGet(&stream->write_position);
+    uint32_t read = (uint32_t)SDL_AtomicGet(&stream->read_position);
+
+    while (!SDL_AtomicGet(&stream->is_finished)) {
+        uint32_t free_size = stream->ring_size - (write - read);
+        uint32_t offset = write & (stream->ring_size - 1);
+        uint32_t size = scg_min_int(free_size, stream->ring_size - offset);
+        size = scg_min_int(size, length - stream->data_position);
+
+        if (stream->data_position == length) {
+            if (!stream->loop || length == 0) {
+                SDL_AtomicSet(&stream->is_finished, 1);
+                break;
+            }
+
+            scg__sound_stream_rewind(stream);
+            continue;
+        }
+
+        if (size == 0) {
+            break;
+        }
+
+        size_t bytes_read =
+            scg__sound_stream_read(stream, stream->ring + offset, size);
+        if (bytes_read != size) {
+            scg_log_error("Failed to read from sound stream, ending it");
+            SDL_AtomicSet(&stream->is_finished, 1);
+            break;
+        }
+
+        stream->data_position += size;
+        write += size;
+
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&stream->write_position, (int)write);
+    }
+
+    if (restart_request != SDL_AtomicGet(&stream->restart_done)) {
+        SDL_AtomicSet(&stream->restart_done, restart_request);
+    }
+}
+
+static int scg__sound_stream_thread(void *data) {
+    scg_sound_t *sound = data;
+    scg__sound_stream_t *stream = sound->stream;
+
+    while (!SDL_AtomicGet(&stream->quit)) {
+        scg__sound_stream_fill(stream, sound->length);
+        SDL_SemWaitTimeout(stream->wake, SCG__SOUND_STREAM_POLL_MS);
+    }
+
+    return 0;
+}
+
+static void scg__sound_stream_free(scg__sound_stream_t *stream) {
+    if (stream->thread != NULL) {
+        SDL_AtomicSet(&stream->quit, 1);
+        SDL_SemPost(stream->wake);
+        SDL_WaitThread(stream->thread, NULL);
+    }
+
+    if (stream->wake != NULL) {
+        SDL_DestroySemaphore(stream->wake);
+    }
+#ifdef SCG__MMAP
+    if (stream->mapping != NULL) {
+        munmap((void *)stream->mapping, stream->mapping_size);
+    }
+#endif
+    if (stream->file != NULL) {
+        SDL_RWclose(stream->file);
+    }
+
+    free(stream->ring);
+    free(stream);
+}
+
+static void scg__sound_free_data(scg_sound_t *sound) {
+    if (sound->stream != NULL) {
+        scg__sound_stream_free(sound->stream);
+    } else if (sound->owns_buffer) {
+        free(sound->buffer);
+    }
+}
+
+// Maps a whole file into memory, or returns NULL where that is not
+// supported. Writable mappings are private, so writes are never seen in the
+// file.
+static uint8_t *scg__map_file(const char *filepath, size_t *size,
+                              bool is_writable) {
+#ifdef SCG__MMAP
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    int protection = is_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *mapping = mmap(NULL, (size_t)file_stat.st_size, protection,
+                         MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    *size = (size_t)file_stat.st_size;
+
+    return mapping;
+#else
+    (void)filepath;
+    (void)size;
+    (void)is_writable;
+
+    return NULL;
+#endif
+}
+
+//
+// scg_sound_new_stream_from_wav implementation
+//
+
+scg_sound_t *scg_sound_new_stream_from_wav(scg_audio_t *audio,
+                                           const char *filepath, bool loop,
+                                           bool memory_map) {
+    SDL_RWops *file = SDL_RWFromFile(filepath, "rb");
+    if (file == NULL) {
+        scg_log_errorf("Failed to open WAV file at %s. %s", filepath,
+                       SDL_GetError());
+        return NULL;
+    }
+
+    scg__wav_format_t format = {0};
+    if (!scg__read_wav_format(file, &format)) {
+        scg_log_errorf("Failed to read WAV file at %s", filepath);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    if (format.format != SCG__WAV_FORMAT_PCM || format.bits_per_sample != 16 ||
+        format.num_channels != audio->num_channels ||
+        format.frequency != audio->frequency) {
+        scg_log_errorf("WAV file at %s must be 16 bit PCM with %d channels "
+                       "at %d Hz to be streamed",
+                       filepath, audio->num_channels, audio->frequency);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    scg_sound_t *sound = calloc(1, sizeof(*sound));
+    scg__sound_stream_t *stream = calloc(1, sizeof(*stream));
+    if (sound == NULL || stream == NULL) {
+        scg_log_error("Failed to allocate memory for sound stream");
+        free(sound);
+        free(stream);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    // The ring size is a power of two so positions wrap with a mask.
+    uint32_t min_ring_size = (uint32_t)audio->frequency *
+                             audio->bytes_per_sample *
+                             SCG__SOUND_STREAM_BUFFER_MS / 1000;
+    stream->ring_size = 1;
+    while (stream->ring_size < min_ring_size) {
+        stream->ring_size <<= 1;
+    }
+
+    stream->file = file;
+    stream->data_offset = format.data_offset;
+    stream->loop = loop;
+    stream->ring = malloc(stream->ring_size);
+    stream->wake = SDL_CreateSemaphore(0);
+
+    if (memory_map) {
+        stream->mapping =
+            scg__map_file(filepath, &stream->mapping_size, false);
+        if (stream->mapping == NULL) {
+            scg_log_warnf("Failed to map WAV file at %s, reading it instead",
+                          filepath);
+        } else if (stream->mapping_size <
+                   (size_t)format.data_offset + format.data_length) {
+            format.data_length =
+                (uint32_t)(stream->mapping_size - format.data_offset);
+        }
+        if (stream->mapping != NULL) {
+            SDL_RWclose(stream->file);
+            stream->file = NULL;
+        }
+    }
+
+    sound->audio = audio;
+    sound->sdl_spec.freq = format.frequency;
+    sound->sdl_spec.format = AUDIO_S16LSB;
+    sound->sdl_spec.channels = (Uint8)format.num_channels;
+    sound->length = format.data_length - format.data_length %
+                                             (uint32_t)audio->bytes_per_sample;
+    sound->buffer = NULL;
+    sound->stream = stream;
+    sound->loop = loop;
+    sound->priority = 0;
+    sound->last_voice = 0;
+
+    if (stream->ring == NULL || stream->wake == NULL) {
+        scg_log_error("Failed to create sound stream");
+        scg__sound_stream_free(stream);
+        free(sound);
+        return NULL;
+    }
+
+    // Prime the ring before the thread starts, so the sound can play at
+    // once.
+    scg__sound_stream_rewind(stream);
+    scg__sound_stream_fill(stream, sound->length);
+
+    stream->thread =
+        SDL_CreateThread(scg__sound_stream_thread, "scg_sound_stream", sound);
+    if (stream->thread == NULL) {
+        scg_log_errorf("Failed to create sound stream thread. %s",
+                       SDL_GetError());
+        scg__sound_stream_free(stream);
+        free(sound);
+        return NULL;
+    }
+
+    sound->next = audio->sounds;
+    audio->sounds = sound;
+
+    return sound;
+}
+
+static inline int scg__voice_index(scg_voice_id_t voice) {
+    return (int)(voice & 0xFFFF) - 1;
+}
+
+typedef struct scg__audio_clock_t {
+    uint64_t audible_frame;
+    uint64_t voice_frames;
+    scg_voice_id_t playing_id;
+    int play_offset;
+    uint64_t play_step;
+    bool play_loop;
+    uint32_t start_frame;
+} scg__audio_clock_t;
+
+// Reads the clock, and the state of a voice if one is given, retrying while
+// the audio thread is publishing them. Each callback asks for the samples
+// that follow those still queued in the device, so the frame being heard is
+// taken to be a device buffer behind the callback, moving on at the device
+// rate until the next one.
+static scg__audio_clock_t scg__audio_read_clock(scg_audio_t *audio,
+                                                scg__voice_t *voice) {
+    scg__audio_clock_t clock = {0};
+    uint64_t clock_frames, clock_counter, voice_frames;
+    int callback_frames, sequence;
+
+    do {
+        sequence = SDL_AtomicGet(&audio->clock_sequence);
+        SDL_MemoryBarrierAcquire();
+
+        clock_frames = audio->clock_frames;
+        clock_counter = audio->clock_counter;
+        callback_frames = audio->clock_callback_frames;
+        voice_frames = audio->voice_frames;
+        if (voice != NULL) {
+            clock.playing_id =
+                (scg_voice_id_t)SDL_AtomicGet(&voice->playing_id);
+            clock.play_offset = SDL_AtomicGet(&voice->play_offset);
+            clock.play_step = voice->play_step;
+            clock.play_loop = voice->play_loop;
+            clock.start_frame = (uint32_t)SDL_AtomicGet(&voice->start_frame);
+        }
+
+        SDL_MemoryBarrierAcquire();
+    } while ((sequence & 1) != 0 ||
+             SDL_AtomicGet(&audio->clock_sequence) != sequence);
+
+    // Offline audio does not play in real time, so only what has been mixed
+    // has been heard.
+    float64_t elapsed_frames =
+        audio->is_offline
+            ? callback_frames
+            : scg_get_elapsed_time_secs(scg_get_performance_counter(),
+                                        clock_counter) *
+                  audio->frequency;
+    uint64_t heard_frames =
+        clock_frames + (elapsed_frames < callback_frames
+                            ? (uint64_t)elapsed_frames
+                            : (uint64_t)callback_frames);
+
+    clock.voice_frames = voice_frames;
+    clock.audible_frame =
+        heard_frames > (uint64_t)audio->latency_sample_count
+            ? heard_frames - audio->latency_sample_count
+            : 0;
+
+    // Never run backwards when a callback is late.
+    if (clock.audible_frame < audio->last_audible_frame) {
+        clock.audible_frame = audio->last_audible_frame;
+    }
+    audio->last_audible_frame = clock.audible_frame;
+
+    return clock;
+}
+
+// Returns voices the audio thread has finished with to the free list. A
+// voice that was stolen since it finished keeps its new id and stays in use.
+static void scg__audio_reclaim_voices(scg_audio_t *audio) {
+    int read = SDL_AtomicGet(&audio->finished_read);
+    int write = SDL_AtomicGet(&audio->finished_write);
+    SDL_MemoryBarrierAcquire();
+
+    for (; read != write; read++) {
+        scg_voice_id_t id =
+            audio->finished_voices[read % audio->finished_voices_capacity];
+        int index = scg__voice_index(id);
+        scg__voice_slot_t *slot = &audio->voice_slots[index];
+
+        if (slot->allocated && slot->id == id) {
+            slot->allocated = false;
+            audio->free_voices[audio->num_free_voices++] = index;
+        }
+    }
+
+    SDL_AtomicSet(&audio->finished_read, read);
+}
+
+// Takes a free voice, or steals the lowest priority and then oldest voice if
+// its priority is not above the new one.
+static int scg__audio_allocate_voice(scg_audio_t *audio, int priority) {
+    scg__audio_reclaim_voices(audio);
+
+    if (audio->num_free_voices > 0) {
+        return audio->free_voices[--audio->num_free_voices];
+    }
+
+    int victim = 0;
+    for (int i = 1; i < audio->num_voices; i++) {
+        scg__voice_slot_t *slot = &audio->voice_slots[i];
+        scg__voice_slot_t *best = &audio->voice_slots[victim];
+
+        if (slot->priority < best->priority ||
+            (slot->priority == best->priority &&
+             slot->play_order < best->play_order)) {
+            victim = i;
+        }
+    }
+
+    if (audio->voice_slots[victim].priority > priority) {
+        return -1;
+    }
+
+    return victim;
+}
+
+//
+// scg_sound_play_with implementation
+//
+
+scg_voice_id_t scg_sound_play_with(scg_sound_t *sound, float32_t volume,
+                                   float32_t pan) {
+    scg_audio_t *audio = sound->audio;
+
+    int index = scg__audio_allocate_voice(audio, sound->priority);
+    if (index < 0) {
+        return 0;
+    }
+
+    // The high bits count how many times the voice has been used, so ids of
+    // earlier plays no longer match.
+    scg__voice_slot_t *slot = &audio->voice_slots[index];
+    uint32_t generation = ((slot->id >> 16) + 1) & 0xFFFF;
+    slot->id = generation << 16 | (uint32_t)(index + 1);
+    slot->sound = sound;
+    slot->priority = sound->priority;
+    slot->play_order = audio->play_count++;
+    slot->allocated = true;
+    sound->last_voice = slot->id;
+
+    scg__audio_command_t command = {
+        .type = SCG__AUDIO_COMMAND_PLAY,
+        .voice = slot->id,
+        .sound = sound,
+        .value = scg_clamp_float32(volume, 0.0f, 1.0f),
+        .loop = sound->loop};
+    scg__audio_send_command(audio, command);
+
+    if (pan != 0.0f) {
+        scg_voice_set_pan(audio, slot->id, pan);
+    }
+
+    return slot->id;
+}
+
+//
+// scg_sound_play implementation
+//
+
+scg_voice_id_t scg_sound_play(scg_sound_t *sound) {
+    return scg_sound_play_with(sound, 1.0f, 0.0f);
+}
+
+//
+// scg_sound_stop implementation
+//
+
+void scg_sound_stop(scg_sound_t *sound) {
+    scg__audio_command_t command = {.type = SCG__AUDIO_COMMAND_STOP_SOUND,
+                                    .sound = sound};
+    scg__audio_send_command(sound->audio, command);
+}
+
+//
+// scg_sound_set_priority implementation
+//
+
+void scg_sound_set_priority(scg_sound_t *sound, int priority) {
+    sound->priority = priority;
+}
+
+//
+// scg_sound_get_position implementation
+//
+
+float32_t scg_sound_get_position(scg_sound_t *sound) {
+    return scg_voice_get_position(sound->audio, sound->last_voice);
+}
+
+//
+// scg_sound_free implementation
+//
+
+void scg_sound_free(scg_sound_t *sound) {
+    scg_audio_t *audio = sound->audio;
+
+    // With the audio thread held off, apply any commands that may still
+    // refer to the sound, then stop its voices.
+    scg__audio_lock(audio);
+
+    scg__audio_process_commands(audio);
+    for (int i = 0; i < audio->num_active_voices;) {
+        scg__voice_t *voice = &audio->voices[audio->active_voices[i]];
+
+        if (voice->sound == sound) {
+            scg__audio_stop_voice(audio, voice);
+        } else {
+            i++;
+        }
+    }
+
+    scg__audio_unlock(audio);
+
+    for (scg_sound_t **link = &audio->sounds; *link != NULL;
+         link = &(*link)->next) {
+        if (*link == sound) {
+            *link = sound->next;
+            break;
+        }
+    }
+
+    scg__sound_free_data(sound);
+    free(sound);
+}
+
+//
+// scg_voice_stop implementation
+//
+
+void scg_voice_stop(scg_audio_t *audio, scg_voice_id_t voice) {
+    scg__audio_command_t command = {.type = SCG__AUDIO_COMMAND_STOP,
+                                    .voice = voice};
+    scg__audio_send_command(audio, command);
+}
+
+//
+// scg_voice_set_volume implementation
+//
+
+void scg_voice_set_volume(scg_audio_t *audio, scg_voice_id_t voice,
+                          float32_t volume) {
+    scg__audio_command_t command = {
+        .type = SCG__AUDIO_COMMAND_SET_VOLUME,
+        .voice = voice,
+        .value = scg_clamp_float32(volume, 0.0f, 1.0f)};
+    scg__audio_send_command(audio, command);
+}
+
+//
+// scg_voice_set_pan implementation
+//
+
+void scg_voice_set_pan(scg_audio_t *audio, scg_voice_id_t voice,
+                       float32_t pan) {
+    scg__audio_command_t command = {
+        .type = SCG__AUDIO_COMMAND_SET_PAN,
+        .voice = voice,
+        .value = scg_clamp_float32(pan, -1.0f, 1.0f)};
+    scg__audio_send_command(audio, command);
+}
+
+//
+// scg_voice_set_pitch implementation
+//
+
+void scg_voice_set_pitch(scg_audio_t *audio, scg_voice_id_t voice,
+                         float32_t pitch) {
+    scg__audio_command_t command = {
+        .type = SCG__AUDIO_COMMAND_SET_PITCH,
+        .voice = voice,
+        .value = scg_clamp_float32(pitch, SCG__AUDIO_MIN_PITCH,
+                                   SCG__AUDIO_MAX_PITCH)};
+    scg__audio_send_command(audio, command);
+}
+
+//
+// scg_voice_is_playing implementation
+//
+
+bool scg_voice_is_playing(scg_audio_t *audio, scg_voice_id_t voice) {
+    int index = scg__voice_index(voice);
+    if (index < 0 || index >= audio->num_voices) {
+        return false;
+    }
+
+    scg__audio_reclaim_voices(audio);
+
+    scg__voice_slot_t *slot = &audio->voice_slots[index];
+
+    return slot->allocated && slot->id == voice;
+}
+
+//
+// scg_voice_get_position implementation
+//
+
+float32_t scg_voice_get_position(scg_audio_t *audio, scg_voice_id_t voice) {
+    int index = scg__voice_index(voice);
+    if (index < 0 || index >= audio->num_voices) {
+        return 0.0f;
+    }
+
+    scg_sound_t *sound = audio->voice_slots[index].sound;
+    scg__audio_clock_t clock =
+        scg__audio_read_clock(audio, &audio->voices[index]);
+
+    if (clock.playing_id != voice || sound->length == 0 ||
+        (int32_t)((uint32_t)clock.audible_frame - clock.start_frame) < 0) {
+        return 0.0f;
+    }
+
+    // The play offset is where mixing stopped, so step back by the frames
+    // mixed but not yet heard, each of which moved the voice on by its step.
+    int64_t length = sound->length;
+    int64_t frames_queued =
+        clock.voice_frames > clock.audible_frame
+            ? (int64_t)(clock.voice_frames - clock.audible_frame)
+            : 0;
+    int64_t sound_frames_queued =
+        (int64_t)(((uint64_t)frames_queued * clock.play_step) >> 32);
+    int64_t offset =
+        clock.play_offset - sound_frames_queued * audio->bytes_per_sample;
+    if (clock.play_loop) {
+        offset = (offset % length + length) % length;
+    } else if (offset < 0) {
+        offset = 0;
+    }
+
+    return (float32_t)offset / (float32_t)length;
+}
+
+//
+// scg_voice_get_time implementation
+//
+
+float64_t scg_voice_get_time(scg_audio_t *audio, scg_voice_id_t voice) {
+    int index = scg__voice_index(voice);
+    if (index < 0 || index >= audio->num_voices) {
+        return 0.0;
+    }
+
+    scg__audio_clock_t clock =
+        scg__audio_read_clock(audio, &audio->voices[index]);
+    int32_t frames_heard =
+        (int32_t)((uint32_t)clock.audible_frame - clock.start_frame);
+
+    if (clock.playing_id != voice || frames_heard < 0) {
+        return 0.0;
+    }
+
+    return (float64_t)frames_heard / audio->frequency;
+}
+
+//
+// scg_audio_get_time implementation
+//
+
+float64_t scg_audio_get_time(scg_audio_t *audio) {
+    scg__audio_clock_t clock = scg__audio_read_clock(audio, NULL);
+
+    return (float64_t)clock.audible_frame / audio->frequency;
+}
+
+//
+// scg_audio_set_volume implementation
+//
+
+void scg_audio_set_volume(scg_audio_t *audio, float32_t volume) {
+    scg__audio_command_t command = {
+        .type = SCG__AUDIO_COMMAND_SET_MASTER_VOLUME,
+        .value = scg_clamp_float32(volume, 0.0f, 1.0f)};
+    scg__audio_send_command(audio, command);
+}
+
+// Takes an effect out of the chain on the audio thread, keeping the order
+// of the rest.
+static void scg__audio_remove_effect_now(scg_audio_t *audio,
+                                         scg_effect_t *effect) {
+    for (int i = 0; i < audio->num_effects; i++) {
+        if (audio->effects[i] == effect) {
+            memmove(&audio->effects[i], &audio->effects[i + 1],
+                    (audio->num_effects - i - 1) * sizeof(*audio->effects));
+            audio->num_effects--;
+            break;
+        }
+    }
+}
+
+static void scg__effect_free_data(scg_effect_t *effect) {
+    if (effect->type == SCG_EFFECT_DELAY) {
+        free(effect->state.delay.buffer);
+    } else if (effect->type == SCG_EFFECT_REVERB) {
+        free(effect->state.reverb.buffer);
+    }
+}
+
+static scg_effect_t *scg__effect_new(scg_audio_t *audio,
+                                     scg_effect_type_t type, float32_t wet) {
+    scg_effect_t *effect = calloc(1, sizeof(*effect));
+    if (effect == NULL) {
+        scg_log_error("Failed to allocate memory for audio effect");
+
+        return NULL;
+    }
+
+    effect->type = type;
+    effect->audio = audio;
+    effect->wet = scg_clamp_float32(wet, 0.0f, 1.0f);
+    effect->next = audio->effect_list;
+    audio->effect_list = effect;
+
+    return effect;
+}
+
+static inline float32_t scg__db_to_gain(float32_t db) {
+    return powf(10.0f, db / 20.0f);
+}
+
+//
+// scg_effect_new_filter implementation
+//
+
+scg_effect_t *scg_effect_new_filter(scg_audio_t *audio, scg_filter_type_t type,
+                                    float32_t frequency, float32_t q,
+                                    float32_t gain_db) {
+    scg_effect_t *effect = scg__effect_new(audio, SCG_EFFECT_FILTER, 1.0f);
+    if (effect == NULL) {
+        return NULL;
+    }
+
+    // Coefficients from the Audio EQ Cookbook by Robert Bristow-Johnson.
+    float32_t sample_rate = (float32_t)audio->frequency;
+    frequency = scg_clamp_float32(frequency, 10.0f, sample_rate * 0.49f);
+    q = scg_max_float32(q, 0.01f);
+
+    float32_t w0 = SCG_PI_2 * frequency / sample_rate;
+    float32_t cos_w0 = cosf(w0);
+    float32_t alpha = sinf(w0) / (2.0f * q);
+    float32_t a = powf(10.0f, gain_db / 40.0f);
+    float32_t shelf = 2.0f * sqrtf(a) * alpha;
+    float32_t b0, b1, b2, a0, a1, a2;
+
+    switch (type) {
+    case SCG_FILTER_LOWPASS:
+        b0 = b2 = (1.0f - cos_w0) / 2.0f;
+        b1 = 1.0f - cos_w0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case SCG_FILTER_HIGHPASS:
+        b0 = b2 = (1.0f + cos_w0) / 2.0f;
+        b1 = -(1.0f + cos_w0);
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case SCG_FILTER_BANDPASS:
+        b0 = alpha;
+        b1 = 0.0f;
+        b2 = -alpha;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case SCG_FILTER_NOTCH:
+        b0 = b2 = 1.0f;
+        b1 = -2.0f * cos_w0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case SCG_FILTER_PEAK:
+        b0 = 1.0f + alpha * a;
+        b1 = -2.0f * cos_w0;
+        b2 = 1.0f - alpha * a;
+        a0 = 1.0f + alpha / a;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha / a;
+        break;
+    case SCG_FILTER_LOW_SHELF:
+        b0 = a * ((a + 1.0f) - (a - 1.0f) * cos_w0 + shelf);
+        b1 = 2.0f * a * ((a - 1.0f) - (a + 1.0f) * cos_w0);
+        b2 = a * ((a + 1.0f) - (a - 1.0f) * cos_w0 - shelf);
+        a0 = (a + 1.0f) + (a - 1.0f) * cos_w0 + shelf;
+        a1 = -2.0f * ((a - 1.0f) + (a + 1.0f) * cos_w0);
+        a2 = (a + 1.0f) + (a - 1.0f) * cos_w0 - shelf;
+        break;
+    case SCG_FILTER_HIGH_SHELF:
+    default:
+        b0 = a * ((a + 1.0f) + (a - 1.0f) * cos_w0 + shelf);
+        b1 = -2.0f * a * ((a - 1.0f) + (a + 1.0f) * cos_w0);
+        b2 = a * ((a + 1.0f) + (a - 1.0f) * cos_w0 - shelf);
+        a0 = (a + 1.0f) - (a - 1.0f) * cos_w0 + shelf;
+        a1 = 2.0f * ((a - 1.0f) - (a + 1.0f) * cos_w0);
+        a2 = (a + 1.0f) - (a - 1.0f) * cos_w0 - shelf;
+        break;
+    }
+
+    scg__biquad_t *biquad = &effect->state.biquad;
+    biquad->b0 = b0 / a0;
+    biquad->b1 = b1 / a0;
+    biquad->b2 = b2 / a0;
+    biquad->a1 = a1 / a0;
+    biquad->a2 = a2 / a0;
+
+    return effect;
+}
+
+//
+// scg_effect_new_delay implementation
+//
+
+scg_effect_t *scg_effect_new_delay(scg_audio_t *audio, float32_t delay_secs,
+                                   float32_t feedback, float32_t wet) {
+    scg_effect_t *effect = scg__effect_new(audio, SCG_EFFECT_DELAY, wet);
+    if (effect == NULL) {
+        return NULL;
+    }
+
+    scg__delay_t *delay = &effect->state.delay;
+    delay->length = scg_max_int((int)(delay_secs * audio->frequency), 1);
+    delay->feedback = scg_clamp_float32(feedback, 0.0f, 0.99f);
+    delay->buffer = calloc(delay->length * 2, sizeof(*delay->buffer));
+    if (delay->buffer == NULL) {
+        scg_log_error("Failed to allocate memory for delay effect");
+
+        scg_effect_free(effect);
+        return NULL;
+    }
+
+    return effect;
+}
+
+//
+// scg_effect_new_reverb implementation
+//
+
+scg_effect_t *scg_effect_new_reverb(scg_audio_t *audio, float32_t room_size,
+                                    float32_t damping, float32_t wet) {
+    // Line lengths of Freeverb at 44100 Hz, scaled to the device rate.
+    static const int comb_lengths[SCG__REVERB_NUM_COMBS] = {1116, 1188, 1277,
+                                                            1356};
+    static const int allpass_lengths[SCG__REVERB_NUM_ALLPASSES] = {556, 441};
+    const int stereo_spread = 23;
+
+    scg_effect_t *effect = scg__effect_new(audio, SCG_EFFECT_REVERB, wet);
+    if (effect == NULL) {
+        return NULL;
+    }
+
+    scg__reverb_t *reverb = &effect->state.reverb;
+    float32_t scale = (float32_t)audio->frequency / 44100.0f;
+    int total_length = 0;
+
+    for (int c = 0; c < 2; c++) {
+        int spread = c * stereo_spread;
+
+        for (int i = 0; i < SCG__REVERB_NUM_COMBS; i++) {
+            reverb->combs[c][i].length =
+                (int)((comb_lengths[i] + spread) * scale);
+            total_length += reverb->combs[c][i].length;
+        }
+        for (int i = 0; i < SCG__REVERB_NUM_ALLPASSES; i++) {
+            reverb->allpasses[c][i].length =
+                (int)((allpass_lengths[i] + spread) * scale);
+            total_length += reverb->allpasses[c][i].length;
+        }
+    }
+
+    reverb->buffer = calloc(total_length, sizeof(*reverb->buffer));
+    if (reverb->buffer == NULL) {
+        scg_log_error("Failed to allocate memory for reverb effect");
+
+        scg_effect_free(effect);
+        return NULL;
+    }
+
+    // Every line gets its own part of one buffer.
+    float32_t *line = reverb->buffer;
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < SCG__REVERB_NUM_COMBS; i++) {
+            reverb->combs[c][i].buffer = line;
+            line += reverb->combs[c][i].length;
+        }
+        for (int i = 0; i < SCG__REVERB_NUM_ALLPASSES; i++) {
+            reverb->allpasses[c][i].buffer = line;
+            line += reverb->allpasses[c][i].length;
+        }
+    }
+
+    reverb->feedback = 0.7f + 0.28f * scg_clamp_float32(room_size, 0.0f, 1.0f);
+    reverb->damping = 0.4f * scg_clamp_float32(damping, 0.0f, 1.0f);
+
+    return effect;
+}
+
+//
+// scg_effect_new_compressor implementation
+//
+
+scg_effect_t *scg_effect_new_compressor(scg_audio_t *audio,
+                                        float32_t threshold_db,
+                                        float32_t ratio, float32_t attack_ms,
+                                        float32_t release_ms,
+                                        float32_t makeup_db) {
+    scg_effect_t *effect =
+        scg__effect_new(audio, SCG_EFFECT_COMPRESSOR, 1.0f);
+    if (effect == NULL) {
+        return NULL;
+    }
+
+    // The envelope moves towards each new peak by a fixed fraction per
+    // frame, reaching about 63% of it after the attack or release time.
+    float32_t frames_per_ms = audio->frequency / 1000.0f;
+    scg__compressor_t *compressor = &effect->state.compressor;
+    compressor->threshold_db = threshold_db;
+    compressor->slope = 1.0f - 1.0f / scg_max_float32(ratio, 1.0f);
+    compressor->attack =
+        expf(-1.0f / scg_max_float32(attack_ms * frames_per_ms, 1.0f));
+    compressor->release =
+        expf(-1.0f / scg_max_float32(release_ms * frames_per_ms, 1.0f));
+    compressor->makeup = scg__db_to_gain(makeup_db);
+
+    return effect;
+}
+
+//
+// scg_effect_new_limiter implementation
+//
+
+scg_effect_t *scg_effect_new_limiter(scg_audio_t *audio, float32_t ceiling_db,
+                                     float32_t release_ms) {
+    return scg_effect_new_compressor(audio, ceiling_db, INFINITY, 0.0f,
+                                     release_ms, 0.0f);
+}
+
+//
+// scg_audio_add_effect implementation
+//
+
+void scg_audio_add_effect(scg_audio_t *audio, scg_effect_t *effect) {
+    if (effect->is_added) {
+        return;
+    }
+
+    int num_effects = 0;
+    for (scg_effect_t *other = audio->effect_list; other != NULL;
+         other = other->next) {
+        num_effects += other->is_added;
+    }
+
+    if (num_effects == SCG__AUDIO_MAX_EFFECTS) {
+        scg_log_errorf("Audio can have at most %d effects",
+                       SCG__AUDIO_MAX_EFFECTS);
+        return;
+    }
+
+    effect->is_added = true;
+
+    scg__audio_command_t command = {.type = SCG__AUDIO_COMMAND_ADD_EFFECT,
+                                    .effect = effect};
+    scg__audio_send_command(audio, command);
+}
+
+//
+// scg_audio_remove_effect implementation
+//
+
+void scg_audio_remove_effect(scg_audio_t *audio, scg_effect_t *effect) {
+    if (!effect->is_added) {
+        return;
+    }
+
+    effect->is_added = false;
+
+    scg__audio_command_t command = {.type = SCG__AUDIO_COMMAND_REMOVE_EFFECT,
+                                    .effect = effect};
+    scg__audio_send_command(audio, command);
+}
+
+//
+// scg_effect_free implementation
+//
+
+void scg_effect_free(scg_effect_t *effect) {
+    scg_audio_t *audio = effect->audio;
+
+    // As with sounds, hold off the audio thread while the effect is taken
+    // out of the chain.
+    scg__audio_lock(audio);
+
+    scg__audio_process_commands(audio);
+    scg__audio_remove_effect_now(audio, effect);
+
+    scg__audio_unlock(audio);
+
+    for (scg_effect_t **link = &audio->effect_list; *link != NULL;
+         link = &(*link)->next) {
+        if (*link == effect) {
+            *link = effect->next;
+            break;
+        }
+    }
+
+    scg__effect_free_data(effect);
+    free(effect);
+}
+
+// A pack starts with a header holding SCG__PACK_MAGIC, the version, the
+// number of entries and the offset of the table of contents. Each entry of
+// the table holds a name, a type, four parameters and the offset and size
+// of its data, which is aligned to SCG__PACK_ALIGNMENT:
+//
+// - Images are ARGB8888 pixels, with the width and height as parameters.
+// - Sounds are samples, with the rate, SDL audio format and number of
+//   channels as parameters.
+// - Fonts are the bitmaps, row bounds and code point ranges of an
+//   scg_font_t, each aligned to 4 bytes, with the glyph width, glyph height,
+//   number of glyphs and number of ranges as parameters.
+//
+// The header and table are little endian, while the asset data is stored
+// as it is laid out in memory so it can be used in place.
+typedef struct scg__pack_entry_t {
+    int index;
+    uint32_t params[4];
+    uint8_t *data;
+    size_t size;
+} scg__pack_entry_t;
+
+static inline uint64_t scg__read_u64_le(const uint8_t *bytes) {
+    return (uint64_t)scg__read_u32_le(bytes) |
+           (uint64_t)scg__read_u32_le(bytes + 4) << 32;
+}
+
+// Finds where the row bounds and ranges of a packed font start, and its
+// total size.
+static size_t scg__pack_font_layout(int glyph_width, int glyph_height,
+                                    int num_glyphs, int num_ranges,
+                                    size_t *row_bounds_offset,
+                                    size_t *ranges_offset) {
+    size_t bitmaps_size =
+        (size_t)num_glyphs * glyph_height * ((glyph_width + 7) / 8);
+
+    *row_bounds_offset = (bitmaps_size + 3) & ~(size_t)3;
+    *ranges_offset =
+        (*row_bounds_offset + (size_t)num_glyphs * 2 + 3) & ~(size_t)3;
+
+    return *ranges_offset + (size_t)num_ranges * sizeof(scg_font_range_t);
+}
+
+// Looks an entry up by name with a binary search of the table.
+static bool scg__pack_find(scg_pack_t *pack, const char *name, uint32_t type,
+                           scg__pack_entry_t *entry) {
+    int low = 0;
+    int high = pack->num_entries - 1;
+
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        const uint8_t *bytes =
+            pack->entries + (size_t)mid * SCG__PACK_ENTRY_SIZE;
+        int order = strncmp(name, (const char *)bytes, SCG__PACK_NAME_SIZE);
+
+        if (order < 0) {
+            high = mid - 1;
+        } else if (order > 0) {
+            low = mid + 1;
+        } else {
+            uint64_t offset = scg__read_u64_le(bytes + 80);
+            uint64_t size = scg__read_u64_le(bytes + 88);
+
+            if (scg__read_u32_le(bytes + 56) != type) {
+                scg_log_errorf("Asset %s in pack has the wrong type", name);
+                return false;
+            }
+            if (offset > pack->size || size > pack->size - offset) {
+                scg_log_errorf("Asset %s in pack is truncated", name);
+                return false;
+            }
+            // Images and fonts are used in place as arrays of uint32_t and
+            // structs, so their data must keep the alignment it was packed
+            // with.
+            if (offset % SCG__PACK_ALIGNMENT != 0) {
+                scg_log_errorf("Asset %s in pack is misaligned", name);
+                return false;
+            }
+
+            entry->index = mid;
+            for (int i = 0; i < 4; i++) {
+                entry->params[i] = scg__read_u32_le(bytes + 60 + i * 4);
+            }
+            entry->data = pack->data + offset;
+            entry->size = (size_t)size;
+
+            return true;
+        }
+    }
+
+    scg_log_errorf("Asset %s not found in pack", name);
+
+    return false;
+}
+
+//
+// scg_pack_new_from_file implementation
+//
+
+scg_pack_t *scg_pack_new_from_file(const char *filepath) {
+    scg_pack_t *pack = calloc(1, sizeof(*pack));
+    if (pack == NULL) {
+        scg_log_error("Failed to allocate memory for pack");
+        return NULL;
+    }
+
+    pack->data = scg__map_file(filepath, &pack->size, true);
+    pack->is_mapped = pack->data != NULL;
+    if (!pack->is_mapped) {
+        pack->data = scg__read_file(filepath, &pack->size);
+        if (pack->data == NULL) {
+            free(pack);
+            return NULL;
+        }
+    }
+
+    const uint8_t *header = pack->data;
+    if (pack->size < SCG__PACK_HEADER_SIZE ||
+        memcmp(header, SCG__PACK_MAGIC, sizeof(SCG__PACK_MAGIC)) != 0 ||
+        scg__read_u32_le(header + 8) != SCG__PACK_VERSION) {
+        scg_log_errorf("File at %s is not an asset pack", filepath);
+        scg_pack_free(pack);
+        return NULL;
+    }
+
+    uint32_t num_entries = scg__read_u32_le(header + 12);
+    uint64_t entries_offset = scg__read_u64_le(header + 16);
+    if (entries_offset > pack->size ||
+        num_entries > (pack->size - entries_offset) / SCG__PACK_ENTRY_SIZE) {
+        scg_log_errorf("Asset pack at %s is truncated", filepath);
+        scg_pack_free(pack);
+        return NULL;
+    }
+
+    pack->num_entries = (int)num_entries;
+    pack->entries = pack->data + entries_offset;
+    pack->fonts = calloc(num_entries + 1, sizeof(*pack->fonts));
+    if (pack->fonts == NULL) {
+        scg_log_error("Failed to allocate memory for pack");
+        scg_pack_free(pack);
+        return NULL;
+    }
+
+    return pack;
+}
+
+//
+// scg_image_new_from_pack implementation
+//
+
+scg_image_t *scg_image_new_from_pack(scg_pack_t *pack, const char *name) {
+    scg__pack_entry_t entry;
+    if (!scg__pack_find(pack, name, SCG__PACK_ENTRY_IMAGE, &entry)) {
+        return NULL;
+    }
+
+    uint32_t width = entry.params[0];
+    uint32_t height = entry.params[1];
+    if (width == 0 || height == 0 || width > SCG__IMAGE_MAX_SIZE ||
+        height > SCG__IMAGE_MAX_SIZE ||
+        (size_t)width * height * sizeof(uint32_t) != entry.size) {
+        scg_log_errorf("Image %s in pack is invalid", name);
+        return NULL;
+    }
+
+    scg_image_t *image = malloc(sizeof(*image));
+    if (image == NULL) {
+        scg_log_error("Failed to allocate memory for image");
+        return NULL;
+    }
+
+    image->width = (int)width;
+    image->height = (int)height;
+    image->pitch = (int)(width * sizeof(uint32_t));
+    image->pixels = (uint32_t *)entry.data;
+    image->blend_mode = SCG_BLEND_MODE_NONE;
+    image->owns_pixels = false;
+
+    return image;
+}
+
+//
+// scg_sound_new_from_pack implementation
+//
+
+scg_sound_t *scg_sound_new_from_pack(scg_audio_t *audio, scg_pack_t *pack,
+                                     const char *name, bool loop) {
+    scg__pack_entry_t entry;
+    if (!scg__pack_find(pack, name, SCG__PACK_ENTRY_SOUND, &entry)) {
+        return NULL;
+    }
+
+    if (entry.size > UINT32_MAX) {
+        scg_log_errorf("Sound %s in pack is too long", name);
+        return NULL;
+    }
+
+    SDL_AudioSpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.freq = (int)entry.params[0];
+    spec.format = (SDL_AudioFormat)entry.params[1];
+    spec.channels = (Uint8)entry.params[2];
+
+    uint32_t length = (uint32_t)entry.size;
+    if (spec.freq == audio->frequency && spec.format == AUDIO_S16LSB &&
+        spec.channels == audio->num_channels) {
+        length -= length % (uint32_t)audio->bytes_per_sample;
+        return scg__sound_new(audio, entry.data, length, false, loop);
+    }
+
+    uint32_t converted_length;
+    uint8_t *converted = scg__audio_convert_wav(
+        audio->frequency, spec, entry.data, length, &converted_length);
+    if (converted == NULL) {
+        scg_log_errorf("Failed to convert sound %s in pack", name);
+        return NULL;
+    }
+
+    scg_sound_t *sound =
+        scg__sound_new(audio, converted, converted_length, true, loop);
+    if (sound == NULL) {
+        free(converted);
+    }
+
+    return sound;
+}
+
+//
+// scg_pack_get_font implementation
+//
+
+const scg_font_t *scg_pack_get_font(scg_pack_t *pack, const char *name) {
+    scg__pack_entry_t entry;
+    if (!scg__pack_find(pack, name, SCG__PACK_ENTRY_FONT, &entry)) {
+        return NULL;
+    }
+
+    if (pack->fonts[entry.index] != NULL) {
+        return pack->fonts[entry.index];
+    }
+
+    uint32_t glyph_width = entry.params[0];
+    uint32_t glyph_height = entry.params[1];
+    uint32_t num_glyphs = entry.params[2];
+    uint32_t num_ranges = entry.params[3];
+    size_t row_bounds_offset = 0;
+    size_t ranges_offset = 0;
+
+    bool is_valid = glyph_width > 0 && glyph_width <= 255 &&
+                    glyph_height > 0 && glyph_height <= 255 &&
+                    num_glyphs > 0 && num_glyphs <= entry.size &&
+                    num_ranges <= entry.size &&
+                    scg__pack_font_layout(
+                        (int)glyph_width, (int)glyph_height, (int)num_glyphs,
+                        (int)num_ranges, &row_bounds_offset,
+                        &ranges_offset) == entry.size;
+
+    // Glyphs are looked up through the ranges, so each must stay within
+    // the glyphs of the font.
+    const scg_font_range_t *ranges =
+        (const scg_font_range_t *)(entry.data + ranges_offset);
+    for (uint32_t i = 0; is_valid && i < num_ranges; i++) {
+        is_valid = ranges[i].first_code <= ranges[i].last_code &&
+                   ranges[i].first_glyph >= 0 &&
+                   (uint32_t)ranges[i].first_glyph < num_glyphs &&
+                   ranges[i].last_code - ranges[i].first_code <
+                       num_glyphs - (uint32_t)ranges[i].first_glyph;
+    }
+
+    if (!is_valid) {
+        scg_log_errorf("Font %s in pack is invalid", name);
+        return NULL;
+    }
+
+    scg_font_t *font = calloc(1, sizeof(*font));
+    if (font == NULL) {
+        scg_log_error("Failed to allocate memory for font");
+        return NULL;
+    }
+
+    font->glyph_width = (int)glyph_width;
+    font->glyph_height = (int)glyph_height;
+    font->bytes_per_row = (font->glyph_width + 7) / 8;
+    font->num_glyphs = (int)num_glyphs;
+    font->bitmaps = entry.data;
+    font->row_bounds = entry.data + row_bounds_offset;
+    font->num_ranges = (int)num_ranges;
+    font->ranges = ranges;
+    font->owns_data = false;
+    scg__font_find_fallback(font);
+
+    pack->fonts[entry.index] = font;
+
+    return font;
+}
+
+//
+// scg_pack_free implementation
+//
+
+void scg_pack_free(scg_pack_t *pack) {
+    if (pack == NULL) {
+        return;
+    }
+
+    for (int i = 0; pack->fonts != NULL && i < pack->num_entries; i++) {
+        if (scg__font == pack->fonts[i]) {
+            scg__font = &scg_font8x8;
+        }
+        free(pack->fonts[i]);
+    }
+    free(pack->fonts);
+
+#ifdef SCG__MMAP
+    if (pack->is_mapped) {
+        munmap(pack->data, pack->size);
+    } else {
+        free(pack->data);
+    }
+#else
+    free(pack->data);
+#endif
+
+    free(pack);
+}
+
+static bool scg__is_wav(const uint8_t *data, size_t size) {
+    return size >= 12 && memcmp(data, "RIFF", 4) == 0 &&
+           memcmp(data + 8, "WAVE", 4) == 0;
+}
+
+// Decodes a WAV file in memory to samples in the format of the audio device.
+// Returns a buffer to release with free, or NULL on failure.
+static uint8_t *scg__wav_decode(scg_audio_t *audio, const uint8_t *data,
+                                size_t size, const char *name,
+                                uint32_t *length) {
+    SDL_AudioSpec spec;
+    uint32_t wav_length;
+    uint8_t *wav_buffer;
+
+    if (audio == NULL) {
+        scg_log_errorf("Failed to load WAV file at %s. No audio device",
+                       name);
+
+        return NULL;
+    }
+
+    if (SDL_LoadWAV_RW(SDL_RWFromConstMem(data, (int)size), 1, &spec,
+                       &wav_buffer, &wav_length) == NULL) {
+        scg_log_errorf("Failed to load WAV file at %s. %s", name,
+                       SDL_GetError());
+
+        return NULL;
+    }
+
+    uint8_t *buffer = scg__audio_convert_wav(audio->frequency, spec,
+                                             wav_buffer, wav_length, length);
+    SDL_FreeWAV(wav_buffer);
+
+    return buffer;
+}
+
+// Decodes an asset on a worker thread. Sounds are converted to the format of
+// the audio device here but only added to it on the main thread, as the list
+// of sounds is not locked.
+static void scg__asset_decode(scg_asset_t *asset) {
+    size_t size;
+    uint8_t *data = scg__read_file(asset->filepath, &size);
+    if (data == NULL) {
+        return;
+    }
+
+    asset->is_sound = scg__is_wav(data, size);
+    if (asset->is_sound) {
+        asset->sound_buffer =
+            scg__wav_decode(asset->loader->audio, data, size,
+                            asset->filepath, &asset->sound_length);
+    } else {
+        asset->image = scg__image_decode(data, size, asset->filepath, NULL);
+    }
+
+    free(data);
+}
+
+static int scg__asset_loader_worker(void *data) {
+    scg_asset_loader_t *loader = data;
+
+    for (;;) {
+        SDL_SemWait(loader->sdl_work_sem);
+
+        SDL_LockMutex(loader->sdl_mutex);
+        if (loader->quit) {
+            SDL_UnlockMutex(loader->sdl_mutex);
+            break;
+        }
+
+        scg_asset_t *asset = loader->queue_head;
+        loader->queue_head = asset->next_queued;
+        if (loader->queue_head == NULL) {
+            loader->queue_tail = NULL;
+        }
+        SDL_UnlockMutex(loader->sdl_mutex);
+
+        scg__asset_decode(asset);
+
+        SDL_LockMutex(loader->sdl_mutex);
+        SDL_AtomicSet(&asset->is_decoded, 1);
+        SDL_AtomicIncRef(&loader->num_decoded);
+        SDL_CondBroadcast(loader->sdl_decoded_cond);
+        SDL_UnlockMutex(loader->sdl_mutex);
+    }
+
+    return 0;
+}
+
+static void scg__asset_loader_free_threads(scg_asset_loader_t *loader) {
+    if (loader->sdl_mutex != NULL) {
+        SDL_LockMutex(loader->sdl_mutex);
+        loader->quit = true;
+        SDL_UnlockMutex(loader->sdl_mutex);
+    }
+
+    for (int i = 0; i < loader->num_threads; i++) {
+        SDL_SemPost(loader->sdl_work_sem);
+    }
+    for (int i = 0; i < loader->num_threads; i++) {
+        SDL_WaitThread(loader->sdl_threads[i], NULL);
+    }
+
+    if (loader->sdl_work_sem != NULL) {
+        SDL_DestroySemaphore(loader->sdl_work_sem);
+    }
+    if (loader->sdl_decoded_cond != NULL) {
+        SDL_DestroyCond(loader->sdl_decoded_cond);
+    }
+    if (loader->sdl_mutex != NULL) {
+        SDL_DestroyMutex(loader->sdl_mutex);
+    }
+
+    free(loader->sdl_threads);
+}
+
+//
+// scg_asset_loader_new implementation
+//
+
+scg_asset_loader_t *scg_asset_loader_new(scg_audio_t *audio, int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = SDL_GetCPUCount();
+    }
+    num_threads = scg_min_int(scg_max_int(num_threads, 1),
+                              SCG__ASSET_LOADER_MAX_THREADS);
+
+    scg_asset_loader_t *loader = calloc(1, sizeof(*loader));
+    if (loader == NULL) {
+        scg_log_error("Failed to allocate memory for asset loader");
+
+        return NULL;
+    }
+
+    loader->audio = audio;
+    loader->sdl_threads = calloc(num_threads, sizeof(*loader->sdl_threads));
+    loader->sdl_mutex = SDL_CreateMutex();
+    loader->sdl_decoded_cond = SDL_CreateCond();
+    loader->sdl_work_sem = SDL_CreateSemaphore(0);
+    if (loader->sdl_threads == NULL || loader->sdl_mutex == NULL ||
+        loader->sdl_decoded_cond == NULL || loader->sdl_work_sem == NULL) {
+        scg_log_errorf("Failed to create asset loader. %s", SDL_GetError());
+
+        scg__asset_loader_free_threads(loader);
+        free(loader);
+        return NULL;
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        loader->sdl_threads[i] = SDL_CreateThread(scg__asset_loader_worker,
+                                                  "scg_asset_loader", loader);
+        if (loader->sdl_threads[i] == NULL) {
+            scg_log_errorf("Failed to create asset loader thread. %s",
+                           SDL_GetError());
+
+            scg__asset_loader_free_threads(loader);
+            free(loader);
+            return NULL;
+        }
+
+        loader->num_threads++;
+    }
+
+    return loader;
+}
+
+//
+// scg_asset_loader_get_progress implementation
+//
+
+float32_t scg_asset_loader_get_progress(scg_asset_loader_t *loader) {
+    int num_queued = SDL_AtomicGet(&loader->num_queued);
+    if (num_queued == 0) {
+        return 1.0f;
+    }
+
+    return (float32_t)SDL_AtomicGet(&loader->num_decoded) / num_queued;
+}
+
+//
+// scg_asset_loader_free implementation
+//
+
+void scg_asset_loader_free(scg_asset_loader_t *loader) {
+    scg__asset_loader_free_threads(loader);
+
+    scg_asset_t *asset = loader->assets;
+    while (asset != NULL) {
+        scg_asset_t *next = asset->next;
+
+        if (!asset->is_claimed) {
+            if (asset->image != NULL) {
+                scg_image_free(asset->image);
+            }
+            if (asset->sound != NULL) {
+                scg_sound_free(asset->sound);
+            }
+        }
+        free(asset->sound_buffer);
+        free(asset->filepath);
+        free(asset);
+
+        asset = next;
+    }
+
+    free(loader);
+}
+
+//
+// scg_asset_load_async implementation
+//
+
+scg_asset_t *scg_asset_load_async(scg_asset_loader_t *loader,
+                                  const char *filepath) {
+    size_t filepath_size = strlen(filepath) + 1;
+
+    scg_asset_t *asset = calloc(1, sizeof(*asset));
+    char *filepath_copy = malloc(filepath_size);
+    if (asset == NULL || filepath_copy == NULL) {
+        scg_log_errorf("Failed to allocate memory for asset %s", filepath);
+
+        free(filepath_copy);
+        free(asset);
+        return NULL;
+    }
+
+    memcpy(filepath_copy, filepath, filepath_size);
+    asset->loader = loader;
+    asset->filepath = filepath_copy;
+    asset->state = SCG_ASSET_STATE_LOADING;
+    asset->next = loader->assets;
+    loader->assets = asset;
+
+    SDL_LockMutex(loader->sdl_mutex);
+    if (loader->queue_tail != NULL) {
+        loader->queue_tail->next_queued = asset;
+    } else {
+        loader->queue_head = asset;
+    }
+    loader->queue_tail = asset;
+    SDL_UnlockMutex(loader->sdl_mutex);
+
+    SDL_AtomicIncRef(&loader->num_queued);
+    SDL_SemPost(loader->sdl_work_sem);
+
+    return asset;
+}
+
+//
+// scg_asset_get_state implementation
+//
+
+scg_asset_state_t scg_asset_get_state(scg_asset_t *asset) {
+    if (asset->state != SCG_ASSET_STATE_LOADING ||
+        SDL_AtomicGet(&asset->is_decoded) == 0) {
+        return asset->state;
+    }
+
+    if (asset->is_sound && asset->sound_buffer != NULL) {
+        asset->sound =
+            scg__sound_new(asset->loader->audio, asset->sound_buffer,
+                           asset->sound_length, true, false);
+        if (asset->sound == NULL) {
+            free(asset->sound_buffer);
+        }
+        asset->sound_buffer = NULL;
+    }
+
+    if (asset->image != NULL || asset->sound != NULL) {
+        asset->state = SCG_ASSET_STATE_READY;
+    } else {
+        scg_log_errorf("Failed to load asset at %s", asset->filepath);
+        asset->state = SCG_ASSET_STATE_FAILED;
+    }
+
+    return asset->state;
+}
+
+//
+// scg_asset_wait implementation
+//
+
+scg_asset_state_t scg_asset_wait(scg_asset_t *asset) {
+    scg_asset_loader_t *loader = asset->loader;
+
+    SDL_LockMutex(loader->sdl_mutex);
+    while (SDL_AtomicGet(&asset->is_decoded) == 0) {
+        SDL_CondWait(loader->sdl_decoded_cond, loader->sdl_mutex);
+    }
+    SDL_UnlockMutex(loader->sdl_mutex);
+
+    return scg_asset_get_state(asset);
+}
+
+//
+// scg_asset_get_image implementation
+//
+
+scg_image_t *scg_asset_get_image(scg_asset_t *asset) {
+    if (scg_asset_get_state(asset) != SCG_ASSET_STATE_READY ||
+        asset->image == NULL) {
+        return NULL;
+    }
+
+    asset->is_claimed = true;
+
+    return asset->image;
+}
+
+//
+// scg_asset_get_sound implementation
+//
+
+scg_sound_t *scg_asset_get_sound(scg_asset_t *asset) {
+    if (scg_asset_get_state(asset) != SCG_ASSET_STATE_READY ||
+        asset->sound == NULL) {
+        return NULL;
+    }
+
+    asset->is_claimed = true;
+
+    return asset->sound;
+}
+
+#ifdef SCG__INOTIFY
+
+// Decodes a changed file on the watcher thread, replacing any earlier reload
+// of it that has not been swapped in yet. A file that fails to decode, say
+// because it was caught halfway through being written, keeps the asset as it
+// was.
+static void scg__asset_watcher_reload(scg_asset_watcher_t *watcher,
+                                      scg__asset_watch_t *watch) {
+    size_t size;
+    uint8_t *data = scg__read_file(watch->filepath, &size);
+    if (data == NULL) {
+        return;
+    }
+
+    scg_image_t *image = NULL;
+    uint8_t *buffer = NULL;
+    uint32_t length = 0;
+
+    if (watch->sound != NULL) {
+        buffer = scg__wav_decode(watcher->audio, data, size, watch->filepath,
+                                 &length);
+    } else {
+        image = scg__image_decode(data, size, watch->filepath, NULL);
+    }
+    free(data);
+
+    if (image == NULL && buffer == NULL) {
+        scg_log_warnf("Failed to reload %s, keeping the previous version",
+                      watch->filepath);
+        return;
+    }
+
+    SDL_LockMutex(watcher->sdl_mutex);
+    if (watch->reloaded_image != NULL) {
+        scg_image_free(watch->reloaded_image);
+    }
+    free(watch->reloaded_buffer);
+    watch->reloaded_image = image;
+    watch->reloaded_buffer = buffer;
+    watch->reloaded_length = length;
+    watch->is_reloaded = true;
+    SDL_UnlockMutex(watcher->sdl_mutex);
+}
+
+static void scg__asset_watcher_handle_event(scg_asset_watcher_t *watcher,
+                                            const struct inotify_event *event) {
+    // Watches are only ever appended, so each one can be used without the
+    // lock once it has been read from the array.
+    for (int i = 0;; i++) {
+        SDL_LockMutex(watcher->sdl_mutex);
+        scg__asset_watch_t *watch =
+            i < watcher->num_watches ? watcher->watches[i] : NULL;
+        SDL_UnlockMutex(watcher->sdl_mutex);
+
+        if (watch == NULL) {
+            break;
+        }
+
+        if (watch->watch_descriptor == event->wd &&
+            strcmp(watch->filename, event->name) == 0) {
+            scg__asset_watcher_reload(watcher, watch);
+        }
+    }
+}
+
+static int scg__asset_watcher_worker(void *data) {
+    scg_asset_watcher_t *watcher = data;
+    // Aligned for the inotify_event structs read into it.
+    uint64_t buffer[512];
+
+    while (SDL_AtomicGet(&watcher->quit) == 0) {
+        struct pollfd poll_fd = {watcher->inotify_fd, POLLIN, 0};
+        if (poll(&poll_fd, 1, SCG__ASSET_WATCHER_POLL_MS) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(watcher->inotify_fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const struct inotify_event *event =
+                (const struct inotify_event *)((const uint8_t *)buffer +
+                                               offset);
+            offset += sizeof(*event) + event->len;
+
+            if (event->len > 0) {
+                scg__asset_watcher_handle_event(watcher, event);
+            }
+        }
+    }
+
+    return 0;
+}
+
+#endif
+
+static bool scg__asset_watcher_add(scg_asset_watcher_t *watcher,
+                                   const char *filepath, scg_image_t *image,
+                                   scg_sound_t *sound) {
+    size_t filepath_size = strlen(filepath) + 1;
+
+    scg__asset_watch_t *watch = calloc(1, sizeof(*watch));
+    char *filepath_copy = malloc(filepath_size);
+    if (watch == NULL || filepath_copy == NULL) {
+        scg_log_errorf("Failed to allocate memory to watch %s", filepath);
+
+        free(filepath_copy);
+        free(watch);
+        return false;
+    }
+
+    memcpy(filepath_copy, filepath, filepath_size);
+    const char *separator = strrchr(filepath_copy, '/');
+
+    watch->filepath = filepath_copy;
+    watch->filename = separator != NULL ? separator + 1 : filepath_copy;
+    watch->watch_descriptor = -1;
+    watch->image = image;
+    watch->sound = sound;
+
+#ifdef SCG__INOTIFY
+    if (watcher->inotify_fd >= 0) {
+        // Watch the directory rather than the file, as many editors save by
+        // writing a new file and renaming it over the old one.
+        char directory[1024] = ".";
+        if (separator != NULL) {
+            size_t directory_length =
+                separator == filepath_copy ? 1 : separator - filepath_copy;
+            if (directory_length < sizeof(directory)) {
+                memcpy(directory, filepath_copy, directory_length);
+                directory[directory_length] = '\0';
+            }
+        }
+
+        watch->watch_descriptor = inotify_add_watch(
+            watcher->inotify_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch->watch_descriptor < 0) {
+            scg_log_errorf("Failed to watch %s. %s", filepath,
+                           strerror(errno));
+
+            free(filepath_copy);
+            free(watch);
+            return false;
+        }
+    }
+#endif
+
+    SDL_LockMutex(watcher->sdl_mutex);
+
+    if (watcher->num_watches == watcher->capacity) {
+        int capacity = scg_max_int(watcher->capacity * 2, 8);
+        scg__asset_watch_t **watches =
+            realloc(watcher->watches, capacity * sizeof(*watches));
+        if (watches == NULL) {
+            SDL_UnlockMutex(watcher->sdl_mutex);
+            scg_log_errorf("Failed to allocate memory to watch %s", filepath);
+
+            free(filepath_copy);
+            free(watch);
+            return false;
+        }
+
+        watcher->watches = watches;
+        watcher->capacity = capacity;
+    }
+
+    watcher->watches[watcher->num_watches++] = watch;
+
+    SDL_UnlockMutex(watcher->sdl_mutex);
+
+    return true;
+}
+
+// Swaps reloaded samples into a sound while the audio thread is held off.
+// Voices past the end of the new samples are stopped, the rest carry on.
+static void scg__sound_swap_buffer(scg_sound_t *sound, uint8_t *buffer,
+                                   uint32_t length) {
+    scg_audio_t *audio = sound->audio;
+
+    scg__audio_lock(audio);
+
+    scg__audio_process_commands(audio);
+    for (int i = 0; i < audio->num_active_voices;) {
+        scg__voice_t *voice = &audio->voices[audio->active_voices[i]];
+
+        if (voice->sound == sound && voice->mix_offset >= length) {
+            scg__audio_stop_voice(audio, voice);
+        } else {
+            i++;
+        }
+    }
+
+    uint8_t *old_buffer = sound->owns_buffer ? sound->buffer : NULL;
+    sound->buffer = buffer;
+    sound->length = length;
+    sound->owns_buffer = true;
+
+    scg__audio_unlock(audio);
+
+    free(old_buffer);
+}
+
+// Copies reloaded pixels into the existing buffer, so sub-images of the
+// image keep pointing at live pixels and see the change. An image of another
+// size is refused, as it would not fit the buffer those views point into.
+static bool scg__image_copy_pixels(scg_image_t *image, scg_image_t *reloaded,
+                                   const char *filepath) {
+    if (reloaded->width != image->width ||
+        reloaded->height != image->height) {
+        scg_log_warnf("Not reloading %s, its size changed from %dx%d to %dx%d",
+                      filepath, image->width, image->height,
+                      reloaded->width, reloaded->height);
+
+        scg_image_free(reloaded);
+        return false;
+    }
+
+    for (int y = 0; y < image->height; y++) {
+        memcpy(scg__image_row(image, y), scg__image_row(reloaded, y),
+               image->width * sizeof(*image->pixels));
+    }
+
+    scg_image_free(reloaded);
+    return true;
+}
+
+//
+// scg_asset_watcher_new implementation
+//
+
+scg_asset_watcher_t *scg_asset_watcher_new(scg_audio_t *audio) {
+    scg_asset_watcher_t *watcher = calloc(1, sizeof(*watcher));
+    if (watcher == NULL) {
+        scg_log_error("Failed to allocate memory for asset watcher");
+
+        return NULL;
+    }
+
+    watcher->audio = audio;
+    watcher->inotify_fd = -1;
+    watcher->sdl_mutex = SDL_CreateMutex();
+    if (watcher->sdl_mutex == NULL) {
+        scg_log_errorf("Failed to create asset watcher mutex. %s",
+                       SDL_GetError());
+
+        free(watcher);
+        return NULL;
+    }
+
+#ifdef SCG__INOTIFY
+    watcher->inotify_fd = inotify_init();
+    if (watcher->inotify_fd < 0) {
+        scg_log_errorf("Failed to start watching files. %s", strerror(errno));
+    } else {
+        watcher->sdl_thread = SDL_CreateThread(scg__asset_watcher_worker,
+                                               "scg_asset_watcher", watcher);
+        if (watcher->sdl_thread == NULL) {
+            scg_log_errorf("Failed to create asset watcher thread. %s",
+                           SDL_GetError());
+
+            close(watcher->inotify_fd);
+            watcher->inotify_fd = -1;
+        }
+    }
+#else
+    scg_log_warn("Watching files is not supported on this platform, assets "
+                 "will not be reloaded");
+#endif
+
+    return watcher;
+}
+
+//
+// scg_asset_watcher_add_image implementation
+//
+
+bool scg_asset_watcher_add_image(scg_asset_watcher_t *watcher,
+                                 scg_image_t *image, const char *filepath) {
+    return scg__asset_watcher_add(watcher, filepath, image, NULL);
+}
+
+//
+// scg_asset_watcher_add_sound implementation
+//
+
+bool scg_asset_watcher_add_sound(scg_asset_watcher_t *watcher,
+                                 scg_sound_t *sound, const char *filepath) {
+    if (sound->stream != NULL) {
+        scg_log_errorf("Failed to watch %s. Streamed sounds are not reloaded",
+                       filepath);
+
+        return false;
+    }
+
+    return scg__asset_watcher_add(watcher, filepath, NULL, sound);
+}
+
+//
+// scg_asset_watcher_update implementation
+//
+
+int scg_asset_watcher_update(scg_asset_watcher_t *watcher) {
+    int num_swapped = 0;
+
+    SDL_LockMutex(watcher->sdl_mutex);
+
+    for (int i = 0; i < watcher->num_watches; i++) {
+        scg__asset_watch_t *watch = watcher->watches[i];
+        if (!watch->is_reloaded) {
+            continue;
+        }
+
+        bool is_swapped = true;
+        if (watch->sound != NULL) {
+            scg__sound_swap_buffer(watch->sound, watch->reloaded_buffer,
+                                   watch->reloaded_length);
+        } else {
+            is_swapped = scg__image_copy_pixels(
+                watch->image, watch->reloaded_image, watch->filepath);
+        }
+
+        watch->is_reloaded = false;
+        watch->reloaded_image = NULL;
+        watch->reloaded_buffer = NULL;
+
+        if (is_swapped) {
+            scg_log_infof("Reloaded %s", watch->filepath);
+            num_swapped++;
+        }
+    }
+
+    SDL_UnlockMutex(watcher->sdl_mutex);
+
+    return num_swapped;
+}
+
+//
+// scg_asset_watcher_free implementation
+//
+
+void scg_asset_watcher_free(scg_asset_watcher_t *watcher) {
+    if (watcher->sdl_thread != NULL) {
+        SDL_AtomicSet(&watcher->quit, 1);
+        SDL_WaitThread(watcher->sdl_thread, NULL);
+    }
+
+#ifdef SCG__INOTIFY
+    if (watcher->inotify_fd >= 0) {
+        close(watcher->inotify_fd);
+    }
+#endif
+
+    for (int i = 0; i < watcher->num_watches; i++) {
+        scg__asset_watch_t *watch = watcher->watches[i];
+
+        if (watch->reloaded_image != NULL) {
+            scg_image_free(watch->reloaded_image);
+        }
+        free(watch->reloaded_buffer);
+        free(watch->filepath);
+        free(watch);
+    }
+
+    free(watcher->watches);
+    SDL_DestroyMutex(watcher->sdl_mutex);
+    free(watcher);
+}
+
+//
+// scg_config_new_default implementation
+//
+
+scg_config_t scg_config_new_default(void) {
+    return (scg_config_t){
+        .video = {.width = 640,
+                  .height = 480,
+                  .title = "SCG Application",
+                  .scale = 1,
+                  .fullscreen = false,
+                  .vsync = true,
+                  .lock_fps = true,
+                  .show_frame_metrics = true,
+                  .screenshot_format = SCG_IMAGE_FORMAT_PNG,
+                  .headless = false,
+                  .num_frames = 0,
+                  .output_path = NULL,
+                  .fixed_delta_time = 0.0f},
+        .input = {.hide_mouse_cursor = true, .screenshot_key = SCG_KEY_F12},
+        .audio = {.enabled = false,
+                  .volume = SCG__MAX_VOLUME / 2,
+                  .num_voices = SCG__AUDIO_DEFAULT_NUM_VOICES,
+                  .interpolation = SCG_AUDIO_INTERPOLATION_CUBIC,
+                  .offline = false,
+                  .output_path = NULL,
+                  .analysis = false},
+        .memory = {.frame_arena_size = SCG__DEFAULT_FRAME_ARENA_SIZE,
+                   .arena_size = SCG__DEFAULT_ARENA_SIZE}};
+}
+
+//
+// scg_app_init implementation
+//
+
+void scg_app_init(scg_app_t *app, scg_config_t config) {
+    // Let test harnesses run any app headless without changing it.
+    {
+        const char *num_frames = getenv("SCG_HEADLESS_FRAMES");
+        if (num_frames != NULL) {
+            config.video.headless = true;
+            config.video.num_frames = atoi(num_frames);
+            config.video.output_path = getenv("SCG_HEADLESS_OUTPUT");
+            if (config.video.fixed_delta_time <= 0.0f) {
+                config.video.fixed_delta_time =
+                    1.0f / SCG__DEFAULT_REFRESH_RATE;
+            }
+        }
+
+        if (config.video.headless) {
+            config.audio.offline = true;
+            config.input.screenshot_key = SCG_KEY_NONE;
+            scg__is_clock_virtual = config.video.fixed_delta_time > 0.0f;
+            scg__virtual_counter = 0;
+        }
+    }
+
+    // Initialise the SDL library.
+    {
+        uint32_t flags = config.video.headless ? 0 : SDL_INIT_VIDEO;
+        if (config.audio.enabled && !config.audio.offline) {
+            flags |= SDL_INIT_AUDIO;
+        }
+
+        if (SDL_Init(flags) != 0) {
+            scg_log_errorf("Failed to initialise SDL. %s", SDL_GetError());
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    scg_image_t *draw_target =
+        scg_image_new(config.video.width, config.video.height);
+    if (draw_target == NULL) {
+        scg_log_error("Failed to create draw target");
+
+        SDL_Quit();
+        exit(EXIT_FAILURE);
+    }
+
+    scg__screen_t *screen = NULL;
+    if (!config.video.headless) {
+        screen = scg__screen_new(draw_target, config.video.title,
+                                 config.video.scale, config.video.fullscreen,
+                                 config.video.vsync, config.video.lock_fps,
+                                 config.input.hide_mouse_cursor);
+    }
+    if (screen == NULL && !config.video.headless) {
+        scg_log_error("Failed to create screen");
+
+        scg_image_free(draw_target);
+        SDL_Quit();
+        exit(EXIT_FAILURE);
+    }
+
+    scg_keyboard_t *keyboard = scg__keyboard_new();
+    if (keyboard == NULL) {
+        scg_log_error("Failed to create keyboard");
+
+        scg__screen_free(screen);
+        scg_image_free(draw_target);
+        SDL_Quit();
+        exit(EXIT_FAILURE);
+    }
+
+    scg_mouse_t *mouse = scg__mouse_new();
+    if (mouse == NULL) {
+        scg_log_error("Failed to create mouse");
+
+        free(keyboard);
+        scg__screen_free(screen);
+        scg_image_free(draw_target);
+        SDL_Quit();
+        exit(EXIT_FAILURE);
+    }
+    if (screen != NULL) {
+        scg__mouse_update(mouse, draw_target->width, draw_target->height,
+                          screen->window_width, screen->window_height);
+    }
+
+    scg_audio_t *audio = NULL;
+    if (config.audio.enabled) {
+        audio = scg__audio_new(&config);
+        if (audio == NULL) {
+            scg_log_error("Failed to create sound device");
+
+            free(keyboard);
+            scg__screen_free(screen);
+            scg_image_free(draw_target);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    scg_arena_t *frame_arena = scg_arena_new(config.memory.frame_arena_size);
+    scg_arena_t *arena = scg_arena_new(config.memory.arena_size);
+    if (frame_arena == NULL || arena == NULL) {
+        scg_log_error("Failed to create arenas");
+
+        if (frame_arena != NULL) {
+            scg_arena_free(frame_arena);
+        }
+        if (audio != NULL) {
+            scg__audio_free(audio);
+        }
+        free(mouse);
+        free(keyboard);
+        scg__screen_free(screen);
+        scg_image_free(draw_target);
+        SDL_Quit();
+        exit(EXIT_FAILURE);
+    }
+
+    // Log some information to stdout.
+    if (config.video.headless) {
+        scg_log_infof("Application '%s' successfuly initialised headless. "
+                      "Width: %d, Height: %d, Frames: %d, Time step: %f",
+                      config.video.title, draw_target->width,
+                      draw_target->height, config.video.num_frames,
+                      config.video.fixed_delta_time);
+    } else {
+        scg_log_infof("Application '%s' successfuly initialised. "
+                      "Width: %d, Height: %d, Target FPS: %d, VSync: %d",
+                      config.video.title, draw_target->width,
+                      draw_target->height, screen->target_fps, screen->vsync);
+        if (config.audio.enabled) {
+            scg_log_infof("Audio successfuly initialised. "
+                          "Device ID: %d, Channels: %d, Samples/sec: %d, "
+                          "Samples/frame: %d, Bytes/sample: %d",
+                          audio->device_id, audio->num_channels,
+                          audio->frequency, audio->latency_sample_count,
+                          audio->bytes_per_sample);
+        }
+
+        SDL_RendererInfo info;
+        SDL_GetRendererInfo(screen->sdl_renderer, &info);
+        scg_log_infof("Renderer name: %s", info.name);
+
+        char buffer[1024] = "";
+        for (unsigned int i = 0; i < info.num_texture_formats; i++) {
+            strcat(buffer, SDL_GetPixelFormatName(info.texture_formats[i]));
+            if (i != info.num_texture_formats - 1) {
+                strcat(buffer, ", ");
+            }
+        }
+        scg_log_infof("Supported texture formats: %s", buffer);
+    }
+
+    app->running = true;
+    app->config = config;
+    app->draw_target = draw_target;
+    app->screen = screen;
+    app->keyboard = keyboard;
+    app->mouse = mouse;
+    app->audio = audio;
+    app->delta_time = 0.0f;
+    app->elapsed_time = 0.0f;
+    app->delta_time_counter = scg_get_performance_counter();
+    app->num_screenshots = 0;
+    app->screenshots = NULL;
+    app->frame_index = 0;
+    app->render_start_counter = SDL_GetPerformanceCounter();
+    app->frame_arena = frame_arena;
+    app->arena = arena;
+}
+
+static scg_image_format_t scg__image_format_from_path(const char *filepath) {
+    const char *extension = strrchr(filepath, '.');
+    if (extension != NULL && strcmp(extension, ".png") == 0) {
+        return SCG_IMAGE_FORMAT_PNG;
+    }
+    if (extension != NULL && strcmp(extension, ".qoi") == 0) {
+        return SCG_IMAGE_FORMAT_QOI;
+    }
+
+    return SCG_IMAGE_FORMAT_BMP;
+}
+
+// Reports how long a headless run took in real time, which harnesses read
+// from the log, and saves the last frame.
+static bool scg__app_finish_headless(scg_app_t *app) {
+    float64_t render_time_ms = scg_get_elapsed_time_millisecs(
+        SDL_GetPerformanceCounter(), app->render_start_counter);
+    scg_log_infof("Rendered %d frames in %.3f ms", app->frame_index,
+                  render_time_ms);
+
+    const char *output_path = app->config.video.output_path;
+    if (output_path == NULL) {
+        return true;
+    }
+
+    return scg__image_save(app->draw_target, output_path,
+                           scg__image_format_from_path(output_path));
+}
+
+//
+// scg_app_process_events implementation
+//
+
+bool scg_app_process_events(scg_app_t *app) {
+    // Handle events that need to be polled. This may include
+    // text input, mouse events, and game controller events.
+    {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            switch (event.type) {
+            case SDL_QUIT:
+                app->running = false;
+                return false;
+            case SDL_KEYDOWN:
+                app->keyboard->current_key_states[event.key.keysym.scancode] =
+                    true;
+                break;
+            case SDL_KEYUP:
+                app->keyboard->current_key_states[event.key.keysym.scancode] =
+                    false;
+                break;
+            case SDL_MOUSEBUTTONUP:
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEMOTION:
+                scg__mouse_update(app->mouse, app->draw_target->width,
+                                  app->draw_target->height,
+                                  app->screen->window_width,
+                                  app->screen->window_height);
+                break;
+            }
+        }
+    }
+
+    if (scg_keyboard_is_key_triggered(app->keyboard, SCG_KEY_ESCAPE)) {
+        app->running = false;
+        return false;
+    }
+
+    if (app->config.video.headless && app->config.video.num_frames > 0 &&
+        app->frame_index >= app->config.video.num_frames) {
+        scg__app_finish_headless(app);
+        app->running = false;
+        return false;
+    }
+
+    // Calculate the delta time and elapsed time in seconds.
+    // This is useful for apps that want some quick consistent animation
+    // and don't care about fixed updates. A fixed time step makes every run
+    // of an app the same.
+    if (app->config.video.fixed_delta_time > 0.0f) {
+        app->delta_time = app->config.video.fixed_delta_time;
+        app->elapsed_time += app->delta_time;
+
+        if (scg__is_clock_virtual) {
+            scg__virtual_counter +=
+                (uint64_t)(app->delta_time * scg_get_performance_frequency());
+        }
+    } else {
+        uint64_t now = scg_get_performance_counter();
+        app->delta_time =
+            scg_get_elapsed_time_secs(now, app->delta_time_counter);
+        app->delta_time_counter = now;
+
+        app->elapsed_time += app->delta_time;
+    }
+
+    // Offline audio is mixed as the app's clock moves on, rather than when a
+    // device asks for more.
+    if (app->audio != NULL && app->audio->is_offline) {
+        scg__audio_render_time(app->audio, app->delta_time);
+    }
+
+    return true;
+}
+
+static const char *const scg__image_format_extensions[] = {"bmp", "qoi",
+                                                           "png"};
+
+// Snapshots the draw target before the frame metrics are drawn over it. The
+// copy is written on another thread, so taking a screenshot costs the frame
+// no more than a copy of the pixels.
+static void scg__app_take_screenshot(scg_app_t *app) {
+    char filepath[256];
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", localtime(&now));
+    snprintf(filepath, sizeof(filepath), "screenshot-%s-%d.%s", timestamp,
+             app->num_screenshots,
+             scg__image_format_extensions[app->config.video.screenshot_format]);
+
+    scg_image_save_t *save = scg_image_save_async(
+        app->draw_target, filepath, app->config.video.screenshot_format);
+    if (save == NULL) {
+        return;
+    }
+
+    scg_log_infof("Saving screenshot to %s", filepath);
+
+    save->next = app->screenshots;
+    app->screenshots = save;
+    app->num_screenshots++;
+}
+
+static void scg__app_finish_screenshots(scg_app_t *app, bool wait) {
+    scg_image_save_t **link = &app->screenshots;
+
+    while (*link != NULL) {
+        scg_image_save_t *save = *link;
+
+        if (wait || scg_image_save_is_done(save)) {
+            *link = save->next;
+            scg_image_save_wait(save);
+        } else {
+            link = &save->next;
+        }
+    }
+}
+
+//
+// scg_app_present implementation
+//
+
+void scg_app_present(scg_app_t *app) {
+    scg_key_code_t screenshot_key = app->config.input.screenshot_key;
+    if (screenshot_key != SCG_KEY_NONE &&
+        scg_keyboard_is_key_triggered(app->keyboard, screenshot_key)) {
+        scg__app_take_screenshot(app);
+    }
+    scg__app_finish_screenshots(app, false);
+
+    if (app->config.video.show_frame_metrics && app->screen != NULL) {
+        scg_image_draw_frame_metrics(app->draw_target,
+                                     app->screen->frame_metrics);
+    }
+
+    scg__keyboard_update_keystates(app->keyboard);
+
+    if (app->screen != NULL) {
+        scg__screen_present(app->screen, app->draw_target);
+    }
+
+    scg_arena_reset(app->frame_arena);
+
+    app->frame_index++;
+}
+
+//
+// scg_app_close implementation
+//
+
+void scg_app_close(scg_app_t *app) {
+    app->running = false;
+}
+
+//
+// scg_app_free implementation
+//
+
+void scg_app_free(scg_app_t *app) {
+    scg__app_finish_screenshots(app, true);
+
+    if (app->audio != NULL) {
+        scg__audio_free(app->audio);
+    }
+
+    free(app->mouse);
+    free(app->keyboard);
+    scg__screen_free(app->screen);
+    scg_image_free(app->draw_target);
+
+    scg_log_infof("Arena high water marks. Frame: %zu of %zu bytes, "
+                  "App: %zu of %zu bytes",
+                  app->frame_arena->high_water_mark,
+                  app->frame_arena->capacity, app->arena->high_water_mark,
+                  app->arena->capacity);
+    scg_arena_free(app->frame_arena);
+    scg_arena_free(app->arena);
+
+    SDL_Quit();
+}
+
+// References used for tween functions:
+// - http://robertpenner.com/easing/
+// - https://github.com/warrenm/AHEasing
+// - https://github.com/tweenjs/tween.js
+
+//
+// scg_tween_linear implementation
+//
+
+float32_t scg_tween_linear(float32_t t) {
+    return t;
+}
+
+//
+// scg_tween_exponential_ease_in implementation
+//
+
+float32_t scg_tween_exponential_ease_in(float32_t t) {
+    return (t == 0.0f) ? t : powf(2.0f, 10.0f * (t - 1.0f));
+}
+
+//
+// scg_tween_exponential_ease_out implementation
+//
+
+float32_t scg_tween_exponential_ease_out(float32_t t) {
+    return (t == 1.0f) ? t : 1.0f - powf(2.0f, -10.0f * t);
+}
+
+//
+// scg_tween_exponential_ease_in_out implementation
+//
+
+float32_t scg_tween_exponential_ease_in_out(float32_t t) {
+    if (t == 0.0f || t == 1.0f) {
+        return t;
+    }
+
+    if (t < 0.5f) {
+        return 0.5f * powf(2.0f, (20.0f * t) - 10.0f);
+    }
+
+    return -0.5f * powf(2.0f, (-20.0f * t) + 10.0f) + 1.0f;
+}
+
+//
+// scg_tween_elastic_ease_in implementation
+//
+
+float32_t scg_tween_elastic_ease_in(float32_t t) {
+    if (t == 0.0f) {
+        return 0.0f;
+    }
+
+    if (t == 1.0f) {
+        return 1.0f;
+    }
+
+    return -powf(2.0f, 10.0f * (t - 1.0f)) * sinf((t - 1.1f) * 5.0f * SCG_PI);
+}
+
+//
+// scg_tween_elastic_ease_out implementation
+//
+
+float32_t scg_tween_elastic_ease_out(float32_t t) {
+    if (t == 0.0f) {
+        return 0.0f;
+    }
+
+    if (t == 1.0f) {
+        return 1.0f;
+    }
+
+    return powf(2.0f, -10.0f * t) * sinf((t - 0.1f) * 5.0f * SCG_PI) + 1.0f;
+}
+
+//
+// scg_tween_elastic_ease_in_out implementation
+//
+
+float32_t scg_tween_elastic_ease_in_out(float32_t t) {
+    if (t == 0.0f) {
+        return 0.0f;
+    }
+
+    if (t == 1.0f) {
+        return 1.0f;
+    }
+
+    t *= 2.0f;
+
+    if (t < 1.0f) {
+        return -0.5f * powf(2.0f, 10.0f * (t - 1.0f)) *
+               sinf((t - 1.1f) * 5.0f * SCG_PI);
+    }
+
+    return 0.5f * powf(2.0f, -10.0f * (t - 1.0f)) *
+               sinf((t - 1.1f) * 5.0f * SCG_PI) +
+           1.0f;
+}
+
+//
+// scg_tween_definition_new implementation
+//
+
+scg_tween_definition_t scg_tween_definition_new(scg_vec2f_t *start_end_values,
+                                                int num_values,
+                                                scg_tween_func_t func,
+                                                float32_t duration, bool loop,
+                                                bool yoyo) {
+    return (scg_tween_definition_t){.start_end_values = start_end_values,
+                                    .num_values = num_values,
+                                    .func = func,
+                                    .duration = duration,
+                                    .loop = loop,
+                                    .yoyo = yoyo};
+}
+
+//
+// scg_tween_new implementation
+//
+
+scg_tween_t scg_tween_new(scg_tween_definition_t tween_definition) {
+    return (scg_tween_t){.definition = tween_definition,
+                         .start_time = 0.0f,
+                         .playing = false,
+                         .paused = false,
+                         .pause_time = 0.0f,
+                         .yoyo_in_progress = false};
+}
+
+//
+// scg_tween_update implementation
+//
+
+void scg_tween_update(scg_tween_t *tween, float32_t *out,
+                      float32_t current_time) {
+    if (!tween->playing) {
+        return;
+    }
+
+    scg_tween_definition_t definition = tween->definition;
+    float32_t time;
+    if (tween->paused) {
+        time = (tween->pause_time - tween->start_time) / definition.duration;
+    } else {
+        time = (current_time - tween->start_time) / definition.duration;
+    }
+
+    if (definition.duration == 0.0f || time > 1.0f) {
+        time = 1.0f;
+    }
+
+    for (int i = 0; i < definition.num_values; i++) {
+        float32_t start = definition.start_end_values[i].x;
+        float32_t end = definition.start_end_values[i].y;
+
+        out[i] = start + definition.func(time) * (end - start);
+    }
+
+    if (time == 1.0f) {
+        if (definition.yoyo) {
+            for (int i = 0; i < definition.num_values; i++) {
+                float32_t start = definition.start_end_values[i].x;
+                float32_t end = definition.start_end_values[i].y;
+                tween->definition.start_end_values[i] =
+                    scg_vec2f_new(end, start);
+            }
+
+            tween->yoyo_in_progress = !tween->yoyo_in_progress;
+        }
+
+        if (definition.loop || tween->yoyo_in_progress) {
+            tween->start_time = current_time;
+        } else {
+            tween->playing = false;
+        }
+    }
+}
+
+//
+// scg_tween_start implementation
+//
+
+void scg_tween_start(scg_tween_t *tween, float32_t current_time) {
+    if (tween->playing) {
+        return;
+    }
+
+    tween->playing = true;
+    tween->start_time = current_time;
+    tween->paused = false;
+    tween->pause_time = 0.0f;
+    tween->yoyo_in_progress = false;
+}
+
+//
+// scg_tween_stop implementation
+//
+
+void scg_tween_stop(scg_tween_t *tween) {
+    if (!tween->playing) {
+        return;
+    }
+
+    tween->playing = false;
+    tween->start_time = 0.0f;
+    tween->paused = false;
+    tween->pause_time = 0.0f;
+    tween->yoyo_in_progress = false;
+}
+
+//
+// scg_tween_pause implementation
+//
+
+void scg_tween_pause(scg_tween_t *tween, float32_t current_time) {
+    if (!tween->playing || tween->paused) {
+        return;
+    }
+
+    tween->paused = true;
+    tween->pause_time = current_time;
+}
+
+//
+// scg_tween_resume implementation
+//
+
+void scg_tween_resume(scg_tween_t *tween, float32_t current_time) {
+    if (!tween->playing || !tween->paused) {
+        return;
+    }
+
+    tween->paused = false;
+    tween->start_time += current_time - tween->pause_time;
+    tween->pause_time = 0.0f;
+}
+
+static int scg__get_monitor_refresh_rate(SDL_DisplayMode display_mode) {
+    int result = display_mode.refresh_rate;
+
+    if (result == 0) {
+        return SCG__DEFAULT_REFRESH_RATE;
+    }
+
+    return result;
+}
+
+static scg__screen_t *scg__screen_new(scg_image_t *draw_target,
+                                      const char *title, int scale,
+                                      bool fullscreen, bool vsync,
+                                      bool lock_fps, bool hide_mouse_cursor) {
+    SDL_DisplayMode display_mode;
+    if (SDL_GetDesktopDisplayMode(0, &display_mode) != 0) {
+        scg_log_errorf("Failed to get SDL desktop display mode. %s",
+                       SDL_GetError());
+
+        return NULL;
+    }
+
+    SDL_Window *sdl_window = NULL;
+    SDL_Renderer *sdl_renderer = NULL;
+    SDL_Texture *sdl_texture = NULL;
+
+    int w = draw_target->width;
+    int h = draw_target->height;
+    int window_w = w * scale;
+    int window_h = h * scale;
+
+    // Setup the SDL window.
+    {
+        sdl_window = SDL_CreateWindow(
+            title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_w,
+            window_h, SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
+        if (sdl_window == NULL) {
+            scg_log_errorf("Failed to create SDL Window. %s", SDL_GetError());
+
+            return NULL;
+        }
+
+        if (fullscreen) {
+            SDL_SetWindowFullscreen(sdl_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+
+            // Desktop fullscreen mode will take the current size of the users
+            // desktop,
+            SDL_GetWindowSize(sdl_window, &window_w, &window_h);
+        }
+
+        int toggle = hide_mouse_cursor ? SDL_DISABLE : SDL_ENABLE;
+        SDL_ShowCursor(toggle);
+    }
+
+    // Setup the SDL renderer.
+    {
+        uint32_t sdl_renderer_flags = SDL_RENDERER_ACCELERATED;
+        if (vsync) {
+            sdl_renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+            SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
+        }
+
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+
+        sdl_renderer = SDL_CreateRenderer(sdl_window, -1, sdl_renderer_flags);
+        if (sdl_renderer == NULL) {
+            scg_log_errorf("Failed to create SDL Renderer. %s", SDL_GetError());
+
+            SDL_DestroyWindow(sdl_window);
+            return NULL;
+        }
+
+        SDL_RenderSetLogicalSize(sdl_renderer, w, h);
+    }
+
+    // Setup the SDL texture which will represent our screen.
+    {
+        sdl_texture = SDL_CreateTexture(sdl_renderer, SCG__IMAGE_PIXEL_FORMAT,
+                                        SDL_TEXTUREACCESS_STREAMING, w, h);
+        if (sdl_texture == NULL) {
+            scg_log_errorf("Failed to create SDL Texture. %s", SDL_GetError());
+
+            SDL_DestroyRenderer(sdl_renderer);
+            SDL_DestroyWindow(sdl_window);
+            return NULL;
+        }
+    }
+
+    scg__screen_t *screen = malloc(sizeof(*screen));
+    if (screen == NULL) {
+        scg_log_error("Failed to allocate memory for screen");
+
+        SDL_DestroyTexture(sdl_texture);
+        SDL_DestroyRenderer(sdl_renderer);
+        SDL_DestroyWindow(sdl_window);
+        return NULL;
+    }
+
+    screen->window_width = window_w;
+    screen->window_height = window_h;
+    screen->target_fps = scg__get_monitor_refresh_rate(display_mode);
+    screen->target_frame_time_secs = 1.0 / (float64_t)screen->target_fps;
+    screen->last_frame_counter = scg_get_performance_counter();
+    screen->sdl_window = sdl_window;
+    screen->sdl_renderer = sdl_renderer;
+    screen->sdl_texture = sdl_texture;
+    screen->vsync = vsync;
+    screen->lock_fps = lock_fps;
+
+    screen->frame_metrics.frame_time_secs = 0.0f;
+    screen->frame_metrics.frame_time_millisecs = 0.0f;
+    screen->frame_metrics.fps = 0;
+    screen->frame_metrics_update_counter = scg_get_performance_counter();
+    screen->frame_metrics.target_fps = screen->target_fps;
+
+    return screen;
+}
+
+static void scg__screen_present(scg__screen_t *screen,
+                                scg_image_t *draw_target) {
+    // Wait until we have reached the target amount of time per frame (e.g 60hz,
+    // ~16ms).
+    if (screen->lock_fps) {
+        float64_t target_secs = screen->target_frame_time_secs;
+
+        if (scg_get_elapsed_time_secs(scg_get_performance_counter(),
+                                      screen->last_frame_counter) <
+            target_secs) {
+            float64_t elapsed_time = scg_get_elapsed_time_secs(
+                scg_get_performance_counter(), screen->last_frame_counter);
+
+            int32_t sleep_time = ((target_secs - elapsed_time) * 1000) - 1;
+            if (sleep_time > 0) {
+                SDL_Delay(sleep_time);
+            }
+
+            while (scg_get_elapsed_time_secs(scg_get_performance_counter(),
+                                             screen->last_frame_counter) <
+                   target_secs) {
+            }
+        }
+    }
+
+    uint64_t end_frame_counter = scg_get_performance_counter();
+
+    // Update the texture and present it on screen.
+    {
+        SDL_UpdateTexture(screen->sdl_texture, NULL, draw_target->pixels,
+                          draw_target->pitch);
+        SDL_RenderClear(screen->sdl_renderer);
+        SDL_RenderCopy(screen->sdl_renderer, screen->sdl_texture, NULL, NULL);
+        SDL_RenderPresent(screen->sdl_renderer);
+    }
+
+    // Update the frame metrics every second.
+    // TODO: Instead of capturing every second, average the metrics...
+    {
+        float64_t elapsed_time_secs =
+            scg_get_elapsed_time_secs(scg_get_performance_counter(),
+                                      screen->frame_metrics_update_counter);
+        if (elapsed_time_secs >= 1.0f) {
+            screen->frame_metrics.frame_time_secs = scg_get_elapsed_time_secs(
+                end_frame_counter, screen->last_frame_counter);
+            screen->frame_metrics.frame_time_millisecs =
+                scg_get_elapsed_time_millisecs(end_frame_counter,
+                                               screen->last_frame_counter);
+            screen->frame_metrics.fps = roundf(
+                (float64_t)scg_get_performance_frequency() /
+                (float64_t)(end_frame_counter - screen->last_frame_counter));
+
+            screen->frame_metrics_update_counter =
+                scg_get_performance_counter();
+        }
+    }
+
+    screen->last_frame_counter = end_frame_counter;
+}
+
+static void scg__screen_free(scg__screen_t *screen) {
+    if (screen == NULL) {
+        return;
+    }
+
+    SDL_DestroyTexture(screen->sdl_texture);
+    SDL_DestroyRenderer(screen->sdl_renderer);
+    SDL_DestroyWindow(screen->sdl_window);
+
+    free(screen);
+}
+
+static scg_keyboard_t *scg__keyboard_new(void) {
+    scg_keyboard_t *keyboard = malloc(sizeof(*keyboard));
+    if (keyboard == NULL) {
+        scg_log_error("Failed to allocate memory for keyboard");
+
+        return NULL;
+    }
+
+    memset(keyboard->current_key_states, 0, sizeof(bool) * SDL_NUM_SCANCODES);
+    memset(keyboard->last_frame_key_states, 0,
+           sizeof(bool) * SDL_NUM_SCANCODES);
+
+    return keyboard;
+}
+
+static void scg__keyboard_update_keystates(scg_keyboard_t *keyboard) {
+    memcpy(keyboard->last_frame_key_states, keyboard->current_key_states,
+           sizeof(bool) * SDL_NUM_SCANCODES);
+}
+
+static scg_mouse_t *scg__mouse_new(void) {
+    scg_mouse_t *mouse = malloc(sizeof(*mouse));
+    if (mouse == NULL) {
+        scg_log_error("Failed to allocate memory for mouse");
+
+        return NULL;
+    }
+
+    return mouse;
+}
+
+static void scg__mouse_update(scg_mouse_t *mouse, int w, int h, int win_w,
+                              int win_h) {
+    int x, y;
+    uint32_t button_state = SDL_GetMouseState(&x, &y);
+
+    mouse->window_x = x;
+    mouse->window_y = y;
+    mouse->x = (int)(((float32_t)x / (float32_t)win_w) * (float32_t)w);
+    mouse->y = (int)(((float32_t)y / (float32_t)win_h) * (float32_t)h);
+    mouse->button_state = button_state;
+}
+
+static scg__audio_analyser_t *scg__audio_analyser_new(int frequency) {
+    const int fft_size = SCG_AUDIO_FFT_SIZE;
+    const int half_size = SCG_AUDIO_FFT_SIZE / 2;
 
-float32_t scg_tween_exponential_ease_in_out(float32_t t) {
-    if (t == 0.0f || t == 1.0f) {
-        return t;
-    }
+    scg__audio_analyser_t *analyser = calloc(1, sizeof(*analyser));
+    if (analyser == NULL) {
+        scg_log_error("Failed to allocate memory for audio analysis");
 
-    if (t < 0.5f) {
-        return 0.5f * powf(2.0f, (20.0f * t) - 10.0f);
+        return NULL;
     }
 
-    return -0.5f * powf(2.0f, (-20.0f * t) + 10.0f) + 1.0f;
-}
+    analyser->frequency = frequency;
 
-//
-// scg_tween_elastic_ease_in implementation
-//
+    for (int i = 0; i < fft_size; i++) {
+        analyser->window[i] = 0.5f - 0.5f * cosf(SCG_PI_2 * i / fft_size);
+    }
 
-float32_t scg_tween_elastic_ease_in(float32_t t) {
-    if (t == 0.0f) {
-        return 0.0f;
+    int num_bits = 0;
+    while (1 << num_bits < half_size) {
+        num_bits++;
     }
 
-    if (t == 1.0f) {
-        return 1.0f;
+    for (int i = 0; i < half_size; i++) {
+        analyser->twiddle_real[i] = cosf(SCG_PI_2 * i / fft_size);
+        analyser->twiddle_imag[i] = -sinf(SCG_PI_2 * i / fft_size);
+
+        int reversed = 0;
+        for (int bit = 0; bit < num_bits; bit++) {
+            reversed |= (i >> bit & 1) << (num_bits - 1 - bit);
+        }
+        analyser->bit_reverse[i] = (uint16_t)reversed;
     }
 
-    return -powf(2.0f, 10.0f * (t - 1.0f)) * sinf((t - 1.1f) * 5.0f * SCG_PI);
-}
+    // Bands are spaced evenly in pitch, each at least one bin wide.
+    const float32_t low = 40.0f;
+    const float32_t high = 16000.0f;
+    float32_t bin_width = (float32_t)frequency / fft_size;
 
-//
-// scg_tween_elastic_ease_out implementation
-//
+    for (int i = 0; i <= SCG_AUDIO_NUM_BANDS; i++) {
+        float32_t edge =
+            low * powf(high / low, (float32_t)i / SCG_AUDIO_NUM_BANDS);
+        int bin = scg_min_int((int)(edge / bin_width + 0.5f),
+                              SCG_AUDIO_SPECTRUM_SIZE);
 
-float32_t scg_tween_elastic_ease_out(float32_t t) {
-    if (t == 0.0f) {
-        return 0.0f;
+        if (i > 0) {
+            bin = scg_max_int(bin, analyser->band_bins[i - 1] + 1);
+        }
+        analyser->band_bins[i] = bin;
     }
+    analyser->band_bins[SCG_AUDIO_NUM_BANDS] = scg_min_int(
+        analyser->band_bins[SCG_AUDIO_NUM_BANDS], SCG_AUDIO_SPECTRUM_SIZE);
 
-    if (t == 1.0f) {
-        return 1.0f;
+    // Onsets closer than a tenth of a second are taken as one.
+    analyser->min_onset_hops = frequency / 10 / half_size + 1;
+    analyser->hops_since_onset = analyser->min_onset_hops;
+
+    return analyser;
+}
+
+// In place radix 2 FFT over the half size complex buffer. The twiddles are
+// for the full size, so every stage steps through them.
+static void scg__audio_analyser_fft(scg__audio_analyser_t *analyser) {
+    const int size = SCG_AUDIO_FFT_SIZE / 2;
+    float32_t *real = analyser->real;
+    float32_t *imag = analyser->imag;
+
+    for (int i = 0; i < size; i++) {
+        int j = analyser->bit_reverse[i];
+        if (j > i) {
+            float32_t t = real[i];
+            real[i] = real[j];
+            real[j] = t;
+            t = imag[i];
+            imag[i] = imag[j];
+            imag[j] = t;
+        }
     }
 
-    return powf(2.0f, -10.0f * t) * sinf((t - 0.1f) * 5.0f * SCG_PI) + 1.0f;
+    for (int length = 2; length <= size; length <<= 1) {
+        int half = length / 2;
+        int step = SCG_AUDIO_FFT_SIZE / length;
+
+        for (int start = 0; start < size; start += length) {
+            for (int j = 0; j < half; j++) {
+                float32_t wr = analyser->twiddle_real[j * step];
+                float32_t wi = analyser->twiddle_imag[j * step];
+                int a = start + j;
+                int b = a + half;
+
+                float32_t tr = real[b] * wr - imag[b] * wi;
+                float32_t ti = real[b] * wi + imag[b] * wr;
+                real[b] = real[a] - tr;
+                imag[b] = imag[a] - ti;
+                real[a] += tr;
+                imag[a] += ti;
+            }
+        }
+    }
 }
 
-//
-// scg_tween_elastic_ease_in_out implementation
-//
+// Analyses the last window. Even samples go in the real parts and odd ones
+// in the imaginary parts, and the spectrum of the real signal is split out
+// of the half size transform afterwards.
+static void scg__audio_analyser_run(scg__audio_analyser_t *analyser) {
+    const int half_size = SCG_AUDIO_FFT_SIZE / 2;
+    const float32_t scale = 4.0f / SCG_AUDIO_FFT_SIZE;
+    scg_audio_analysis_t *analysis = &analyser->analysis;
+
+    for (int i = 0; i < half_size; i++) {
+        int even = (analyser->input_position + i * 2) % SCG_AUDIO_FFT_SIZE;
+        int odd = (even + 1) % SCG_AUDIO_FFT_SIZE;
+
+        analyser->real[i] = analyser->input[even] * analyser->window[i * 2];
+        analyser->imag[i] =
+            analyser->input[odd] * analyser->window[i * 2 + 1];
+    }
 
-float32_t scg_tween_elastic_ease_in_out(float32_t t) {
-    if (t == 0.0f) {
-        return 0.0f;
+    scg__audio_analyser_fft(analyser);
+
+    float32_t flux = 0.0f;
+    for (int k = 0; k < half_size; k++) {
+        int m = (half_size - k) % half_size;
+        float32_t zr = analyser->real[k], zi = analyser->imag[k];
+        float32_t cr = analyser->real[m], ci = -analyser->imag[m];
+
+        float32_t even_real = (zr + cr) * 0.5f;
+        float32_t even_imag = (zi + ci) * 0.5f;
+        float32_t odd_real = (zi - ci) * 0.5f;
+        float32_t odd_imag = (cr - zr) * 0.5f;
+        float32_t wr = analyser->twiddle_real[k];
+        float32_t wi = analyser->twiddle_imag[k];
+
+        float32_t xr = even_real + wr * odd_real - wi * odd_imag;
+        float32_t xi = even_imag + wr * odd_imag + wi * odd_real;
+        float32_t amplitude = sqrtf(xr * xr + xi * xi) * scale;
+
+        flux += scg_max_float32(amplitude - analyser->previous_spectrum[k],
+                                0.0f);
+        analyser->previous_spectrum[k] = amplitude;
+        analysis->spectrum[k] = amplitude;
     }
 
-    if (t == 1.0f) {
-        return 1.0f;
+    for (int i = 0; i < SCG_AUDIO_NUM_BANDS; i++) {
+        float32_t power = 0.0f;
+        for (int k = analyser->band_bins[i]; k < analyser->band_bins[i + 1];
+             k++) {
+            power += analysis->spectrum[k] * analysis->spectrum[k];
+        }
+        analysis->bands[i] = sqrtf(power);
     }
 
-    t *= 2.0f;
+    // An onset is flux well above its recent average.
+    float32_t mean_flux = 0.0f;
+    for (int i = 0; i < SCG__AUDIO_FLUX_HISTORY; i++) {
+        mean_flux += analyser->flux_history[i];
+    }
+    mean_flux /= SCG__AUDIO_FLUX_HISTORY;
 
-    if (t < 1.0f) {
-        return -0.5f * powf(2.0f, 10.0f * (t - 1.0f)) *
-               sinf((t - 1.1f) * 5.0f * SCG_PI);
+    analyser->flux_history[analyser->flux_position] = flux;
+    analyser->flux_position =
+        (analyser->flux_position + 1) % SCG__AUDIO_FLUX_HISTORY;
+    analyser->hops_since_onset++;
+
+    if (flux > mean_flux * 1.5f + 0.05f &&
+        analyser->hops_since_onset >= analyser->min_onset_hops) {
+        analysis->num_onsets++;
+        analyser->hops_since_onset = 0;
     }
 
-    return 0.5f * powf(2.0f, -10.0f * (t - 1.0f)) *
-               sinf((t - 1.1f) * 5.0f * SCG_PI) +
-           1.0f;
-}
+    analysis->flux = flux;
+    analysis->level = sqrtf(analyser->hop_power / half_size);
+    analysis->time = (float64_t)analyser->num_frames / analyser->frequency;
 
-//
-// scg_tween_definition_new implementation
-//
+    SDL_AtomicAdd(&analyser->sequence, 1);
+    SDL_MemoryBarrierRelease();
+    analyser->published = *analysis;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&analyser->sequence, 1);
+}
 
-scg_tween_definition_t scg_tween_definition_new(scg_vec2f_t *start_end_values,
-                                                int num_values,
-                                                scg_tween_func_t func,
-                                                float32_t duration, bool loop,
-                                                bool yoyo) {
-    return (scg_tween_definition_t){.start_end_values = start_end_values,
-                                    .num_values = num_values,
-                                    .func = func,
-                                    .duration = duration,
-                                    .loop = loop,
-                                    .yoyo = yoyo};
+// Feeds mixed output to the analyser as mono, analysing every half window.
+static void scg__audio_analyse(scg__audio_analyser_t *analyser,
+                               const int16_t *samples, int num_frames) {
+    for (int i = 0; i < num_frames; i++) {
+        float32_t sample =
+            (samples[i * 2] + samples[i * 2 + 1]) * (0.5f / 32768.0f);
+
+        analyser->input[analyser->input_position] = sample;
+        analyser->input_position =
+            (analyser->input_position + 1) % SCG_AUDIO_FFT_SIZE;
+        analyser->hop_power += sample * sample;
+        analyser->num_frames++;
+
+        if (++analyser->hop_position == SCG_AUDIO_FFT_SIZE / 2) {
+            scg__audio_analyser_run(analyser);
+            analyser->hop_position = 0;
+            analyser->hop_power = 0.0f;
+        }
+    }
 }
 
-//
-// scg_tween_new implementation
-//
+static void scg__audio_callback(void *userdata, Uint8 *stream, int len);
 
-scg_tween_t scg_tween_new(scg_tween_definition_t tween_definition) {
-    return (scg_tween_t){.definition = tween_definition,
-                         .start_time = 0.0f,
-                         .playing = false,
-                         .paused = false,
-                         .pause_time = 0.0f,
-                         .yoyo_in_progress = false};
-}
+static scg_audio_t *scg__audio_new(const scg_config_t *config) {
+    SDL_AudioSpec desired, obtained;
 
-//
-// scg_tween_update implementation
-//
+    int num_voices = config->audio.num_voices;
+    bool offline = config->audio.offline;
+    const char *output_path = config->audio.output_path;
+    int samples_per_sec = 48000;
+    int desired_num_channels = 2;
+    size_t bytes_per_sample = sizeof(int16_t) * desired_num_channels;
 
-void scg_tween_update(scg_tween_t *tween, float32_t *out,
-                      float32_t current_time) {
-    if (!tween->playing) {
-        return;
+    if (num_voices <= 0 || num_voices > SCG__AUDIO_MAX_VOICES) {
+        scg_log_errorf("Number of voices must be from 1 to %d, got %d",
+                       SCG__AUDIO_MAX_VOICES, num_voices);
+        return NULL;
     }
 
-    scg_tween_definition_t definition = tween->definition;
-    float32_t time;
-    if (tween->paused) {
-        time = (tween->pause_time - tween->start_time) / definition.duration;
-    } else {
-        time = (current_time - tween->start_time) / definition.duration;
-    }
+    scg_audio_t *audio = calloc(1, sizeof(*audio));
+    if (audio == NULL) {
+        scg_log_error("Failed to allocate memory for audio");
 
-    if (definition.duration == 0.0f || time > 1.0f) {
-        time = 1.0f;
+        return NULL;
     }
 
-    for (int i = 0; i < definition.num_values; i++) {
-        float32_t start = definition.start_end_values[i].x;
-        float32_t end = definition.start_end_values[i].y;
+    // Each voice finishes once per play, so between two drains of the
+    // finished ring at most the voices that were playing and those started
+    // by queued commands can finish.
+    audio->num_voices = num_voices;
+    audio->finished_voices_capacity = num_voices + SCG__AUDIO_MAX_COMMANDS;
+    audio->finished_voices = malloc(audio->finished_voices_capacity *
+                                    sizeof(*audio->finished_voices));
+    audio->voice_slots = calloc(num_voices, sizeof(*audio->voice_slots));
+    audio->free_voices = malloc(num_voices * sizeof(*audio->free_voices));
+    audio->voices = calloc(num_voices, sizeof(*audio->voices));
+    audio->active_voices = malloc(num_voices * sizeof(*audio->active_voices));
+
+    if (audio->finished_voices == NULL || audio->voice_slots == NULL ||
+        audio->free_voices == NULL || audio->voices == NULL ||
+        audio->active_voices == NULL) {
+        scg_log_error("Failed to allocate memory for audio voices");
+
+        scg__audio_free(audio);
+        return NULL;
+    }
 
-        out[i] = start + definition.func(time) * (end - start);
+    for (int i = 0; i < num_voices; i++) {
+        audio->free_voices[i] = num_voices - 1 - i;
+        audio->voices[i].active_index = -1;
     }
+    audio->num_free_voices = num_voices;
 
-    if (time == 1.0f) {
-        if (definition.yoyo) {
-            for (int i = 0; i < definition.num_values; i++) {
-                float32_t start = definition.start_end_values[i].x;
-                float32_t end = definition.start_end_values[i].y;
-                tween->definition.start_end_values[i] =
-                    scg_vec2f_new(end, start);
-            }
+    memset(&desired, 0, sizeof(desired));
+    desired.freq = samples_per_sec;
+    desired.format = AUDIO_S16LSB;
+    desired.channels = desired_num_channels;
+    desired.samples = 2048;
+    desired.callback = scg__audio_callback;
+    desired.userdata = audio;
 
-            tween->yoyo_in_progress = !tween->yoyo_in_progress;
-        }
+    // SDL converts to the format of the device if it differs, so sounds are
+    // always mixed as 16 bit stereo at a known rate.
+    if (offline) {
+        obtained = desired;
+    } else {
+        audio->device_id =
+            SDL_OpenAudioDevice(NULL, 0, &desired, &obtained, 0);
+        if (audio->device_id == 0) {
+            scg_log_errorf("Failed to open SDL audio device. %s",
+                           SDL_GetError());
 
-        if (definition.loop || tween->yoyo_in_progress) {
-            tween->start_time = current_time;
-        } else {
-            tween->playing = false;
+            scg__audio_free(audio);
+            return NULL;
         }
     }
-}
 
-//
-// scg_tween_start implementation
-//
+    audio->mix_buffer_frames = obtained.samples;
+    audio->mix_buffer = malloc(audio->mix_buffer_frames *
+                               obtained.channels * sizeof(int32_t));
+    audio->effect_buffer = malloc(audio->mix_buffer_frames *
+                                  obtained.channels * sizeof(float32_t));
+    if (audio->mix_buffer == NULL || audio->effect_buffer == NULL) {
+        scg_log_error("Failed to allocate memory for audio mix buffer");
 
-void scg_tween_start(scg_tween_t *tween, float32_t current_time) {
-    if (tween->playing) {
-        return;
+        scg__audio_free(audio);
+        return NULL;
     }
 
-    tween->playing = true;
-    tween->start_time = current_time;
-    tween->paused = false;
-    tween->pause_time = 0.0f;
-    tween->yoyo_in_progress = false;
-}
+    audio->frequency = obtained.freq;
+    audio->num_channels = obtained.channels;
+    audio->num_samples = obtained.samples;
+    audio->bytes_per_sample = bytes_per_sample;
+    audio->latency_sample_count = obtained.samples;
+    audio->interpolation = config->audio.interpolation;
+    audio->volume =
+        scg_clamp_float32((float32_t)config->audio.volume / SCG__MAX_VOLUME,
+                          0.0f, 1.0f);
+
+    if (config->audio.analysis) {
+        audio->analyser = scg__audio_analyser_new(audio->frequency);
+        if (audio->analyser == NULL) {
+            scg__audio_free(audio);
+            return NULL;
+        }
+    }
 
-//
-// scg_tween_stop implementation
-//
+    if (offline) {
+        // Offline samples are heard as soon as they are mixed.
+        audio->is_offline = true;
+        audio->latency_sample_count = 0;
+        audio->render_buffer = malloc(audio->mix_buffer_frames *
+                                      audio->bytes_per_sample);
+        if (audio->render_buffer == NULL) {
+            scg_log_error("Failed to allocate memory for audio rendering");
 
-void scg_tween_stop(scg_tween_t *tween) {
-    if (!tween->playing) {
-        return;
-    }
+            scg__audio_free(audio);
+            return NULL;
+        }
 
-    tween->playing = false;
-    tween->start_time = 0.0f;
-    tween->paused = false;
-    tween->pause_time = 0.0f;
-    tween->yoyo_in_progress = false;
-}
+        if (output_path != NULL) {
+            audio->output = SDL_RWFromFile(output_path, "wb");
+            if (audio->output == NULL ||
+                !scg__audio_write_wav_header(audio)) {
+                scg_log_errorf("Failed to create audio output at %s. %s",
+                               output_path, SDL_GetError());
 
-//
-// scg_tween_pause implementation
-//
+                scg__audio_free(audio);
+                return NULL;
+            }
+        }
 
-void scg_tween_pause(scg_tween_t *tween, float32_t current_time) {
-    if (!tween->playing || tween->paused) {
-        return;
+        return audio;
     }
 
-    tween->paused = true;
-    tween->pause_time = current_time;
+    SDL_PauseAudioDevice(audio->device_id, 0);
+
+    return audio;
+}
+
+// Writes the header of the output file at its start for the samples written
+// so far. It is written once up front and again with the final length when
+// audio is freed.
+static bool scg__audio_write_wav_header(scg_audio_t *audio) {
+    uint8_t header[44];
+    uint32_t byte_rate = audio->frequency * audio->bytes_per_sample;
+
+    memcpy(header, "RIFF", 4);
+    scg__write_u32_le(header + 4, 36 + audio->output_length);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    scg__write_u32_le(header + 16, 16);
+    scg__write_u16_le(header + 20, SCG__WAV_FORMAT_PCM);
+    scg__write_u16_le(header + 22, audio->num_channels);
+    scg__write_u32_le(header + 24, audio->frequency);
+    scg__write_u32_le(header + 28, byte_rate);
+    scg__write_u16_le(header + 32, audio->bytes_per_sample);
+    scg__write_u16_le(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    scg__write_u32_le(header + 40, audio->output_length);
+
+    return SDL_RWseek(audio->output, 0, RW_SEEK_SET) == 0 &&
+           SDL_RWwrite(audio->output, header, 1, sizeof(header)) ==
+               sizeof(header);
 }
 
 //
-// scg_tween_resume implementation
+// scg_audio_get_analysis implementation
 //
 
-void scg_tween_resume(scg_tween_t *tween, float32_t current_time) {
-    if (!tween->playing || !tween->paused) {
-        return;
+bool scg_audio_get_analysis(scg_audio_t *audio,
+                            scg_audio_analysis_t *analysis) {
+    scg__audio_analyser_t *analyser = audio->analyser;
+    if (analyser == NULL) {
+        return false;
     }
 
-    tween->paused = false;
-    tween->start_time += current_time - tween->pause_time;
-    tween->pause_time = 0.0f;
-}
+    int sequence;
+    do {
+        sequence = SDL_AtomicGet(&analyser->sequence);
+        SDL_MemoryBarrierAcquire();
+        *analysis = analyser->published;
+        SDL_MemoryBarrierAcquire();
+    } while ((sequence & 1) != 0 ||
+             SDL_AtomicGet(&analyser->sequence) != sequence);
 
-static int scg__get_monitor_refresh_rate(SDL_DisplayMode display_mode) {
-    int result = display_mode.refresh_rate;
-
-    if (result == 0) {
-        return SCG__DEFAULT_REFRESH_RATE;
-    }
+    analysis->is_onset = analysis->num_onsets != audio->last_num_onsets;
+    audio->last_num_onsets = analysis->num_onsets;
 
-    return result;
+    return true;
 }
 
-static scg__screen_t *scg__screen_new(scg_image_t *draw_target,
-                                      const char *title, int scale,
-                                      bool fullscreen, bool vsync,
-                                      bool lock_fps, bool hide_mouse_cursor) {
-    SDL_DisplayMode display_mode;
-    if (SDL_GetDesktopDisplayMode(0, &display_mode) != 0) {
-        scg_log_errorf("Failed to get SDL desktop display mode. %s",
-                       SDL_GetError());
+//
+// scg_audio_render implementation
+//
 
-        return NULL;
+void scg_audio_render(scg_audio_t *audio, int num_frames) {
+    if (!audio->is_offline) {
+        scg_log_error("Only offline audio can be rendered");
+        return;
     }
 
-    SDL_Window *sdl_window = NULL;
-    SDL_Renderer *sdl_renderer = NULL;
-    SDL_Texture *sdl_texture = NULL;
-
-    int w = draw_target->width;
-    int h = draw_target->height;
-    int window_w = w * scale;
-    int window_h = h * scale;
-
-    // Setup the SDL window.
-    {
-        sdl_window = SDL_CreateWindow(
-            title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_w,
-            window_h, SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
-        if (sdl_window == NULL) {
-            scg_log_errorf("Failed to create SDL Window. %s", SDL_GetError());
-
-            return NULL;
-        }
+    while (num_frames > 0) {
+        int block_frames = scg_min_int(num_frames, audio->mix_buffer_frames);
+        int length = block_frames * audio->bytes_per_sample;
 
-        if (fullscreen) {
-            SDL_SetWindowFullscreen(sdl_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+        scg__audio_callback(audio, (Uint8 *)audio->render_buffer, length);
 
-            // Desktop fullscreen mode will take the current size of the users
-            // desktop,
-            SDL_GetWindowSize(sdl_window, &window_w, &window_h);
+        if (audio->output != NULL) {
+            if (SDL_RWwrite(audio->output, audio->render_buffer, 1,
+                            length) != (size_t)length) {
+                scg_log_errorf("Failed to write audio output. %s",
+                               SDL_GetError());
+            } else {
+                audio->output_length += length;
+            }
         }
 
-        int toggle = hide_mouse_cursor ? SDL_DISABLE : SDL_ENABLE;
-        SDL_ShowCursor(toggle);
+        num_frames -= block_frames;
     }
+}
 
-    // Setup the SDL renderer.
-    {
-        uint32_t sdl_renderer_flags = SDL_RENDERER_ACCELERATED;
-        if (vsync) {
-            sdl_renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
-            SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
-        }
-
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+// Renders offline audio for the time that has passed, carrying over the
+// part of a frame that is left.
+static void scg__audio_render_time(scg_audio_t *audio, float64_t seconds) {
+    audio->render_frames_due += seconds * audio->frequency;
 
-        sdl_renderer = SDL_CreateRenderer(sdl_window, -1, sdl_renderer_flags);
-        if (sdl_renderer == NULL) {
-            scg_log_errorf("Failed to create SDL Renderer. %s", SDL_GetError());
+    int num_frames = (int)audio->render_frames_due;
+    audio->render_frames_due -= num_frames;
 
-            SDL_DestroyWindow(sdl_window);
-            return NULL;
-        }
+    scg_audio_render(audio, num_frames);
+}
 
-        SDL_RenderSetLogicalSize(sdl_renderer, w, h);
+// Pushes a command for the audio thread. The command is written before the
+// write index is published, so the audio thread never reads a partial
+// command.
+static void scg__audio_send_command(scg_audio_t *audio,
+                                    scg__audio_command_t command) {
+    int write = SDL_AtomicGet(&audio->command_write);
+    int read = SDL_AtomicGet(&audio->command_read);
+
+    if (write - read == SCG__AUDIO_MAX_COMMANDS) {
+        scg_log_error("Audio command queue is full, dropping command");
+        return;
     }
 
-    // Setup the SDL texture which will represent our screen.
-    {
-        sdl_texture = SDL_CreateTexture(sdl_renderer, SCG__IMAGE_PIXEL_FORMAT,
-                                        SDL_TEXTUREACCESS_STREAMING, w, h);
-        if (sdl_texture == NULL) {
-            scg_log_errorf("Failed to create SDL Texture. %s", SDL_GetError());
+    audio->commands[write % SCG__AUDIO_MAX_COMMANDS] = command;
 
-            SDL_DestroyRenderer(sdl_renderer);
-            SDL_DestroyWindow(sdl_window);
-            return NULL;
-        }
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&audio->command_write, write + 1);
+}
+
+// Holds off the audio thread, so its state can be changed directly. Offline
+// audio is mixed on the controlling thread, so there is nothing to hold off.
+static void scg__audio_lock(scg_audio_t *audio) {
+    if (audio->device_id != 0) {
+        SDL_LockAudioDevice(audio->device_id);
     }
+}
 
-    scg__screen_t *screen = malloc(sizeof(*screen));
-    if (screen == NULL) {
-        scg_log_error("Failed to allocate memory for screen");
+static void scg__audio_unlock(scg_audio_t *audio) {
+    if (audio->device_id != 0) {
+        SDL_UnlockAudioDevice(audio->device_id);
+    }
+}
 
-        SDL_DestroyTexture(sdl_texture);
-        SDL_DestroyRenderer(sdl_renderer);
-        SDL_DestroyWindow(sdl_window);
-        return NULL;
+static void scg__audio_stop_voice(scg_audio_t *audio, scg__voice_t *voice) {
+    int index = voice->active_index;
+    int last = audio->active_voices[--audio->num_active_voices];
+
+    audio->active_voices[index] = last;
+    audio->voices[last].active_index = index;
+    voice->active_index = -1;
+    SDL_AtomicSet(&voice->playing_id, 0);
+
+    // Hand the voice back to the controlling thread. The ring can not be
+    // full, but if it were the voice would still be reused by stealing.
+    int write = SDL_AtomicGet(&audio->finished_write);
+    int read = SDL_AtomicGet(&audio->finished_read);
+    if (write - read < audio->finished_voices_capacity) {
+        audio->finished_voices[write % audio->finished_voices_capacity] =
+            voice->id;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&audio->finished_write, write + 1);
     }
+}
 
-    screen->window_width = window_w;
-    screen->window_height = window_h;
-    screen->target_fps = scg__get_monitor_refresh_rate(display_mode);
-    screen->target_frame_time_secs = 1.0 / (float64_t)screen->target_fps;
-    screen->last_frame_counter = scg_get_performance_counter();
-    screen->sdl_window = sdl_window;
-    screen->sdl_renderer = sdl_renderer;
-    screen->sdl_texture = sdl_texture;
-    screen->vsync = vsync;
-    screen->lock_fps = lock_fps;
+// Returns the voice a command refers to, or NULL if the voice has since been
+// reused or has finished.
+static scg__voice_t *scg__audio_command_voice(scg_audio_t *audio,
+                                              scg_voice_id_t id) {
+    int index = scg__voice_index(id);
+    if (index < 0 || index >= audio->num_voices) {
+        return NULL;
+    }
 
-    screen->frame_metrics.frame_time_secs = 0.0f;
-    screen->frame_metrics.frame_time_millisecs = 0.0f;
-    screen->frame_metrics.fps = 0;
-    screen->frame_metrics_update_counter = scg_get_performance_counter();
-    screen->frame_metrics.target_fps = screen->target_fps;
+    scg__voice_t *voice = &audio->voices[index];
 
-    return screen;
+    return voice->id == id && voice->active_index >= 0 ? voice : NULL;
 }
 
-static void scg__screen_present(scg__screen_t *screen,
-                                scg_image_t *draw_target) {
-    // Wait until we have reached the target amount of time per frame (e.g 60hz,
-    // ~16ms).
-    if (screen->lock_fps) {
-        float64_t target_secs = screen->target_frame_time_secs;
+// A stream plays on one voice at a time, so starting it again stops the
+// other voice and has the stream thread rewind the file, unless nothing has
+// been read from it yet.
+static void scg__audio_play_stream(scg_audio_t *audio, scg__voice_t *voice) {
+    scg__sound_stream_t *stream = voice->sound->stream;
 
-        if (scg_get_elapsed_time_secs(scg_get_performance_counter(),
-                                      screen->last_frame_counter) <
-            target_secs) {
-            float64_t elapsed_time = scg_get_elapsed_time_secs(
-                scg_get_performance_counter(), screen->last_frame_counter);
+    for (int i = 0; i < audio->num_active_voices;) {
+        scg__voice_t *other = &audio->voices[audio->active_voices[i]];
 
-            int32_t sleep_time = ((target_secs - elapsed_time) * 1000) - 1;
-            if (sleep_time > 0) {
-                SDL_Delay(sleep_time);
+        if (other != voice && other->sound == voice->sound) {
+            scg__audio_stop_voice(audio, other);
+        } else {
+            i++;
+        }
+    }
+
+    if (SDL_AtomicGet(&stream->read_position) != 0 ||
+        SDL_AtomicGet(&stream->restart_request) !=
+            SDL_AtomicGet(&stream->restart_done)) {
+        SDL_AtomicAdd(&stream->restart_request, 1);
+        SDL_SemPost(stream->wake);
+    }
+}
+
+static void scg__audio_process_commands(scg_audio_t *audio) {
+    int read = SDL_AtomicGet(&audio->command_read);
+    int write = SDL_AtomicGet(&audio->command_write);
+    SDL_MemoryBarrierAcquire();
+
+    for (; read != write; read++) {
+        scg__audio_command_t *command =
+            &audio->commands[read % SCG__AUDIO_MAX_COMMANDS];
+        scg__voice_t *voice;
+
+        switch (command->type) {
+        case SCG__AUDIO_COMMAND_PLAY:
+            // A stolen voice is replaced in place.
+            voice = &audio->voices[scg__voice_index(command->voice)];
+            if (voice->active_index < 0) {
+                voice->active_index = audio->num_active_voices;
+                audio->active_voices[audio->num_active_voices++] =
+                    scg__voice_index(command->voice);
             }
 
-            while (scg_get_elapsed_time_secs(scg_get_performance_counter(),
-                                             screen->last_frame_counter) <
-                   target_secs) {
+            voice->id = command->voice;
+            voice->sound = command->sound;
+            voice->mix_offset = 0;
+            voice->volume = command->value;
+            voice->pan = 0.0f;
+            voice->pitch = 1.0f;
+            voice->mix_fraction = 0;
+            voice->loop = command->loop;
+            SDL_AtomicSet(&voice->play_offset, 0);
+            SDL_AtomicSet(&voice->start_frame, (int)audio->mixed_frames);
+            SDL_AtomicSet(&voice->playing_id, (int)voice->id);
+
+            if (voice->sound->length == 0) {
+                scg__audio_stop_voice(audio, voice);
+            } else if (voice->sound->stream != NULL) {
+                scg__audio_play_stream(audio, voice);
+            }
+            break;
+        case SCG__AUDIO_COMMAND_STOP:
+            voice = scg__audio_command_voice(audio, command->voice);
+            if (voice != NULL) {
+                scg__audio_stop_voice(audio, voice);
+            }
+            break;
+        case SCG__AUDIO_COMMAND_STOP_SOUND:
+            for (int i = 0; i < audio->num_active_voices;) {
+                voice = &audio->voices[audio->active_voices[i]];
+
+                if (voice->sound == command->sound) {
+                    scg__audio_stop_voice(audio, voice);
+                } else {
+                    i++;
+                }
+            }
+            break;
+        case SCG__AUDIO_COMMAND_SET_VOLUME:
+            voice = scg__audio_command_voice(audio, command->voice);
+            if (voice != NULL) {
+                voice->volume = command->value;
+            }
+            break;
+        case SCG__AUDIO_COMMAND_SET_PAN:
+            voice = scg__audio_command_voice(audio, command->voice);
+            if (voice != NULL) {
+                voice->pan = command->value;
             }
+            break;
+        case SCG__AUDIO_COMMAND_SET_PITCH:
+            voice = scg__audio_command_voice(audio, command->voice);
+            if (voice != NULL) {
+                voice->pitch = command->value;
+            }
+            break;
+        case SCG__AUDIO_COMMAND_SET_MASTER_VOLUME:
+            audio->volume = command->value;
+            break;
+        case SCG__AUDIO_COMMAND_ADD_EFFECT:
+            if (audio->num_effects < SCG__AUDIO_MAX_EFFECTS) {
+                audio->effects[audio->num_effects++] = command->effect;
+            }
+            break;
+        case SCG__AUDIO_COMMAND_REMOVE_EFFECT:
+            scg__audio_remove_effect_now(audio, command->effect);
+            break;
         }
     }
 
-    uint64_t end_frame_counter = scg_get_performance_counter();
+    SDL_AtomicSet(&audio->command_read, read);
+}
 
-    // Update the texture and present it on screen.
-    {
-        SDL_UpdateTexture(screen->sdl_texture, NULL, draw_target->pixels,
-                          draw_target->pitch);
-        SDL_RenderClear(screen->sdl_renderer);
-        SDL_RenderCopy(screen->sdl_renderer, screen->sdl_texture, NULL, NULL);
-        SDL_RenderPresent(screen->sdl_renderer);
+// Adds stereo samples into the mix buffer scaled by left and right gains in
+// Q15 fixed point. With SSE2 the samples are interleaved with zeros so that
+// one multiply-add gives the 32 bit products of four frames.
+static void scg__audio_mix_samples(int32_t *mix, const int16_t *samples,
+                                   int num_frames, int gain_left,
+                                   int gain_right) {
+    int i = 0;
+
+#ifdef SCG__SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i gains = _mm_set_epi16(0, (int16_t)gain_right, 0,
+                                        (int16_t)gain_left, 0,
+                                        (int16_t)gain_right, 0,
+                                        (int16_t)gain_left);
+
+    for (; i + 4 <= num_frames; i += 4) {
+        __m128i frames = _mm_loadu_si128((const __m128i *)(samples + i * 2));
+        __m128i frames_lo = _mm_unpacklo_epi16(frames, zero);
+        __m128i frames_hi = _mm_unpackhi_epi16(frames, zero);
+        __m128i mixed_lo = _mm_srai_epi32(_mm_madd_epi16(frames_lo, gains), 15);
+        __m128i mixed_hi = _mm_srai_epi32(_mm_madd_epi16(frames_hi, gains), 15);
+
+        __m128i *dest = (__m128i *)(mix + i * 2);
+        _mm_storeu_si128(dest, _mm_add_epi32(_mm_loadu_si128(dest), mixed_lo));
+        _mm_storeu_si128(dest + 1,
+                         _mm_add_epi32(_mm_loadu_si128(dest + 1), mixed_hi));
     }
+#endif
 
-    // Update the frame metrics every second.
-    // TODO: Instead of capturing every second, average the metrics...
-    {
-        float64_t elapsed_time_secs =
-            scg_get_elapsed_time_secs(scg_get_performance_counter(),
-                                      screen->frame_metrics_update_counter);
-        if (elapsed_time_secs >= 1.0f) {
-            screen->frame_metrics.frame_time_secs = scg_get_elapsed_time_secs(
-                end_frame_counter, screen->last_frame_counter);
-            screen->frame_metrics.frame_time_millisecs =
-                scg_get_elapsed_time_millisecs(end_frame_counter,
-                                               screen->last_frame_counter);
-            screen->frame_metrics.fps = roundf(
-                (float64_t)scg_get_performance_frequency() /
-                (float64_t)(end_frame_counter - screen->last_frame_counter));
+    for (; i < num_frames; i++) {
+        mix[i * 2] += (samples[i * 2] * gain_left) >> 15;
+        mix[i * 2 + 1] += (samples[i * 2 + 1] * gain_right) >> 15;
+    }
+}
 
-            screen->frame_metrics_update_counter =
-                scg_get_performance_counter();
-        }
+// Saturates the mix buffer to 16 bit samples.
+static void scg__audio_clip_samples(int16_t *dest, const int32_t *mix,
+                                    int num_samples) {
+    int i = 0;
+
+#ifdef SCG__SSE2
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i mix_lo = _mm_loadu_si128((const __m128i *)(mix + i));
+        __m128i mix_hi = _mm_loadu_si128((const __m128i *)(mix + i + 4));
+
+        _mm_storeu_si128((__m128i *)(dest + i),
+                         _mm_packs_epi32(mix_lo, mix_hi));
     }
+#endif
 
-    screen->last_frame_counter = end_frame_counter;
+    for (; i < num_samples; i++) {
+        dest[i] = (int16_t)scg_max_int(scg_min_int(mix[i], INT16_MAX),
+                                       INT16_MIN);
+    }
 }
 
-static void scg__screen_free(scg__screen_t *screen) {
-    SDL_DestroyTexture(screen->sdl_texture);
-    SDL_DestroyRenderer(screen->sdl_renderer);
-    SDL_DestroyWindow(screen->sdl_window);
+// Mixes a voice of a streamed sound from the ring filled by the stream
+// thread. Returns false once the stream has ended and the ring is drained.
+static bool scg__audio_mix_stream(scg_audio_t *audio, scg__voice_t *voice,
+                                  int32_t *mix, int num_frames, int gain_left,
+                                  int gain_right) {
+    scg__sound_stream_t *stream = voice->sound->stream;
+    uint32_t length = voice->sound->length;
+    int frame_size = audio->bytes_per_sample;
+
+    // Play silence until the stream thread has rewound the file.
+    if (SDL_AtomicGet(&stream->restart_request) !=
+        SDL_AtomicGet(&stream->restart_done)) {
+        return true;
+    }
 
-    free(screen);
-}
+    uint32_t read = (uint32_t)SDL_AtomicGet(&stream->read_position);
+    uint32_t write = (uint32_t)SDL_AtomicGet(&stream->write_position);
+    SDL_MemoryBarrierAcquire();
+
+    int written = 0;
+    while (written < num_frames && write - read >= (uint32_t)frame_size) {
+        uint32_t offset = read & (stream->ring_size - 1);
+        uint32_t available =
+            scg_min_int(write - read, stream->ring_size - offset);
+        int frames_to_mix =
+            scg_min_int(available / frame_size, num_frames - written);
+
+        scg__audio_mix_samples(mix + written * 2,
+                               (const int16_t *)(stream->ring + offset),
+                               frames_to_mix, gain_left, gain_right);
+
+        written += frames_to_mix;
+        read += frames_to_mix * frame_size;
+        voice->mix_offset =
+            (voice->mix_offset + frames_to_mix * frame_size) % length;
+    }
 
-static scg_keyboard_t *scg__keyboard_new(void) {
-    scg_keyboard_t *keyboard = malloc(sizeof(*keyboard));
-    if (keyboard == NULL) {
-        scg_log_error("Failed to allocate memory for keyboard");
+    SDL_AtomicSet(&stream->read_position, (int)read);
 
-        return NULL;
+    // Wake the stream thread early once the ring is half empty.
+    if (write - read < stream->ring_size / 2) {
+        SDL_SemPost(stream->wake);
     }
 
-    memset(keyboard->current_key_states, 0, sizeof(bool) * SDL_NUM_SCANCODES);
-    memset(keyboard->last_frame_key_states, 0,
-           sizeof(bool) * SDL_NUM_SCANCODES);
+    // The stream thread sets is_finished after its last write, so it is
+    // read first.
+    bool is_finished = SDL_AtomicGet(&stream->is_finished);
+    write = (uint32_t)SDL_AtomicGet(&stream->write_position);
 
-    return keyboard;
+    return !is_finished || write - read >= (uint32_t)frame_size;
 }
 
-static void scg__keyboard_update_keystates(scg_keyboard_t *keyboard) {
-    memcpy(keyboard->last_frame_key_states, keyboard->current_key_states,
-           sizeof(bool) * SDL_NUM_SCANCODES);
+// Runs a biquad over interleaved stereo. With SSE the left and right
+// channels share one vector, so each frame is a single pass of the filter.
+static void scg__biquad_process(scg__biquad_t *biquad, float32_t *samples,
+                                int num_frames) {
+#ifdef SCG__SSE2
+    const __m128 b0 = _mm_set1_ps(biquad->b0);
+    const __m128 b1 = _mm_set1_ps(biquad->b1);
+    const __m128 b2 = _mm_set1_ps(biquad->b2);
+    const __m128 a1 = _mm_set1_ps(biquad->a1);
+    const __m128 a2 = _mm_set1_ps(biquad->a2);
+    __m128 z1 = _mm_setr_ps(biquad->z1[0], biquad->z1[1], 0.0f, 0.0f);
+    __m128 z2 = _mm_setr_ps(biquad->z2[0], biquad->z2[1], 0.0f, 0.0f);
+
+    for (int i = 0; i < num_frames; i++) {
+        __m64 *frame = (__m64 *)(samples + i * 2);
+        __m128 x = _mm_loadl_pi(_mm_setzero_ps(), frame);
+        __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_storel_pi(frame, y);
+    }
+
+    float32_t state[4];
+    _mm_storeu_ps(state, z1);
+    biquad->z1[0] = state[0];
+    biquad->z1[1] = state[1];
+    _mm_storeu_ps(state, z2);
+    biquad->z2[0] = state[0];
+    biquad->z2[1] = state[1];
+#else
+    for (int i = 0; i < num_frames; i++) {
+        for (int c = 0; c < 2; c++) {
+            float32_t x = samples[i * 2 + c];
+            float32_t y = biquad->b0 * x + biquad->z1[c];
+
+            biquad->z1[c] = biquad->b1 * x - biquad->a1 * y + biquad->z2[c];
+            biquad->z2[c] = biquad->b2 * x - biquad->a2 * y;
+            samples[i * 2 + c] = y;
+        }
+    }
+#endif
 }
 
-static scg_mouse_t *scg__mouse_new(void) {
-    scg_mouse_t *mouse = malloc(sizeof(*mouse));
-    if (mouse == NULL) {
-        scg_log_error("Failed to allocate memory for mouse");
+static void scg__delay_process(scg__delay_t *delay, float32_t wet,
+                               float32_t *samples, int num_frames) {
+    for (int i = 0; i < num_frames; i++) {
+        float32_t *line = delay->buffer + delay->position * 2;
 
-        return NULL;
+        for (int c = 0; c < 2; c++) {
+            float32_t x = samples[i * 2 + c];
+            float32_t delayed = line[c];
+
+            line[c] = x + delayed * delay->feedback;
+            samples[i * 2 + c] = x + delayed * wet;
+        }
+
+        if (++delay->position == delay->length) {
+            delay->position = 0;
+        }
     }
+}
 
-    return mouse;
+static inline float32_t scg__reverb_comb(scg__delay_line_t *comb,
+                                         float32_t input, float32_t feedback,
+                                         float32_t damping) {
+    float32_t output = comb->buffer[comb->position];
+
+    comb->filter_state =
+        output * (1.0f - damping) + comb->filter_state * damping;
+    comb->buffer[comb->position] = input + comb->filter_state * feedback;
+    if (++comb->position == comb->length) {
+        comb->position = 0;
+    }
+
+    return output;
 }
 
-static void scg__mouse_update(scg_mouse_t *mouse, int w, int h, int win_w,
-                              int win_h) {
-    int x, y;
-    uint32_t button_state = SDL_GetMouseState(&x, &y);
+static inline float32_t scg__reverb_allpass(scg__delay_line_t *allpass,
+                                            float32_t input) {
+    float32_t delayed = allpass->buffer[allpass->position];
 
-    mouse->window_x = x;
-    mouse->window_y = y;
-    mouse->x = (int)(((float32_t)x / (float32_t)win_w) * (float32_t)w);
-    mouse->y = (int)(((float32_t)y / (float32_t)win_h) * (float32_t)h);
-    mouse->button_state = button_state;
+    allpass->buffer[allpass->position] = input + delayed * 0.5f;
+    if (++allpass->position == allpass->length) {
+        allpass->position = 0;
+    }
+
+    return delayed - input;
 }
 
-static scg_audio_t *scg__audio_new() {
-    SDL_AudioSpec desired, obtained;
+static void scg__reverb_process(scg__reverb_t *reverb, float32_t wet,
+                                float32_t *samples, int num_frames) {
+    const float32_t input_gain = 0.03f;
 
-    int samples_per_sec = 48000;
-    int desired_num_channels = 2;
-    size_t bytes_per_sample = sizeof(int16_t) * desired_num_channels;
+    for (int i = 0; i < num_frames; i++) {
+        float32_t input =
+            (samples[i * 2] + samples[i * 2 + 1]) * input_gain;
 
-    memset(&desired, 0, sizeof(desired));
-    desired.freq = samples_per_sec;
-    desired.format = AUDIO_S16LSB;
-    desired.channels = desired_num_channels;
-    desired.samples = 2048;
-    desired.callback = NULL;
+        for (int c = 0; c < 2; c++) {
+            float32_t output = 0.0f;
 
-    SDL_AudioDeviceID device_id = SDL_OpenAudioDevice(
-        NULL, 0, &desired, &obtained, SDL_AUDIO_ALLOW_FORMAT_CHANGE);
-    if (device_id == 0) {
-        scg_log_errorf("Failed to open SDL audio device. %s", SDL_GetError());
+            for (int j = 0; j < SCG__REVERB_NUM_COMBS; j++) {
+                output += scg__reverb_comb(&reverb->combs[c][j], input,
+                                           reverb->feedback, reverb->damping);
+            }
+            for (int j = 0; j < SCG__REVERB_NUM_ALLPASSES; j++) {
+                output = scg__reverb_allpass(&reverb->allpasses[c][j], output);
+            }
 
-        return NULL;
+            samples[i * 2 + c] += output * wet;
+        }
     }
+}
 
-    if (obtained.format != desired.format) {
-        scg_log_error("Audio device does not support format S16LSB");
+// Follows the louder channel's peak and turns down both channels by the
+// amount the envelope is over the threshold, scaled by the slope. The
+// logarithms are only taken while the envelope is over the threshold.
+static void scg__compressor_process(scg__compressor_t *compressor,
+                                    float32_t *samples, int num_frames) {
+    float32_t threshold = scg__db_to_gain(compressor->threshold_db);
+
+    for (int i = 0; i < num_frames; i++) {
+        float32_t peak = scg_max_float32(fabsf(samples[i * 2]),
+                                         fabsf(samples[i * 2 + 1]));
+        float32_t coefficient = peak > compressor->envelope
+                                    ? compressor->attack
+                                    : compressor->release;
+        compressor->envelope =
+            peak + coefficient * (compressor->envelope - peak);
+
+        float32_t gain = compressor->makeup;
+        if (compressor->envelope > threshold) {
+            float32_t over_db = 20.0f * log10f(compressor->envelope) -
+                                compressor->threshold_db;
+            gain *= scg__db_to_gain(-over_db * compressor->slope);
+        }
 
-        SDL_CloseAudioDevice(device_id);
-        return NULL;
+        samples[i * 2] *= gain;
+        samples[i * 2 + 1] *= gain;
     }
+}
 
-    int obtained_frequency = obtained.freq;
-    int latency_sample_count = obtained_frequency / 15;
-    uint32_t buffer_size = latency_sample_count * bytes_per_sample;
-    uint8_t *buffer = malloc(buffer_size);
-    if (buffer == NULL) {
-        scg_log_errorf("Failed to allocate memory for sound buffer. bytes=%u",
-                       buffer_size);
-
-        SDL_CloseAudioDevice(device_id);
-        return NULL;
+// Runs the mix buffer through the effect chain as floats from -1 to 1 and
+// converts the result to saturated 16 bit samples.
+static void scg__audio_apply_effects(scg_audio_t *audio, int16_t *dest,
+                                     int num_frames) {
+    const float32_t to_float = 1.0f / 32768.0f;
+    float32_t *samples = audio->effect_buffer;
+    const int32_t *mix = audio->mix_buffer;
+    int num_samples = num_frames * 2;
+    int i = 0;
+
+#ifdef SCG__SSE2
+    for (; i + 4 <= num_samples; i += 4) {
+        __m128i values = _mm_loadu_si128((const __m128i *)(mix + i));
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_cvtepi32_ps(values),
+                                              _mm_set1_ps(to_float)));
+    }
+#endif
+    for (; i < num_samples; i++) {
+        samples[i] = (float32_t)mix[i] * to_float;
     }
 
-    scg_audio_t *audio = malloc(sizeof(*audio));
-    if (audio == NULL) {
-        scg_log_error("Failed to allocate memory for audio");
+    for (int j = 0; j < audio->num_effects; j++) {
+        scg_effect_t *effect = audio->effects[j];
 
-        free(buffer);
-        SDL_CloseAudioDevice(device_id);
-        return NULL;
+        switch (effect->type) {
+        case SCG_EFFECT_FILTER:
+            scg__biquad_process(&effect->state.biquad, samples, num_frames);
+            break;
+        case SCG_EFFECT_DELAY:
+            scg__delay_process(&effect->state.delay, effect->wet, samples,
+                               num_frames);
+            break;
+        case SCG_EFFECT_REVERB:
+            scg__reverb_process(&effect->state.reverb, effect->wet, samples,
+                                num_frames);
+            break;
+        case SCG_EFFECT_COMPRESSOR:
+            scg__compressor_process(&effect->state.compressor, samples,
+                                    num_frames);
+            break;
+        }
     }
 
-    audio->device_id = device_id;
-    audio->frequency = obtained_frequency;
-    audio->num_channels = obtained.channels;
-    audio->num_samples = obtained.samples;
-    audio->bytes_per_sample = bytes_per_sample;
-    audio->latency_sample_count = latency_sample_count;
-    audio->buffer_size = buffer_size;
-    audio->buffer = buffer;
-    audio->num_sounds = 0;
+    i = 0;
+#ifdef SCG__SSE2
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(samples + i), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(samples + i + 4), scale);
+        lo = _mm_min_ps(_mm_max_ps(lo, low), high);
+        hi = _mm_min_ps(_mm_max_ps(hi, low), high);
+
+        _mm_storeu_si128((__m128i *)(dest + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(lo),
+                                         _mm_cvtps_epi32(hi)));
+    }
+#endif
+    for (; i < num_samples; i++) {
+        float32_t sample = scg_clamp_float32(samples[i] * 32768.0f, -32768.0f,
+                                             32767.0f);
+        dest[i] = (int16_t)lrintf(sample);
+    }
+}
 
-    SDL_PauseAudioDevice(device_id, 0);
+// Returns a sample around a frame of a sound, wrapping for looping sounds
+// and holding the first or last frame for others.
+static inline int scg__audio_sound_sample(const int16_t *samples,
+                                          int num_frames, int frame,
+                                          int channel, bool loop) {
+    if (frame < 0 || frame >= num_frames) {
+        frame = loop ? (frame + num_frames) % num_frames
+                     : scg_max_int(scg_min_int(frame, num_frames - 1), 0);
+    }
 
-    return audio;
+    return samples[frame * 2 + channel];
 }
 
-static void scg__audio_update(scg_audio_t *audio) {
-    memset(audio->buffer, 0, audio->buffer_size);
+// Mixes a voice played at another pitch, stepping through the sound in 32.32
+// fixed point and interpolating between frames. Returns false once a voice
+// that does not loop has played to the end.
+static bool scg__audio_mix_pitched(scg_audio_t *audio, scg__voice_t *voice,
+                                   int32_t *mix, int num_frames, int gain_left,
+                                   int gain_right) {
+    scg_sound_t *sound = voice->sound;
+    const int16_t *samples = (const int16_t *)sound->buffer;
+    int frame_size = audio->bytes_per_sample;
+    int num_sound_frames = sound->length / frame_size;
+    bool is_cubic = audio->interpolation == SCG_AUDIO_INTERPOLATION_CUBIC;
+    float32_t gains[2] = {gain_left / 32768.0f, gain_right / 32768.0f};
+
+    uint64_t end = (uint64_t)num_sound_frames << 32;
+    uint64_t step = (uint64_t)(voice->pitch * 4294967296.0f);
+    uint64_t position =
+        (uint64_t)(voice->mix_offset / frame_size) << 32 | voice->mix_fraction;
+
+    for (int i = 0; i < num_frames; i++, position += step) {
+        if (position >= end) {
+            if (!voice->loop) {
+                return false;
+            }
+            position %= end;
+        }
+
+        int frame = (int)(position >> 32);
+        float32_t t = (float32_t)(uint32_t)position / 4294967296.0f;
+
+        for (int c = 0; c < 2; c++) {
+            float32_t s1 = scg__audio_sound_sample(samples, num_sound_frames,
+                                                   frame, c, voice->loop);
+            float32_t s2 = scg__audio_sound_sample(samples, num_sound_frames,
+                                                   frame + 1, c, voice->loop);
+            float32_t value = s1 + (s2 - s1) * t;
+
+            // Catmull-Rom spline through the two frames on either side.
+            if (is_cubic) {
+                float32_t s0 = scg__audio_sound_sample(
+                    samples, num_sound_frames, frame - 1, c, voice->loop);
+                float32_t s3 = scg__audio_sound_sample(
+                    samples, num_sound_frames, frame + 2, c, voice->loop);
+                value = s1 + 0.5f * t *
+                                 (s2 - s0 +
+                                  t * (2.0f * s0 - 5.0f * s1 + 4.0f * s2 - s3 +
+                                       t * (3.0f * (s1 - s2) + s3 - s0)));
+            }
+
+            mix[i * 2 + c] += (int32_t)(value * gains[c]);
+        }
+    }
 
-    uint32_t target_queue_bytes = audio->buffer_size;
-    uint32_t bytes_to_write =
-        target_queue_bytes - SDL_GetQueuedAudioSize(audio->device_id);
+    voice->mix_offset = (uint32_t)(position >> 32) * frame_size;
+    voice->mix_fraction = (uint32_t)position;
 
-    for (int i = 0; i < audio->num_sounds; i++) {
-        scg_sound_t *sound = audio->sounds[i];
+    return true;
+}
+
+// Mixes every playing voice into one block of the mix buffer. Looping voices
+// wrap within the same block, so there is no gap at the loop point.
+static void scg__audio_mix_block(scg_audio_t *audio, int num_frames) {
+    int32_t *mix = audio->mix_buffer;
+    int frame_size = audio->bytes_per_sample;
+
+    memset(mix, 0, num_frames * 2 * sizeof(*mix));
+
+    for (int i = 0; i < audio->num_active_voices;) {
+        scg__voice_t *voice = &audio->voices[audio->active_voices[i]];
+        scg_sound_t *sound = voice->sound;
+
+        // Balance keeps the centre at full volume and fades out the
+        // opposite side as the voice is panned.
+        float32_t gain = voice->volume * audio->volume * 32767.0f;
+        int gain_left = (int)(gain * scg_min_float32(1.0f - voice->pan, 1.0f));
+        int gain_right =
+            (int)(gain * scg_min_float32(1.0f + voice->pan, 1.0f));
+        int written = 0;
+
+        if (sound->stream != NULL || voice->pitch != 1.0f) {
+            bool is_playing =
+                sound->stream != NULL
+                    ? scg__audio_mix_stream(audio, voice, mix, num_frames,
+                                            gain_left, gain_right)
+                    : scg__audio_mix_pitched(audio, voice, mix, num_frames,
+                                             gain_left, gain_right);
+            if (!is_playing) {
+                scg__audio_stop_voice(audio, voice);
+                continue;
+            }
 
-        if (!sound->is_playing) {
+            i++;
             continue;
         }
 
-        const uint8_t *current_play_position =
-            sound->buffer + sound->play_offset;
-        const uint32_t remaining_bytes_to_play =
-            sound->length - sound->play_offset;
+        while (written < num_frames) {
+            int remaining = (sound->length - voice->mix_offset) / frame_size;
+            int frames_to_mix = scg_min_int(remaining, num_frames - written);
 
-        if (current_play_position >= sound->end_position) {
-            if (!sound->loop) {
-                sound->is_playing = false;
-            }
+            scg__audio_mix_samples(
+                mix + written * 2,
+                (const int16_t *)(sound->buffer + voice->mix_offset),
+                frames_to_mix, gain_left, gain_right);
 
-            sound->play_offset = 0;
-        } else {
-            uint32_t bytes_to_mix = (bytes_to_write > remaining_bytes_to_play)
-                                        ? remaining_bytes_to_play
-                                        : bytes_to_write;
+            written += frames_to_mix;
+            voice->mix_offset += frames_to_mix * frame_size;
 
-            SDL_MixAudioFormat(audio->buffer, current_play_position,
-                               AUDIO_S16LSB, bytes_to_mix, SCG__MAX_VOLUME / 2);
+            if (sound->length - voice->mix_offset < (uint32_t)frame_size) {
+                voice->mix_offset = sound->length;
+                if (!voice->loop) {
+                    break;
+                }
+                voice->mix_offset = 0;
+            }
+        }
 
-            sound->play_offset += bytes_to_mix;
+        if (voice->mix_offset == sound->length) {
+            scg__audio_stop_voice(audio, voice);
+            continue;
         }
-    }
 
-    SDL_QueueAudio(audio->device_id, audio->buffer, bytes_to_write);
+        i++;
+    }
 }
 
-static void scg__audio_free(scg_audio_t *audio) {
-    SDL_PauseAudioDevice(audio->device_id, 1);
-    SDL_ClearQueuedAudio(audio->device_id);
+// Mixes the stream in blocks the size of the mix buffer.
+static void scg__audio_mix(scg_audio_t *audio, uint8_t *stream,
+                           uint32_t length) {
+    int16_t *dest = (int16_t *)stream;
+    int num_frames = length / audio->bytes_per_sample;
 
-    for (int i = 0; i < audio->num_sounds; i++) {
-        SDL_FreeWAV(audio->sounds[i]->buffer);
-    }
+    while (num_frames > 0) {
+        int block_frames = scg_min_int(num_frames, audio->mix_buffer_frames);
 
-    free(audio->buffer);
-    SDL_CloseAudioDevice(audio->device_id);
+        scg__audio_mix_block(audio, block_frames);
+        if (audio->num_effects > 0) {
+            scg__audio_apply_effects(audio, dest, block_frames);
+        } else {
+            scg__audio_clip_samples(dest, audio->mix_buffer, block_frames * 2);
+        }
 
-    free(audio);
+        if (audio->analyser != NULL) {
+            scg__audio_analyse(audio->analyser, dest, block_frames);
+        }
+
+        dest += block_frames * 2;
+        num_frames -= block_frames;
+    }
 }
 
-static uint8_t scg__base64_index_from_char(char c) {
-    for (int i = 0; i < 64; i++) {
-        if (c == scg__base64_table[i]) {
-            return i;
-        }
+// Publishes where each playing voice stopped mixing, and the step it moves
+// through its sound by. Streams are always played at their own pitch.
+static void scg__audio_publish_voices(scg_audio_t *audio) {
+    SDL_AtomicAdd(&audio->clock_sequence, 1);
+    SDL_MemoryBarrierRelease();
+
+    for (int i = 0; i < audio->num_active_voices; i++) {
+        scg__voice_t *voice = &audio->voices[audio->active_voices[i]];
+
+        SDL_AtomicSet(&voice->play_offset, (int)voice->mix_offset);
+        voice->play_step = voice->sound->stream != NULL
+                               ? (uint64_t)1 << 32
+                               : (uint64_t)(voice->pitch * 4294967296.0f);
+        voice->play_loop = voice->loop;
     }
+    audio->voice_frames = audio->mixed_frames;
 
-    return 0;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&audio->clock_sequence, 1);
 }
 
-static void scg__decode_font_data(char *out, size_t out_len, const char *data) {
-    const int len = strlen(data);
+static void scg__audio_callback(void *userdata, Uint8 *stream, int len) {
+    scg_audio_t *audio = userdata;
+    int num_frames = len / audio->bytes_per_sample;
 
-    uint8_t indices[4];
-    uint8_t buf[3];
-    size_t size = 0;
+    SDL_AtomicAdd(&audio->clock_sequence, 1);
+    SDL_MemoryBarrierRelease();
+    audio->clock_frames = audio->mixed_frames;
+    audio->clock_counter = scg_get_performance_counter();
+    audio->clock_callback_frames = num_frames;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&audio->clock_sequence, 1);
 
-    for (int i = 0; i < len; i += 4) {
-        indices[0] = scg__base64_index_from_char(data[i]);
-        indices[1] = scg__base64_index_from_char(data[i + 1]);
-        indices[2] = scg__base64_index_from_char(data[i + 2]);
-        indices[3] = scg__base64_index_from_char(data[i + 3]);
+    scg__audio_process_commands(audio);
+    scg__audio_mix(audio, stream, (uint32_t)len);
+    audio->mixed_frames += num_frames;
 
-        buf[0] = (indices[0] << 2) + ((indices[1] & 0x30) >> 4);
-        buf[1] = ((indices[1] & 0xF) << 4) + ((indices[2] & 0x3C) >> 2);
-        buf[2] = ((indices[2] & 0x3) << 6) + indices[3];
+    scg__audio_publish_voices(audio);
+}
 
-        for (int j = 0; j < 3; j++) {
-            if (size == out_len) {
-                return;
-            }
+static void scg__audio_free(scg_audio_t *audio) {
+    if (audio->device_id != 0) {
+        SDL_PauseAudioDevice(audio->device_id, 1);
+        SDL_CloseAudioDevice(audio->device_id);
+    }
 
-            out[size++] = buf[j];
+    if (audio->output != NULL) {
+        if (!scg__audio_write_wav_header(audio)) {
+            scg_log_errorf("Failed to finish audio output. %s",
+                           SDL_GetError());
         }
+        SDL_RWclose(audio->output);
     }
-}
 
-static const char scg__base64_table[64] = {
-    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
-    'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
-    'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
-    'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
-    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+    while (audio->sounds != NULL) {
+        scg_sound_t *sound = audio->sounds;
+        audio->sounds = sound->next;
+
+        scg__sound_free_data(sound);
+        free(sound);
+    }
+
+    while (audio->effect_list != NULL) {
+        scg_effect_t *effect = audio->effect_list;
+        audio->effect_list = effect->next;
+
+        scg__effect_free_data(effect);
+        free(effect);
+    }
+
+    free(audio->finished_voices);
+    free(audio->voice_slots);
+    free(audio->free_voices);
+    free(audio->voices);
+    free(audio->active_voices);
+    free(audio->mix_buffer);
+    free(audio->effect_buffer);
+    free(audio->render_buffer);
+    free(audio->analyser);
+    free(audio);
+}
 
 // Bitmap fonts taken from https://github.com/dhepper/font8x8.
-static const char *scg__font8x8_data =
-    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
-    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
-    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
-    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
-    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAGDw8GBgAGAA2NgAAAA"
-    "AAADY2fzZ/"
-    "NjYADD4DHjAfDAAAYzMYDGZjABw2HG47M24ABgYDAAAAAAAYDAYGBgwYAAYMGBgYDAYAAGY8/"
-    "zxmAAAADAw/"
-    "DAwAAAAAAAAADAwGAAAAPwAAAAAAAAAAAAwMAGAwGAwGAwEAPmNze29nPgAMDgwMDAw/"
-    "AB4zMBwGMz8AHjMwHDAzHgA4PDYzfzB4AD8DHzAwMx4AHAYDHzMzHgA/"
-    "MzAYDAwMAB4zMx4zMx4AHjMzPjAYDgAADAwAAAwMAAAMDAAADAwGGAwGAwYMGAAAAD8AAD8AAA"
-    "YMGDAYDAYAHjMwGAwADAA+Y3t7ewMeAAweMzM/"
-    "MzMAP2ZmPmZmPwA8ZgMDA2Y8AB82ZmZmNh8Af0YWHhZGfwB/"
-    "RhYeFgYPADxmAwNzZnwAMzMzPzMzMwAeDAwMDAweAHgwMDAzMx4AZ2Y2HjZmZwAPBgYGRmZ/"
-    "AGN3f39rY2MAY2dve3NjYwAcNmNjYzYcAD9mZj4GBg8AHjMzMzseOAA/"
-    "ZmY+NmZnAB4zBw44Mx4APy0MDAwMHgAzMzMzMzM/"
-    "ADMzMzMzHgwAY2Nja393YwBjYzYcHDZjADMzMx4MDB4Af2MxGExmfwAeBgYGBgYeAAMGDBgwYE"
-    "AAHhgYGBgYHgAIHDZjAAAAAAAAAAAAAAD/"
-    "DAwYAAAAAAAAAB4wPjNuAAcGBj5mZjsAAAAeMwMzHgA4MDA+MzNuAAAAHjM/"
-    "Ax4AHDYGDwYGDwAAAG4zMz4wHwcGNm5mZmcADAAODAwMHgAwADAwMDMzHgcGZjYeNmcADgwMDA"
-    "wMHgAAADN/"
-    "f2tjAAAAHzMzMzMAAAAeMzMzHgAAADtmZj4GDwAAbjMzPjB4AAA7bmYGDwAAAD4DHjAfAAgMPg"
-    "wMLBgAAAAzMzMzbgAAADMzMx4MAAAAY2t/"
-    "fzYAAABjNhw2YwAAADMzMz4wHwAAPxkMJj8AOAwMBwwMOAAYGBgAGBgYAAcMDDgMDAcAbjsAAA"
-    "AAAAAAAAAAAAAAAA==";
-
-static const char *scg__font8x8_hiragana_data =
-    "AAAAAAAAAAAEPwQ8Vk0mAAQ/"
-    "BDxWTSYAAAAAESElAgAAAREhISUCAAAcABwiIBgAPAA8QkAgGAAcAD4QOCRiABwAPhA4JGIAJE"
-    "8EPEZFIgAkTwQ8RkUiAAQkT1RSEgkARCQPVFJSCQAIHwg/"
-    "HAI8AEQvBB8OAR4AEAgEAgQIEAAoRBIhAgQIAAAieSEhIhAAQCIRPRESCAAAADwAAgI8ACBAFi"
-    "ABAQ4AEH4QPAICHAAkTxQuAQEOAAACAgJCIhwAIEISIgIiHAAQfhgUGBAMAEQvBgUGBAMAIHIv"
-    "IhoCHACAUDoXGgIcAB4IBH8IBDgATyQCfwgEOAACDwJyAglxAEIvAnICCXEACH4IPEBAOABELw"
-    "QeICAcAAAAABwiIBwAABwiQUAgHABAIB4hICAcAAA+"
-    "CAQEBDgAAD5IJAQEOAAEBAg8AgI8AEQkCDwCAjwAMgInInIpEQAAAnoCCnICAAgJPktlVSIABA"
-    "c0TGZUJAAAADxKSUUiAAAieiJyKhIAgFEdETkVCQBAsV0RORUJAAAAEzJREQ4AQCADMlERDgBA"
-    "oEMyUREOABwACCpJEAwATCAIKkkQDABMoEgKKUgMAAAABAoRIEAAIEAUKhEgQAAgUCQKESBAAH"
-    "0RfRE5VQkAnVEdETlVCQBdsV0ROVUJAH4IPggcKgQAAAckJH4lEgAED2QGBSY8AAAJPUpLRSoA"
-    "Ag8CD2JCPAAAABIfIhIEAAASP0JCNAQAAAARPVM5EQAAET1TUTkRAAAIOAgcKgQACAg4CBwqBA"
-    "AeAAI6RkIwAAAgIiIqJBAAHwg8QklUOAAEBwQMFlUkAD8QCDxCQTAAAAAIDjhMKgAEBwQ8RkUk"
-    "AA4IPEppVTIABjxCOQQ2SQAEDwRuEQhwAAgIBAxWUiEAQC4APEJAOAAAAAAAAAAAAAAAAAAAAA"
-    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAABAgCBAAAAAAECgQAAAAAAAAAAICBAw"
-    "DAAgQBQkCBgGAAAAAAAAAAAA";
+// BEGIN GENERATED FONT TABLES
+// Generated by tools/font_tables.c, do not edit by hand.
+
+static const uint8_t scg__font8x8_bitmaps[224][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0000
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0001
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0002
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0003
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0004
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0005
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0006
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0007
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0008
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0009
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+000A
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+000B
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+000C
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+000D
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+000E
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+000F
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0010
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0011
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0012
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0013
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0014
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0015
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0016
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0017
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0018
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0019
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+001A
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+001B
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+001C
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+001D
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+001E
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+001F
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0020
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // U+0021
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0022
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // U+0023
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // U+0024
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // U+0025
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // U+0026
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0027
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // U+0028
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // U+0029
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // U+002A
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // U+002B
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // U+002C
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // U+002D
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // U+002E
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // U+002F
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // U+0030
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // U+0031
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // U+0032
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // U+0033
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // U+0034
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // U+0035
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // U+0036
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // U+0037
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // U+0038
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // U+0039
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // U+003A
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // U+003B
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // U+003C
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // U+003D
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // U+003E
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // U+003F
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // U+0040
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // U+0041
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // U+0042
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // U+0043
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // U+0044
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // U+0045
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // U+0046
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // U+0047
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // U+0048
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // U+0049
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // U+004A
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // U+004B
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // U+004C
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // U+004D
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // U+004E
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // U+004F
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // U+0050
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // U+0051
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // U+0052
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // U+0053
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // U+0054
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // U+0055
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // U+0056
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // U+0057
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // U+0058
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // U+0059
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // U+005A
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // U+005B
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // U+005C
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // U+005D
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // U+005E
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // U+005F
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+0060
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // U+0061
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // U+0062
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // U+0063
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, // U+0064
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, // U+0065
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, // U+0066
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // U+0067
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // U+0068
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // U+0069
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // U+006A
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // U+006B
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // U+006C
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // U+006D
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // U+006E
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // U+006F
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // U+0070
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // U+0071
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // U+0072
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // U+0073
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // U+0074
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // U+0075
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // U+0076
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // U+0077
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // U+0078
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // U+0079
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // U+007A
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // U+007B
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // U+007C
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // U+007D
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+007E
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+007F
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+3040
+    {0x04, 0x3F, 0x04, 0x3C, 0x56, 0x4D, 0x26, 0x00}, // U+3041
+    {0x04, 0x3F, 0x04, 0x3C, 0x56, 0x4D, 0x26, 0x00}, // U+3042
+    {0x00, 0x00, 0x00, 0x11, 0x21, 0x25, 0x02, 0x00}, // U+3043
+    {0x00, 0x01, 0x11, 0x21, 0x21, 0x25, 0x02, 0x00}, // U+3044
+    {0x00, 0x1C, 0x00, 0x1C, 0x22, 0x20, 0x18, 0x00}, // U+3045
+    {0x3C, 0x00, 0x3C, 0x42, 0x40, 0x20, 0x18, 0x00}, // U+3046
+    {0x1C, 0x00, 0x3E, 0x10, 0x38, 0x24, 0x62, 0x00}, // U+3047
+    {0x1C, 0x00, 0x3E, 0x10, 0x38, 0x24, 0x62, 0x00}, // U+3048
+    {0x24, 0x4F, 0x04, 0x3C, 0x46, 0x45, 0x22, 0x00}, // U+3049
+    {0x24, 0x4F, 0x04, 0x3C, 0x46, 0x45, 0x22, 0x00}, // U+304A
+    {0x04, 0x24, 0x4F, 0x54, 0x52, 0x12, 0x09, 0x00}, // U+304B
+    {0x44, 0x24, 0x0F, 0x54, 0x52, 0x52, 0x09, 0x00}, // U+304C
+    {0x08, 0x1F, 0x08, 0x3F, 0x1C, 0x02, 0x3C, 0x00}, // U+304D
+    {0x44, 0x2F, 0x04, 0x1F, 0x0E, 0x01, 0x1E, 0x00}, // U+304E
+    {0x10, 0x08, 0x04, 0x02, 0x04, 0x08, 0x10, 0x00}, // U+304F
+    {0x28, 0x44, 0x12, 0x21, 0x02, 0x04, 0x08, 0x00}, // U+3050
+    {0x00, 0x22, 0x79, 0x21, 0x21, 0x22, 0x10, 0x00}, // U+3051
+    {0x40, 0x22, 0x11, 0x3D, 0x11, 0x12, 0x08, 0x00}, // U+3052
+    {0x00, 0x00, 0x3C, 0x00, 0x02, 0x02, 0x3C, 0x00}, // U+3053
+    {0x20, 0x40, 0x16, 0x20, 0x01, 0x01, 0x0E, 0x00}, // U+3054
+    {0x10, 0x7E, 0x10, 0x3C, 0x02, 0x02, 0x1C, 0x00}, // U+3055
+    {0x24, 0x4F, 0x14, 0x2E, 0x01, 0x01, 0x0E, 0x00}, // U+3056
+    {0x00, 0x02, 0x02, 0x02, 0x42, 0x22, 0x1C, 0x00}, // U+3057
+    {0x20, 0x42, 0x12, 0x22, 0x02, 0x22, 0x1C, 0x00}, // U+3058
+    {0x10, 0x7E, 0x18, 0x14, 0x18, 0x10, 0x0C, 0x00}, // U+3059
+    {0x44, 0x2F, 0x06, 0x05, 0x06, 0x04, 0x03, 0x00}, // U+305A
+    {0x20, 0x72, 0x2F, 0x22, 0x1A, 0x02, 0x1C, 0x00}, // U+305B
+    {0x80, 0x50, 0x3A, 0x17, 0x1A, 0x02, 0x1C, 0x00}, // U+305C
+    {0x1E, 0x08, 0x04, 0x7F, 0x08, 0x04, 0x38, 0x00}, // U+305D
+    {0x4F, 0x24, 0x02, 0x7F, 0x08, 0x04, 0x38, 0x00}, // U+305E
+    {0x02, 0x0F, 0x02, 0x72, 0x02, 0x09, 0x71, 0x00}, // U+305F
+    {0x42, 0x2F, 0x02, 0x72, 0x02, 0x09, 0x71, 0x00}, // U+3060
+    {0x08, 0x7E, 0x08, 0x3C, 0x40, 0x40, 0x38, 0x00}, // U+3061
+    {0x44, 0x2F, 0x04, 0x1E, 0x20, 0x20, 0x1C, 0x00}, // U+3062
+    {0x00, 0x00, 0x00, 0x1C, 0x22, 0x20, 0x1C, 0x00}, // U+3063
+    {0x00, 0x1C, 0x22, 0x41, 0x40, 0x20, 0x1C, 0x00}, // U+3064
+    {0x40, 0x20, 0x1E, 0x21, 0x20, 0x20, 0x1C, 0x00}, // U+3065
+    {0x00, 0x3E, 0x08, 0x04, 0x04, 0x04, 0x38, 0x00}, // U+3066
+    {0x00, 0x3E, 0x48, 0x24, 0x04, 0x04, 0x38, 0x00}, // U+3067
+    {0x04, 0x04, 0x08, 0x3C, 0x02, 0x02, 0x3C, 0x00}, // U+3068
+    {0x44, 0x24, 0x08, 0x3C, 0x02, 0x02, 0x3C, 0x00}, // U+3069
+    {0x32, 0x02, 0x27, 0x22, 0x72, 0x29, 0x11, 0x00}, // U+306A
+    {0x00, 0x02, 0x7A, 0x02, 0x0A, 0x72, 0x02, 0x00}, // U+306B
+    {0x08, 0x09, 0x3E, 0x4B, 0x65, 0x55, 0x22, 0x00}, // U+306C
+    {0x04, 0x07, 0x34, 0x4C, 0x66, 0x54, 0x24, 0x00}, // U+306D
+    {0x00, 0x00, 0x3C, 0x4A, 0x49, 0x45, 0x22, 0x00}, // U+306E
+    {0x00, 0x22, 0x7A, 0x22, 0x72, 0x2A, 0x12, 0x00}, // U+306F
+    {0x80, 0x51, 0x1D, 0x11, 0x39, 0x15, 0x09, 0x00}, // U+3070
+    {0x40, 0xB1, 0x5D, 0x11, 0x39, 0x15, 0x09, 0x00}, // U+3071
+    {0x00, 0x00, 0x13, 0x32, 0x51, 0x11, 0x0E, 0x00}, // U+3072
+    {0x40, 0x20, 0x03, 0x32, 0x51, 0x11, 0x0E, 0x00}, // U+3073
+    {0x40, 0xA0, 0x43, 0x32, 0x51, 0x11, 0x0E, 0x00}, // U+3074
+    {0x1C, 0x00, 0x08, 0x2A, 0x49, 0x10, 0x0C, 0x00}, // U+3075
+    {0x4C, 0x20, 0x08, 0x2A, 0x49, 0x10, 0x0C, 0x00}, // U+3076
+    {0x4C, 0xA0, 0x48, 0x0A, 0x29, 0x48, 0x0C, 0x00}, // U+3077
+    {0x00, 0x00, 0x04, 0x0A, 0x11, 0x20, 0x40, 0x00}, // U+3078
+    {0x20, 0x40, 0x14, 0x2A, 0x11, 0x20, 0x40, 0x00}, // U+3079
+    {0x20, 0x50, 0x24, 0x0A, 0x11, 0x20, 0x40, 0x00}, // U+307A
+    {0x7D, 0x11, 0x7D, 0x11, 0x39, 0x55, 0x09, 0x00}, // U+307B
+    {0x9D, 0x51, 0x1D, 0x11, 0x39, 0x55, 0x09, 0x00}, // U+307C
+    {0x5D, 0xB1, 0x5D, 0x11, 0x39, 0x55, 0x09, 0x00}, // U+307D
+    {0x7E, 0x08, 0x3E, 0x08, 0x1C, 0x2A, 0x04, 0x00}, // U+307E
+    {0x00, 0x07, 0x24, 0x24, 0x7E, 0x25, 0x12, 0x00}, // U+307F
+    {0x04, 0x0F, 0x64, 0x06, 0x05, 0x26, 0x3C, 0x00}, // U+3080
+    {0x00, 0x09, 0x3D, 0x4A, 0x4B, 0x45, 0x2A, 0x00}, // U+3081
+    {0x02, 0x0F, 0x02, 0x0F, 0x62, 0x42, 0x3C, 0x00}, // U+3082
+    {0x00, 0x00, 0x12, 0x1F, 0x22, 0x12, 0x04, 0x00}, // U+3083
+    {0x00, 0x12, 0x3F, 0x42, 0x42, 0x34, 0x04, 0x00}, // U+3084
+    {0x00, 0x00, 0x11, 0x3D, 0x53, 0x39, 0x11, 0x00}, // U+3085
+    {0x00, 0x11, 0x3D, 0x53, 0x51, 0x39, 0x11, 0x00}, // U+3086
+    {0x00, 0x08, 0x38, 0x08, 0x1C, 0x2A, 0x04, 0x00}, // U+3087
+    {0x08, 0x08, 0x38, 0x08, 0x1C, 0x2A, 0x04, 0x00}, // U+3088
+    {0x1E, 0x00, 0x02, 0x3A, 0x46, 0x42, 0x30, 0x00}, // U+3089
+    {0x00, 0x20, 0x22, 0x22, 0x2A, 0x24, 0x10, 0x00}, // U+308A
+    {0x1F, 0x08, 0x3C, 0x42, 0x49, 0x54, 0x38, 0x00}, // U+308B
+    {0x04, 0x07, 0x04, 0x0C, 0x16, 0x55, 0x24, 0x00}, // U+308C
+    {0x3F, 0x10, 0x08, 0x3C, 0x42, 0x41, 0x30, 0x00}, // U+308D
+    {0x00, 0x00, 0x08, 0x0E, 0x38, 0x4C, 0x2A, 0x00}, // U+308E
+    {0x04, 0x07, 0x04, 0x3C, 0x46, 0x45, 0x24, 0x00}, // U+308F
+    {0x0E, 0x08, 0x3C, 0x4A, 0x69, 0x55, 0x32, 0x00}, // U+3090
+    {0x06, 0x3C, 0x42, 0x39, 0x04, 0x36, 0x49, 0x00}, // U+3091
+    {0x04, 0x0F, 0x04, 0x6E, 0x11, 0x08, 0x70, 0x00}, // U+3092
+    {0x08, 0x08, 0x04, 0x0C, 0x56, 0x52, 0x21, 0x00}, // U+3093
+    {0x40, 0x2E, 0x00, 0x3C, 0x42, 0x40, 0x38, 0x00}, // U+3094
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+3095
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+3096
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+3097
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+3098
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+3099
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+309A
+    {0x40, 0x80, 0x20, 0x40, 0x00, 0x00, 0x00, 0x00}, // U+309B
+    {0x40, 0xA0, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+309C
+    {0x00, 0x00, 0x08, 0x08, 0x10, 0x30, 0x0C, 0x00}, // U+309D
+    {0x20, 0x40, 0x14, 0x24, 0x08, 0x18, 0x06, 0x00}, // U+309E
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // U+309F
+};
+
+static const uint8_t scg__font8x8_row_bounds[224][2] = {
+    {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+    {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+    {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+    {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+    {0, 0}, {0, 7}, {0, 2}, {0, 7}, {0, 7}, {1, 7}, {0, 7}, {0, 3},
+    {0, 7}, {0, 7}, {1, 6}, {1, 6}, {5, 8}, {3, 4}, {5, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {1, 7}, {1, 8}, {0, 7}, {2, 6}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 4}, {7, 8},
+    {0, 3}, {2, 7}, {0, 7}, {2, 7}, {0, 7}, {2, 7}, {0, 7}, {2, 8},
+    {0, 7}, {0, 7}, {0, 8}, {0, 7}, {0, 7}, {2, 7}, {2, 7}, {2, 7},
+    {2, 8}, {2, 8}, {2, 7}, {2, 7}, {0, 7}, {2, 7}, {2, 7}, {2, 7},
+    {2, 7}, {2, 8}, {2, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 2}, {0, 0},
+    {0, 0}, {0, 7}, {0, 7}, {3, 7}, {1, 7}, {1, 7}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {0, 7}, {1, 7}, {0, 7}, {2, 7}, {0, 7}, {0, 7}, {0, 7}, {1, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {3, 7}, {1, 7}, {0, 7}, {1, 7}, {1, 7},
+    {0, 7}, {0, 7}, {0, 7}, {1, 7}, {0, 7}, {0, 7}, {2, 7}, {1, 7},
+    {0, 7}, {0, 7}, {2, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7},
+    {2, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {1, 7},
+    {0, 7}, {1, 7}, {0, 7}, {2, 7}, {1, 7}, {2, 7}, {1, 7}, {1, 7},
+    {0, 7}, {0, 7}, {1, 7}, {0, 7}, {0, 7}, {0, 7}, {2, 7}, {0, 7},
+    {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 7}, {0, 0}, {0, 0}, {0, 0},
+    {0, 0}, {0, 0}, {0, 0}, {0, 4}, {0, 3}, {2, 7}, {0, 7}, {0, 0},
+};
+
+static const scg_font_range_t scg__font8x8_ranges[2] = {
+    {0x0000, 0x007F, 0},
+    {0x3040, 0x309F, 128},
+};
+
+static const scg__glyph_row_spans_t scg__glyph_row_spans[256] = {
+    {0, {0, 0, 0, 0}, {0, 0, 0, 0}}, // 0x00
+    {1, {0, 0, 0, 0}, {1, 0, 0, 0}}, // 0x01
+    {1, {1, 0, 0, 0}, {1, 0, 0, 0}}, // 0x02
+    {1, {0, 0, 0, 0}, {2, 0, 0, 0}}, // 0x03
+    {1, {2, 0, 0, 0}, {1, 0, 0, 0}}, // 0x04
+    {2, {0, 2, 0, 0}, {1, 1, 0, 0}}, // 0x05
+    {1, {1, 0, 0, 0}, {2, 0, 0, 0}}, // 0x06
+    {1, {0, 0, 0, 0}, {3, 0, 0, 0}}, // 0x07
+    {1, {3, 0, 0, 0}, {1, 0, 0, 0}}, // 0x08
+    {2, {0, 3, 0, 0}, {1, 1, 0, 0}}, // 0x09
+    {2, {1, 3, 0, 0}, {1, 1, 0, 0}}, // 0x0A
+    {2, {0, 3, 0, 0}, {2, 1, 0, 0}}, // 0x0B
+    {1, {2, 0, 0, 0}, {2, 0, 0, 0}}, // 0x0C
+    {2, {0, 2, 0, 0}, {1, 2, 0, 0}}, // 0x0D
+    {1, {1, 0, 0, 0}, {3, 0, 0, 0}}, // 0x0E
+    {1, {0, 0, 0, 0}, {4, 0, 0, 0}}, // 0x0F
+    {1, {4, 0, 0, 0}, {1, 0, 0, 0}}, // 0x10
+    {2, {0, 4, 0, 0}, {1, 1, 0, 0}}, // 0x11
+    {2, {1, 4, 0, 0}, {1, 1, 0, 0}}, // 0x12
+    {2, {0, 4, 0, 0}, {2, 1, 0, 0}}, // 0x13
+    {2, {2, 4, 0, 0}, {1, 1, 0, 0}}, // 0x14
+    {3, {0, 2, 4, 0}, {1, 1, 1, 0}}, // 0x15
+    {2, {1, 4, 0, 0}, {2, 1, 0, 0}}, // 0x16
+    {2, {0, 4, 0, 0}, {3, 1, 0, 0}}, // 0x17
+    {1, {3, 0, 0, 0}, {2, 0, 0, 0}}, // 0x18
+    {2, {0, 3, 0, 0}, {1, 2, 0, 0}}, // 0x19
+    {2, {1, 3, 0, 0}, {1, 2, 0, 0}}, // 0x1A
+    {2, {0, 3, 0, 0}, {2, 2, 0, 0}}, // 0x1B
+    {1, {2, 0, 0, 0}, {3, 0, 0, 0}}, // 0x1C
+    {2, {0, 2, 0, 0}, {1, 3, 0, 0}}, // 0x1D
+    {1, {1, 0, 0, 0}, {4, 0, 0, 0}}, // 0x1E
+    {1, {0, 0, 0, 0}, {5, 0, 0, 0}}, // 0x1F
+    {1, {5, 0, 0, 0}, {1, 0, 0, 0}}, // 0x20
+    {2, {0, 5, 0, 0}, {1, 1, 0, 0}}, // 0x21
+    {2, {1, 5, 0, 0}, {1, 1, 0, 0}}, // 0x22
+    {2, {0, 5, 0, 0}, {2, 1, 0, 0}}, // 0x23
+    {2, {2, 5, 0, 0}, {1, 1, 0, 0}}, // 0x24
+    {3, {0, 2, 5, 0}, {1, 1, 1, 0}}, // 0x25
+    {2, {1, 5, 0, 0}, {2, 1, 0, 0}}, // 0x26
+    {2, {0, 5, 0, 0}, {3, 1, 0, 0}}, // 0x27
+    {2, {3, 5, 0, 0}, {1, 1, 0, 0}}, // 0x28
+    {3, {0, 3, 5, 0}, {1, 1, 1, 0}}, // 0x29
+    {3, {1, 3, 5, 0}, {1, 1, 1, 0}}, // 0x2A
+    {3, {0, 3, 5, 0}, {2, 1, 1, 0}}, // 0x2B
+    {2, {2, 5, 0, 0}, {2, 1, 0, 0}}, // 0x2C
+    {3, {0, 2, 5, 0}, {1, 2, 1, 0}}, // 0x2D
+    {2, {1, 5, 0, 0}, {3, 1, 0, 0}}, // 0x2E
+    {2, {0, 5, 0, 0}, {4, 1, 0, 0}}, // 0x2F
+    {1, {4, 0, 0, 0}, {2, 0, 0, 0}}, // 0x30
+    {2, {0, 4, 0, 0}, {1, 2, 0, 0}}, // 0x31
+    {2, {1, 4, 0, 0}, {1, 2, 0, 0}}, // 0x32
+    {2, {0, 4, 0, 0}, {2, 2, 0, 0}}, // 0x33
+    {2, {2, 4, 0, 0}, {1, 2, 0, 0}}, // 0x34
+    {3, {0, 2, 4, 0}, {1, 1, 2, 0}}, // 0x35
+    {2, {1, 4, 0, 0}, {2, 2, 0, 0}}, // 0x36
+    {2, {0, 4, 0, 0}, {3, 2, 0, 0}}, // 0x37
+    {1, {3, 0, 0, 0}, {3, 0, 0, 0}}, // 0x38
+    {2, {0, 3, 0, 0}, {1, 3, 0, 0}}, // 0x39
+    {2, {1, 3, 0, 0}, {1, 3, 0, 0}}, // 0x3A
+    {2, {0, 3, 0, 0}, {2, 3, 0, 0}}, // 0x3B
+    {1, {2, 0, 0, 0}, {4, 0, 0, 0}}, // 0x3C
+    {2, {0, 2, 0, 0}, {1, 4, 0, 0}}, // 0x3D
+    {1, {1, 0, 0, 0}, {5, 0, 0, 0}}, // 0x3E
+    {1, {0, 0, 0, 0}, {6, 0, 0, 0}}, // 0x3F
+    {1, {6, 0, 0, 0}, {1, 0, 0, 0}}, // 0x40
+    {2, {0, 6, 0, 0}, {1, 1, 0, 0}}, // 0x41
+    {2, {1, 6, 0, 0}, {1, 1, 0, 0}}, // 0x42
+    {2, {0, 6, 0, 0}, {2, 1, 0, 0}}, // 0x43
+    {2, {2, 6, 0, 0}, {1, 1, 0, 0}}, // 0x44
+    {3, {0, 2, 6, 0}, {1, 1, 1, 0}}, // 0x45
+    {2, {1, 6, 0, 0}, {2, 1, 0, 0}}, // 0x46
+    {2, {0, 6, 0, 0}, {3, 1, 0, 0}}, // 0x47
+    {2, {3, 6, 0, 0}, {1, 1, 0, 0}}, // 0x48
+    {3, {0, 3, 6, 0}, {1, 1, 1, 0}}, // 0x49
+    {3, {1, 3, 6, 0}, {1, 1, 1, 0}}, // 0x4A
+    {3, {0, 3, 6, 0}, {2, 1, 1, 0}}, // 0x4B
+    {2, {2, 6, 0, 0}, {2, 1, 0, 0}}, // 0x4C
+    {3, {0, 2, 6, 0}, {1, 2, 1, 0}}, // 0x4D
+    {2, {1, 6, 0, 0}, {3, 1, 0, 0}}, // 0x4E
+    {2, {0, 6, 0, 0}, {4, 1, 0, 0}}, // 0x4F
+    {2, {4, 6, 0, 0}, {1, 1, 0, 0}}, // 0x50
+    {3, {0, 4, 6, 0}, {1, 1, 1, 0}}, // 0x51
+    {3, {1, 4, 6, 0}, {1, 1, 1, 0}}, // 0x52
+    {3, {0, 4, 6, 0}, {2, 1, 1, 0}}, // 0x53
+    {3, {2, 4, 6, 0}, {1, 1, 1, 0}}, // 0x54
+    {4, {0, 2, 4, 6}, {1, 1, 1, 1}}, // 0x55
+    {3, {1, 4, 6, 0}, {2, 1, 1, 0}}, // 0x56
+    {3, {0, 4, 6, 0}, {3, 1, 1, 0}}, // 0x57
+    {2, {3, 6, 0, 0}, {2, 1, 0, 0}}, // 0x58
+    {3, {0, 3, 6, 0}, {1, 2, 1, 0}}, // 0x59
+    {3, {1, 3, 6, 0}, {1, 2, 1, 0}}, // 0x5A
+    {3, {0, 3, 6, 0}, {2, 2, 1, 0}}, // 0x5B
+    {2, {2, 6, 0, 0}, {3, 1, 0, 0}}, // 0x5C
+    {3, {0, 2, 6, 0}, {1, 3, 1, 0}}, // 0x5D
+    {2, {1, 6, 0, 0}, {4, 1, 0, 0}}, // 0x5E
+    {2, {0, 6, 0, 0}, {5, 1, 0, 0}}, // 0x5F
+    {1, {5, 0, 0, 0}, {2, 0, 0, 0}}, // 0x60
+    {2, {0, 5, 0, 0}, {1, 2, 0, 0}}, // 0x61
+    {2, {1, 5, 0, 0}, {1, 2, 0, 0}}, // 0x62
+    {2, {0, 5, 0, 0}, {2, 2, 0, 0}}, // 0x63
+    {2, {2, 5, 0, 0}, {1, 2, 0, 0}}, // 0x64
+    {3, {0, 2, 5, 0}, {1, 1, 2, 0}}, // 0x65
+    {2, {1, 5, 0, 0}, {2, 2, 0, 0}}, // 0x66
+    {2, {0, 5, 0, 0}, {3, 2, 0, 0}}, // 0x67
+    {2, {3, 5, 0, 0}, {1, 2, 0, 0}}, // 0x68
+    {3, {0, 3, 5, 0}, {1, 1, 2, 0}}, // 0x69
+    {3, {1, 3, 5, 0}, {1, 1, 2, 0}}, // 0x6A
+    {3, {0, 3, 5, 0}, {2, 1, 2, 0}}, // 0x6B
+    {2, {2, 5, 0, 0}, {2, 2, 0, 0}}, // 0x6C
+    {3, {0, 2, 5, 0}, {1, 2, 2, 0}}, // 0x6D
+    {2, {1, 5, 0, 0}, {3, 2, 0, 0}}, // 0x6E
+    {2, {0, 5, 0, 0}, {4, 2, 0, 0}}, // 0x6F
+    {1, {4, 0, 0, 0}, {3, 0, 0, 0}}, // 0x70
+    {2, {0, 4, 0, 0}, {1, 3, 0, 0}}, // 0x71
+    {2, {1, 4, 0, 0}, {1, 3, 0, 0}}, // 0x72
+    {2, {0, 4, 0, 0}, {2, 3, 0, 0}}, // 0x73
+    {2, {2, 4, 0, 0}, {1, 3, 0, 0}}, // 0x74
+    {3, {0, 2, 4, 0}, {1, 1, 3, 0}}, // 0x75
+    {2, {1, 4, 0, 0}, {2, 3, 0, 0}}, // 0x76
+    {2, {0, 4, 0, 0}, {3, 3, 0, 0}}, // 0x77
+    {1, {3, 0, 0, 0}, {4, 0, 0, 0}}, // 0x78
+    {2, {0, 3, 0, 0}, {1, 4, 0, 0}}, // 0x79
+    {2, {1, 3, 0, 0}, {1, 4, 0, 0}}, // 0x7A
+    {2, {0, 3, 0, 0}, {2, 4, 0, 0}}, // 0x7B
+    {1, {2, 0, 0, 0}, {5, 0, 0, 0}}, // 0x7C
+    {2, {0, 2, 0, 0}, {1, 5, 0, 0}}, // 0x7D
+    {1, {1, 0, 0, 0}, {6, 0, 0, 0}}, // 0x7E
+    {1, {0, 0, 0, 0}, {7, 0, 0, 0}}, // 0x7F
+    {1, {7, 0, 0, 0}, {1, 0, 0, 0}}, // 0x80
+    {2, {0, 7, 0, 0}, {1, 1, 0, 0}}, // 0x81
+    {2, {1, 7, 0, 0}, {1, 1, 0, 0}}, // 0x82
+    {2, {0, 7, 0, 0}, {2, 1, 0, 0}}, // 0x83
+    {2, {2, 7, 0, 0}, {1, 1, 0, 0}}, // 0x84
+    {3, {0, 2, 7, 0}, {1, 1, 1, 0}}, // 0x85
+    {2, {1, 7, 0, 0}, {2, 1, 0, 0}}, // 0x86
+    {2, {0, 7, 0, 0}, {3, 1, 0, 0}}, // 0x87
+    {2, {3, 7, 0, 0}, {1, 1, 0, 0}}, // 0x88
+    {3, {0, 3, 7, 0}, {1, 1, 1, 0}}, // 0x89
+    {3, {1, 3, 7, 0}, {1, 1, 1, 0}}, // 0x8A
+    {3, {0, 3, 7, 0}, {2, 1, 1, 0}}, // 0x8B
+    {2, {2, 7, 0, 0}, {2, 1, 0, 0}}, // 0x8C
+    {3, {0, 2, 7, 0}, {1, 2, 1, 0}}, // 0x8D
+    {2, {1, 7, 0, 0}, {3, 1, 0, 0}}, // 0x8E
+    {2, {0, 7, 0, 0}, {4, 1, 0, 0}}, // 0x8F
+    {2, {4, 7, 0, 0}, {1, 1, 0, 0}}, // 0x90
+    {3, {0, 4, 7, 0}, {1, 1, 1, 0}}, // 0x91
+    {3, {1, 4, 7, 0}, {1, 1, 1, 0}}, // 0x92
+    {3, {0, 4, 7, 0}, {2, 1, 1, 0}}, // 0x93
+    {3, {2, 4, 7, 0}, {1, 1, 1, 0}}, // 0x94
+    {4, {0, 2, 4, 7}, {1, 1, 1, 1}}, // 0x95
+    {3, {1, 4, 7, 0}, {2, 1, 1, 0}}, // 0x96
+    {3, {0, 4, 7, 0}, {3, 1, 1, 0}}, // 0x97
+    {2, {3, 7, 0, 0}, {2, 1, 0, 0}}, // 0x98
+    {3, {0, 3, 7, 0}, {1, 2, 1, 0}}, // 0x99
+    {3, {1, 3, 7, 0}, {1, 2, 1, 0}}, // 0x9A
+    {3, {0, 3, 7, 0}, {2, 2, 1, 0}}, // 0x9B
+    {2, {2, 7, 0, 0}, {3, 1, 0, 0}}, // 0x9C
+    {3, {0, 2, 7, 0}, {1, 3, 1, 0}}, // 0x9D
+    {2, {1, 7, 0, 0}, {4, 1, 0, 0}}, // 0x9E
+    {2, {0, 7, 0, 0}, {5, 1, 0, 0}}, // 0x9F
+    {2, {5, 7, 0, 0}, {1, 1, 0, 0}}, // 0xA0
+    {3, {0, 5, 7, 0}, {1, 1, 1, 0}}, // 0xA1
+    {3, {1, 5, 7, 0}, {1, 1, 1, 0}}, // 0xA2
+    {3, {0, 5, 7, 0}, {2, 1, 1, 0}}, // 0xA3
+    {3, {2, 5, 7, 0}, {1, 1, 1, 0}}, // 0xA4
+    {4, {0, 2, 5, 7}, {1, 1, 1, 1}}, // 0xA5
+    {3, {1, 5, 7, 0}, {2, 1, 1, 0}}, // 0xA6
+    {3, {0, 5, 7, 0}, {3, 1, 1, 0}}, // 0xA7
+    {3, {3, 5, 7, 0}, {1, 1, 1, 0}}, // 0xA8
+    {4, {0, 3, 5, 7}, {1, 1, 1, 1}}, // 0xA9
+    {4, {1, 3, 5, 7}, {1, 1, 1, 1}}, // 0xAA
+    {4, {0, 3, 5, 7}, {2, 1, 1, 1}}, // 0xAB
+    {3, {2, 5, 7, 0}, {2, 1, 1, 0}}, // 0xAC
+    {4, {0, 2, 5, 7}, {1, 2, 1, 1}}, // 0xAD
+    {3, {1, 5, 7, 0}, {3, 1, 1, 0}}, // 0xAE
+    {3, {0, 5, 7, 0}, {4, 1, 1, 0}}, // 0xAF
+    {2, {4, 7, 0, 0}, {2, 1, 0, 0}}, // 0xB0
+    {3, {0, 4, 7, 0}, {1, 2, 1, 0}}, // 0xB1
+    {3, {1, 4, 7, 0}, {1, 2, 1, 0}}, // 0xB2
+    {3, {0, 4, 7, 0}, {2, 2, 1, 0}}, // 0xB3
+    {3, {2, 4, 7, 0}, {1, 2, 1, 0}}, // 0xB4
+    {4, {0, 2, 4, 7}, {1, 1, 2, 1}}, // 0xB5
+    {3, {1, 4, 7, 0}, {2, 2, 1, 0}}, // 0xB6
+    {3, {0, 4, 7, 0}, {3, 2, 1, 0}}, // 0xB7
+    {2, {3, 7, 0, 0}, {3, 1, 0, 0}}, // 0xB8
+    {3, {0, 3, 7, 0}, {1, 3, 1, 0}}, // 0xB9
+    {3, {1, 3, 7, 0}, {1, 3, 1, 0}}, // 0xBA
+    {3, {0, 3, 7, 0}, {2, 3, 1, 0}}, // 0xBB
+    {2, {2, 7, 0, 0}, {4, 1, 0, 0}}, // 0xBC
+    {3, {0, 2, 7, 0}, {1, 4, 1, 0}}, // 0xBD
+    {2, {1, 7, 0, 0}, {5, 1, 0, 0}}, // 0xBE
+    {2, {0, 7, 0, 0}, {6, 1, 0, 0}}, // 0xBF
+    {1, {6, 0, 0, 0}, {2, 0, 0, 0}}, // 0xC0
+    {2, {0, 6, 0, 0}, {1, 2, 0, 0}}, // 0xC1
+    {2, {1, 6, 0, 0}, {1, 2, 0, 0}}, // 0xC2
+    {2, {0, 6, 0, 0}, {2, 2, 0, 0}}, // 0xC3
+    {2, {2, 6, 0, 0}, {1, 2, 0, 0}}, // 0xC4
+    {3, {0, 2, 6, 0}, {1, 1, 2, 0}}, // 0xC5
+    {2, {1, 6, 0, 0}, {2, 2, 0, 0}}, // 0xC6
+    {2, {0, 6, 0, 0}, {3, 2, 0, 0}}, // 0xC7
+    {2, {3, 6, 0, 0}, {1, 2, 0, 0}}, // 0xC8
+    {3, {0, 3, 6, 0}, {1, 1, 2, 0}}, // 0xC9
+    {3, {1, 3, 6, 0}, {1, 1, 2, 0}}, // 0xCA
+    {3, {0, 3, 6, 0}, {2, 1, 2, 0}}, // 0xCB
+    {2, {2, 6, 0, 0}, {2, 2, 0, 0}}, // 0xCC
+    {3, {0, 2, 6, 0}, {1, 2, 2, 0}}, // 0xCD
+    {2, {1, 6, 0, 0}, {3, 2, 0, 0}}, // 0xCE
+    {2, {0, 6, 0, 0}, {4, 2, 0, 0}}, // 0xCF
+    {2, {4, 6, 0, 0}, {1, 2, 0, 0}}, // 0xD0
+    {3, {0, 4, 6, 0}, {1, 1, 2, 0}}, // 0xD1
+    {3, {1, 4, 6, 0}, {1, 1, 2, 0}}, // 0xD2
+    {3, {0, 4, 6, 0}, {2, 1, 2, 0}}, // 0xD3
+    {3, {2, 4, 6, 0}, {1, 1, 2, 0}}, // 0xD4
+    {4, {0, 2, 4, 6}, {1, 1, 1, 2}}, // 0xD5
+    {3, {1, 4, 6, 0}, {2, 1, 2, 0}}, // 0xD6
+    {3, {0, 4, 6, 0}, {3, 1, 2, 0}}, // 0xD7
+    {2, {3, 6, 0, 0}, {2, 2, 0, 0}}, // 0xD8
+    {3, {0, 3, 6, 0}, {1, 2, 2, 0}}, // 0xD9
+    {3, {1, 3, 6, 0}, {1, 2, 2, 0}}, // 0xDA
+    {3, {0, 3, 6, 0}, {2, 2, 2, 0}}, // 0xDB
+    {2, {2, 6, 0, 0}, {3, 2, 0, 0}}, // 0xDC
+    {3, {0, 2, 6, 0}, {1, 3, 2, 0}}, // 0xDD
+    {2, {1, 6, 0, 0}, {4, 2, 0, 0}}, // 0xDE
+    {2, {0, 6, 0, 0}, {5, 2, 0, 0}}, // 0xDF
+    {1, {5, 0, 0, 0}, {3, 0, 0, 0}}, // 0xE0
+    {2, {0, 5, 0, 0}, {1, 3, 0, 0}}, // 0xE1
+    {2, {1, 5, 0, 0}, {1, 3, 0, 0}}, // 0xE2
+    {2, {0, 5, 0, 0}, {2, 3, 0, 0}}, // 0xE3
+    {2, {2, 5, 0, 0}, {1, 3, 0, 0}}, // 0xE4
+    {3, {0, 2, 5, 0}, {1, 1, 3, 0}}, // 0xE5
+    {2, {1, 5, 0, 0}, {2, 3, 0, 0}}, // 0xE6
+    {2, {0, 5, 0, 0}, {3, 3, 0, 0}}, // 0xE7
+    {2, {3, 5, 0, 0}, {1, 3, 0, 0}}, // 0xE8
+    {3, {0, 3, 5, 0}, {1, 1, 3, 0}}, // 0xE9
+    {3, {1, 3, 5, 0}, {1, 1, 3, 0}}, // 0xEA
+    {3, {0, 3, 5, 0}, {2, 1, 3, 0}}, // 0xEB
+    {2, {2, 5, 0, 0}, {2, 3, 0, 0}}, // 0xEC
+    {3, {0, 2, 5, 0}, {1, 2, 3, 0}}, // 0xED
+    {2, {1, 5, 0, 0}, {3, 3, 0, 0}}, // 0xEE
+    {2, {0, 5, 0, 0}, {4, 3, 0, 0}}, // 0xEF
+    {1, {4, 0, 0, 0}, {4, 0, 0, 0}}, // 0xF0
+    {2, {0, 4, 0, 0}, {1, 4, 0, 0}}, // 0xF1
+    {2, {1, 4, 0, 0}, {1, 4, 0, 0}}, // 0xF2
+    {2, {0, 4, 0, 0}, {2, 4, 0, 0}}, // 0xF3
+    {2, {2, 4, 0, 0}, {1, 4, 0, 0}}, // 0xF4
+    {3, {0, 2, 4, 0}, {1, 1, 4, 0}}, // 0xF5
+    {2, {1, 4, 0, 0}, {2, 4, 0, 0}}, // 0xF6
+    {2, {0, 4, 0, 0}, {3, 4, 0, 0}}, // 0xF7
+    {1, {3, 0, 0, 0}, {5, 0, 0, 0}}, // 0xF8
+    {2, {0, 3, 0, 0}, {1, 5, 0, 0}}, // 0xF9
+    {2, {1, 3, 0, 0}, {1, 5, 0, 0}}, // 0xFA
+    {2, {0, 3, 0, 0}, {2, 5, 0, 0}}, // 0xFB
+    {1, {2, 0, 0, 0}, {6, 0, 0, 0}}, // 0xFC
+    {2, {0, 2, 0, 0}, {1, 6, 0, 0}}, // 0xFD
+    {1, {1, 0, 0, 0}, {7, 0, 0, 0}}, // 0xFE
+    {1, {0, 0, 0, 0}, {8, 0, 0, 0}}, // 0xFF
+};
+// END GENERATED FONT TABLES
+
+const scg_font_t scg_font8x8 = {
+    .glyph_width = SCG_FONT_SIZE,
+    .glyph_height = SCG_FONT_SIZE,
+    .bytes_per_row = 1,
+    .num_glyphs = sizeof(scg__font8x8_bitmaps) / sizeof(*scg__font8x8_bitmaps),
+    .bitmaps = &scg__font8x8_bitmaps[0][0],
+    .row_bounds = &scg__font8x8_row_bounds[0][0],
+    .coverage = NULL,
+    .num_ranges = sizeof(scg__font8x8_ranges) / sizeof(*scg__font8x8_ranges),
+    .ranges = scg__font8x8_ranges,
+    .pages = NULL,
+    .fallback_glyph = SCG__FONT_CHAR_CODE_QUESTION_MARK,
+    .owns_data = false};
 
 #endif // SCG_IMPLEMENTATION
@@ -0,0 +1,213 @@
+// Generates the constant glyph tables compiled into scg.h from raw 8x8 bitmap
+// font files, so fonts never need to be decoded at runtime.
+//
+// Each font file holds 8 bytes per glyph, one byte per row, where bit j of a
+// row is the pixel at x + j. Every file is given with the code point of its
+// first glyph, and the glyphs of all files are written to one table along
+// with the range of non-empty rows of each glyph.
+//
+// Usage:
+// font_tables [-s] NAME FILE:FIRST_CODE [FILE:FIRST_CODE ...]
+//
+// -s also writes the table mapping each row byte to its spans of set pixels.
+//
+// `make fonts` runs this for the built-in fonts and splices the output into
+// scg.h. It can be run by hand to generate tables for other fonts, which can
+// then be used through an scg_font_t without decoding anything at startup.
+// Fonts of other sizes can be loaded at runtime with scg_font_new_from_bdf,
+// scg_font_new_from_psf and scg_font_new_from_raw.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FONT_SIZE 8
+#define MAX_FILES 16
+
+typedef struct font_file_t {
+    uint8_t *bitmaps;
+    int num_glyphs;
+    unsigned long first_code;
+} font_file_t;
+
+static bool load_font_file(font_file_t *file, const char *arg) {
+    char path[1024];
+    const char *separator = strrchr(arg, ':');
+    if (separator == NULL || (size_t)(separator - arg) >= sizeof(path)) {
+        fprintf(stderr, "Expected FILE:FIRST_CODE, got %s\n", arg);
+        return false;
+    }
+
+    memcpy(path, arg, separator - arg);
+    path[separator - arg] = '\0';
+    file->first_code = strtoul(separator + 1, NULL, 0);
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Failed to open font file %s\n", path);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size % FONT_SIZE != 0) {
+        fprintf(stderr, "Font file %s is not a multiple of %d bytes\n", path,
+                FONT_SIZE);
+        fclose(fp);
+        return false;
+    }
+
+    file->bitmaps = malloc(size);
+    if (file->bitmaps == NULL ||
+        fread(file->bitmaps, 1, size, fp) != (size_t)size) {
+        fprintf(stderr, "Failed to read font file %s\n", path);
+        free(file->bitmaps);
+        fclose(fp);
+        return false;
+    }
+
+    file->num_glyphs = (int)(size / FONT_SIZE);
+    fclose(fp);
+
+    return true;
+}
+
+static void write_glyphs(const char *name, font_file_t *files, int num_files) {
+    int num_glyphs = 0;
+    for (int i = 0; i < num_files; i++) {
+        num_glyphs += files[i].num_glyphs;
+    }
+
+    printf("static const uint8_t %s_bitmaps[%d][%d] = {\n", name, num_glyphs,
+           FONT_SIZE);
+
+    for (int i = 0; i < num_files; i++) {
+        for (int j = 0; j < files[i].num_glyphs; j++) {
+            const uint8_t *rows = files[i].bitmaps + j * FONT_SIZE;
+
+            printf("    {");
+            for (int k = 0; k < FONT_SIZE; k++) {
+                printf("0x%02X%s", rows[k], k < FONT_SIZE - 1 ? ", " : "");
+            }
+            printf("}, // U+%04lX\n", files[i].first_code + j);
+        }
+    }
+
+    printf("};\n\n");
+
+    printf("static const uint8_t %s_row_bounds[%d][2] = {", name, num_glyphs);
+
+    int glyph = 0;
+    for (int i = 0; i < num_files; i++) {
+        for (int j = 0; j < files[i].num_glyphs; j++, glyph++) {
+            const uint8_t *rows = files[i].bitmaps + j * FONT_SIZE;
+            int first_row = FONT_SIZE;
+            int last_row = 0;
+
+            for (int k = 0; k < FONT_SIZE; k++) {
+                if (rows[k] != 0) {
+                    first_row = first_row < k ? first_row : k;
+                    last_row = k + 1;
+                }
+            }
+            if (last_row == 0) {
+                first_row = 0;
+            }
+
+            printf("%s{%d, %d},", glyph % 8 == 0 ? "\n    " : " ", first_row,
+                   last_row);
+        }
+    }
+
+    printf("\n};\n\n");
+
+    printf("static const scg_font_range_t %s_ranges[%d] = {\n", name,
+           num_files);
+
+    int first_glyph = 0;
+    for (int i = 0; i < num_files; i++) {
+        printf("    {0x%04lX, 0x%04lX, %d},\n", files[i].first_code,
+               files[i].first_code + files[i].num_glyphs - 1, first_glyph);
+        first_glyph += files[i].num_glyphs;
+    }
+
+    printf("};\n");
+}
+
+static void write_row_spans(void) {
+    printf("\nstatic const scg__glyph_row_spans_t scg__glyph_row_spans[256] = "
+           "{\n");
+
+    for (int bits = 0; bits < 256; bits++) {
+        int starts[FONT_SIZE / 2] = {0};
+        int lengths[FONT_SIZE / 2] = {0};
+        int num_spans = 0;
+
+        for (int j = 0; j < FONT_SIZE;) {
+            if (!(bits & 1 << j)) {
+                j++;
+                continue;
+            }
+
+            int start = j;
+            while (j < FONT_SIZE && (bits & 1 << j)) {
+                j++;
+            }
+
+            starts[num_spans] = start;
+            lengths[num_spans] = j - start;
+            num_spans++;
+        }
+
+        printf("    {%d, {%d, %d, %d, %d}, {%d, %d, %d, %d}}, // 0x%02X\n",
+               num_spans, starts[0], starts[1], starts[2], starts[3],
+               lengths[0], lengths[1], lengths[2], lengths[3], bits);
+    }
+
+    printf("};\n");
+}
+
+int main(int argc, char *argv[]) {
+    bool row_spans = false;
+    int arg = 1;
+
+    if (arg < argc && strcmp(argv[arg], "-s") == 0) {
+        row_spans = true;
+        arg++;
+    }
+
+    if (argc - arg < 2 || argc - arg - 1 > MAX_FILES) {
+        fprintf(stderr,
+                "Usage: %s [-s] NAME FILE:FIRST_CODE [FILE:FIRST_CODE ...]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *name = argv[arg++];
+
+    font_file_t files[MAX_FILES];
+    int num_files = 0;
+    for (; arg < argc; arg++) {
+        if (!load_font_file(&files[num_files], argv[arg])) {
+            return EXIT_FAILURE;
+        }
+        num_files++;
+    }
+
+    printf("// Generated by tools/font_tables.c, do not edit by hand.\n\n");
+
+    write_glyphs(name, files, num_files);
+    if (row_spans) {
+        write_row_spans();
+    }
+
+    for (int i = 0; i < num_files; i++) {
+        free(files[i].bitmaps);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+// Runs examples headless for a fixed number of frames at a fixed time step
+// and compares the last frame of each with a golden image, so changes to the
+// renderers can be checked for visual regressions.
+//
+// Each example is run from the working directory as ./NAME with
+// SCG_HEADLESS_FRAMES and SCG_HEADLESS_OUTPUT set, and its frame is compared
+// with GOLDEN_DIR/NAME.png. Pixels are compared in YIQ space, which weighs
+// differences in brightness and colour roughly as the eye does. A pixel
+// differs when its difference is over the threshold, from 0 to 1, and an
+// example fails when more than the given percentage of its pixels differ.
+// The frame of a failing example is kept as GOLDEN_DIR/NAME.actual.png,
+// along with GOLDEN_DIR/NAME.diff.png which marks the differing pixels in
+// red.
+//
+// The time each example took to render its frames, as logged by the
+// example, is reported with its result.
+//
+// Usage:
+// golden [-u] [-f FRAMES] [-t THRESHOLD] [-p PERCENT] GOLDEN_DIR NAME ...
+//
+// -u saves the frames as the new golden images instead of comparing them.
+//
+// `make test` runs this for the examples and `make golden` updates the
+// golden images.
+
+#define _POSIX_C_SOURCE 200809L
+
+#define SCG_IMPLEMENTATION
+#include "../scg.h"
+
+#define DEFAULT_FRAMES 120
+#define DEFAULT_THRESHOLD 0.1
+#define DEFAULT_PERCENT 0.1
+#define MAX_PATH_SIZE 1024
+#define MAX_LINE_SIZE 1024
+
+// The largest difference between two colours in YIQ space.
+#define MAX_YIQ_DELTA 35215.0
+
+typedef struct options_t {
+    bool update;
+    int num_frames;
+    double threshold;
+    double percent;
+    const char *golden_dir;
+} options_t;
+
+// Runs an example until it saves its last frame, and reads how long the
+// frames took to render from its log. The rest of the log is only shown if
+// the example fails.
+static bool run_example(const char *name, int num_frames, const char *output,
+                        double *render_time_ms) {
+    char command[MAX_PATH_SIZE * 2];
+    snprintf(command, sizeof(command),
+             "SCG_HEADLESS_FRAMES=%d SCG_HEADLESS_OUTPUT='%s' ./%s 2>&1",
+             num_frames, output, name);
+
+    remove(output);
+
+    FILE *pipe = popen(command, "r");
+    if (pipe == NULL) {
+        fprintf(stderr, "Failed to run %s\n", name);
+        return false;
+    }
+
+    char log[MAX_LINE_SIZE * 8] = "";
+    char line[MAX_LINE_SIZE];
+    *render_time_ms = -1.0;
+
+    while (fgets(line, sizeof(line), pipe) != NULL) {
+        const char *rendered = strstr(line, "Rendered ");
+        int frames;
+
+        if (rendered == NULL ||
+            sscanf(rendered, "Rendered %d frames in %lf ms", &frames,
+                   render_time_ms) != 2) {
+            strncat(log, line, sizeof(log) - strlen(log) - 1);
+        }
+    }
+
+    int status = pclose(pipe);
+    if (status != 0 || *render_time_ms < 0.0) {
+        fprintf(stderr, "%s failed with status %d\n%s", name, status, log);
+        return false;
+    }
+
+    return true;
+}
+
+static double yiq_delta(uint32_t a, uint32_t b) {
+    double dr = (double)(a >> 16 & 0xFF) - (double)(b >> 16 & 0xFF);
+    double dg = (double)(a >> 8 & 0xFF) - (double)(b >> 8 & 0xFF);
+    double db = (double)(a & 0xFF) - (double)(b & 0xFF);
+
+    double y = dr * 0.29889531 + dg * 0.58662247 + db * 0.11448223;
+    double i = dr * 0.59597799 - dg * 0.27417610 - db * 0.32180189;
+    double q = dr * 0.21147017 - dg * 0.52261711 + db * 0.31114694;
+
+    return 0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q;
+}
+
+// Counts the pixels that differ by more than the threshold, drawing them in
+// red over a faded copy of the golden image.
+static int compare_images(scg_image_t *golden, scg_image_t *actual,
+                          double threshold, scg_image_t *diff) {
+    double max_delta = threshold * threshold * MAX_YIQ_DELTA;
+    int num_different = 0;
+
+    for (int y = 0; y < golden->height; y++) {
+        const uint32_t *golden_row = scg__image_row(golden, y);
+        const uint32_t *actual_row = scg__image_row(actual, y);
+        uint32_t *diff_row = scg__image_row(diff, y);
+
+        for (int x = 0; x < golden->width; x++) {
+            if (yiq_delta(golden_row[x], actual_row[x]) > max_delta) {
+                diff_row[x] = 0xFFFF0000;
+                num_different++;
+                continue;
+            }
+
+            uint32_t pixel = golden_row[x];
+            uint32_t luma = ((pixel >> 16 & 0xFF) * 77 +
+                             (pixel >> 8 & 0xFF) * 150 + (pixel & 0xFF) * 29) >>
+                            8;
+            uint32_t faded = 192 + luma / 4;
+            diff_row[x] = 0xFF000000 | faded << 16 | faded << 8 | faded;
+        }
+    }
+
+    return num_different;
+}
+
+static bool test_example(const options_t *options, const char *name) {
+    char golden_path[MAX_PATH_SIZE];
+    char actual_path[MAX_PATH_SIZE];
+    char diff_path[MAX_PATH_SIZE];
+    snprintf(golden_path, sizeof(golden_path), "%s/%s.png",
+             options->golden_dir, name);
+    snprintf(actual_path, sizeof(actual_path), "%s/%s.actual.png",
+             options->golden_dir, name);
+    snprintf(diff_path, sizeof(diff_path), "%s/%s.diff.png",
+             options->golden_dir, name);
+
+    double render_time_ms;
+
+    if (options->update) {
+        if (!run_example(name, options->num_frames, golden_path,
+                         &render_time_ms)) {
+            return false;
+        }
+
+        printf("%-16s SAVED %10.2f ms  %s\n", name, render_time_ms,
+               golden_path);
+        return true;
+    }
+
+    remove(diff_path);
+    if (!run_example(name, options->num_frames, actual_path,
+                     &render_time_ms)) {
+        printf("%-16s FAIL\n", name);
+        return false;
+    }
+
+    scg_image_t *golden = scg_image_new_from_file(golden_path);
+    scg_image_t *actual = scg_image_new_from_file(actual_path);
+    if (golden == NULL || actual == NULL ||
+        golden->width != actual->width || golden->height != actual->height) {
+        printf("%-16s FAIL %10.2f ms  %s\n", name, render_time_ms,
+               golden == NULL ? "no golden image" : "size differs");
+
+        if (golden != NULL) {
+            scg_image_free(golden);
+        }
+        if (actual != NULL) {
+            scg_image_free(actual);
+        }
+        return false;
+    }
+
+    scg_image_t *diff = scg_image_new(golden->width, golden->height);
+    int num_different =
+        compare_images(golden, actual, options->threshold, diff);
+    double percent =
+        100.0 * num_different / ((double)golden->width * golden->height);
+    bool passed = percent <= options->percent;
+
+    printf("%-16s %-5s %10.2f ms  %.3f%% of pixels differ\n", name,
+           passed ? "PASS" : "FAIL", render_time_ms, percent);
+
+    if (passed) {
+        remove(actual_path);
+    } else {
+        scg_image_save_to_png(diff, diff_path);
+    }
+
+    scg_image_free(diff);
+    scg_image_free(actual);
+    scg_image_free(golden);
+
+    return passed;
+}
+
+int main(int argc, char *argv[]) {
+    options_t options = {false, DEFAULT_FRAMES, DEFAULT_THRESHOLD,
+                         DEFAULT_PERCENT, NULL};
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-u") == 0) {
+            options.update = true;
+        } else if (arg + 1 < argc && strcmp(argv[arg], "-f") == 0) {
+            options.num_frames = atoi(argv[++arg]);
+        } else if (arg + 1 < argc && strcmp(argv[arg], "-t") == 0) {
+            options.threshold = atof(argv[++arg]);
+        } else if (arg + 1 < argc && strcmp(argv[arg], "-p") == 0) {
+            options.percent = atof(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+
+    if (argc - arg < 2 || options.num_frames <= 0) {
+        fprintf(stderr,
+                "Usage: %s [-u] [-f FRAMES] [-t THRESHOLD] [-p PERCENT] "
+                "GOLDEN_DIR NAME ...\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    options.golden_dir = argv[arg++];
+
+    int num_examples = argc - arg;
+    int num_failed = 0;
+    for (; arg < argc; arg++) {
+        if (!test_example(&options, argv[arg])) {
+            num_failed++;
+        }
+    }
+
+    if (!options.update) {
+        printf("%d of %d examples passed\n", num_examples - num_failed,
+               num_examples);
+    }
+
+    return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
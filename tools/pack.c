@@ -0,0 +1,392 @@
+// Packs the assets of a directory into a single file that scg_pack_t maps
+// into memory, so nothing is decoded or converted at startup.
+//
+// Images (BMP, PNG, QOI and TGA) are decoded to ARGB8888 pixels. Sounds
+// (WAV) are converted to 16 bit stereo at the given rate, which should be
+// the rate of the audio device so they can be played straight from the
+// pack. Fonts (PSF and BDF) keep their glyphs and code points. Each asset
+// is named by its path relative to the directory, and other files are
+// skipped.
+//
+// Usage:
+// pack [-r RATE] OUTPUT DIRECTORY
+//
+// `make pack` packs the assets directory into assets.pack.
+
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define SCG_IMPLEMENTATION
+#include "../scg.h"
+
+#define DEFAULT_RATE 48000
+#define MAX_PATH_SIZE 1024
+
+typedef struct entry_t {
+    char name[SCG__PACK_NAME_SIZE];
+    uint32_t type;
+    uint32_t params[4];
+    uint8_t *data;
+    size_t size;
+} entry_t;
+
+typedef struct packer_t {
+    entry_t *entries;
+    int num_entries;
+    int max_entries;
+    int rate;
+} packer_t;
+
+static const char *file_extension(const char *path) {
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+
+    return dot != NULL && (slash == NULL || dot > slash) ? dot + 1 : "";
+}
+
+static bool has_extension(const char *path, const char *extension) {
+    const char *ext = file_extension(path);
+
+    for (; *ext != '\0' && *extension != '\0'; ext++, extension++) {
+        if (tolower((unsigned char)*ext) != *extension) {
+            return false;
+        }
+    }
+
+    return *ext == '\0' && *extension == '\0';
+}
+
+static bool pack_image(entry_t *entry, const char *path) {
+    scg_image_t *image = scg_image_new_from_file(path);
+    if (image == NULL) {
+        return false;
+    }
+
+    entry->type = SCG__PACK_ENTRY_IMAGE;
+    entry->params[0] = (uint32_t)image->width;
+    entry->params[1] = (uint32_t)image->height;
+    entry->size = (size_t)image->pitch * image->height;
+    entry->data = malloc(entry->size);
+    if (entry->data == NULL) {
+        fprintf(stderr, "Failed to allocate memory for %s\n", path);
+        scg_image_free(image);
+        return false;
+    }
+
+    memcpy(entry->data, image->pixels, entry->size);
+    scg_image_free(image);
+
+    return true;
+}
+
+static bool pack_sound(entry_t *entry, const char *path, int rate) {
+    SDL_AudioSpec spec;
+    uint8_t *buffer;
+    uint32_t length;
+
+    if (SDL_LoadWAV(path, &spec, &buffer, &length) == NULL) {
+        fprintf(stderr, "Failed to load %s. %s\n", path, SDL_GetError());
+        return false;
+    }
+
+    uint32_t converted_length;
+    entry->data =
+        scg__audio_convert_wav(rate, spec, buffer, length, &converted_length);
+    SDL_FreeWAV(buffer);
+    if (entry->data == NULL) {
+        fprintf(stderr, "Failed to convert %s\n", path);
+        return false;
+    }
+
+    entry->type = SCG__PACK_ENTRY_SOUND;
+    entry->params[0] = (uint32_t)rate;
+    entry->params[1] = AUDIO_S16LSB;
+    entry->params[2] = 2;
+    entry->size = converted_length;
+
+    return true;
+}
+
+// Finds the runs of consecutive code points mapped to consecutive glyphs,
+// which are the ranges scg_font_t looks glyphs up through when it has no
+// page table. Returns the number of ranges, writing them if ranges is not
+// NULL.
+static int font_ranges(const scg_font_t *font, scg_font_range_t *ranges) {
+    int num_ranges = 0;
+    scg_font_range_t range = {0, 0, -1};
+
+    for (uint32_t code = 0; code < SCG__FONT_NUM_PAGES * SCG__FONT_PAGE_SIZE;
+         code++) {
+        const int32_t *page = font->pages[code / SCG__FONT_PAGE_SIZE];
+        int glyph = page != NULL ? page[code % SCG__FONT_PAGE_SIZE] : -1;
+        if (glyph < 0) {
+            continue;
+        }
+
+        if (range.first_glyph >= 0 && code == range.last_code + 1 &&
+            glyph == range.first_glyph +
+                         (int)(code - range.first_code)) {
+            range.last_code = code;
+            continue;
+        }
+
+        if (range.first_glyph >= 0) {
+            if (ranges != NULL) {
+                ranges[num_ranges] = range;
+            }
+            num_ranges++;
+        }
+
+        range.first_code = code;
+        range.last_code = code;
+        range.first_glyph = glyph;
+    }
+
+    if (range.first_glyph >= 0) {
+        if (ranges != NULL) {
+            ranges[num_ranges] = range;
+        }
+        num_ranges++;
+    }
+
+    return num_ranges;
+}
+
+static bool pack_font(entry_t *entry, const char *path) {
+    scg_font_t *font = has_extension(path, "psf")
+                           ? scg_font_new_from_psf(path)
+                           : scg_font_new_from_bdf(path);
+    if (font == NULL) {
+        return false;
+    }
+
+    if (font->coverage != NULL || font->pages == NULL) {
+        fprintf(stderr, "Font %s cannot be packed\n", path);
+        scg_font_free(font);
+        return false;
+    }
+
+    int num_ranges = font_ranges(font, NULL);
+    size_t row_bounds_offset, ranges_offset;
+    entry->size = scg__pack_font_layout(
+        font->glyph_width, font->glyph_height, font->num_glyphs, num_ranges,
+        &row_bounds_offset, &ranges_offset);
+    entry->data = calloc(entry->size, 1);
+    if (entry->data == NULL) {
+        fprintf(stderr, "Failed to allocate memory for %s\n", path);
+        scg_font_free(font);
+        return false;
+    }
+
+    memcpy(entry->data, font->bitmaps,
+           (size_t)font->num_glyphs * font->glyph_height *
+               font->bytes_per_row);
+    memcpy(entry->data + row_bounds_offset, font->row_bounds,
+           (size_t)font->num_glyphs * 2);
+    font_ranges(font, (scg_font_range_t *)(entry->data + ranges_offset));
+
+    entry->type = SCG__PACK_ENTRY_FONT;
+    entry->params[0] = (uint32_t)font->glyph_width;
+    entry->params[1] = (uint32_t)font->glyph_height;
+    entry->params[2] = (uint32_t)font->num_glyphs;
+    entry->params[3] = (uint32_t)num_ranges;
+
+    scg_font_free(font);
+
+    return true;
+}
+
+static bool pack_file(packer_t *packer, const char *path, const char *name) {
+    bool is_image = has_extension(path, "bmp") || has_extension(path, "png") ||
+                    has_extension(path, "qoi") || has_extension(path, "tga");
+    bool is_font = has_extension(path, "psf") || has_extension(path, "bdf");
+    bool is_sound = has_extension(path, "wav");
+
+    if (!is_image && !is_font && !is_sound) {
+        fprintf(stderr, "Skipping %s\n", path);
+        return true;
+    }
+
+    if (strlen(name) >= SCG__PACK_NAME_SIZE) {
+        fprintf(stderr, "Name %s is longer than %d characters\n", name,
+                SCG__PACK_NAME_SIZE - 1);
+        return false;
+    }
+
+    if (packer->num_entries == packer->max_entries) {
+        int max_entries = packer->max_entries * 2 + 16;
+        entry_t *entries =
+            realloc(packer->entries, max_entries * sizeof(*entries));
+        if (entries == NULL) {
+            fprintf(stderr, "Failed to allocate memory for entries\n");
+            return false;
+        }
+        packer->entries = entries;
+        packer->max_entries = max_entries;
+    }
+
+    entry_t *entry = &packer->entries[packer->num_entries];
+    memset(entry, 0, sizeof(*entry));
+    strcpy(entry->name, name);
+
+    bool ok;
+    if (is_image) {
+        ok = pack_image(entry, path);
+    } else if (is_font) {
+        ok = pack_font(entry, path);
+    } else {
+        ok = pack_sound(entry, path, packer->rate);
+    }
+    if (ok) {
+        packer->num_entries++;
+    }
+
+    return ok;
+}
+
+// Packs every file below a directory, naming each by its path relative to
+// the root.
+static bool pack_directory(packer_t *packer, const char *path,
+                           size_t root_length) {
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        fprintf(stderr, "Failed to open directory %s\n", path);
+        return false;
+    }
+
+    bool ok = true;
+    struct dirent *item;
+    while (ok && (item = readdir(dir)) != NULL) {
+        if (item->d_name[0] == '.') {
+            continue;
+        }
+
+        char child[MAX_PATH_SIZE];
+        if ((size_t)snprintf(child, sizeof(child), "%s/%s", path,
+                             item->d_name) >= sizeof(child)) {
+            fprintf(stderr, "Path %s/%s is too long\n", path, item->d_name);
+            ok = false;
+            break;
+        }
+
+        struct stat child_stat;
+        if (stat(child, &child_stat) != 0) {
+            continue;
+        }
+
+        if (S_ISDIR(child_stat.st_mode)) {
+            ok = pack_directory(packer, child, root_length);
+        } else if (S_ISREG(child_stat.st_mode)) {
+            ok = pack_file(packer, child, child + root_length + 1);
+        }
+    }
+
+    closedir(dir);
+
+    return ok;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    return strcmp(((const entry_t *)a)->name, ((const entry_t *)b)->name);
+}
+
+static size_t align_offset(size_t offset) {
+    size_t mask = SCG__PACK_ALIGNMENT - 1;
+
+    return (offset + mask) & ~mask;
+}
+
+static void write_u64_le(uint8_t *bytes, uint64_t value) {
+    scg__write_u32_le(bytes, (uint32_t)value);
+    scg__write_u32_le(bytes + 4, (uint32_t)(value >> 32));
+}
+
+static bool write_pack(const packer_t *packer, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    uint8_t header[SCG__PACK_HEADER_SIZE] = {0};
+    memcpy(header, SCG__PACK_MAGIC, sizeof(SCG__PACK_MAGIC));
+    scg__write_u32_le(header + 8, SCG__PACK_VERSION);
+    scg__write_u32_le(header + 12, (uint32_t)packer->num_entries);
+    write_u64_le(header + 16, SCG__PACK_HEADER_SIZE);
+    bool ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+
+    size_t entries_end = SCG__PACK_HEADER_SIZE +
+                         (size_t)packer->num_entries * SCG__PACK_ENTRY_SIZE;
+
+    size_t offset = align_offset(entries_end);
+    for (int i = 0; ok && i < packer->num_entries; i++) {
+        const entry_t *entry = &packer->entries[i];
+        uint8_t bytes[SCG__PACK_ENTRY_SIZE] = {0};
+
+        memcpy(bytes, entry->name, SCG__PACK_NAME_SIZE);
+        scg__write_u32_le(bytes + 56, entry->type);
+        for (int j = 0; j < 4; j++) {
+            scg__write_u32_le(bytes + 60 + j * 4, entry->params[j]);
+        }
+        write_u64_le(bytes + 80, offset);
+        write_u64_le(bytes + 88, entry->size);
+
+        ok = fwrite(bytes, 1, sizeof(bytes), fp) == sizeof(bytes);
+        offset = align_offset(offset + entry->size);
+    }
+
+    static const uint8_t padding[SCG__PACK_ALIGNMENT] = {0};
+    size_t position = entries_end;
+    for (int i = 0; ok && i < packer->num_entries; i++) {
+        const entry_t *entry = &packer->entries[i];
+        size_t padding_size = align_offset(position) - position;
+
+        ok = fwrite(padding, 1, padding_size, fp) == padding_size &&
+             fwrite(entry->data, 1, entry->size, fp) == entry->size;
+        position += padding_size + entry->size;
+    }
+
+    if (fclose(fp) != 0 || !ok) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    packer_t packer = {NULL, 0, 0, DEFAULT_RATE};
+    int arg = 1;
+
+    if (arg + 1 < argc && strcmp(argv[arg], "-r") == 0) {
+        packer.rate = atoi(argv[arg + 1]);
+        arg += 2;
+    }
+
+    if (argc - arg != 2 || packer.rate <= 0) {
+        fprintf(stderr, "Usage: %s [-r RATE] OUTPUT DIRECTORY\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *output = argv[arg];
+    const char *directory = argv[arg + 1];
+
+    bool ok = pack_directory(&packer, directory, strlen(directory));
+    if (ok) {
+        qsort(packer.entries, packer.num_entries, sizeof(*packer.entries),
+              compare_entries);
+        ok = write_pack(&packer, output);
+    }
+
+    if (ok) {
+        printf("Packed %d assets into %s\n", packer.num_entries, output);
+    }
+
+    for (int i = 0; i < packer.num_entries; i++) {
+        free(packer.entries[i].data);
+    }
+    free(packer.entries);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}